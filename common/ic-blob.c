@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2015 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <glib.h>
+
+#include "iotcon-types.h"
+#include "ic-common.h"
+#include "ic-log.h"
+#include "ic-utils.h"
+#include "ic-blob.h"
+
+#ifdef F_ADD_SEALS
+/* nobody can change the contents under the mappings of the others */
+#define IC_BLOB_SEALS (F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL)
+#endif
+
+/* Returns the sealed memfd, or -1 if the blob is not available. */
+int ic_blob_create(const unsigned char *data, size_t length)
+{
+#ifdef F_ADD_SEALS
+	int fd;
+	ssize_t written;
+	size_t offset = 0;
+
+	RETV_IF(NULL == data, -1);
+	RETV_IF(0 == length, -1);
+
+	fd = ic_utils_memfd_create("iotcon-blob");
+	if (fd < 0) {
+		ERR("memfd_create() Fail(%d)", errno);
+		return -1;
+	}
+
+	while (offset < length) {
+		written = write(fd, data + offset, length - offset);
+		if (written < 0) {
+			if (EINTR == errno)
+				continue;
+			ERR("write() Fail(%d)", errno);
+			close(fd);
+			return -1;
+		}
+		offset += written;
+	}
+
+	if (fcntl(fd, F_ADD_SEALS, IC_BLOB_SEALS) < 0) {
+		ERR("fcntl() Fail(%d)", errno);
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+#else
+	return -1;
+#endif
+}
+
+
+/* The fd of the peer is used only if it is sealed with the given length. */
+int ic_blob_check(int fd, size_t length)
+{
+#ifdef F_ADD_SEALS
+	int seals;
+	struct stat st;
+
+	seals = fcntl(fd, F_GET_SEALS);
+	if (seals < 0) {
+		ERR("fcntl() Fail(%d)", errno);
+		return IOTCON_ERROR_INVALID_PARAMETER;
+	}
+	if ((seals & IC_BLOB_SEALS) != IC_BLOB_SEALS) {
+		ERR("Invalid seals(%x)", seals);
+		return IOTCON_ERROR_INVALID_PARAMETER;
+	}
+
+	if (fstat(fd, &st) < 0) {
+		ERR("fstat() Fail(%d)", errno);
+		return IOTCON_ERROR_SYSTEM;
+	}
+	if (0 == length || st.st_size != length) {
+		ERR("Invalid length(%zu, %lld)", length, (long long)st.st_size);
+		return IOTCON_ERROR_INVALID_PARAMETER;
+	}
+
+	return IOTCON_ERROR_NONE;
+#else
+	return IOTCON_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+
+/* The fd is not consumed. The mapping is read-only and shared with the peer. */
+int ic_blob_map(int fd, size_t length, const unsigned char **data)
+{
+	int ret;
+	void *addr;
+
+	RETV_IF(NULL == data, IOTCON_ERROR_INVALID_PARAMETER);
+
+	ret = ic_blob_check(fd, length);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("ic_blob_check() Fail(%d)", ret);
+		return ret;
+	}
+
+	addr = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+	if (MAP_FAILED == addr) {
+		ERR("mmap() Fail(%d)", errno);
+		return IOTCON_ERROR_OUT_OF_MEMORY;
+	}
+
+	*data = addr;
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+void ic_blob_unmap(const unsigned char *data, size_t length)
+{
+	RET_IF(NULL == data);
+
+	munmap((void*)data, length);
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2015 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __IOT_CONNECTIVITY_MANAGER_INTERNAL_COMMON_BLOB_H__
+#define __IOT_CONNECTIVITY_MANAGER_INTERNAL_COMMON_BLOB_H__
+
+#include <stddef.h>
+
+/*
+ * A byte string of IC_BLOB_THRESHOLD bytes or more is kept in a sealed memfd.
+ * The representation carries only (blob id, length), and the fd is passed
+ * by the blobPut and blobGet methods.
+ */
+#define IC_BLOB_THRESHOLD (64 * 1024)
+#define IC_BLOB_TYPE "(tt)"
+
+int ic_blob_create(const unsigned char *data, size_t length);
+int ic_blob_check(int fd, size_t length);
+int ic_blob_map(int fd, size_t length, const unsigned char **data);
+void ic_blob_unmap(const unsigned char *data, size_t length);
+
+#endif /* __IOT_CONNECTIVITY_MANAGER_INTERNAL_COMMON_BLOB_H__ */
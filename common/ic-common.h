@@ -35,6 +35,7 @@
 #define IC_DBUS_SIGNAL_PRESENCE "PRESENCE"
 #define IC_DBUS_SIGNAL_MONITORING "MONITORING"
 #define IC_DBUS_SIGNAL_CACHING "CACHING"
+#define IC_DBUS_SIGNAL_RING "RING"
 
 #define IC_FEATURE_OIC "http://tizen.org/feature/iot.oic"
 
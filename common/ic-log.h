@@ -95,6 +95,19 @@
 
 #endif /* IC_DEBUGGING */
 
+/* g_variant_print() is evaluated even if the debug log is filtered out.
+ * Dumping GVariant is enabled only when IC_DEBUGGING_GVARIANT is defined. */
+#ifdef IC_DEBUGGING_GVARIANT
+#define DBG_GVARIANT(title, value) \
+	do { \
+		gchar *_str = g_variant_print(value, FALSE); \
+		_DBG("%s : %s", title, _str); \
+		g_free(_str); \
+	} while (0)
+#else
+#define DBG_GVARIANT(title, value)
+#endif
+
 #define RET_IF(expr) \
 	do { \
 		if (expr) { \
@@ -0,0 +1,388 @@
+/*
+ * Copyright (c) 2015 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/eventfd.h>
+#include <glib.h>
+
+#include "iotcon-types.h"
+#include "ic-common.h"
+#include "ic-log.h"
+#include "ic-utils.h"
+#include "ic-ring.h"
+
+#define IC_RING_MAGIC 0x69637267 /* "icrg" */
+#define IC_RING_RECORD_PAD 0x1
+#define IC_RING_ALIGN(n) (((n) + 7) & ~7U)
+
+/*
+ * The producer owns head and the consumer owns tail. Both count bytes and wrap
+ * around 2^32, so (head - tail) is the used size of the ring.
+ * The indices in the shared memory are only hints for the other side.
+ * Each side keeps its own index, and validates what it reads from the other.
+ */
+typedef struct {
+	gint magic;
+	gint size;
+	char pad1[56];
+	volatile gint head;
+	char pad2[60];
+	volatile gint tail;
+	/* set by the consumer before it sleeps on the eventfd */
+	volatile gint need_wakeup;
+	char pad3[56];
+} ic_ring_header_s;
+
+/* A record never wraps. The rest of the ring is skipped with a pad record. */
+typedef struct {
+	guint32 length;
+	guint32 flags;
+} ic_ring_record_s;
+
+struct ic_ring {
+	int mem_fd;
+	int event_fd;
+	size_t map_size;
+	ic_ring_header_s *header;
+	unsigned char *data;
+	guint32 size;
+	guint32 pos;
+	GMutex mutex;
+};
+
+
+static ic_ring_s* _ic_ring_map(int mem_fd, int event_fd, size_t map_size)
+{
+	void *addr;
+	ic_ring_s *ring;
+
+	ring = calloc(1, sizeof(ic_ring_s));
+	if (NULL == ring) {
+		ERR("calloc() Fail(%d)", errno);
+		return NULL;
+	}
+
+	addr = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, mem_fd, 0);
+	if (MAP_FAILED == addr) {
+		ERR("mmap() Fail(%d)", errno);
+		free(ring);
+		return NULL;
+	}
+
+	ring->mem_fd = mem_fd;
+	ring->event_fd = event_fd;
+	ring->map_size = map_size;
+	ring->header = addr;
+	ring->data = (unsigned char*)addr + sizeof(ic_ring_header_s);
+	g_mutex_init(&ring->mutex);
+
+	return ring;
+}
+
+
+/* size should be a power of 2 */
+ic_ring_s* ic_ring_create(unsigned int size)
+{
+	int mem_fd, event_fd;
+	size_t map_size;
+	ic_ring_s *ring;
+
+	RETV_IF(0 == size || (size & (size - 1)), NULL);
+
+	map_size = sizeof(ic_ring_header_s) + size;
+
+	mem_fd = ic_utils_memfd_create("iotcon-ring");
+	if (mem_fd < 0) {
+		ERR("memfd_create() Fail(%d)", errno);
+		return NULL;
+	}
+
+	if (ftruncate(mem_fd, map_size) < 0) {
+		ERR("ftruncate() Fail(%d)", errno);
+		close(mem_fd);
+		return NULL;
+	}
+
+#ifdef F_ADD_SEALS
+	/* the peer can not shrink the memory under our mapping */
+	if (fcntl(mem_fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0)
+		WARN("fcntl() Fail(%d)", errno);
+#endif
+
+	event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (event_fd < 0) {
+		ERR("eventfd() Fail(%d)", errno);
+		close(mem_fd);
+		return NULL;
+	}
+
+	ring = _ic_ring_map(mem_fd, event_fd, map_size);
+	if (NULL == ring) {
+		ERR("_ic_ring_map() Fail");
+		close(event_fd);
+		close(mem_fd);
+		return NULL;
+	}
+
+	ring->size = size;
+	ring->header->magic = IC_RING_MAGIC;
+	ring->header->size = size;
+	ring->header->head = 0;
+	ring->header->tail = 0;
+	ring->header->need_wakeup = 1;
+
+	return ring;
+}
+
+
+/* The fds are owned by the ring, even if it fails. */
+ic_ring_s* ic_ring_attach(int mem_fd, int event_fd)
+{
+	guint32 size;
+	struct stat st;
+	ic_ring_s *ring;
+
+	if (fstat(mem_fd, &st) < 0 || st.st_size <= sizeof(ic_ring_header_s)) {
+		ERR("Invalid ring(%d)", errno);
+		close(event_fd);
+		close(mem_fd);
+		return NULL;
+	}
+
+	ring = _ic_ring_map(mem_fd, event_fd, st.st_size);
+	if (NULL == ring) {
+		ERR("_ic_ring_map() Fail");
+		close(event_fd);
+		close(mem_fd);
+		return NULL;
+	}
+
+	size = ring->header->size;
+	if (IC_RING_MAGIC != ring->header->magic || 0 == size || (size & (size - 1))
+			|| sizeof(ic_ring_header_s) + size != ring->map_size) {
+		ERR("Invalid ring(magic:%x, size:%u)", ring->header->magic, size);
+		ic_ring_destroy(ring);
+		return NULL;
+	}
+
+	ring->size = size;
+
+	return ring;
+}
+
+
+void ic_ring_destroy(ic_ring_s *ring)
+{
+	RET_IF(NULL == ring);
+
+	munmap(ring->header, ring->map_size);
+	close(ring->event_fd);
+	close(ring->mem_fd);
+	g_mutex_clear(&ring->mutex);
+	free(ring);
+}
+
+
+int ic_ring_get_mem_fd(ic_ring_s *ring)
+{
+	RETV_IF(NULL == ring, -1);
+
+	return ring->mem_fd;
+}
+
+
+int ic_ring_get_event_fd(ic_ring_s *ring)
+{
+	RETV_IF(NULL == ring, -1);
+
+	return ring->event_fd;
+}
+
+
+static void _ic_ring_wakeup(ic_ring_s *ring)
+{
+	uint64_t count = 1;
+
+	/* the consumer is awake, and will see the record before it sleeps */
+	if (FALSE == g_atomic_int_compare_and_exchange(&ring->header->need_wakeup, 1, 0))
+		return;
+
+	if (write(ring->event_fd, &count, sizeof(count)) < 0 && EAGAIN != errno)
+		ERR("write() Fail(%d)", errno);
+}
+
+
+/* The value is not consumed. IOTCON_ERROR_OUT_OF_MEMORY means the ring is full. */
+int ic_ring_write(ic_ring_s *ring, GVariant *value)
+{
+	gsize length;
+	ic_ring_record_s *record;
+	guint32 tail, used, offset, room, need;
+
+	RETV_IF(NULL == ring, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(NULL == value, IOTCON_ERROR_INVALID_PARAMETER);
+
+	length = g_variant_get_size(value);
+	if (ring->size / 2 < sizeof(ic_ring_record_s) + length)
+		return IOTCON_ERROR_OUT_OF_MEMORY;
+	need = sizeof(ic_ring_record_s) + IC_RING_ALIGN(length);
+
+	g_mutex_lock(&ring->mutex);
+
+	tail = g_atomic_int_get(&ring->header->tail);
+	used = ring->pos - tail;
+	if (ring->size < used) {
+		ERR("Invalid tail(%u)", tail);
+		g_mutex_unlock(&ring->mutex);
+		return IOTCON_ERROR_SYSTEM;
+	}
+
+	offset = ring->pos & (ring->size - 1);
+	room = ring->size - offset;
+	if (room < need) {
+		if (ring->size - used < room + need) {
+			g_mutex_unlock(&ring->mutex);
+			return IOTCON_ERROR_OUT_OF_MEMORY;
+		}
+		record = (ic_ring_record_s*)(ring->data + offset);
+		record->length = 0;
+		record->flags = IC_RING_RECORD_PAD;
+		ring->pos += room;
+		offset = 0;
+	} else if (ring->size - used < need) {
+		g_mutex_unlock(&ring->mutex);
+		return IOTCON_ERROR_OUT_OF_MEMORY;
+	}
+
+	record = (ic_ring_record_s*)(ring->data + offset);
+	record->length = length;
+	record->flags = 0;
+	g_variant_store(value, record + 1);
+	ring->pos += need;
+
+	/* publish the record, then check whether the consumer sleeps */
+	g_atomic_int_set(&ring->header->head, ring->pos);
+	_ic_ring_wakeup(ring);
+
+	g_mutex_unlock(&ring->mutex);
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+/* *value is NULL when the ring is empty. The peer is not trusted. */
+int ic_ring_read(ic_ring_s *ring, const GVariantType *type, GVariant **value)
+{
+	gpointer buf;
+	guint32 head, available, offset, room, need;
+	ic_ring_record_s record;
+
+	RETV_IF(NULL == ring, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(NULL == type, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(NULL == value, IOTCON_ERROR_INVALID_PARAMETER);
+
+	*value = NULL;
+
+	head = g_atomic_int_get(&ring->header->head);
+	while (head != ring->pos) {
+		available = head - ring->pos;
+		offset = ring->pos & (ring->size - 1);
+		room = ring->size - offset;
+		if (ring->size < available || room < sizeof(ic_ring_record_s)) {
+			ERR("Invalid head(%u)", head);
+			return IOTCON_ERROR_SYSTEM;
+		}
+
+		memcpy(&record, ring->data + offset, sizeof(record));
+		if (IC_RING_RECORD_PAD & record.flags) {
+			if (available < room) {
+				ERR("Invalid pad(%u)", room);
+				return IOTCON_ERROR_SYSTEM;
+			}
+			ring->pos += room;
+			g_atomic_int_set(&ring->header->tail, ring->pos);
+			continue;
+		}
+
+		if (ring->size / 2 < record.length) {
+			ERR("Invalid record(%u)", record.length);
+			return IOTCON_ERROR_SYSTEM;
+		}
+		need = sizeof(ic_ring_record_s) + IC_RING_ALIGN(record.length);
+		if (room < need || available < need) {
+			ERR("Invalid record(%u)", record.length);
+			return IOTCON_ERROR_SYSTEM;
+		}
+
+		/* copy out before the slot is given back to the producer */
+		buf = g_memdup(ring->data + offset + sizeof(ic_ring_record_s), record.length);
+		*value = g_variant_new_from_data(type, buf, record.length, FALSE, g_free, buf);
+		g_variant_ref_sink(*value);
+
+		ring->pos += need;
+		g_atomic_int_set(&ring->header->tail, ring->pos);
+		break;
+	}
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+void ic_ring_clear_event(ic_ring_s *ring)
+{
+	uint64_t count;
+
+	RET_IF(NULL == ring);
+
+	if (read(ring->event_fd, &count, sizeof(count)) < 0 && EAGAIN != errno)
+		ERR("read() Fail(%d)", errno);
+}
+
+
+/* Returns true if the consumer can sleep on the eventfd. Otherwise, read again. */
+bool ic_ring_wait(ic_ring_s *ring)
+{
+	RETV_IF(NULL == ring, true);
+
+	g_atomic_int_set(&ring->header->need_wakeup, 1);
+
+	/* a record written before the flag is set, does not wake us up */
+	if (g_atomic_int_get(&ring->header->head) != ring->pos)
+		return false;
+
+	return true;
+}
+
+
+/* Returns true if the consumer read every record. Only for the producer. */
+bool ic_ring_is_empty(ic_ring_s *ring)
+{
+	bool empty;
+
+	RETV_IF(NULL == ring, true);
+
+	g_mutex_lock(&ring->mutex);
+	empty = ((guint32)g_atomic_int_get(&ring->header->tail) == ring->pos);
+	g_mutex_unlock(&ring->mutex);
+
+	return empty;
+}
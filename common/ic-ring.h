@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2015 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __IOT_CONNECTIVITY_MANAGER_INTERNAL_COMMON_RING_H__
+#define __IOT_CONNECTIVITY_MANAGER_INTERNAL_COMMON_RING_H__
+
+#include <stdbool.h>
+#include <glib.h>
+
+/*
+ * Single-producer/single-consumer ring of serialized GVariants in a memfd,
+ * shared by the daemon and one client. The eventfd wakes up the consumer.
+ */
+#define IC_RING_SIGNAL_SIZE (256 * 1024)
+#define IC_RING_NOTIFY_SIZE (64 * 1024)
+
+#define IC_RING_SIGNAL_TYPE "(sv)"
+#define IC_RING_NOTIFY_TYPE "(xavaii)"
+
+typedef struct ic_ring ic_ring_s;
+
+ic_ring_s* ic_ring_create(unsigned int size);
+ic_ring_s* ic_ring_attach(int mem_fd, int event_fd);
+void ic_ring_destroy(ic_ring_s *ring);
+
+int ic_ring_get_mem_fd(ic_ring_s *ring);
+int ic_ring_get_event_fd(ic_ring_s *ring);
+
+int ic_ring_write(ic_ring_s *ring, GVariant *value);
+int ic_ring_read(ic_ring_s *ring, const GVariantType *type, GVariant **value);
+void ic_ring_clear_event(ic_ring_s *ring);
+bool ic_ring_wait(ic_ring_s *ring);
+bool ic_ring_is_empty(ic_ring_s *ring);
+
+#endif /* __IOT_CONNECTIVITY_MANAGER_INTERNAL_COMMON_RING_H__ */
@@ -16,6 +16,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
 #include <glib.h>
 #include <system_info.h>
 
@@ -24,6 +26,11 @@
 #include "ic-log.h"
 #include "ic-utils.h"
 
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+
 #ifdef TZ_VER_3
 static int _ic_oic_feature_supported = -1;
 #endif
@@ -62,6 +69,18 @@ char* ic_utils_dbus_decode_str(char *src)
 }
 
 
+/* The memory can be sealed. Returns -1 on error. */
+int ic_utils_memfd_create(const char *name)
+{
+#ifdef __NR_memfd_create
+	return syscall(__NR_memfd_create, name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#else
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+
 void ic_utils_gvariant_array_free(GVariant **value)
 {
 	int i;
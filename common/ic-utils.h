@@ -27,6 +27,7 @@
 char* ic_utils_strdup(const char *src);
 const char* ic_utils_dbus_encode_str(const char *src);
 char* ic_utils_dbus_decode_str(char *src);
+int ic_utils_memfd_create(const char *name);
 void ic_utils_gvariant_array_free(GVariant **value);
 bool ic_utils_check_oic_feature_supported();
 
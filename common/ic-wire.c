@@ -0,0 +1,521 @@
+/*
+ * Copyright (c) 2015 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "iotcon-types.h"
+#include "ic-common.h"
+#include "ic-log.h"
+#include "ic-wire.h"
+
+/* a typical sensor payload fits without growing the columns */
+#define IC_WIRE_RESERVE 16
+
+void ic_wire_writer_init(ic_wire_writer_s *writer)
+{
+	RET_IF(NULL == writer);
+
+	writer->key_table = g_hash_table_new(g_str_hash, g_str_equal);
+	writer->keys = g_ptr_array_sized_new(IC_WIRE_RESERVE);
+	g_variant_builder_init(&writer->nodes, G_VARIANT_TYPE("a(sasasuu)"));
+	writer->n_nodes = 0;
+	writer->states = g_array_sized_new(FALSE, TRUE, sizeof(ic_wire_range_s),
+			IC_WIRE_RESERVE);
+	writer->attrs = g_array_sized_new(FALSE, TRUE, sizeof(ic_wire_attr_s),
+			IC_WIRE_RESERVE);
+	writer->lists = g_array_sized_new(FALSE, TRUE, sizeof(ic_wire_list_s),
+			IC_WIRE_RESERVE);
+	writer->bools = g_array_sized_new(FALSE, TRUE, sizeof(guint8), IC_WIRE_RESERVE);
+	writer->ints = g_array_sized_new(FALSE, TRUE, sizeof(gint32), IC_WIRE_RESERVE);
+	writer->doubles = g_array_sized_new(FALSE, TRUE, sizeof(gdouble), IC_WIRE_RESERVE);
+	writer->strs = g_ptr_array_sized_new(IC_WIRE_RESERVE);
+	writer->bytes = g_byte_array_new();
+	writer->byte_strs = g_array_new(FALSE, TRUE, sizeof(ic_wire_range_s));
+	writer->blobs = g_array_new(FALSE, TRUE, sizeof(ic_wire_blob_s));
+}
+
+
+void ic_wire_writer_clear(ic_wire_writer_s *writer)
+{
+	RET_IF(NULL == writer);
+
+	if (NULL == writer->key_table)
+		return;
+
+	g_hash_table_destroy(writer->key_table);
+	g_ptr_array_free(writer->keys, TRUE);
+	g_variant_builder_clear(&writer->nodes);
+	g_array_free(writer->states, TRUE);
+	g_array_free(writer->attrs, TRUE);
+	g_array_free(writer->lists, TRUE);
+	g_array_free(writer->bools, TRUE);
+	g_array_free(writer->ints, TRUE);
+	g_array_free(writer->doubles, TRUE);
+	g_ptr_array_free(writer->strs, TRUE);
+	g_byte_array_free(writer->bytes, TRUE);
+	g_array_free(writer->byte_strs, TRUE);
+	g_array_free(writer->blobs, TRUE);
+
+	memset(writer, 0, sizeof(ic_wire_writer_s));
+}
+
+
+static GVariant* _ic_wire_fixed_array(const char *type, GArray *arr)
+{
+	return g_variant_new_fixed_array(G_VARIANT_TYPE(type), arr->data, arr->len,
+			g_array_get_element_size(arr));
+}
+
+
+/* Returns the floating value of IC_WIRE_TYPE. The writer is cleared. */
+GVariant* ic_wire_writer_end(ic_wire_writer_s *writer)
+{
+	GVariant *value;
+
+	RETV_IF(NULL == writer, NULL);
+	RETV_IF(NULL == writer->key_table, NULL);
+
+	value = g_variant_new("(q@as@a(sasasuu)@a(uu)@a(uyu)@a(yuu)@ab@ai@ad@as@ay@a(uu)@a(tt))",
+			IC_WIRE_VERSION_2,
+			g_variant_new_strv((const gchar * const *)writer->keys->pdata,
+				writer->keys->len),
+			g_variant_builder_end(&writer->nodes),
+			_ic_wire_fixed_array("(uu)", writer->states),
+			_ic_wire_fixed_array("(uyu)", writer->attrs),
+			_ic_wire_fixed_array("(yuu)", writer->lists),
+			_ic_wire_fixed_array("b", writer->bools),
+			_ic_wire_fixed_array("i", writer->ints),
+			_ic_wire_fixed_array("d", writer->doubles),
+			g_variant_new_strv((const gchar * const *)writer->strs->pdata,
+				writer->strs->len),
+			g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, writer->bytes->data,
+				writer->bytes->len, sizeof(guint8)),
+			_ic_wire_fixed_array("(uu)", writer->byte_strs),
+			_ic_wire_fixed_array("(tt)", writer->blobs));
+
+	ic_wire_writer_clear(writer);
+
+	return value;
+}
+
+
+/* ifaces and types are "as" */
+guint32 ic_wire_writer_add_node(ic_wire_writer_s *writer, const char *uri_path,
+		GVariant *ifaces, GVariant *types, guint32 parent, guint32 state)
+{
+	g_variant_builder_add(&writer->nodes, "(s@as@asuu)", uri_path, ifaces, types, parent,
+			state);
+
+	return writer->n_nodes++;
+}
+
+
+static guint32 _ic_wire_reserve(GArray *arr, guint32 count)
+{
+	guint32 first = arr->len;
+
+	/* the reserved elements are cleared, including the padding */
+	g_array_set_size(arr, first + count);
+
+	return first;
+}
+
+
+guint32 ic_wire_writer_reserve_states(ic_wire_writer_s *writer, guint32 count)
+{
+	return _ic_wire_reserve(writer->states, count);
+}
+
+
+guint32 ic_wire_writer_reserve_attrs(ic_wire_writer_s *writer, guint32 count)
+{
+	return _ic_wire_reserve(writer->attrs, count);
+}
+
+
+guint32 ic_wire_writer_reserve_lists(ic_wire_writer_s *writer, guint32 count)
+{
+	return _ic_wire_reserve(writer->lists, count);
+}
+
+
+void ic_wire_writer_set_state(ic_wire_writer_s *writer, guint32 state, guint32 first,
+		guint32 count)
+{
+	ic_wire_range_s *range;
+
+	range = &g_array_index(writer->states, ic_wire_range_s, state);
+	range->first = first;
+	range->count = count;
+}
+
+
+static guint32 _ic_wire_writer_key(ic_wire_writer_s *writer, const char *key)
+{
+	guint32 index;
+	gpointer value;
+
+	if (g_hash_table_lookup_extended(writer->key_table, key, NULL, &value))
+		return GPOINTER_TO_UINT(value);
+
+	index = writer->keys->len;
+	g_ptr_array_add(writer->keys, (gpointer)key);
+	g_hash_table_insert(writer->key_table, (gpointer)key, GUINT_TO_POINTER(index));
+
+	return index;
+}
+
+
+void ic_wire_writer_set_attr(ic_wire_writer_s *writer, guint32 attr, const char *key,
+		guint8 tag, guint32 value)
+{
+	ic_wire_attr_s *wire_attr;
+
+	wire_attr = &g_array_index(writer->attrs, ic_wire_attr_s, attr);
+	wire_attr->key = _ic_wire_writer_key(writer, key);
+	wire_attr->tag = tag;
+	wire_attr->value = value;
+}
+
+
+void ic_wire_writer_set_list(ic_wire_writer_s *writer, guint32 list, guint8 tag,
+		guint32 first, guint32 count)
+{
+	ic_wire_list_s *wire_list;
+
+	wire_list = &g_array_index(writer->lists, ic_wire_list_s, list);
+	wire_list->tag = tag;
+	wire_list->first = first;
+	wire_list->count = count;
+}
+
+
+guint32 ic_wire_writer_add_bool(ic_wire_writer_s *writer, bool value)
+{
+	guint8 b = value ? 1 : 0;
+
+	g_array_append_val(writer->bools, b);
+
+	return writer->bools->len - 1;
+}
+
+
+guint32 ic_wire_writer_add_int(ic_wire_writer_s *writer, gint32 value)
+{
+	g_array_append_val(writer->ints, value);
+
+	return writer->ints->len - 1;
+}
+
+
+guint32 ic_wire_writer_add_double(ic_wire_writer_s *writer, double value)
+{
+	g_array_append_val(writer->doubles, value);
+
+	return writer->doubles->len - 1;
+}
+
+
+guint32 ic_wire_writer_add_str(ic_wire_writer_s *writer, const char *value)
+{
+	g_ptr_array_add(writer->strs, (gpointer)value);
+
+	return writer->strs->len - 1;
+}
+
+
+guint32 ic_wire_writer_add_byte_str(ic_wire_writer_s *writer, const unsigned char *data,
+		guint32 length)
+{
+	ic_wire_range_s range;
+
+	range.first = writer->bytes->len;
+	range.count = length;
+	g_byte_array_append(writer->bytes, data, length);
+	g_array_append_val(writer->byte_strs, range);
+
+	return writer->byte_strs->len - 1;
+}
+
+
+guint32 ic_wire_writer_add_blob(ic_wire_writer_s *writer, guint64 id, guint64 length)
+{
+	ic_wire_blob_s blob;
+
+	blob.id = id;
+	blob.length = length;
+	g_array_append_val(writer->blobs, blob);
+
+	return writer->blobs->len - 1;
+}
+
+
+bool ic_wire_is_flat(GVariant *value)
+{
+	RETV_IF(NULL == value, false);
+
+	return g_variant_is_of_type(value, G_VARIANT_TYPE(IC_WIRE_TYPE));
+}
+
+
+int ic_wire_reader_init(ic_wire_reader_s *reader, GVariant *value)
+{
+	int i;
+	guint16 version;
+
+	RETV_IF(NULL == reader, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(NULL == value, IOTCON_ERROR_INVALID_PARAMETER);
+
+	memset(reader, 0, sizeof(ic_wire_reader_s));
+
+	if (false == ic_wire_is_flat(value)) {
+		ERR("Invalid type(%s)", g_variant_get_type_string(value));
+		return IOTCON_ERROR_INVALID_TYPE;
+	}
+
+	g_variant_get_child(value, 0, "q", &version);
+	if (IC_WIRE_VERSION_2 != version) {
+		ERR("Invalid version(%d)", version);
+		return IOTCON_ERROR_INVALID_TYPE;
+	}
+
+	reader->value = g_variant_ref(value);
+	reader->nodes = g_variant_get_child_value(value, 2);
+	reader->n_nodes = g_variant_n_children(reader->nodes);
+
+	/* keys, and the columns after the nodes */
+	reader->columns[0] = g_variant_get_child_value(value, 1);
+	for (i = 1; i < G_N_ELEMENTS(reader->columns); i++)
+		reader->columns[i] = g_variant_get_child_value(value, i + 2);
+
+	reader->keys = g_variant_get_strv(reader->columns[0], &reader->n_keys);
+	reader->states = g_variant_get_fixed_array(reader->columns[1], &reader->n_states,
+			sizeof(ic_wire_range_s));
+	reader->attrs = g_variant_get_fixed_array(reader->columns[2], &reader->n_attrs,
+			sizeof(ic_wire_attr_s));
+	reader->lists = g_variant_get_fixed_array(reader->columns[3], &reader->n_lists,
+			sizeof(ic_wire_list_s));
+	reader->bools = g_variant_get_fixed_array(reader->columns[4], &reader->n_bools,
+			sizeof(guint8));
+	reader->ints = g_variant_get_fixed_array(reader->columns[5], &reader->n_ints,
+			sizeof(gint32));
+	reader->doubles = g_variant_get_fixed_array(reader->columns[6], &reader->n_doubles,
+			sizeof(gdouble));
+	reader->strs = g_variant_get_strv(reader->columns[7], &reader->n_strs);
+	reader->bytes = g_variant_get_fixed_array(reader->columns[8], &reader->n_bytes,
+			sizeof(guint8));
+	reader->byte_strs = g_variant_get_fixed_array(reader->columns[9],
+			&reader->n_byte_strs, sizeof(ic_wire_range_s));
+	reader->blobs = g_variant_get_fixed_array(reader->columns[10], &reader->n_blobs,
+			sizeof(ic_wire_blob_s));
+
+	if (0 == reader->n_nodes) {
+		ERR("No node");
+		ic_wire_reader_clear(reader);
+		return IOTCON_ERROR_INVALID_PARAMETER;
+	}
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+void ic_wire_reader_clear(ic_wire_reader_s *reader)
+{
+	int i;
+
+	RET_IF(NULL == reader);
+
+	if (NULL == reader->value)
+		return;
+
+	g_free(reader->strs);
+	g_free(reader->keys);
+	for (i = 0; i < G_N_ELEMENTS(reader->columns); i++)
+		g_variant_unref(reader->columns[i]);
+	g_variant_unref(reader->nodes);
+	g_variant_unref(reader->value);
+
+	memset(reader, 0, sizeof(ic_wire_reader_s));
+}
+
+
+/* The strings are valid until the reader is cleared. ifaces and types should be freed
+ * by g_free(). */
+int ic_wire_reader_get_node(ic_wire_reader_s *reader, guint32 node,
+		const char **uri_path, const gchar ***ifaces, const gchar ***types,
+		guint32 *parent, guint32 *state)
+{
+	RETV_IF(NULL == reader, IOTCON_ERROR_INVALID_PARAMETER);
+
+	if (reader->n_nodes <= node) {
+		ERR("Invalid node(%u)", node);
+		return IOTCON_ERROR_INVALID_PARAMETER;
+	}
+
+	g_variant_get_child(reader->nodes, node, "(&s^a&s^a&suu)", uri_path, ifaces, types,
+			parent, state);
+
+	/* a node follows its parent, so that the nodes make a tree */
+	if ((0 == node && IC_WIRE_NO_PARENT != *parent) || (0 < node && node <= *parent)) {
+		ERR("Invalid parent(%u) of node(%u)", *parent, node);
+		g_free(*types);
+		g_free(*ifaces);
+		return IOTCON_ERROR_INVALID_PARAMETER;
+	}
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+static gsize _ic_wire_reader_column_size(ic_wire_reader_s *reader, guint8 tag)
+{
+	switch (tag) {
+	case IC_WIRE_BOOL:
+		return reader->n_bools;
+	case IC_WIRE_INT:
+		return reader->n_ints;
+	case IC_WIRE_DOUBLE:
+		return reader->n_doubles;
+	case IC_WIRE_STR:
+		return reader->n_strs;
+	case IC_WIRE_BYTE_STR:
+		return reader->n_byte_strs;
+	case IC_WIRE_BLOB:
+		return reader->n_blobs;
+	case IC_WIRE_LIST:
+		return reader->n_lists;
+	case IC_WIRE_STATE:
+		return reader->n_states;
+	case IC_WIRE_NULL:
+	default:
+		return 0;
+	}
+}
+
+
+/* [first, first + count) is in the column of the tag */
+bool ic_wire_reader_check(ic_wire_reader_s *reader, guint8 tag, guint32 first,
+		guint32 count)
+{
+	gsize size;
+
+	RETV_IF(NULL == reader, false);
+
+	size = _ic_wire_reader_column_size(reader, tag);
+	if (size < first || size - first < count) {
+		ERR("Invalid index(%u, %u) of tag(%d)", first, count, tag);
+		return false;
+	}
+
+	return true;
+}
+
+
+/* The attributes of the returned state are in the column of attributes. */
+const ic_wire_range_s* ic_wire_reader_get_state(ic_wire_reader_s *reader,
+		guint32 state)
+{
+	const ic_wire_range_s *range;
+
+	RETV_IF(NULL == reader, NULL);
+
+	if (reader->n_states <= state) {
+		ERR("Invalid state(%u)", state);
+		return NULL;
+	}
+
+	range = &reader->states[state];
+	if (reader->n_attrs < range->first || reader->n_attrs - range->first < range->count) {
+		ERR("Invalid attributes(%u, %u)", range->first, range->count);
+		return NULL;
+	}
+
+	return range;
+}
+
+
+const char* ic_wire_reader_get_key(ic_wire_reader_s *reader, guint32 key)
+{
+	RETV_IF(NULL == reader, NULL);
+
+	if (reader->n_keys <= key) {
+		ERR("Invalid key(%u)", key);
+		return NULL;
+	}
+
+	return reader->keys[key];
+}
+
+
+/* The elements of the returned list are in the column of its tag. */
+const ic_wire_list_s* ic_wire_reader_get_list(ic_wire_reader_s *reader, guint32 list)
+{
+	const ic_wire_list_s *wire_list;
+
+	RETV_IF(NULL == reader, NULL);
+
+	if (reader->n_lists <= list) {
+		ERR("Invalid list(%u)", list);
+		return NULL;
+	}
+
+	wire_list = &reader->lists[list];
+	switch (wire_list->tag) {
+	case IC_WIRE_BOOL:
+	case IC_WIRE_INT:
+	case IC_WIRE_DOUBLE:
+	case IC_WIRE_STR:
+	case IC_WIRE_BYTE_STR:
+	case IC_WIRE_LIST:
+	case IC_WIRE_STATE:
+		break;
+	default:
+		ERR("Invalid tag(%d) of list(%u)", wire_list->tag, list);
+		return NULL;
+	}
+
+	if (false == ic_wire_reader_check(reader, wire_list->tag, wire_list->first,
+				wire_list->count))
+		return NULL;
+
+	return wire_list;
+}
+
+
+bool ic_wire_reader_get_byte_str(ic_wire_reader_s *reader, guint32 index,
+		const unsigned char **data, guint32 *length)
+{
+	const ic_wire_range_s *range;
+
+	RETV_IF(NULL == reader, false);
+
+	if (reader->n_byte_strs <= index) {
+		ERR("Invalid byte string(%u)", index);
+		return false;
+	}
+
+	range = &reader->byte_strs[index];
+	if (reader->n_bytes < range->first || reader->n_bytes - range->first < range->count) {
+		ERR("Invalid bytes(%u, %u)", range->first, range->count);
+		return false;
+	}
+
+	*data = reader->bytes + range->first;
+	*length = range->count;
+
+	return true;
+}
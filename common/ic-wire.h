@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2015 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __IOT_CONNECTIVITY_MANAGER_INTERNAL_COMMON_WIRE_H__
+#define __IOT_CONNECTIVITY_MANAGER_INTERNAL_COMMON_WIRE_H__
+
+#include <stdbool.h>
+#include <glib.h>
+
+/*
+ * Wire formats of a representation in a "v" of D-Bus.
+ * The version is negotiated by the negotiateWire method, and a peer which never
+ * negotiates gets IC_WIRE_VERSION_1. Both versions are always accepted.
+ * The negotiated version is the highest one which the peer reads. IC_WIRE_VERSION_2
+ * is larger, and slower to encode for a small representation
+ * (see test/iotcon-test-wire-bench.c), so a representation goes in it only with
+ * IC_WIRE_FLAT_MIN_ELEMENTS list elements or more.
+ *
+ * IC_WIRE_VERSION_1 : "(sasasa{sv}av)", every attribute and child is boxed.
+ * IC_WIRE_VERSION_2 : IC_WIRE_TYPE, the attributes are typed columns.
+ *   q            : version
+ *   as           : keys
+ *   a(sasasuu)   : nodes (uri path, interfaces, types, parent node, state).
+ *                  The first node is the parent, and a node follows its parent.
+ *   a(uu)        : states (first attribute, count)
+ *   a(uyu)       : attributes (key, tag, index in the column of the tag)
+ *   a(yuu)       : lists (tag of elements, first element, count)
+ *   ab ai ad as  : bool, int, double and string columns
+ *   ay a(uu)     : bytes, and the byte strings (offset, length) in the bytes
+ *   a(tt)        : blobs (id, length). See ic-blob.h
+ */
+#define IC_WIRE_VERSION_1 1
+#define IC_WIRE_VERSION_2 2
+#define IC_WIRE_VERSION_MAX IC_WIRE_VERSION_2
+
+#define IC_WIRE_FLAT_MIN_ELEMENTS 48
+
+#define IC_WIRE_TYPE "(qasa(sasasuu)a(uu)a(uyu)a(yuu)abaiadasaya(uu)a(tt))"
+
+#define IC_WIRE_NO_PARENT G_MAXUINT32
+/* states and lists may refer to each other */
+#define IC_WIRE_MAX_DEPTH 32
+
+enum {
+	IC_WIRE_NULL = 0,
+	IC_WIRE_BOOL,
+	IC_WIRE_INT,
+	IC_WIRE_DOUBLE,
+	IC_WIRE_STR,
+	IC_WIRE_BYTE_STR,
+	IC_WIRE_BLOB,
+	IC_WIRE_LIST,
+	IC_WIRE_STATE,
+};
+
+/* The layouts are the same as the serialized GVariants. */
+typedef struct {
+	guint32 first;
+	guint32 count;
+} ic_wire_range_s;
+
+typedef struct {
+	guint32 key;
+	guint8 tag;
+	guint32 value;
+} ic_wire_attr_s;
+
+typedef struct {
+	guint8 tag;
+	guint32 first;
+	guint32 count;
+} ic_wire_list_s;
+
+typedef struct {
+	guint64 id;
+	guint64 length;
+} ic_wire_blob_s;
+
+/*
+ * The writer appends to the columns. The elements of a state or a list must be
+ * contiguous, so they are reserved first, and filled later by index.
+ * The strings are not copied until ic_wire_writer_end().
+ */
+typedef struct {
+	GHashTable *key_table;
+	GPtrArray *keys;
+	GVariantBuilder nodes;
+	guint32 n_nodes;
+	GArray *states;
+	GArray *attrs;
+	GArray *lists;
+	GArray *bools;
+	GArray *ints;
+	GArray *doubles;
+	GPtrArray *strs;
+	GByteArray *bytes;
+	GArray *byte_strs;
+	GArray *blobs;
+} ic_wire_writer_s;
+
+void ic_wire_writer_init(ic_wire_writer_s *writer);
+void ic_wire_writer_clear(ic_wire_writer_s *writer);
+GVariant* ic_wire_writer_end(ic_wire_writer_s *writer);
+
+guint32 ic_wire_writer_add_node(ic_wire_writer_s *writer, const char *uri_path,
+		GVariant *ifaces, GVariant *types, guint32 parent, guint32 state);
+guint32 ic_wire_writer_reserve_states(ic_wire_writer_s *writer, guint32 count);
+guint32 ic_wire_writer_reserve_attrs(ic_wire_writer_s *writer, guint32 count);
+guint32 ic_wire_writer_reserve_lists(ic_wire_writer_s *writer, guint32 count);
+void ic_wire_writer_set_state(ic_wire_writer_s *writer, guint32 state, guint32 first,
+		guint32 count);
+void ic_wire_writer_set_attr(ic_wire_writer_s *writer, guint32 attr, const char *key,
+		guint8 tag, guint32 value);
+void ic_wire_writer_set_list(ic_wire_writer_s *writer, guint32 list, guint8 tag,
+		guint32 first, guint32 count);
+
+guint32 ic_wire_writer_add_bool(ic_wire_writer_s *writer, bool value);
+guint32 ic_wire_writer_add_int(ic_wire_writer_s *writer, gint32 value);
+guint32 ic_wire_writer_add_double(ic_wire_writer_s *writer, double value);
+guint32 ic_wire_writer_add_str(ic_wire_writer_s *writer, const char *value);
+guint32 ic_wire_writer_add_byte_str(ic_wire_writer_s *writer, const unsigned char *data,
+		guint32 length);
+guint32 ic_wire_writer_add_blob(ic_wire_writer_s *writer, guint64 id, guint64 length);
+
+/*
+ * The reader points into the serialized value, and checks every index
+ * before it is used. The peer is not trusted.
+ */
+typedef struct {
+	GVariant *value;
+	const gchar **keys;
+	gsize n_keys;
+	GVariant *nodes;
+	gsize n_nodes;
+	GVariant *columns[11];
+	const ic_wire_range_s *states;
+	gsize n_states;
+	const ic_wire_attr_s *attrs;
+	gsize n_attrs;
+	const ic_wire_list_s *lists;
+	gsize n_lists;
+	const guint8 *bools;
+	gsize n_bools;
+	const gint32 *ints;
+	gsize n_ints;
+	const gdouble *doubles;
+	gsize n_doubles;
+	const gchar **strs;
+	gsize n_strs;
+	const guint8 *bytes;
+	gsize n_bytes;
+	const ic_wire_range_s *byte_strs;
+	gsize n_byte_strs;
+	const ic_wire_blob_s *blobs;
+	gsize n_blobs;
+} ic_wire_reader_s;
+
+bool ic_wire_is_flat(GVariant *value);
+
+int ic_wire_reader_init(ic_wire_reader_s *reader, GVariant *value);
+void ic_wire_reader_clear(ic_wire_reader_s *reader);
+
+int ic_wire_reader_get_node(ic_wire_reader_s *reader, guint32 node,
+		const char **uri_path, const gchar ***ifaces, const gchar ***types,
+		guint32 *parent, guint32 *state);
+const ic_wire_range_s* ic_wire_reader_get_state(ic_wire_reader_s *reader,
+		guint32 state);
+const char* ic_wire_reader_get_key(ic_wire_reader_s *reader, guint32 key);
+const ic_wire_list_s* ic_wire_reader_get_list(ic_wire_reader_s *reader, guint32 list);
+bool ic_wire_reader_check(ic_wire_reader_s *reader, guint8 tag, guint32 first,
+		guint32 count);
+bool ic_wire_reader_get_byte_str(ic_wire_reader_s *reader, guint32 index,
+		const unsigned char **data, guint32 *length);
+
+#endif /* __IOT_CONNECTIVITY_MANAGER_INTERNAL_COMMON_WIRE_H__ */
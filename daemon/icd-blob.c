@@ -0,0 +1,476 @@
+/*
+ * Copyright (c) 2015 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <glib.h>
+
+#include "iotcon.h"
+#include "ic-utils.h"
+#include "ic-blob.h"
+#include "icd.h"
+#include "icd-blob.h"
+
+#define ICD_BLOB_LIFETIME (5 * G_TIME_SPAN_MINUTE) /* since the last use */
+#define ICD_BLOB_MAX_SIZE (64 * 1024 * 1024) /* of all blobs of an owner */
+#define ICD_BLOB_DAEMON "" /* the owner of the blobs from the stack */
+
+/* A blob put by a client is owned by it. A blob of a representation from the stack is
+ * owned by the daemon, and could be sent to several clients, or kept in the history.
+ * Only the owner and the clients which the blob is sent to can get it. The id also
+ * comes from the kernel random source, which a client can not predict from the ids it
+ * got. A blob expires after the lifetime since its last use, or when the blobs of its
+ * owner take too much memory. */
+typedef struct {
+	char *bus_name;
+	uint64_t size;
+	int count;
+} icd_blob_owner_s;
+
+typedef struct {
+	int fd;
+	uint64_t length;
+	gint64 expire_time;
+	icd_blob_owner_s *owner;
+	GHashTable *recipients; /* bus names, NULL until it is sent */
+} icd_blob_s;
+
+static GMutex icd_blob_mutex;
+static GHashTable *icd_blob_table; /* key : id */
+static GHashTable *icd_blob_owner_table; /* key : bus name */
+
+
+static void _icd_blob_free(gpointer data)
+{
+	icd_blob_s *blob = data;
+	icd_blob_owner_s *owner = blob->owner;
+
+	owner->size -= blob->length;
+	if (0 == --owner->count)
+		g_hash_table_remove(icd_blob_owner_table, owner->bus_name);
+
+	if (blob->recipients)
+		g_hash_table_destroy(blob->recipients);
+	close(blob->fd);
+	free(blob);
+}
+
+
+static void _icd_blob_free_owner(gpointer data)
+{
+	icd_blob_owner_s *owner = data;
+
+	free(owner->bus_name);
+	free(owner);
+}
+
+
+/* MUST be called with the blob mutex */
+static icd_blob_owner_s* _icd_blob_get_owner(const char *bus_name)
+{
+	icd_blob_owner_s *owner;
+
+	if (NULL == icd_blob_owner_table)
+		icd_blob_owner_table = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+				_icd_blob_free_owner);
+
+	owner = g_hash_table_lookup(icd_blob_owner_table, bus_name);
+	if (owner)
+		return owner;
+
+	owner = calloc(1, sizeof(icd_blob_owner_s));
+	if (NULL == owner) {
+		ERR("calloc() Fail(%d)", errno);
+		return NULL;
+	}
+	owner->bus_name = ic_utils_strdup(bus_name);
+	if (NULL == owner->bus_name) {
+		ERR("ic_utils_strdup() Fail");
+		free(owner);
+		return NULL;
+	}
+	g_hash_table_insert(icd_blob_owner_table, owner->bus_name, owner);
+
+	return owner;
+}
+
+
+static gboolean _icd_blob_is_expired(gpointer key, gpointer value, gpointer user_data)
+{
+	icd_blob_s *blob = value;
+	gint64 *now = user_data;
+
+	return (blob->expire_time <= *now);
+}
+
+
+static gboolean _icd_blob_is_owned_by(gpointer key, gpointer value, gpointer user_data)
+{
+	icd_blob_s *blob = value;
+
+	return (IC_STR_EQUAL == g_strcmp0(blob->owner->bus_name, user_data));
+}
+
+
+/* MUST be called with the blob mutex */
+static void _icd_blob_remove_oldest(icd_blob_owner_s *owner)
+{
+	GHashTableIter iter;
+	gpointer key, value, oldest_key = NULL;
+	icd_blob_s *blob, *oldest = NULL;
+
+	g_hash_table_iter_init(&iter, icd_blob_table);
+	while (g_hash_table_iter_next(&iter, &key, &value)) {
+		blob = value;
+		if (owner != blob->owner)
+			continue;
+		if (NULL == oldest || blob->expire_time < oldest->expire_time) {
+			oldest = blob;
+			oldest_key = key;
+		}
+	}
+
+	if (oldest_key)
+		g_hash_table_remove(icd_blob_table, oldest_key);
+}
+
+
+static int _icd_blob_random_id(uint64_t *id)
+{
+	int fd;
+	ssize_t len;
+
+	fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		ERR("open() Fail(%d)", errno);
+		return IOTCON_ERROR_SYSTEM;
+	}
+
+	do {
+		len = read(fd, id, sizeof(uint64_t));
+	} while (len < 0 && EINTR == errno);
+	close(fd);
+
+	if (sizeof(uint64_t) != len) {
+		ERR("read() Fail(%d)", errno);
+		return IOTCON_ERROR_SYSTEM;
+	}
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+/* The fd is owned by the table, even if it fails. */
+static int _icd_blob_add(int fd, uint64_t length, const char *bus_name, uint64_t *id)
+{
+	int ret;
+	gint64 now;
+	uint64_t *key;
+	icd_blob_s *blob;
+	icd_blob_owner_s *owner;
+
+	if (ICD_BLOB_MAX_SIZE < length) {
+		ERR("Too large blob(%llu)", length);
+		close(fd);
+		return IOTCON_ERROR_OUT_OF_MEMORY;
+	}
+
+	blob = calloc(1, sizeof(icd_blob_s));
+	if (NULL == blob) {
+		ERR("calloc() Fail(%d)", errno);
+		close(fd);
+		return IOTCON_ERROR_OUT_OF_MEMORY;
+	}
+
+	key = calloc(1, sizeof(uint64_t));
+	if (NULL == key) {
+		ERR("calloc() Fail(%d)", errno);
+		free(blob);
+		close(fd);
+		return IOTCON_ERROR_OUT_OF_MEMORY;
+	}
+
+	now = g_get_monotonic_time();
+	blob->fd = fd;
+	blob->length = length;
+	blob->expire_time = now + ICD_BLOB_LIFETIME;
+
+	g_mutex_lock(&icd_blob_mutex);
+	if (NULL == icd_blob_table)
+		icd_blob_table = g_hash_table_new_full(g_int64_hash, g_int64_equal, free,
+				_icd_blob_free);
+
+	g_hash_table_foreach_remove(icd_blob_table, _icd_blob_is_expired, &now);
+
+	owner = _icd_blob_get_owner(bus_name);
+	if (NULL == owner) {
+		ERR("_icd_blob_get_owner() Fail");
+		g_mutex_unlock(&icd_blob_mutex);
+		free(key);
+		free(blob);
+		close(fd);
+		return IOTCON_ERROR_OUT_OF_MEMORY;
+	}
+	/* the blob is counted first, not to free the owner with its last blob */
+	owner->count++;
+	while (ICD_BLOB_MAX_SIZE < owner->size + length)
+		_icd_blob_remove_oldest(owner);
+
+	do {
+		ret = _icd_blob_random_id(key);
+		if (IOTCON_ERROR_NONE != ret) {
+			ERR("_icd_blob_random_id() Fail(%d)", ret);
+			if (0 == --owner->count)
+				g_hash_table_remove(icd_blob_owner_table, owner->bus_name);
+			g_mutex_unlock(&icd_blob_mutex);
+			free(key);
+			free(blob);
+			close(fd);
+			return ret;
+		}
+	} while (0 == *key || g_hash_table_contains(icd_blob_table, key));
+
+	owner->size += length;
+	blob->owner = owner;
+	g_hash_table_insert(icd_blob_table, key, blob);
+	*id = *key;
+	g_mutex_unlock(&icd_blob_mutex);
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+/* Returns the reference of the blob, or NULL to send the bytes inline */
+GVariant* icd_blob_new(const uint8_t *bytes, size_t length)
+{
+	int fd, ret;
+	uint64_t id;
+
+	fd = ic_blob_create(bytes, length);
+	if (fd < 0)
+		return NULL;
+
+	ret = _icd_blob_add(fd, length, ICD_BLOB_DAEMON, &id);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("_icd_blob_add() Fail(%d)", ret);
+		return NULL;
+	}
+
+	return g_variant_new(IC_BLOB_TYPE, id, (guint64)length);
+}
+
+
+/* The fd from the client is owned by the table, even if it fails. */
+int icd_blob_add(int fd, uint64_t length, const char *bus_name, uint64_t *id)
+{
+	int ret;
+
+	RETV_IF(NULL == bus_name, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(NULL == id, IOTCON_ERROR_INVALID_PARAMETER);
+
+	ret = ic_blob_check(fd, length);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("ic_blob_check() Fail(%d)", ret);
+		close(fd);
+		return ret;
+	}
+
+	return _icd_blob_add(fd, length, bus_name, id);
+}
+
+
+/* bus_name NULL : the daemon itself */
+static int _icd_blob_dup_fd(uint64_t id, uint64_t length, const char *bus_name,
+		int *fd)
+{
+	icd_blob_s *blob = NULL;
+
+	g_mutex_lock(&icd_blob_mutex);
+	if (icd_blob_table)
+		blob = g_hash_table_lookup(icd_blob_table, &id);
+	if (NULL == blob || length != blob->length) {
+		g_mutex_unlock(&icd_blob_mutex);
+		ERR("No blob(%llx)", id);
+		return IOTCON_ERROR_NO_DATA;
+	}
+
+	if (bus_name && IC_STR_EQUAL != g_strcmp0(blob->owner->bus_name, bus_name)
+			&& (NULL == blob->recipients
+				|| FALSE == g_hash_table_contains(blob->recipients, bus_name))) {
+		g_mutex_unlock(&icd_blob_mutex);
+		ERR("bus(%s) has no blob(%llx)", bus_name, id);
+		return IOTCON_ERROR_PERMISSION_DENIED;
+	}
+
+	*fd = dup(blob->fd);
+	blob->expire_time = g_get_monotonic_time() + ICD_BLOB_LIFETIME;
+	g_mutex_unlock(&icd_blob_mutex);
+
+	if (*fd < 0) {
+		ERR("dup() Fail(%d)", errno);
+		return IOTCON_ERROR_SYSTEM;
+	}
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+/* Only the owner, or the clients which the blob is sent to can get the blob */
+int icd_blob_dup_fd(uint64_t id, uint64_t length, const char *bus_name, int *fd)
+{
+	RETV_IF(NULL == bus_name, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(NULL == fd, IOTCON_ERROR_INVALID_PARAMETER);
+
+	return _icd_blob_dup_fd(id, length, bus_name, fd);
+}
+
+
+static void _icd_blob_add_recipient(uint64_t id, const char *bus_name)
+{
+	char *recipient;
+	icd_blob_s *blob = NULL;
+
+	g_mutex_lock(&icd_blob_mutex);
+	if (icd_blob_table)
+		blob = g_hash_table_lookup(icd_blob_table, &id);
+	if (NULL == blob) {
+		g_mutex_unlock(&icd_blob_mutex);
+		return;
+	}
+
+	if (NULL == blob->recipients)
+		blob->recipients = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+	if (FALSE == g_hash_table_contains(blob->recipients, bus_name)) {
+		recipient = ic_utils_strdup(bus_name);
+		if (recipient)
+			g_hash_table_add(blob->recipients, recipient);
+	}
+	g_mutex_unlock(&icd_blob_mutex);
+}
+
+
+/* The references of the blobs are IC_BLOB_TYPE anywhere in the value.
+ * The containers which can not hold one are skipped. */
+static void _icd_blob_grant(GVariant *value, const char *bus_name)
+{
+	gsize i, n_children;
+	GVariant *child;
+	guint64 id, length;
+	const char *type_str;
+
+	type_str = g_variant_get_type_string(value);
+	if (NULL == strstr(type_str, IC_BLOB_TYPE) && NULL == strchr(type_str, 'v'))
+		return;
+
+	if (g_variant_is_of_type(value, G_VARIANT_TYPE(IC_BLOB_TYPE))) {
+		g_variant_get(value, IC_BLOB_TYPE, &id, &length);
+		_icd_blob_add_recipient(id, bus_name);
+		return;
+	}
+
+	n_children = g_variant_n_children(value);
+	for (i = 0; i < n_children; i++) {
+		child = g_variant_get_child_value(value, i);
+		_icd_blob_grant(child, bus_name);
+		g_variant_unref(child);
+	}
+}
+
+
+/* The blobs in the value are sent to the client. It can get them, then. */
+void icd_blob_grant(GVariant *value, const char *bus_name)
+{
+	bool empty;
+
+	RET_IF(NULL == value);
+	RET_IF(NULL == bus_name);
+
+	/* the values are not walked, unless there is a blob */
+	g_mutex_lock(&icd_blob_mutex);
+	empty = (NULL == icd_blob_table || 0 == g_hash_table_size(icd_blob_table));
+	g_mutex_unlock(&icd_blob_mutex);
+	if (empty)
+		return;
+
+	_icd_blob_grant(value, bus_name);
+}
+
+
+/* the client is gone. Its blobs are freed */
+void icd_blob_remove_client(const char *bus_name)
+{
+	GHashTableIter iter;
+	gpointer value;
+	icd_blob_s *blob;
+
+	RET_IF(NULL == bus_name);
+
+	g_mutex_lock(&icd_blob_mutex);
+	if (NULL == icd_blob_table) {
+		g_mutex_unlock(&icd_blob_mutex);
+		return;
+	}
+
+	g_hash_table_foreach_remove(icd_blob_table, _icd_blob_is_owned_by, (gpointer)bus_name);
+
+	g_hash_table_iter_init(&iter, icd_blob_table);
+	while (g_hash_table_iter_next(&iter, NULL, &value)) {
+		blob = value;
+		if (blob->recipients)
+			g_hash_table_remove(blob->recipients, bus_name);
+	}
+	g_mutex_unlock(&icd_blob_mutex);
+}
+
+
+int icd_blob_map(uint64_t id, uint64_t length, const unsigned char **data)
+{
+	int fd, ret;
+
+	ret = _icd_blob_dup_fd(id, length, NULL, &fd);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("_icd_blob_dup_fd() Fail(%d)", ret);
+		return ret;
+	}
+
+	/* the mapping stays after the fd is closed */
+	ret = ic_blob_map(fd, length, data);
+	close(fd);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("ic_blob_map() Fail(%d)", ret);
+		return ret;
+	}
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+void icd_blob_deinit()
+{
+	g_mutex_lock(&icd_blob_mutex);
+	if (icd_blob_table) {
+		g_hash_table_destroy(icd_blob_table);
+		icd_blob_table = NULL;
+	}
+	if (icd_blob_owner_table) {
+		g_hash_table_destroy(icd_blob_owner_table);
+		icd_blob_owner_table = NULL;
+	}
+	g_mutex_unlock(&icd_blob_mutex);
+}
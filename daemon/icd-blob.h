@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) 2015 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __IOT_CONNECTIVITY_MANAGER_DAEMON_BLOB_H__
+#define __IOT_CONNECTIVITY_MANAGER_DAEMON_BLOB_H__
+
+#include <stdint.h>
+#include <glib.h>
+
+GVariant* icd_blob_new(const uint8_t *bytes, size_t length);
+int icd_blob_add(int fd, uint64_t length, const char *bus_name, uint64_t *id);
+int icd_blob_dup_fd(uint64_t id, uint64_t length, const char *bus_name, int *fd);
+int icd_blob_map(uint64_t id, uint64_t length, const unsigned char **data);
+void icd_blob_grant(GVariant *value, const char *bus_name);
+void icd_blob_remove_client(const char *bus_name);
+void icd_blob_deinit();
+
+#endif /*__IOT_CONNECTIVITY_MANAGER_DAEMON_BLOB_H__*/
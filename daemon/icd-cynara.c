@@ -26,6 +26,7 @@
 #include "iotcon.h"
 #include "ic-common.h"
 #include "icd.h"
+#include "icd-dbus.h"
 #include "icd-cynara.h"
 
 static const char *_icd_privileges_network[] = {
@@ -83,15 +84,16 @@ static int _icd_cynara_check(GDBusMethodInvocation *invocation, const char **pri
 	RETV_IF(NULL == invocation, IOTCON_ERROR_INVALID_PARAMETER);
 	RETV_IF(NULL == privileges, IOTCON_ERROR_INVALID_PARAMETER);
 
-	conn = g_dbus_method_invocation_get_connection(invocation);
+	/* the credentials of the client on a private connection are taken from the bus */
+	conn = icd_dbus_get_bus_connection();
 	if (NULL == conn) {
-		ERR("g_dbus_method_invocation_get_connection() return NULL");
+		ERR("icd_dbus_get_bus_connection() return NULL");
 		return IOTCON_ERROR_SYSTEM;
 	}
 
-	sender = g_dbus_method_invocation_get_sender(invocation);
+	sender = icd_dbus_get_sender(invocation);
 	if (NULL == sender) {
-		ERR("g_dbus_method_invocation_get_sender() return NULL");
+		ERR("icd_dbus_get_sender() return NULL");
 		return IOTCON_ERROR_SYSTEM;
 	}
 
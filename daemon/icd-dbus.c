@@ -15,47 +15,105 @@
  */
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <glib-unix.h>
 #include <gio/gio.h>
+#include <gio/gunixfdlist.h>
 
 #include <octypes.h>
 
 #include "iotcon.h"
 #include "ic-common.h"
 #include "ic-utils.h"
+#include "ic-ring.h"
+#include "ic-wire.h"
 #include "ic-dbus.h"
 #include "icd.h"
 #include "icd-ioty.h"
+#include "icd-ioty-ocprocess.h"
 #include "icd-cynara.h"
+#include "icd-blob.h"
 #include "icd-dbus.h"
 
 static icDbus *icd_dbus_object;
 
-/* global list to care resource handle for each client */
-static GList *icd_dbus_client_list;
-static GMutex icd_dbus_client_list_mutex;
+/* global table to care resource handle for each client (key : bus name) */
+static GHashTable *icd_dbus_client_table;
+/* resource handle index of all clients (key : OCResourceHandle) */
+static GHashTable *icd_dbus_resource_table;
+/* presence subscribers of all clients (key : OCDoHandle, value : GPtrArray) */
+static GHashTable *icd_dbus_presence_table;
+static GRWLock icd_dbus_client_table_lock;
+
+/* The clients talk to the daemon on private connections of this server.
+ * The system bus is used only for the handshake and the name owner tracking. */
+#define ICD_DBUS_P2P_ADDRESS "unix:tmpdir=/tmp"
+#define ICD_DBUS_P2P_BUS_NAME "icd-bus-name"
+
+static GDBusServer *icd_dbus_p2p_server;
+static GMutex icd_dbus_p2p_mutex;
+/* key : bus name, value : GDBusConnection */
+static GHashTable *icd_dbus_p2p_table;
+/* handshakes to be connected (key : pid, value : bus name) */
+static GHashTable *icd_dbus_p2p_pending_table;
+
+/*
+ * The rings shared with the clients carry the signals and the notifications
+ * without D-Bus marshalling. D-Bus is used for the control, and when a ring is full.
+ *
+ * The signals to a client keep their order, whichever way they go. Once a signal does
+ * not fit into the ring, the following signals also go through D-Bus (fallback).
+ * When the client has read every record of the ring, the daemon sends the RING signal
+ * through D-Bus after the others (drained). The client stops reading the ring, and
+ * calls ringResume. The ring is used again after the reply, which follows every signal
+ * sent through D-Bus before it.
+ */
+typedef struct {
+	ic_ring_s *signal_ring;
+	ic_ring_s *notify_ring;
+	guint notify_source;
+	bool fallback;
+	bool drained;
+} icd_dbus_ring_s;
+
+static GMutex icd_dbus_ring_mutex;
+/* key : bus name, value : icd_dbus_ring_s */
+static GHashTable *icd_dbus_ring_table;
+
+static GMutex icd_dbus_wire_mutex;
+/* key : bus name, value : wire version of representations, if it is negotiated */
+static GHashTable *icd_dbus_wire_table;
 
 typedef struct _icd_dbus_client_s {
 	gchar *bus_name;
-	GList *resource_list;
-	GList *presence_list;
-	GList *observe_list;
-	GList *encap_list;
+	GHashTable *resource_table;
+	GHashTable *presence_table;
+	GHashTable *observe_table;
+	GHashTable *encap_table;
 } icd_dbus_client_s;
 
 typedef struct _icd_resource_handle {
 	OCResourceHandle handle;
 	int64_t signal_number;
+	icd_dbus_client_s *client;
 } icd_resource_handle_s;
 
 typedef struct _icd_presence_handle {
 	OCDoHandle handle;
 	char *host_address;
+	char *resource_type; /* NULL : every resource type */
+	int count;
+	icd_dbus_client_s *client;
 } icd_presence_handle_s;
 
 typedef struct _icd_encap_handle {
 	int type;
 	char *host_address;
 	char *uri_path;
+	int count;
+	int delta_count;
+	icd_dbus_client_s *client;
 } icd_encap_handle_s;
 
 icDbus* icd_dbus_get_object()
@@ -75,56 +133,114 @@ int64_t icd_dbus_generate_signal_number()
 int icd_dbus_client_list_get_resource_info(OCResourceHandle handle,
 		int64_t *signal_number, gchar **bus_name)
 {
-	icd_dbus_client_s *client;
-	GList *cur_client, *cur_hd;
 	icd_resource_handle_s *rsrc_handle;
 
 	RETV_IF(NULL == signal_number, IOTCON_ERROR_INVALID_PARAMETER);
 	RETV_IF(NULL == bus_name, IOTCON_ERROR_INVALID_PARAMETER);
 
-	g_mutex_lock(&icd_dbus_client_list_mutex);
-	cur_client = icd_dbus_client_list;
-	while (cur_client) {
-		client = cur_client->data;
-		if (NULL == client) {
-			ERR("client is NULL");
-			g_mutex_unlock(&icd_dbus_client_list_mutex);
-			return IOTCON_ERROR_NO_DATA;
-		}
+	g_rw_lock_reader_lock(&icd_dbus_client_table_lock);
+	rsrc_handle = g_hash_table_lookup(icd_dbus_resource_table, handle);
+	if (NULL == rsrc_handle) {
+		g_rw_lock_reader_unlock(&icd_dbus_client_table_lock);
+		return IOTCON_ERROR_NO_DATA;
+	}
+
+	DBG_HANDLE(handle);
+	DBG("signal_number(%llx) found", rsrc_handle->signal_number);
+	*signal_number = rsrc_handle->signal_number;
+	*bus_name = ic_utils_strdup(rsrc_handle->client->bus_name);
+	g_rw_lock_reader_unlock(&icd_dbus_client_table_lock);
+
+	return IOTCON_ERROR_NONE;
+}
 
-		cur_hd = client->resource_list;
-		while (cur_hd) {
-			rsrc_handle = cur_hd->data;
-
-			if (rsrc_handle->handle == handle) {
-				DBG_HANDLE(handle);
-				DBG("signal_number(%llx) found", rsrc_handle->signal_number);
-				*signal_number = rsrc_handle->signal_number;
-				*bus_name = ic_utils_strdup(client->bus_name);
-				g_mutex_unlock(&icd_dbus_client_list_mutex);
-				return IOTCON_ERROR_NONE;
-			}
-			cur_hd = cur_hd->next;
-		}
 
-		cur_client = cur_client->next;
+/* returns the bus names subscribing presence of the handle for the resource_type */
+GList* icd_dbus_client_list_get_presence_subscribers(OCDoHandle handle,
+		const char *resource_type)
+{
+	int i;
+	GPtrArray *subscribers;
+	GList *bus_names = NULL;
+	icd_presence_handle_s *presence_handle;
+
+	RETV_IF(NULL == handle, NULL);
+
+	g_rw_lock_reader_lock(&icd_dbus_client_table_lock);
+	subscribers = g_hash_table_lookup(icd_dbus_presence_table, handle);
+	for (i = 0; subscribers && i < subscribers->len; i++) {
+		presence_handle = g_ptr_array_index(subscribers, i);
+		if (resource_type && presence_handle->resource_type
+				&& IC_STR_EQUAL != strcmp(resource_type, presence_handle->resource_type))
+			continue;
+		bus_names = g_list_prepend(bus_names,
+				ic_utils_strdup(presence_handle->client->bus_name));
 	}
+	g_rw_lock_reader_unlock(&icd_dbus_client_table_lock);
 
-	g_mutex_unlock(&icd_dbus_client_list_mutex);
-	return IOTCON_ERROR_NO_DATA;
+	return bus_names;
 }
 
-int icd_dbus_emit_signal(const char *dest, const char *signal_name, GVariant *value)
+
+/* the system bus, which the object is exported on first */
+GDBusConnection* icd_dbus_get_bus_connection()
+{
+	icDbusSkeleton *skeleton;
+
+	skeleton = IC_DBUS_SKELETON(icd_dbus_get_object());
+
+	return g_dbus_interface_skeleton_get_connection(G_DBUS_INTERFACE_SKELETON(skeleton));
+}
+
+
+/* the bus name of the client, also for the invocations on the private connections */
+const gchar* icd_dbus_get_sender(GDBusMethodInvocation *invocation)
+{
+	const gchar *sender;
+	GDBusConnection *conn;
+
+	sender = g_dbus_method_invocation_get_sender(invocation);
+	if (sender)
+		return sender;
+
+	conn = g_dbus_method_invocation_get_connection(invocation);
+
+	return g_object_get_data(G_OBJECT(conn), ICD_DBUS_P2P_BUS_NAME);
+}
+
+
+static GDBusConnection* _icd_dbus_p2p_get_connection(const char *bus_name)
+{
+	GDBusConnection *conn = NULL;
+
+	if (NULL == bus_name)
+		return NULL;
+
+	g_mutex_lock(&icd_dbus_p2p_mutex);
+	if (icd_dbus_p2p_table)
+		conn = g_hash_table_lookup(icd_dbus_p2p_table, bus_name);
+	if (conn)
+		g_object_ref(conn);
+	g_mutex_unlock(&icd_dbus_p2p_mutex);
+
+	return conn;
+}
+
+
+/* A floating value is consumed */
+static int _icd_dbus_bus_emit_signal(const char *dest, const char *signal_name,
+		GVariant *value)
 {
 	gboolean ret;
 	GError *error = NULL;
 	GDBusConnection *conn;
-	icDbusSkeleton *skeleton;
-
-	DBG("SIG : %s, %s", signal_name, g_variant_print(value, FALSE));
 
-	skeleton = IC_DBUS_SKELETON(icd_dbus_get_object());
-	conn = g_dbus_interface_skeleton_get_connection(G_DBUS_INTERFACE_SKELETON(skeleton));
+	/* the client connected directly does not need the system bus */
+	conn = _icd_dbus_p2p_get_connection(dest);
+	if (conn)
+		dest = NULL;
+	else
+		conn = g_object_ref(icd_dbus_get_bus_connection());
 
 	ret = g_dbus_connection_emit_signal(conn,
 			dest,
@@ -133,24 +249,120 @@ int icd_dbus_emit_signal(const char *dest, const char *signal_name, GVariant *va
 			signal_name,
 			value,
 			&error);
+	g_object_unref(conn);
 	if (FALSE == ret) {
 		ERR("g_dbus_connection_emit_signal() Fail(%s)", error->message);
 		g_error_free(error);
-		g_variant_unref(value);
 		return IOTCON_ERROR_DBUS;
 	}
 
-	if (FALSE == g_dbus_connection_flush_sync(conn, NULL, &error)) {
-		ERR("g_dbus_connection_flush_sync() Fail(%s)", error->message);
-		g_error_free(error);
-		g_variant_unref(value);
-		return IOTCON_ERROR_DBUS;
+	return IOTCON_ERROR_NONE;
+}
+
+
+/* IOTCON_ERROR_NO_DATA means the client has no ring */
+static int _icd_dbus_ring_emit_signal(const char *dest, const char *signal_name,
+		GVariant *value)
+{
+	int ret;
+	GVariant *record;
+	icd_dbus_ring_s *ring = NULL;
+
+	if (NULL == dest)
+		return IOTCON_ERROR_NO_DATA;
+
+	/* the lock also serializes the producers of the ring, and the fallback signals */
+	g_mutex_lock(&icd_dbus_ring_mutex);
+	if (icd_dbus_ring_table)
+		ring = g_hash_table_lookup(icd_dbus_ring_table, dest);
+	if (NULL == ring) {
+		g_mutex_unlock(&icd_dbus_ring_mutex);
+		return IOTCON_ERROR_NO_DATA;
+	}
+
+	if (false == ring->fallback) {
+		record = g_variant_ref_sink(g_variant_new(IC_RING_SIGNAL_TYPE, signal_name,
+					value));
+		ret = ic_ring_write(ring->signal_ring, record);
+		g_variant_unref(record);
+		if (IOTCON_ERROR_OUT_OF_MEMORY != ret) {
+			g_mutex_unlock(&icd_dbus_ring_mutex);
+			return ret;
+		}
+		/* the ring is full, or the signal is too large for it */
+		WARN("ring of bus(%s) is not available", dest);
+		ring->fallback = true;
+	}
+
+	ret = _icd_dbus_bus_emit_signal(dest, signal_name, value);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("_icd_dbus_bus_emit_signal() Fail(%d)", ret);
+		g_mutex_unlock(&icd_dbus_ring_mutex);
+		return ret;
 	}
 
+	/* the older records are read. The client resumes the ring after this signal */
+	if (false == ring->drained && ic_ring_is_empty(ring->signal_ring)) {
+		ret = _icd_dbus_bus_emit_signal(dest, IC_DBUS_SIGNAL_RING,
+				g_variant_new("(xv)", 0, g_variant_new_boolean(TRUE)));
+		if (IOTCON_ERROR_NONE == ret)
+			ring->drained = true;
+		else
+			ERR("_icd_dbus_bus_emit_signal() Fail(%d)", ret);
+	}
+	g_mutex_unlock(&icd_dbus_ring_mutex);
+
 	return IOTCON_ERROR_NONE;
 }
 
 
+/*
+ * The signal is queued to the GDBus worker thread, which writes it out
+ * asynchronously. Call icd_dbus_flush() after a batch of signals if needed.
+ * If the client has a ring, the signal is written into the ring instead.
+ * One reference of the value is consumed, whether it is floating or not.
+ */
+int icd_dbus_emit_signal(const char *dest, const char *signal_name, GVariant *value)
+{
+	int ret;
+
+	value = g_variant_take_ref(value);
+
+	DBG("SIG : %s", signal_name);
+	DBG_GVARIANT(signal_name, value);
+
+	if (dest)
+		icd_blob_grant(value, dest);
+
+	ret = _icd_dbus_ring_emit_signal(dest, signal_name, value);
+	if (IOTCON_ERROR_NO_DATA == ret)
+		ret = _icd_dbus_bus_emit_signal(dest, signal_name, value);
+	g_variant_unref(value);
+
+	return ret;
+}
+
+
+/* flush the queued signals without waiting for completion */
+void icd_dbus_flush()
+{
+	GList *cur, *conns = NULL;
+
+	g_mutex_lock(&icd_dbus_p2p_mutex);
+	if (icd_dbus_p2p_table)
+		conns = g_hash_table_get_values(icd_dbus_p2p_table);
+	for (cur = conns; cur; cur = cur->next)
+		g_object_ref(cur->data);
+	g_mutex_unlock(&icd_dbus_p2p_mutex);
+
+	for (cur = conns; cur; cur = cur->next)
+		g_dbus_connection_flush(cur->data, NULL, NULL, NULL);
+	g_list_free_full(conns, g_object_unref);
+
+	g_dbus_connection_flush(icd_dbus_get_bus_connection(), NULL, NULL, NULL);
+}
+
+
 static void _icd_dbus_cleanup_resource_list(void *data)
 {
 	int ret;
@@ -181,11 +393,14 @@ static void _icd_dbus_cleanup_presence_list(void *data)
 	DBG("Deregistering presence handle");
 	DBG_HANDLE(presence_handle->handle);
 
-	ret = icd_ioty_unsubscribe_presence(presence_handle->handle,
-			presence_handle->host_address);
-	if (IOTCON_ERROR_NONE != ret)
-		ERR("icd_ioty_unsubscribe_presence() Fail(%d)", ret);
+	for (; 0 < presence_handle->count; presence_handle->count--) {
+		ret = icd_ioty_unsubscribe_presence(presence_handle->handle,
+				presence_handle->host_address);
+		if (IOTCON_ERROR_NONE != ret)
+			ERR("icd_ioty_unsubscribe_presence() Fail(%d)", ret);
+	}
 
+	free(presence_handle->resource_type);
 	free(presence_handle->host_address);
 	free(presence_handle);
 }
@@ -213,10 +428,16 @@ static void _icd_dbus_cleanup_encap_list(void *data)
 
 	DBG("Deregistering encapsulation");
 
-	ret = icd_ioty_stop_encap(encap_handle->type, encap_handle->uri_path,
-			encap_handle->host_address);
-	if (IOTCON_ERROR_NONE != ret)
-		ERR("icd_ioty_stop_encap() Fail(%d)", ret);
+	icd_ioty_encap_remove_client(encap_handle->type, encap_handle->uri_path,
+			encap_handle->host_address, encap_handle->client->bus_name, encap_handle->count,
+			encap_handle->delta_count);
+
+	for (; 0 < encap_handle->count; encap_handle->count--) {
+		ret = icd_ioty_stop_encap(encap_handle->type, encap_handle->uri_path,
+				encap_handle->host_address);
+		if (IOTCON_ERROR_NONE != ret)
+			ERR("icd_ioty_stop_encap() Fail(%d)", ret);
+	}
 
 	free(encap_handle->uri_path);
 	free(encap_handle->host_address);
@@ -224,60 +445,88 @@ static void _icd_dbus_cleanup_encap_list(void *data)
 }
 
 
-static int _icd_dbus_client_list_cleanup_handle_list(GList *client_list)
+static void _icd_dbus_free_presence_handle(void *data)
 {
-	FN_CALL;
-	icd_dbus_client_s *client;
-
-	RETV_IF(NULL == client_list, IOTCON_ERROR_INVALID_PARAMETER);
+	icd_presence_handle_s *presence_handle = data;
 
-	client = client_list->data;
+	free(presence_handle->resource_type);
+	free(presence_handle->host_address);
+	free(presence_handle);
+}
 
-	/* resource list */
-	g_list_free_full(client->resource_list, _icd_dbus_cleanup_resource_list);
-	/* presence list */
-	g_list_free_full(client->presence_list, _icd_dbus_cleanup_presence_list);
-	/* observe list */
-	g_list_free_full(client->observe_list, _icd_dbus_cleanup_observe_list);
-	/* encapsulation list */
-	g_list_free_full(client->encap_list, _icd_dbus_cleanup_encap_list);
 
-	free(client->bus_name);
-	client->bus_name = NULL;
-	free(client);
-	g_list_free(client_list);
+static void _icd_dbus_free_encap_handle(void *data)
+{
+	icd_encap_handle_s *encap_handle = data;
 
-	return IOTCON_ERROR_NONE;
+	free(encap_handle->uri_path);
+	free(encap_handle->host_address);
+	free(encap_handle);
 }
 
 
-static int _icd_dbus_client_list_compare_bus_name(const void *a, const void *b)
+static char* _icd_dbus_encap_key(int type, const char *host_address,
+		const char *uri_path)
 {
-	const icd_dbus_client_s *client = a;
+	return g_strdup_printf("%d%s%s", type, host_address, uri_path);
+}
+
 
-	return g_strcmp0(client->bus_name, b);
+static void _icd_dbus_client_free(icd_dbus_client_s *client)
+{
+	g_hash_table_destroy(client->resource_table);
+	g_hash_table_destroy(client->presence_table);
+	g_hash_table_destroy(client->observe_table);
+	g_hash_table_destroy(client->encap_table);
+	free(client->bus_name);
+	free(client);
 }
 
 
-static inline GList* _icd_dbus_client_list_find_client(const gchar *owner)
+static int _icd_dbus_client_list_cleanup_handle_list(icd_dbus_client_s *client)
 {
-	return g_list_find_custom(icd_dbus_client_list, owner,
-			_icd_dbus_client_list_compare_bus_name);
+	FN_CALL;
+	GList *cur, *handles;
+
+	RETV_IF(NULL == client, IOTCON_ERROR_INVALID_PARAMETER);
+
+	/* resource list */
+	handles = g_hash_table_get_values(client->resource_table);
+	g_hash_table_steal_all(client->resource_table);
+	g_list_free_full(handles, _icd_dbus_cleanup_resource_list);
+	/* presence list */
+	handles = g_hash_table_get_values(client->presence_table);
+	g_hash_table_steal_all(client->presence_table);
+	g_list_free_full(handles, _icd_dbus_cleanup_presence_list);
+	/* observe list */
+	handles = g_hash_table_get_keys(client->observe_table);
+	g_hash_table_steal_all(client->observe_table);
+	for (cur = handles; cur; cur = cur->next)
+		_icd_dbus_cleanup_observe_list(cur->data);
+	g_list_free(handles);
+	/* encapsulation list */
+	handles = g_hash_table_get_values(client->encap_table);
+	g_hash_table_steal_all(client->encap_table);
+	g_list_free_full(handles, _icd_dbus_cleanup_encap_list);
+
+	_icd_dbus_client_free(client);
+
+	return IOTCON_ERROR_NONE;
 }
 
 
+/* MUST be called with the writer lock */
 static int _icd_dbus_client_list_get_client(const gchar *bus_name,
 		icd_dbus_client_s **ret_client)
 {
-	GList *found_client = NULL;
 	icd_dbus_client_s *client = NULL;
 
 	RETV_IF(NULL == bus_name, IOTCON_ERROR_INVALID_PARAMETER);
 	RETV_IF(NULL == ret_client, IOTCON_ERROR_INVALID_PARAMETER);
 
-	found_client = _icd_dbus_client_list_find_client(bus_name);
-	if (found_client) {
-		*ret_client = found_client->data;
+	client = g_hash_table_lookup(icd_dbus_client_table, bus_name);
+	if (client) {
+		*ret_client = client;
 		return IOTCON_ERROR_NONE;
 	}
 
@@ -294,14 +543,123 @@ static int _icd_dbus_client_list_get_client(const gchar *bus_name,
 		return IOTCON_ERROR_OUT_OF_MEMORY;
 	}
 
+	client->resource_table = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+			free);
+	client->presence_table = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+			_icd_dbus_free_presence_handle);
+	client->observe_table = g_hash_table_new(g_direct_hash, g_direct_equal);
+	client->encap_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+			_icd_dbus_free_encap_handle);
+
 	DBG("new client(%s) added", bus_name);
-	icd_dbus_client_list = g_list_append(icd_dbus_client_list, client);
+	g_hash_table_insert(icd_dbus_client_table, client->bus_name, client);
 	*ret_client = client;
 
 	return IOTCON_ERROR_NONE;
 }
 
 
+static gboolean _icd_dbus_resource_table_remove_client(gpointer key, gpointer value,
+		gpointer user_data)
+{
+	icd_resource_handle_s *resource_handle = value;
+
+	return (resource_handle->client == user_data);
+}
+
+
+/* MUST be called with the writer lock */
+static void _icd_dbus_presence_table_remove(icd_presence_handle_s *presence_handle)
+{
+	GPtrArray *subscribers;
+
+	subscribers = g_hash_table_lookup(icd_dbus_presence_table, presence_handle->handle);
+	if (NULL == subscribers)
+		return;
+
+	g_ptr_array_remove_fast(subscribers, presence_handle);
+	if (0 == subscribers->len)
+		g_hash_table_remove(icd_dbus_presence_table, presence_handle->handle);
+}
+
+
+static gboolean _icd_dbus_p2p_pending_remove_cb(gpointer key, gpointer value,
+		gpointer user_data)
+{
+	return (IC_STR_EQUAL == g_strcmp0(value, user_data));
+}
+
+
+static void _icd_dbus_p2p_remove(const char *bus_name)
+{
+	GDBusConnection *conn;
+
+	/* the handshake which is not connected */
+	g_mutex_lock(&icd_dbus_p2p_mutex);
+	if (icd_dbus_p2p_pending_table)
+		g_hash_table_foreach_remove(icd_dbus_p2p_pending_table,
+				_icd_dbus_p2p_pending_remove_cb, (gpointer)bus_name);
+	g_mutex_unlock(&icd_dbus_p2p_mutex);
+
+	conn = _icd_dbus_p2p_get_connection(bus_name);
+	if (NULL == conn)
+		return;
+
+	/* the closed signal removes the connection from the table */
+	g_dbus_connection_close(conn, NULL, NULL, NULL);
+	g_object_unref(conn);
+}
+
+
+static void _icd_dbus_ring_free(gpointer data)
+{
+	icd_dbus_ring_s *ring = data;
+
+	if (ring->notify_source)
+		g_source_remove(ring->notify_source);
+	ic_ring_destroy(ring->notify_ring);
+	ic_ring_destroy(ring->signal_ring);
+	free(ring);
+}
+
+
+static void _icd_dbus_ring_remove(const char *bus_name)
+{
+	g_mutex_lock(&icd_dbus_ring_mutex);
+	if (icd_dbus_ring_table)
+		g_hash_table_remove(icd_dbus_ring_table, bus_name);
+	g_mutex_unlock(&icd_dbus_ring_mutex);
+}
+
+
+static void _icd_dbus_wire_remove(const char *bus_name)
+{
+	g_mutex_lock(&icd_dbus_wire_mutex);
+	if (icd_dbus_wire_table)
+		g_hash_table_remove(icd_dbus_wire_table, bus_name);
+	g_mutex_unlock(&icd_dbus_wire_mutex);
+}
+
+
+/* the wire version of the representations to the client */
+int icd_dbus_get_wire_version(const char *bus_name)
+{
+	gpointer version = NULL;
+
+	RETV_IF(NULL == bus_name, IC_WIRE_VERSION_1);
+
+	g_mutex_lock(&icd_dbus_wire_mutex);
+	if (icd_dbus_wire_table)
+		version = g_hash_table_lookup(icd_dbus_wire_table, bus_name);
+	g_mutex_unlock(&icd_dbus_wire_mutex);
+
+	if (NULL == version)
+		return IC_WIRE_VERSION_1;
+
+	return GPOINTER_TO_INT(version);
+}
+
+
 static void _icd_dbus_name_owner_changed_cb(GDBusConnection *conn,
 		const gchar *sender_name,
 		const gchar *object_path,
@@ -311,19 +669,32 @@ static void _icd_dbus_name_owner_changed_cb(GDBusConnection *conn,
 		gpointer user_data)
 {
 	int ret;
-	GList *client = NULL;
+	GHashTableIter iter;
+	gpointer presence_handle;
+	icd_dbus_client_s *client = NULL;
 	gchar *name, *old_owner, *new_owner;
 
 	g_variant_get(parameters, "(&s&s&s)", &name, &old_owner, &new_owner);
 
 	if (0 == strlen(new_owner)) {
-		g_mutex_lock(&icd_dbus_client_list_mutex);
-		client = _icd_dbus_client_list_find_client(old_owner);
+		_icd_dbus_p2p_remove(old_owner);
+		_icd_dbus_ring_remove(old_owner);
+		_icd_dbus_wire_remove(old_owner);
+		icd_blob_remove_client(old_owner);
+
+		g_rw_lock_writer_lock(&icd_dbus_client_table_lock);
+		client = g_hash_table_lookup(icd_dbus_client_table, old_owner);
 		if (client) { /* found bus name in our bus list */
 			DBG("bus(%s) stopped", old_owner);
-			icd_dbus_client_list = g_list_remove_link(icd_dbus_client_list, client);
+			g_hash_table_steal(icd_dbus_client_table, old_owner);
+			if (g_hash_table_size(client->resource_table))
+				g_hash_table_foreach_remove(icd_dbus_resource_table,
+						_icd_dbus_resource_table_remove_client, client);
+			g_hash_table_iter_init(&iter, client->presence_table);
+			while (g_hash_table_iter_next(&iter, NULL, &presence_handle))
+				_icd_dbus_presence_table_remove(presence_handle);
 		}
-		g_mutex_unlock(&icd_dbus_client_list_mutex);
+		g_rw_lock_writer_unlock(&icd_dbus_client_table_lock);
 
 		if (client) {
 			ret = _icd_dbus_client_list_cleanup_handle_list(client);
@@ -375,93 +746,106 @@ static int _icd_dbus_resource_list_add(const gchar *bus_name, OCResourceHandle h
 	resource_handle->handle = handle;
 	resource_handle->signal_number = signal_number;
 
-	g_mutex_lock(&icd_dbus_client_list_mutex);
+	g_rw_lock_writer_lock(&icd_dbus_client_table_lock);
 	ret = _icd_dbus_client_list_get_client(bus_name, &client);
 	if (IOTCON_ERROR_NONE != ret) {
 		ERR("_icd_dbus_client_list_get_client() Fail");
 		free(resource_handle);
-		g_mutex_unlock(&icd_dbus_client_list_mutex);
+		g_rw_lock_writer_unlock(&icd_dbus_client_table_lock);
 		return ret;
 	}
 
 	DBG("Resource handle added in the client(%s)", bus_name);
 	DBG_HANDLE(handle);
 
-	client->resource_list = g_list_append(client->resource_list, resource_handle);
+	resource_handle->client = client;
+	g_hash_table_replace(client->resource_table, handle, resource_handle);
+	g_hash_table_replace(icd_dbus_resource_table, handle, resource_handle);
 
-	g_mutex_unlock(&icd_dbus_client_list_mutex);
+	g_rw_lock_writer_unlock(&icd_dbus_client_table_lock);
 	return IOTCON_ERROR_NONE;
 }
 
 
 static void _icd_dbus_resource_list_remove(const gchar *bus_name, OCResourceHandle handle)
 {
-	GList *cur_hd;
-	GList *client_list = NULL;
 	icd_dbus_client_s *client = NULL;
-	icd_resource_handle_s *resource_handle;
 
-	g_mutex_lock(&icd_dbus_client_list_mutex);
-	client_list = _icd_dbus_client_list_find_client(bus_name);
-	if (NULL == client_list) {
-		ERR("_icd_dbus_client_list_find_client() Fail");
-		g_mutex_unlock(&icd_dbus_client_list_mutex);
+	g_rw_lock_writer_lock(&icd_dbus_client_table_lock);
+	client = g_hash_table_lookup(icd_dbus_client_table, bus_name);
+	if (NULL == client) {
+		ERR("g_hash_table_lookup() Fail");
+		g_rw_lock_writer_unlock(&icd_dbus_client_table_lock);
 		return;
 	}
 
-	client = client_list->data;
-	cur_hd = client->resource_list;
-	while (cur_hd) {
-		resource_handle = cur_hd->data;
-
-		if (resource_handle->handle == handle) {
-			DBG("Resource handle is removed");
-			DBG_HANDLE(handle);
-			client->resource_list = g_list_delete_link(client->resource_list, cur_hd);
-			free(resource_handle);
-			g_mutex_unlock(&icd_dbus_client_list_mutex);
-			return;
-		}
-		cur_hd = cur_hd->next;
+	if (g_hash_table_contains(client->resource_table, handle)) {
+		DBG("Resource handle is removed");
+		DBG_HANDLE(handle);
+		g_hash_table_remove(icd_dbus_resource_table, handle);
+		g_hash_table_remove(client->resource_table, handle);
 	}
-	g_mutex_unlock(&icd_dbus_client_list_mutex);
+	g_rw_lock_writer_unlock(&icd_dbus_client_table_lock);
 }
 
 
 static int _icd_dbus_presence_list_add(const gchar *bus_name,
-		OCDoHandle handle, const char *host_address)
+		OCDoHandle handle, const char *host_address, const char *resource_type)
 {
 	int ret;
+	GPtrArray *subscribers;
 	icd_dbus_client_s *client = NULL;
 	icd_presence_handle_s *presence_handle;
 
 	RETV_IF(NULL == bus_name, IOTCON_ERROR_INVALID_PARAMETER);
 	RETV_IF(NULL == handle, IOTCON_ERROR_INVALID_PARAMETER);
 
+	g_rw_lock_writer_lock(&icd_dbus_client_table_lock);
+	ret = _icd_dbus_client_list_get_client(bus_name, &client);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("_icd_dbus_client_list_get_client() Fail(%d)", ret);
+		g_rw_lock_writer_unlock(&icd_dbus_client_table_lock);
+		return ret;
+	}
+
+	presence_handle = g_hash_table_lookup(client->presence_table, handle);
+	if (presence_handle) {
+		/* The client filters again, so widen the filter on a different type */
+		if (presence_handle->resource_type && (NULL == resource_type
+				|| IC_STR_EQUAL != strcmp(presence_handle->resource_type, resource_type))) {
+			free(presence_handle->resource_type);
+			presence_handle->resource_type = NULL;
+		}
+		presence_handle->count++;
+		g_rw_lock_writer_unlock(&icd_dbus_client_table_lock);
+		return IOTCON_ERROR_NONE;
+	}
+
 	presence_handle = calloc(1, sizeof(icd_presence_handle_s));
 	if (NULL == presence_handle) {
 		ERR("calloc(handle) Fail(%d)", errno);
+		g_rw_lock_writer_unlock(&icd_dbus_client_table_lock);
 		return IOTCON_ERROR_OUT_OF_MEMORY;
 	}
 	presence_handle->handle = handle;
 	presence_handle->host_address = ic_utils_strdup(host_address);
-
-	g_mutex_lock(&icd_dbus_client_list_mutex);
-	ret = _icd_dbus_client_list_get_client(bus_name, &client);
-	if (IOTCON_ERROR_NONE != ret) {
-		ERR("_icd_dbus_client_list_get_client() Fail(%d)", ret);
-		free(presence_handle->host_address);
-		free(presence_handle);
-		g_mutex_unlock(&icd_dbus_client_list_mutex);
-		return ret;
-	}
+	presence_handle->resource_type = ic_utils_strdup(resource_type);
+	presence_handle->count = 1;
+	presence_handle->client = client;
 
 	DBG("Presence handle added in the client(%s)", bus_name);
 	DBG_HANDLE(handle);
 
-	client->presence_list = g_list_append(client->presence_list, presence_handle);
+	g_hash_table_insert(client->presence_table, handle, presence_handle);
+
+	subscribers = g_hash_table_lookup(icd_dbus_presence_table, handle);
+	if (NULL == subscribers) {
+		subscribers = g_ptr_array_new();
+		g_hash_table_insert(icd_dbus_presence_table, handle, subscribers);
+	}
+	g_ptr_array_add(subscribers, presence_handle);
 
-	g_mutex_unlock(&icd_dbus_client_list_mutex);
+	g_rw_lock_writer_unlock(&icd_dbus_client_table_lock);
 	return IOTCON_ERROR_NONE;
 }
 
@@ -469,36 +853,25 @@ static int _icd_dbus_presence_list_add(const gchar *bus_name,
 static void _icd_dbus_presence_list_remove(const gchar *bus_name,
 		OCDoHandle handle)
 {
-	GList *cur_hd;
-	GList *client_list = NULL;
 	icd_dbus_client_s *client = NULL;
 	icd_presence_handle_s *presence_handle;
 
-	g_mutex_lock(&icd_dbus_client_list_mutex);
-	client_list = _icd_dbus_client_list_find_client(bus_name);
-	if (NULL == client_list) {
-		ERR("_icd_dbus_client_list_find_client() Fail");
-		g_mutex_unlock(&icd_dbus_client_list_mutex);
+	g_rw_lock_writer_lock(&icd_dbus_client_table_lock);
+	client = g_hash_table_lookup(icd_dbus_client_table, bus_name);
+	if (NULL == client) {
+		ERR("g_hash_table_lookup() Fail");
+		g_rw_lock_writer_unlock(&icd_dbus_client_table_lock);
 		return;
 	}
 
-	client = client_list->data;
-	cur_hd = client->presence_list;
-	while (cur_hd) {
-		presence_handle = cur_hd->data;
-
-		if (presence_handle->handle == handle) {
-			DBG("Presence handle is removed");
-			DBG_HANDLE(handle);
-			client->presence_list = g_list_delete_link(client->presence_list, cur_hd);
-			free(presence_handle->host_address);
-			free(presence_handle);
-			g_mutex_unlock(&icd_dbus_client_list_mutex);
-			return;
-		}
-		cur_hd = cur_hd->next;
+	presence_handle = g_hash_table_lookup(client->presence_table, handle);
+	if (presence_handle && 0 == --presence_handle->count) {
+		DBG("Presence handle is removed");
+		DBG_HANDLE(handle);
+		_icd_dbus_presence_table_remove(presence_handle);
+		g_hash_table_remove(client->presence_table, handle);
 	}
-	g_mutex_unlock(&icd_dbus_client_list_mutex);
+	g_rw_lock_writer_unlock(&icd_dbus_client_table_lock);
 }
 
 
@@ -510,20 +883,20 @@ static int _icd_dbus_observe_list_add(const gchar *bus_name, OCDoHandle handle)
 	RETV_IF(NULL == bus_name, IOTCON_ERROR_INVALID_PARAMETER);
 	RETV_IF(NULL == handle, IOTCON_ERROR_INVALID_PARAMETER);
 
-	g_mutex_lock(&icd_dbus_client_list_mutex);
+	g_rw_lock_writer_lock(&icd_dbus_client_table_lock);
 	ret = _icd_dbus_client_list_get_client(bus_name, &client);
 	if (IOTCON_ERROR_NONE != ret) {
 		ERR("_icd_dbus_client_list_get_client() Fail(%d)", ret);
-		g_mutex_unlock(&icd_dbus_client_list_mutex);
+		g_rw_lock_writer_unlock(&icd_dbus_client_table_lock);
 		return ret;
 	}
 
 	DBG("Observe handle added in the client(%s)", bus_name);
 	DBG_HANDLE(handle);
 
-	client->observe_list = g_list_append(client->observe_list, handle);
+	g_hash_table_add(client->observe_table, handle);
 
-	g_mutex_unlock(&icd_dbus_client_list_mutex);
+	g_rw_lock_writer_unlock(&icd_dbus_client_table_lock);
 	return IOTCON_ERROR_NONE;
 }
 
@@ -531,110 +904,106 @@ static int _icd_dbus_observe_list_add(const gchar *bus_name, OCDoHandle handle)
 static void _icd_dbus_observe_list_remove(const gchar *bus_name,
 		OCDoHandle handle)
 {
-	GList *cur_hd;
-	GList *client_list = NULL;
-	OCDoHandle observe_handle;
 	icd_dbus_client_s *client = NULL;
 
-	g_mutex_lock(&icd_dbus_client_list_mutex);
-	client_list = _icd_dbus_client_list_find_client(bus_name);
-	if (NULL == client_list) {
-		ERR("_icd_dbus_client_list_find_client() Fail");
-		g_mutex_unlock(&icd_dbus_client_list_mutex);
+	g_rw_lock_writer_lock(&icd_dbus_client_table_lock);
+	client = g_hash_table_lookup(icd_dbus_client_table, bus_name);
+	if (NULL == client) {
+		ERR("g_hash_table_lookup() Fail");
+		g_rw_lock_writer_unlock(&icd_dbus_client_table_lock);
 		return;
 	}
 
-	client = client_list->data;
-	cur_hd = client->observe_list;
-	while (cur_hd) {
-		observe_handle = cur_hd->data;
-
-		if (observe_handle == handle) {
-			DBG("Observe handle is removed");
-			DBG_HANDLE(handle);
-			client->observe_list = g_list_delete_link(client->observe_list, cur_hd);
-			g_mutex_unlock(&icd_dbus_client_list_mutex);
-			return;
-		}
-		cur_hd = cur_hd->next;
+	if (g_hash_table_remove(client->observe_table, handle)) {
+		DBG("Observe handle is removed");
+		DBG_HANDLE(handle);
 	}
-	g_mutex_unlock(&icd_dbus_client_list_mutex);
+	g_rw_lock_writer_unlock(&icd_dbus_client_table_lock);
 }
 
 
 static int _icd_dbus_encap_list_add(const gchar *bus_name, int type,
-		const char *host_address, const char *uri_path)
+		const char *host_address, const char *uri_path, bool delta)
 {
 	int ret;
+	char *key;
 	icd_dbus_client_s *client = NULL;
 	icd_encap_handle_s *encap_handle;
 
 	RETV_IF(NULL == bus_name, IOTCON_ERROR_INVALID_PARAMETER);
 
-	encap_handle = calloc(1, sizeof(icd_encap_handle_s));
-	if (NULL == encap_handle) {
-		ERR("calloc(handle) Fail(%d)", errno);
-		return IOTCON_ERROR_OUT_OF_MEMORY;
-	}
-	encap_handle->type = type;
-	encap_handle->host_address = ic_utils_strdup(host_address);
-	encap_handle->uri_path = ic_utils_strdup(uri_path);
-
-	g_mutex_lock(&icd_dbus_client_list_mutex);
+	g_rw_lock_writer_lock(&icd_dbus_client_table_lock);
 	ret = _icd_dbus_client_list_get_client(bus_name, &client);
 	if (IOTCON_ERROR_NONE != ret) {
 		ERR("_icd_dbus_client_list_get_client() Fail(%d)", ret);
-		free(encap_handle->uri_path);
-		free(encap_handle->host_address);
-		free(encap_handle);
-		g_mutex_unlock(&icd_dbus_client_list_mutex);
+		g_rw_lock_writer_unlock(&icd_dbus_client_table_lock);
 		return ret;
 	}
 
-	DBG("encap info added in the client(%s)", bus_name);
+	key = _icd_dbus_encap_key(type, host_address, uri_path);
+	encap_handle = g_hash_table_lookup(client->encap_table, key);
+	if (encap_handle) {
+		encap_handle->count++;
+		g_free(key);
+	} else {
+		encap_handle = calloc(1, sizeof(icd_encap_handle_s));
+		if (NULL == encap_handle) {
+			ERR("calloc(handle) Fail(%d)", errno);
+			g_free(key);
+			g_rw_lock_writer_unlock(&icd_dbus_client_table_lock);
+			return IOTCON_ERROR_OUT_OF_MEMORY;
+		}
+		encap_handle->type = type;
+		encap_handle->host_address = ic_utils_strdup(host_address);
+		encap_handle->uri_path = ic_utils_strdup(uri_path);
+		encap_handle->count = 1;
+		encap_handle->client = client;
+
+		DBG("encap info added in the client(%s)", bus_name);
+		g_hash_table_insert(client->encap_table, key, encap_handle);
+	}
+	if (delta)
+		encap_handle->delta_count++;
 
-	client->encap_list = g_list_append(client->encap_list, encap_handle);
+	icd_ioty_encap_add_client(type, uri_path, host_address, bus_name, delta);
 
-	g_mutex_unlock(&icd_dbus_client_list_mutex);
+	g_rw_lock_writer_unlock(&icd_dbus_client_table_lock);
 	return IOTCON_ERROR_NONE;
 }
 
 
 static void _icd_dbus_encap_list_remove(const gchar *bus_name, int type,
-		const char *host_address, const char *uri_path)
+		const char *host_address, const char *uri_path, bool delta)
 {
-	GList *cur_hd;
-	GList *client_list = NULL;
+	char *key;
 	icd_dbus_client_s *client = NULL;
 	icd_encap_handle_s *encap_handle;
 
-	g_mutex_lock(&icd_dbus_client_list_mutex);
-	client_list = _icd_dbus_client_list_find_client(bus_name);
-	if (NULL == client_list) {
-		ERR("_icd_dbus_client_list_find_client() Fail");
-		g_mutex_unlock(&icd_dbus_client_list_mutex);
+	g_rw_lock_writer_lock(&icd_dbus_client_table_lock);
+	client = g_hash_table_lookup(icd_dbus_client_table, bus_name);
+	if (NULL == client) {
+		ERR("g_hash_table_lookup() Fail");
+		g_rw_lock_writer_unlock(&icd_dbus_client_table_lock);
 		return;
 	}
 
-	client = client_list->data;
-	cur_hd = client->encap_list;
-	while (cur_hd) {
-		encap_handle = cur_hd->data;
-
-		if (type == encap_handle->type
-				&& IC_STR_EQUAL == g_strcmp0(encap_handle->host_address, host_address)
-				&& IC_STR_EQUAL == g_strcmp0(encap_handle->uri_path, uri_path)) {
+	key = _icd_dbus_encap_key(type, host_address, uri_path);
+	encap_handle = g_hash_table_lookup(client->encap_table, key);
+	if (encap_handle) {
+		if (0 == encap_handle->delta_count)
+			delta = false;
+		if (delta)
+			encap_handle->delta_count--;
+		icd_ioty_encap_remove_client(type, uri_path, host_address, bus_name, 1,
+				delta ? 1 : 0);
+		if (0 == --encap_handle->count) {
+			g_hash_table_remove(client->encap_table, key);
 			DBG("encap info(%s, %s) removed", host_address, uri_path);
-			client->encap_list = g_list_delete_link(client->encap_list, cur_hd);
-			free(encap_handle->uri_path);
-			free(encap_handle->host_address);
-			free(encap_handle);
-			g_mutex_unlock(&icd_dbus_client_list_mutex);
-			return;
 		}
-		cur_hd = cur_hd->next;
 	}
-	g_mutex_unlock(&icd_dbus_client_list_mutex);
+	g_free(key);
+
+	g_rw_lock_writer_unlock(&icd_dbus_client_table_lock);
 }
 
 
@@ -663,7 +1032,7 @@ static gboolean _dbus_handle_register_resource(icDbus *object,
 
 	handle = icd_ioty_register_resource(uri_path, resource_types, ifaces, properties);
 	if (handle) {
-		sender = g_dbus_method_invocation_get_sender(invocation);
+		sender = icd_dbus_get_sender(invocation);
 
 		signal_number = icd_dbus_generate_signal_number();
 		ret = _icd_dbus_resource_list_add(sender, handle, signal_number);
@@ -693,7 +1062,7 @@ static gboolean _dbus_handle_unregister_resource(icDbus *object,
 	int ret;
 	const gchar *sender;
 
-	sender = g_dbus_method_invocation_get_sender(invocation);
+	sender = icd_dbus_get_sender(invocation);
 	_icd_dbus_resource_list_remove(sender, ICD_INT64_TO_POINTER(resource));
 
 	ret = icd_cynara_check_network(invocation);
@@ -824,14 +1193,14 @@ static gboolean _dbus_handle_find_resource(icDbus *object,
 		return TRUE;
 	}
 
-	sender = g_dbus_method_invocation_get_sender(invocation);
+	sender = icd_dbus_get_sender(invocation);
 
-	ret = icd_ioty_find_resource(host_address, connectivity, type, is_secure, timeout,
-			signal_number, sender);
-	if (IOTCON_ERROR_NONE != ret)
+	ret = icd_ioty_find_resource(invocation, host_address, connectivity, type, is_secure,
+			timeout, signal_number, sender);
+	if (IOTCON_ERROR_NONE != ret) {
 		ERR("icd_ioty_find_resource() Fail(%d)", ret);
-
-	ic_dbus_complete_find_resource(object, invocation, signal_number, ret);
+		ic_dbus_complete_find_resource(object, invocation, signal_number, ret);
+	}
 
 	return TRUE;
 }
@@ -858,7 +1227,7 @@ static gboolean _dbus_handle_observer_start(icDbus *object,
 		return TRUE;
 	}
 
-	sender = g_dbus_method_invocation_get_sender(invocation);
+	sender = icd_dbus_get_sender(invocation);
 
 	observe_h = icd_ioty_observer_start(resource, observe_policy, query,
 			signal_number, sender);
@@ -900,7 +1269,7 @@ static gboolean _dbus_handle_observer_stop(icDbus *object,
 		return TRUE;
 	}
 
-	sender = g_dbus_method_invocation_get_sender(invocation);
+	sender = icd_dbus_get_sender(invocation);
 	_icd_dbus_observe_list_remove(sender, ICD_INT64_TO_POINTER(observe_h));
 
 	ret = icd_ioty_observer_stop(ICD_INT64_TO_POINTER(observe_h), options);
@@ -931,11 +1300,12 @@ static gboolean _dbus_handle_notify(icDbus *object,
 		return TRUE;
 	}
 
-	ret = icd_ioty_notify(ICD_INT64_TO_POINTER(resource), notify_msg, observers, qos);
-	if (IOTCON_ERROR_NONE != ret)
+	ret = icd_ioty_notify(invocation, ICD_INT64_TO_POINTER(resource), notify_msg,
+			observers, qos);
+	if (IOTCON_ERROR_NONE != ret) {
 		ERR("icd_ioty_notify() Fail(%d)", ret);
-
-	ic_dbus_complete_notify(object, invocation, ret);
+		ic_dbus_complete_notify(object, invocation, ret);
+	}
 
 	return TRUE;
 }
@@ -953,11 +1323,11 @@ static gboolean _dbus_handle_send_response(icDbus *object,
 		return TRUE;
 	}
 
-	ret = icd_ioty_send_response(response);
-	if (IOTCON_ERROR_NONE != ret)
+	ret = icd_ioty_send_response(invocation, response);
+	if (IOTCON_ERROR_NONE != ret) {
 		ERR("icd_ioty_send_response() Fail(%d)", ret);
-
-	ic_dbus_complete_send_response(object, invocation, ret);
+		ic_dbus_complete_send_response(object, invocation, ret);
+	}
 
 	return TRUE;
 }
@@ -981,14 +1351,14 @@ static gboolean _dbus_handle_get_device_info(icDbus *object,
 		return TRUE;
 	}
 
-	sender = g_dbus_method_invocation_get_sender(invocation);
+	sender = icd_dbus_get_sender(invocation);
 
-	ret = icd_ioty_get_info(ICD_DEVICE_INFO, host_address, connectivity, timeout,
-			signal_number, sender);
-	if (IOTCON_ERROR_NONE != ret)
+	ret = icd_ioty_get_info(invocation, ICD_DEVICE_INFO, host_address, connectivity,
+			timeout, signal_number, sender);
+	if (IOTCON_ERROR_NONE != ret) {
 		ERR("icd_ioty_get_info(device info) Fail(%d)", ret);
-
-	ic_dbus_complete_get_device_info(object, invocation, signal_number, ret);
+		ic_dbus_complete_get_device_info(object, invocation, signal_number, ret);
+	}
 
 	return TRUE;
 }
@@ -1012,14 +1382,14 @@ static gboolean _dbus_handle_get_platform_info(icDbus *object,
 		return TRUE;
 	}
 
-	sender = g_dbus_method_invocation_get_sender(invocation);
+	sender = icd_dbus_get_sender(invocation);
 
-	ret = icd_ioty_get_info(ICD_PLATFORM_INFO, host_address, connectivity, timeout,
-			signal_number, sender);
-	if (IOTCON_ERROR_NONE != ret)
+	ret = icd_ioty_get_info(invocation, ICD_PLATFORM_INFO, host_address, connectivity,
+			timeout, signal_number, sender);
+	if (IOTCON_ERROR_NONE != ret) {
 		ERR("icd_ioty_get_info(platform info) Fail(%d)", ret);
-
-	ic_dbus_complete_get_platform_info(object, invocation, signal_number, ret);
+		ic_dbus_complete_get_platform_info(object, invocation, signal_number, ret);
+	}
 
 	return TRUE;
 }
@@ -1091,9 +1461,10 @@ static gboolean _dbus_handle_subscribe_presence(icDbus *object,
 	presence_h = icd_ioty_subscribe_presence(ICD_PRESENCE, host_address, connectivity,
 			type, NULL);
 	if (presence_h) {
-		sender = g_dbus_method_invocation_get_sender(invocation);
+		sender = icd_dbus_get_sender(invocation);
 
-		ret = _icd_dbus_presence_list_add(sender, presence_h, host_address);
+		ret = _icd_dbus_presence_list_add(sender, presence_h, host_address,
+				ic_utils_dbus_decode_str((char *)type));
 		if (IOTCON_ERROR_NONE != ret) {
 			ERR("_icd_dbus_presence_list_add() Fail(%d)", ret);
 
@@ -1129,7 +1500,7 @@ static gboolean _dbus_handle_unsubscribe_presence(icDbus *object,
 		return TRUE;
 	}
 
-	sender = g_dbus_method_invocation_get_sender(invocation);
+	sender = icd_dbus_get_sender(invocation);
 	_icd_dbus_presence_list_remove(sender, ICD_INT64_TO_POINTER(presence_h));
 
 	ret = icd_ioty_unsubscribe_presence(ICD_INT64_TO_POINTER(presence_h), host_address);
@@ -1167,30 +1538,169 @@ static gboolean _dbus_handle_encap_set_time_interval(icDbus *object,
 }
 
 
-static gboolean _dbus_handle_start_monitoring(icDbus *object,
+static gboolean _dbus_handle_encap_set_poll_interval(icDbus *object,
 		GDBusMethodInvocation *invocation,
 		const gchar *uri_path,
 		const gchar *host_address,
-		gint connectivity)
+		guint min_interval,
+		guint max_interval)
 {
 	int ret;
-	const gchar *sender;
-	int64_t signal_number = 0;
 
 	ret = icd_cynara_check_network(invocation);
 	if (IOTCON_ERROR_NONE != ret) {
 		ERR("icd_cynara_check_network() Fail(%d)", ret);
-		ic_dbus_complete_start_monitoring(object, invocation, signal_number, ret);
+		ic_dbus_complete_encap_set_poll_interval(object, invocation, ret);
+		return TRUE;
+	}
+
+	ret = icd_ioty_encap_set_poll_interval(uri_path, host_address, min_interval,
+			max_interval);
+	if (IOTCON_ERROR_NONE != ret)
+		ERR("icd_ioty_encap_set_poll_interval() Fail(%d)", ret);
+
+	ic_dbus_complete_encap_set_poll_interval(object, invocation, ret);
+
+	return TRUE;
+}
+
+
+static gboolean _dbus_handle_encap_set_hysteresis(icDbus *object,
+		GDBusMethodInvocation *invocation,
+		const gchar *uri_path,
+		const gchar *host_address,
+		guint lost_count,
+		guint alive_count,
+		guint dwell_time)
+{
+	int ret;
+
+	ret = icd_cynara_check_network(invocation);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("icd_cynara_check_network() Fail(%d)", ret);
+		ic_dbus_complete_encap_set_hysteresis(object, invocation, ret);
+		return TRUE;
+	}
+
+	ret = icd_ioty_encap_set_hysteresis(uri_path, host_address, lost_count, alive_count,
+			dwell_time);
+	if (IOTCON_ERROR_NONE != ret)
+		ERR("icd_ioty_encap_set_hysteresis() Fail(%d)", ret);
+
+	ic_dbus_complete_encap_set_hysteresis(object, invocation, ret);
+
+	return TRUE;
+}
+
+
+static gboolean _dbus_handle_encap_set_history_size(icDbus *object,
+		GDBusMethodInvocation *invocation,
+		const gchar *uri_path,
+		const gchar *host_address,
+		guint size)
+{
+	int ret;
+
+	ret = icd_cynara_check_network(invocation);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("icd_cynara_check_network() Fail(%d)", ret);
+		ic_dbus_complete_encap_set_history_size(object, invocation, ret);
+		return TRUE;
+	}
+
+	ret = icd_ioty_encap_set_history_size(uri_path, host_address, size);
+	if (IOTCON_ERROR_NONE != ret)
+		ERR("icd_ioty_encap_set_history_size() Fail(%d)", ret);
+
+	ic_dbus_complete_encap_set_history_size(object, invocation, ret);
+
+	return TRUE;
+}
+
+
+static gboolean _dbus_handle_encap_resync_caching(icDbus *object,
+		GDBusMethodInvocation *invocation,
+		const gchar *uri_path,
+		const gchar *host_address)
+{
+	int ret;
+	const gchar *sender;
+
+	ret = icd_cynara_check_network(invocation);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("icd_cynara_check_network() Fail(%d)", ret);
+		ic_dbus_complete_encap_resync_caching(object, invocation, ret);
+		return TRUE;
+	}
+
+	sender = icd_dbus_get_sender(invocation);
+
+	ret = icd_ioty_ocprocess_encap_resync(uri_path, host_address, sender);
+	if (IOTCON_ERROR_NONE != ret)
+		ERR("icd_ioty_ocprocess_encap_resync() Fail(%d)", ret);
+
+	ic_dbus_complete_encap_resync_caching(object, invocation, ret);
+
+	return TRUE;
+}
+
+
+static gboolean _dbus_handle_encap_get_history(icDbus *object,
+		GDBusMethodInvocation *invocation,
+		const gchar *uri_path,
+		const gchar *host_address,
+		guint count,
+		gint64 since,
+		gint64 until)
+{
+	int ret;
+	GVariant *history = NULL;
+
+	ret = icd_cynara_check_network(invocation);
+	if (IOTCON_ERROR_NONE == ret) {
+		ret = icd_ioty_encap_get_history(uri_path, host_address, count, since, until,
+				&history);
+		if (IOTCON_ERROR_NONE != ret)
+			ERR("icd_ioty_encap_get_history() Fail(%d)", ret);
+	} else {
+		ERR("icd_cynara_check_network() Fail(%d)", ret);
+	}
+
+	if (NULL == history)
+		history = g_variant_new_array(G_VARIANT_TYPE("(xv)"), NULL, 0);
+	else
+		icd_blob_grant(history, icd_dbus_get_sender(invocation));
+
+	ic_dbus_complete_encap_get_history(object, invocation, history, ret);
+
+	return TRUE;
+}
+
+
+static gboolean _dbus_handle_start_monitoring(icDbus *object,
+		GDBusMethodInvocation *invocation,
+		const gchar *uri_path,
+		const gchar *host_address,
+		gint connectivity)
+{
+	int ret;
+	const gchar *sender;
+	int64_t signal_number = 0;
+
+	ret = icd_cynara_check_network(invocation);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("icd_cynara_check_network() Fail(%d)", ret);
+		ic_dbus_complete_start_monitoring(object, invocation, signal_number, ret);
 		return TRUE;
 	}
 
 	ret = icd_ioty_start_encap(ICD_ENCAP_MONITORING, uri_path, host_address, connectivity,
 			&signal_number);
 	if (IOTCON_ERROR_NONE == ret) {
-		sender = g_dbus_method_invocation_get_sender(invocation);
+		sender = icd_dbus_get_sender(invocation);
 
 		ret = _icd_dbus_encap_list_add(sender, ICD_ENCAP_MONITORING, host_address,
-				uri_path);
+				uri_path, false);
 		if (IOTCON_ERROR_NONE != ret) {
 			ERR("_icd_dbus_encap_list_add() Fail(%d)", ret);
 
@@ -1227,8 +1737,9 @@ static gboolean _dbus_handle_stop_monitoring(icDbus *object,
 
 	ret = icd_ioty_stop_encap(ICD_ENCAP_MONITORING, uri_path, host_address);
 	if (IOTCON_ERROR_NONE == ret) {
-		sender = g_dbus_method_invocation_get_sender(invocation);
-		_icd_dbus_encap_list_remove(sender, ICD_ENCAP_MONITORING, host_address, uri_path);
+		sender = icd_dbus_get_sender(invocation);
+		_icd_dbus_encap_list_remove(sender, ICD_ENCAP_MONITORING, host_address, uri_path,
+				false);
 	} else {
 		ERR("icd_ioty_stop_encap() Fail(%d)", ret);
 	}
@@ -1243,7 +1754,8 @@ static gboolean _dbus_handle_start_caching(icDbus *object,
 		GDBusMethodInvocation *invocation,
 		const gchar *uri_path,
 		const gchar *host_address,
-		gint connectivity)
+		gint connectivity,
+		gboolean delta)
 {
 	int ret;
 	const gchar *sender;
@@ -1259,9 +1771,10 @@ static gboolean _dbus_handle_start_caching(icDbus *object,
 	ret = icd_ioty_start_encap(ICD_ENCAP_CACHING, uri_path, host_address, connectivity,
 			&signal_number);
 	if (IOTCON_ERROR_NONE == ret) {
-		sender = g_dbus_method_invocation_get_sender(invocation);
+		sender = icd_dbus_get_sender(invocation);
 
-		ret = _icd_dbus_encap_list_add(sender, ICD_ENCAP_CACHING, host_address, uri_path);
+		ret = _icd_dbus_encap_list_add(sender, ICD_ENCAP_CACHING, host_address, uri_path,
+				delta);
 		if (IOTCON_ERROR_NONE != ret) {
 			ERR("_icd_dbus_encap_list_add() Fail(%d)", ret);
 
@@ -1284,7 +1797,8 @@ static gboolean _dbus_handle_start_caching(icDbus *object,
 static gboolean _dbus_handle_stop_caching(icDbus *object,
 		GDBusMethodInvocation *invocation,
 		const gchar *uri_path,
-		const gchar *host_address)
+		const gchar *host_address,
+		gboolean delta)
 {
 	int ret;
 	const gchar *sender;
@@ -1298,8 +1812,9 @@ static gboolean _dbus_handle_stop_caching(icDbus *object,
 
 	ret = icd_ioty_stop_encap(ICD_ENCAP_CACHING, uri_path, host_address);
 	if (IOTCON_ERROR_NONE == ret) {
-		sender = g_dbus_method_invocation_get_sender(invocation);
-		_icd_dbus_encap_list_remove(sender, ICD_ENCAP_CACHING, host_address, uri_path);
+		sender = icd_dbus_get_sender(invocation);
+		_icd_dbus_encap_list_remove(sender, ICD_ENCAP_CACHING, host_address, uri_path,
+				delta);
 	} else {
 		ERR("icd_ioty_stop_encap() Fail(%d)", ret);
 	}
@@ -1310,6 +1825,502 @@ static gboolean _dbus_handle_stop_caching(icDbus *object,
 }
 
 
+static int _icd_dbus_ring_notify(ic_ring_s *notify_ring)
+{
+	int ret;
+	gint qos;
+	gint64 resource;
+	GVariant *record, *notify_msg, *observers;
+
+	while (1) {
+		ret = ic_ring_read(notify_ring, G_VARIANT_TYPE(IC_RING_NOTIFY_TYPE), &record);
+		if (IOTCON_ERROR_NONE != ret) {
+			ERR("ic_ring_read() Fail(%d)", ret);
+			return ret;
+		}
+		if (NULL == record)
+			return IOTCON_ERROR_NONE;
+
+		g_variant_get(record, "(x@av@aii)", &resource, &notify_msg, &observers, &qos);
+
+		/* nobody waits for the result */
+		ret = icd_ioty_notify(NULL, ICD_INT64_TO_POINTER(resource), notify_msg,
+				observers, qos);
+		if (IOTCON_ERROR_NONE != ret)
+			ERR("icd_ioty_notify() Fail(%d)", ret);
+
+		g_variant_unref(observers);
+		g_variant_unref(notify_msg);
+		g_variant_unref(record);
+	}
+}
+
+
+static gboolean _icd_dbus_ring_notify_cb(gint fd, GIOCondition condition,
+		gpointer user_data)
+{
+	int ret;
+	icd_dbus_ring_s *ring = user_data;
+
+	ic_ring_clear_event(ring->notify_ring);
+
+	do {
+		ret = _icd_dbus_ring_notify(ring->notify_ring);
+		if (IOTCON_ERROR_NONE != ret) {
+			/* the ring is broken by the client. Stop reading it. */
+			ERR("_icd_dbus_ring_notify() Fail(%d)", ret);
+			ring->notify_source = 0;
+			return G_SOURCE_REMOVE;
+		}
+	} while (false == ic_ring_wait(ring->notify_ring));
+
+	return G_SOURCE_CONTINUE;
+}
+
+
+static icd_dbus_ring_s* _icd_dbus_ring_new()
+{
+	icd_dbus_ring_s *ring;
+
+	ring = calloc(1, sizeof(icd_dbus_ring_s));
+	if (NULL == ring) {
+		ERR("calloc() Fail(%d)", errno);
+		return NULL;
+	}
+
+	ring->signal_ring = ic_ring_create(IC_RING_SIGNAL_SIZE);
+	if (NULL == ring->signal_ring) {
+		ERR("ic_ring_create() Fail");
+		free(ring);
+		return NULL;
+	}
+
+	ring->notify_ring = ic_ring_create(IC_RING_NOTIFY_SIZE);
+	if (NULL == ring->notify_ring) {
+		ERR("ic_ring_create() Fail");
+		ic_ring_destroy(ring->signal_ring);
+		free(ring);
+		return NULL;
+	}
+
+	ring->notify_source = g_unix_fd_add(ic_ring_get_event_fd(ring->notify_ring),
+			G_IO_IN, _icd_dbus_ring_notify_cb, ring);
+
+	return ring;
+}
+
+
+/* The rings are created by the daemon, and the memory is sealed against shrinking.
+ * The client gets the fds of the rings and the eventfds. */
+static gboolean _dbus_handle_ring_open(icDbus *object,
+		GDBusMethodInvocation *invocation, GUnixFDList *fd_list)
+{
+	int ret;
+	const gchar *sender;
+	GError *error = NULL;
+	icd_dbus_ring_s *ring;
+	GUnixFDList *out_fd_list;
+
+	/* the notifications on the ring are not checked one by one */
+	ret = icd_cynara_check_network(invocation);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("icd_cynara_check_network() Fail(%d)", ret);
+		ic_dbus_complete_ring_open(object, invocation, NULL, 0, 0, 0, 0, ret);
+		return TRUE;
+	}
+
+	sender = icd_dbus_get_sender(invocation);
+	if (NULL == sender) {
+		ERR("Invalid sender");
+		ic_dbus_complete_ring_open(object, invocation, NULL, 0, 0, 0, 0,
+				IOTCON_ERROR_NOT_SUPPORTED);
+		return TRUE;
+	}
+
+	ring = _icd_dbus_ring_new();
+	if (NULL == ring) {
+		ERR("_icd_dbus_ring_new() Fail");
+		ic_dbus_complete_ring_open(object, invocation, NULL, 0, 0, 0, 0,
+				IOTCON_ERROR_NOT_SUPPORTED);
+		return TRUE;
+	}
+
+	out_fd_list = g_unix_fd_list_new();
+	if (g_unix_fd_list_append(out_fd_list, ic_ring_get_mem_fd(ring->signal_ring),
+				&error) < 0
+			|| g_unix_fd_list_append(out_fd_list, ic_ring_get_event_fd(ring->signal_ring),
+				&error) < 0
+			|| g_unix_fd_list_append(out_fd_list, ic_ring_get_mem_fd(ring->notify_ring),
+				&error) < 0
+			|| g_unix_fd_list_append(out_fd_list, ic_ring_get_event_fd(ring->notify_ring),
+				&error) < 0) {
+		ERR("g_unix_fd_list_append() Fail(%s)", error->message);
+		g_error_free(error);
+		g_object_unref(out_fd_list);
+		_icd_dbus_ring_free(ring);
+		ic_dbus_complete_ring_open(object, invocation, NULL, 0, 0, 0, 0,
+				IOTCON_ERROR_SYSTEM);
+		return TRUE;
+	}
+
+	/* the ring of the previous open is dropped */
+	g_mutex_lock(&icd_dbus_ring_mutex);
+	g_hash_table_replace(icd_dbus_ring_table, ic_utils_strdup(sender), ring);
+	g_mutex_unlock(&icd_dbus_ring_mutex);
+
+	ic_dbus_complete_ring_open(object, invocation, out_fd_list, 0, 1, 2, 3,
+			IOTCON_ERROR_NONE);
+	g_object_unref(out_fd_list);
+
+	return TRUE;
+}
+
+
+static gboolean _dbus_handle_ring_close(icDbus *object,
+		GDBusMethodInvocation *invocation)
+{
+	const gchar *sender;
+
+	sender = icd_dbus_get_sender(invocation);
+	if (sender)
+		_icd_dbus_ring_remove(sender);
+
+	ic_dbus_complete_ring_close(object, invocation, IOTCON_ERROR_NONE);
+
+	return TRUE;
+}
+
+
+/* The client received the RING signal, and every signal before it */
+static gboolean _dbus_handle_ring_resume(icDbus *object,
+		GDBusMethodInvocation *invocation)
+{
+	const gchar *sender;
+	icd_dbus_ring_s *ring = NULL;
+
+	sender = icd_dbus_get_sender(invocation);
+
+	g_mutex_lock(&icd_dbus_ring_mutex);
+	if (icd_dbus_ring_table && sender)
+		ring = g_hash_table_lookup(icd_dbus_ring_table, sender);
+	if (NULL == ring) {
+		g_mutex_unlock(&icd_dbus_ring_mutex);
+		ERR("No ring of bus(%s)", sender);
+		ic_dbus_complete_ring_resume(object, invocation, IOTCON_ERROR_NO_DATA);
+		return TRUE;
+	}
+	if (ring->drained) {
+		ring->fallback = false;
+		ring->drained = false;
+	}
+	g_mutex_unlock(&icd_dbus_ring_mutex);
+
+	ic_dbus_complete_ring_resume(object, invocation, IOTCON_ERROR_NONE);
+
+	return TRUE;
+}
+
+
+/* The client tells the highest wire version of representations, which it reads.
+ * Both sides send the agreed version, and read every version. */
+static gboolean _dbus_handle_negotiate_wire(icDbus *object,
+		GDBusMethodInvocation *invocation,
+		guint16 max_version)
+{
+	int version;
+	const gchar *sender;
+
+	version = MIN(max_version, IC_WIRE_VERSION_MAX);
+
+	sender = icd_dbus_get_sender(invocation);
+	if (NULL == sender || version < IC_WIRE_VERSION_1) {
+		ERR("Invalid sender or version(%d)", max_version);
+		ic_dbus_complete_negotiate_wire(object, invocation, IC_WIRE_VERSION_1);
+		return TRUE;
+	}
+
+	g_mutex_lock(&icd_dbus_wire_mutex);
+	g_hash_table_replace(icd_dbus_wire_table, ic_utils_strdup(sender),
+			GINT_TO_POINTER(version));
+	g_mutex_unlock(&icd_dbus_wire_mutex);
+
+	ic_dbus_complete_negotiate_wire(object, invocation, version);
+
+	return TRUE;
+}
+
+
+/* The sealed memfd of a large byte string, which the client will send */
+static gboolean _dbus_handle_blob_put(icDbus *object,
+		GDBusMethodInvocation *invocation,
+		GUnixFDList *fd_list,
+		gint blob,
+		guint64 length)
+{
+	int fd, ret;
+	uint64_t id = 0;
+	GError *error = NULL;
+
+	ret = icd_cynara_check_network(invocation);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("icd_cynara_check_network() Fail(%d)", ret);
+		ic_dbus_complete_blob_put(object, invocation, NULL, 0, ret);
+		return TRUE;
+	}
+
+	if (NULL == fd_list) {
+		ERR("No fd");
+		ic_dbus_complete_blob_put(object, invocation, NULL, 0,
+				IOTCON_ERROR_INVALID_PARAMETER);
+		return TRUE;
+	}
+
+	fd = g_unix_fd_list_get(fd_list, blob, &error);
+	if (fd < 0) {
+		ERR("g_unix_fd_list_get() Fail(%s)", error->message);
+		g_error_free(error);
+		ic_dbus_complete_blob_put(object, invocation, NULL, 0,
+				IOTCON_ERROR_INVALID_PARAMETER);
+		return TRUE;
+	}
+
+	ret = icd_blob_add(fd, length, icd_dbus_get_sender(invocation), &id);
+	if (IOTCON_ERROR_NONE != ret)
+		ERR("icd_blob_add() Fail(%d)", ret);
+
+	ic_dbus_complete_blob_put(object, invocation, NULL, id, ret);
+
+	return TRUE;
+}
+
+
+/* The sealed memfd of a large byte string in a representation from the daemon */
+static gboolean _dbus_handle_blob_get(icDbus *object,
+		GDBusMethodInvocation *invocation,
+		GUnixFDList *fd_list,
+		guint64 id,
+		guint64 length)
+{
+	int fd, ret;
+	GError *error = NULL;
+	GUnixFDList *out_fd_list;
+
+	ret = icd_cynara_check_network(invocation);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("icd_cynara_check_network() Fail(%d)", ret);
+		ic_dbus_complete_blob_get(object, invocation, NULL, 0, ret);
+		return TRUE;
+	}
+
+	ret = icd_blob_dup_fd(id, length, icd_dbus_get_sender(invocation), &fd);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("icd_blob_dup_fd() Fail(%d)", ret);
+		ic_dbus_complete_blob_get(object, invocation, NULL, 0, ret);
+		return TRUE;
+	}
+
+	out_fd_list = g_unix_fd_list_new();
+	if (g_unix_fd_list_append(out_fd_list, fd, &error) < 0) {
+		ERR("g_unix_fd_list_append() Fail(%s)", error->message);
+		g_error_free(error);
+		g_object_unref(out_fd_list);
+		close(fd);
+		ic_dbus_complete_blob_get(object, invocation, NULL, 0, IOTCON_ERROR_SYSTEM);
+		return TRUE;
+	}
+	close(fd);
+
+	ic_dbus_complete_blob_get(object, invocation, out_fd_list, 0, IOTCON_ERROR_NONE);
+	g_object_unref(out_fd_list);
+
+	return TRUE;
+}
+
+
+static void _icd_dbus_p2p_get_pid_cb(GObject *source, GAsyncResult *res,
+		gpointer user_data)
+{
+	guint pid;
+	GVariant *result;
+	const gchar *sender;
+	GError *error = NULL;
+	GDBusMethodInvocation *invocation = user_data;
+
+	result = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, &error);
+	if (NULL == result) {
+		ERR("g_dbus_connection_call_finish() Fail(%s)", error->message);
+		g_error_free(error);
+		ic_dbus_complete_p2p_connect(icd_dbus_get_object(), invocation, "",
+				IOTCON_ERROR_DBUS);
+		return;
+	}
+	g_variant_get(result, "(u)", &pid);
+	g_variant_unref(result);
+
+	sender = g_dbus_method_invocation_get_sender(invocation);
+
+	g_mutex_lock(&icd_dbus_p2p_mutex);
+	g_hash_table_replace(icd_dbus_p2p_pending_table, GUINT_TO_POINTER(pid),
+			ic_utils_strdup(sender));
+	g_mutex_unlock(&icd_dbus_p2p_mutex);
+
+	ic_dbus_complete_p2p_connect(icd_dbus_get_object(), invocation,
+			g_dbus_server_get_client_address(icd_dbus_p2p_server), IOTCON_ERROR_NONE);
+}
+
+
+/* The handshake on the system bus. The process of the sender is allowed to connect
+ * to the server, and its connection is bound to the bus name of the sender. */
+static gboolean _dbus_handle_p2p_connect(icDbus *object,
+		GDBusMethodInvocation *invocation)
+{
+	if (NULL == icd_dbus_p2p_server
+			|| NULL == g_dbus_method_invocation_get_sender(invocation)) {
+		ic_dbus_complete_p2p_connect(object, invocation, "", IOTCON_ERROR_NOT_SUPPORTED);
+		return TRUE;
+	}
+
+	g_dbus_connection_call(g_dbus_method_invocation_get_connection(invocation),
+			"org.freedesktop.DBus",
+			"/org/freedesktop/DBus",
+			"org.freedesktop.DBus",
+			"GetConnectionUnixProcessID",
+			g_variant_new("(s)", g_dbus_method_invocation_get_sender(invocation)),
+			G_VARIANT_TYPE("(u)"),
+			G_DBUS_CALL_FLAGS_NONE,
+			-1,
+			NULL,
+			_icd_dbus_p2p_get_pid_cb,
+			invocation);
+
+	return TRUE;
+}
+
+
+static gboolean _icd_dbus_p2p_authorize_cb(GDBusAuthObserver *observer,
+		GIOStream *stream, GCredentials *credentials, gpointer user_data)
+{
+	pid_t pid;
+	gboolean authorized = FALSE;
+
+	if (NULL == credentials)
+		return FALSE;
+
+	pid = g_credentials_get_unix_pid(credentials, NULL);
+	if (pid <= 0)
+		return FALSE;
+
+	g_mutex_lock(&icd_dbus_p2p_mutex);
+	if (g_hash_table_contains(icd_dbus_p2p_pending_table, GUINT_TO_POINTER(pid)))
+		authorized = TRUE;
+	g_mutex_unlock(&icd_dbus_p2p_mutex);
+
+	if (FALSE == authorized)
+		ERR("Unknown peer(%d)", pid);
+
+	return authorized;
+}
+
+
+static void _icd_dbus_p2p_closed_cb(GDBusConnection *conn, gboolean remote_peer_vanished,
+		GError *error, gpointer user_data)
+{
+	const char *bus_name;
+
+	bus_name = g_object_get_data(G_OBJECT(conn), ICD_DBUS_P2P_BUS_NAME);
+	DBG("bus(%s) disconnected", bus_name);
+
+	g_dbus_interface_skeleton_unexport_from_connection(
+			G_DBUS_INTERFACE_SKELETON(icd_dbus_object), conn);
+
+	g_mutex_lock(&icd_dbus_p2p_mutex);
+	if (icd_dbus_p2p_table && conn == g_hash_table_lookup(icd_dbus_p2p_table, bus_name))
+		g_hash_table_remove(icd_dbus_p2p_table, bus_name);
+	g_mutex_unlock(&icd_dbus_p2p_mutex);
+}
+
+
+static gboolean _icd_dbus_p2p_new_connection_cb(GDBusServer *server,
+		GDBusConnection *conn, gpointer user_data)
+{
+	pid_t pid;
+	gboolean ret;
+	char *bus_name;
+	GError *error = NULL;
+	GCredentials *credentials;
+
+	credentials = g_dbus_connection_get_peer_credentials(conn);
+	if (NULL == credentials) {
+		ERR("g_dbus_connection_get_peer_credentials() Fail");
+		return FALSE;
+	}
+	pid = g_credentials_get_unix_pid(credentials, NULL);
+
+	g_mutex_lock(&icd_dbus_p2p_mutex);
+	bus_name = g_hash_table_lookup(icd_dbus_p2p_pending_table, GUINT_TO_POINTER(pid));
+	if (bus_name)
+		g_hash_table_steal(icd_dbus_p2p_pending_table, GUINT_TO_POINTER(pid));
+	g_mutex_unlock(&icd_dbus_p2p_mutex);
+
+	if (NULL == bus_name) {
+		ERR("No handshake(%d)", pid);
+		return FALSE;
+	}
+
+	ret = g_dbus_interface_skeleton_export(G_DBUS_INTERFACE_SKELETON(icd_dbus_object),
+			conn, IOTCON_DBUS_OBJPATH, &error);
+	if (FALSE == ret) {
+		ERR("g_dbus_interface_skeleton_export() Fail(%s)", error->message);
+		g_error_free(error);
+		free(bus_name);
+		return FALSE;
+	}
+
+	g_object_set_data_full(G_OBJECT(conn), ICD_DBUS_P2P_BUS_NAME, bus_name, free);
+	g_signal_connect(conn, "closed", G_CALLBACK(_icd_dbus_p2p_closed_cb), NULL);
+
+	g_mutex_lock(&icd_dbus_p2p_mutex);
+	g_hash_table_replace(icd_dbus_p2p_table, ic_utils_strdup(bus_name),
+			g_object_ref(conn));
+	g_mutex_unlock(&icd_dbus_p2p_mutex);
+
+	DBG("bus(%s) connected", bus_name);
+
+	return TRUE;
+}
+
+
+static int _icd_dbus_p2p_start()
+{
+	gchar *guid;
+	GError *error = NULL;
+	GDBusAuthObserver *observer;
+
+	observer = g_dbus_auth_observer_new();
+	g_signal_connect(observer, "authorize-authenticated-peer",
+			G_CALLBACK(_icd_dbus_p2p_authorize_cb), NULL);
+
+	guid = g_dbus_generate_guid();
+	icd_dbus_p2p_server = g_dbus_server_new_sync(ICD_DBUS_P2P_ADDRESS,
+			G_DBUS_SERVER_FLAGS_NONE, guid, observer, NULL, &error);
+	g_free(guid);
+	g_object_unref(observer);
+	if (NULL == icd_dbus_p2p_server) {
+		ERR("g_dbus_server_new_sync() Fail(%s)", error->message);
+		g_error_free(error);
+		return IOTCON_ERROR_DBUS;
+	}
+
+	g_signal_connect(icd_dbus_p2p_server, "new-connection",
+			G_CALLBACK(_icd_dbus_p2p_new_connection_cb), NULL);
+	g_dbus_server_start(icd_dbus_p2p_server);
+
+	DBG("p2p server(%s)", g_dbus_server_get_client_address(icd_dbus_p2p_server));
+
+	return IOTCON_ERROR_NONE;
+}
+
+
 static void _dbus_on_bus_acquired(GDBusConnection *conn, const gchar *name,
 		gpointer user_data)
 {
@@ -1368,6 +2379,16 @@ static void _dbus_on_bus_acquired(GDBusConnection *conn, const gchar *name,
 			G_CALLBACK(_dbus_handle_encap_get_time_interval), NULL);
 	g_signal_connect(icd_dbus_object, "handle-encap-set-time-interval",
 			G_CALLBACK(_dbus_handle_encap_set_time_interval), NULL);
+	g_signal_connect(icd_dbus_object, "handle-encap-set-poll-interval",
+			G_CALLBACK(_dbus_handle_encap_set_poll_interval), NULL);
+	g_signal_connect(icd_dbus_object, "handle-encap-set-hysteresis",
+			G_CALLBACK(_dbus_handle_encap_set_hysteresis), NULL);
+	g_signal_connect(icd_dbus_object, "handle-encap-set-history-size",
+			G_CALLBACK(_dbus_handle_encap_set_history_size), NULL);
+	g_signal_connect(icd_dbus_object, "handle-encap-resync-caching",
+			G_CALLBACK(_dbus_handle_encap_resync_caching), NULL);
+	g_signal_connect(icd_dbus_object, "handle-encap-get-history",
+			G_CALLBACK(_dbus_handle_encap_get_history), NULL);
 	g_signal_connect(icd_dbus_object, "handle-start-monitoring",
 			G_CALLBACK(_dbus_handle_start_monitoring), NULL);
 	g_signal_connect(icd_dbus_object, "handle-stop-monitoring",
@@ -1376,6 +2397,20 @@ static void _dbus_on_bus_acquired(GDBusConnection *conn, const gchar *name,
 			G_CALLBACK(_dbus_handle_start_caching), NULL);
 	g_signal_connect(icd_dbus_object, "handle-stop-caching",
 			G_CALLBACK(_dbus_handle_stop_caching), NULL);
+	g_signal_connect(icd_dbus_object, "handle-p2p-connect",
+			G_CALLBACK(_dbus_handle_p2p_connect), NULL);
+	g_signal_connect(icd_dbus_object, "handle-ring-open",
+			G_CALLBACK(_dbus_handle_ring_open), NULL);
+	g_signal_connect(icd_dbus_object, "handle-ring-close",
+			G_CALLBACK(_dbus_handle_ring_close), NULL);
+	g_signal_connect(icd_dbus_object, "handle-ring-resume",
+			G_CALLBACK(_dbus_handle_ring_resume), NULL);
+	g_signal_connect(icd_dbus_object, "handle-blob-put",
+			G_CALLBACK(_dbus_handle_blob_put), NULL);
+	g_signal_connect(icd_dbus_object, "handle-blob-get",
+			G_CALLBACK(_dbus_handle_blob_get), NULL);
+	g_signal_connect(icd_dbus_object, "handle-negotiate-wire",
+			G_CALLBACK(_dbus_handle_negotiate_wire), NULL);
 
 	ret = g_dbus_interface_skeleton_export(G_DBUS_INTERFACE_SKELETON(icd_dbus_object),
 			conn, IOTCON_DBUS_OBJPATH, &error);
@@ -1390,6 +2425,10 @@ static void _dbus_on_bus_acquired(GDBusConnection *conn, const gchar *name,
 		return;
 	}
 
+	/* the clients stay on the system bus without the server */
+	ret = _icd_dbus_p2p_start();
+	if (IOTCON_ERROR_NONE != ret)
+		ERR("_icd_dbus_p2p_start() Fail(%d)", ret);
 }
 
 
@@ -1411,6 +2450,18 @@ unsigned int icd_dbus_init()
 {
 	guint id;
 
+	icd_dbus_client_table = g_hash_table_new(g_str_hash, g_str_equal);
+	icd_dbus_resource_table = g_hash_table_new(g_direct_hash, g_direct_equal);
+	icd_dbus_presence_table = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+			(GDestroyNotify)g_ptr_array_unref);
+	icd_dbus_p2p_table = g_hash_table_new_full(g_str_hash, g_str_equal, free,
+			g_object_unref);
+	icd_dbus_p2p_pending_table = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+			NULL, free);
+	icd_dbus_ring_table = g_hash_table_new_full(g_str_hash, g_str_equal, free,
+			_icd_dbus_ring_free);
+	icd_dbus_wire_table = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+
 	id = g_bus_own_name(G_BUS_TYPE_SYSTEM,
 			IOTCON_DBUS_INTERFACE,
 			G_BUS_NAME_OWNER_FLAGS_REPLACE,
@@ -1421,6 +2472,13 @@ unsigned int icd_dbus_init()
 			NULL);
 	if (0 == id) {
 		ERR("g_bus_own_name() Fail");
+		g_hash_table_destroy(icd_dbus_wire_table);
+		g_hash_table_destroy(icd_dbus_ring_table);
+		g_hash_table_destroy(icd_dbus_p2p_pending_table);
+		g_hash_table_destroy(icd_dbus_p2p_table);
+		g_hash_table_destroy(icd_dbus_presence_table);
+		g_hash_table_destroy(icd_dbus_resource_table);
+		g_hash_table_destroy(icd_dbus_client_table);
 		return 0;
 	}
 
@@ -1430,6 +2488,39 @@ unsigned int icd_dbus_init()
 
 void icd_dbus_deinit(unsigned int id)
 {
+	GHashTable *p2p_table, *ring_table, *wire_table;
+
+	if (icd_dbus_p2p_server) {
+		g_dbus_server_stop(icd_dbus_p2p_server);
+		g_object_unref(icd_dbus_p2p_server);
+		icd_dbus_p2p_server = NULL;
+	}
+
+	g_mutex_lock(&icd_dbus_p2p_mutex);
+	p2p_table = icd_dbus_p2p_table;
+	icd_dbus_p2p_table = NULL;
+	g_mutex_unlock(&icd_dbus_p2p_mutex);
+	g_hash_table_destroy(p2p_table);
+	g_hash_table_destroy(icd_dbus_p2p_pending_table);
+
+	g_mutex_lock(&icd_dbus_ring_mutex);
+	ring_table = icd_dbus_ring_table;
+	icd_dbus_ring_table = NULL;
+	g_mutex_unlock(&icd_dbus_ring_mutex);
+	g_hash_table_destroy(ring_table);
+
+	g_mutex_lock(&icd_dbus_wire_mutex);
+	wire_table = icd_dbus_wire_table;
+	icd_dbus_wire_table = NULL;
+	g_mutex_unlock(&icd_dbus_wire_mutex);
+	g_hash_table_destroy(wire_table);
+
+	icd_blob_deinit();
+
 	g_bus_unown_name(id);
+
+	g_hash_table_destroy(icd_dbus_presence_table);
+	g_hash_table_destroy(icd_dbus_resource_table);
+	g_hash_table_destroy(icd_dbus_client_table);
 }
 
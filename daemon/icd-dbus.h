@@ -27,8 +27,14 @@ icDbus* icd_dbus_get_object();
 int64_t icd_dbus_generate_signal_number();
 int icd_dbus_client_list_get_resource_info(void *handle, int64_t *signal_number,
 		gchar **bus_name);
+GList* icd_dbus_client_list_get_presence_subscribers(void *handle,
+		const char *resource_type);
+GDBusConnection* icd_dbus_get_bus_connection();
+const gchar* icd_dbus_get_sender(GDBusMethodInvocation *invocation);
+int icd_dbus_get_wire_version(const char *bus_name);
 int icd_dbus_emit_signal(const char *dest, const char *signal_name,
 		GVariant *value);
+void icd_dbus_flush();
 unsigned int icd_dbus_init();
 void icd_dbus_deinit(unsigned int id);
 
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2015 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <glib.h>
+#include <octypes.h>
+
+#include "iotcon.h"
+#include "ic-utils.h"
+#include "icd.h"
+#include "icd-ioty-health.h"
+
+#define ICD_HEALTH_FAIL_COUNT 3 /* consecutive failures to open the circuit */
+#define ICD_HEALTH_OPEN_TIME (5 * G_TIME_SPAN_SECOND)
+#define ICD_HEALTH_MAX_OPEN_TIME (2 * G_TIME_SPAN_MINUTE)
+#define ICD_HEALTH_KEY_SIZE (MAX_ADDR_STR_SIZE + 16)
+
+/* The circuit of an endpoint is opened after the consecutive failures. While it is open,
+ * requests to the host fail at once, except one request per open time (half-open).
+ * Any response of the host closes the circuit. */
+typedef struct {
+	unsigned int fail_count;
+	gint64 open_time; /* 0 : closed */
+	gint64 retry_time;
+	bool probing;
+} icd_health_s;
+
+static GMutex icd_health_mutex;
+static GHashTable *icd_health_table; /* key : adapter, address and port */
+
+
+/* the servers on the other ports of a host are not affected by a dead one */
+static void _icd_ioty_health_key(const OCDevAddr *dev_addr, char *key, size_t size)
+{
+	snprintf(key, size, "%d:%s:%u", dev_addr->adapter, dev_addr->addr, dev_addr->port);
+}
+
+
+static bool _icd_ioty_health_is_failure(OCStackResult result)
+{
+	switch (result) {
+	case OC_STACK_TIMEOUT:
+	case OC_STACK_COMM_ERROR:
+	case OC_STACK_PRESENCE_TIMEOUT:
+		return true;
+	default:
+		return false;
+	}
+}
+
+
+int icd_ioty_health_check(const OCDevAddr *dev_addr)
+{
+	gint64 now;
+	icd_health_s *health;
+	char key[ICD_HEALTH_KEY_SIZE];
+
+	RETV_IF(NULL == dev_addr, IOTCON_ERROR_INVALID_PARAMETER);
+
+	g_mutex_lock(&icd_health_mutex);
+	if (NULL == icd_health_table) {
+		g_mutex_unlock(&icd_health_mutex);
+		return IOTCON_ERROR_NONE;
+	}
+
+	_icd_ioty_health_key(dev_addr, key, sizeof(key));
+	health = g_hash_table_lookup(icd_health_table, key);
+	if (NULL == health || 0 == health->open_time) {
+		g_mutex_unlock(&icd_health_mutex);
+		return IOTCON_ERROR_NONE;
+	}
+
+	now = g_get_monotonic_time();
+	if (now < health->retry_time) {
+		g_mutex_unlock(&icd_health_mutex);
+		return IOTCON_ERROR_TIMEOUT;
+	}
+
+	/* half-open : this request probes the host. The others still fail at once */
+	health->retry_time = now + health->open_time;
+	health->probing = true;
+	g_mutex_unlock(&icd_health_mutex);
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+/* every response from the stack is reported, including the timeouts */
+void icd_ioty_health_report(const OCDevAddr *dev_addr, OCStackResult result)
+{
+	icd_health_s *health;
+	char key[ICD_HEALTH_KEY_SIZE];
+
+	RET_IF(NULL == dev_addr);
+
+	if ('\0' == dev_addr->addr[0])
+		return;
+
+	_icd_ioty_health_key(dev_addr, key, sizeof(key));
+
+	g_mutex_lock(&icd_health_mutex);
+	if (false == _icd_ioty_health_is_failure(result)) {
+		if (icd_health_table && g_hash_table_remove(icd_health_table, key))
+			DBG("%s is reachable", key);
+		g_mutex_unlock(&icd_health_mutex);
+		return;
+	}
+
+	if (NULL == icd_health_table)
+		icd_health_table = g_hash_table_new_full(g_str_hash, g_str_equal, free, free);
+
+	health = g_hash_table_lookup(icd_health_table, key);
+	if (NULL == health) {
+		health = calloc(1, sizeof(icd_health_s));
+		if (NULL == health) {
+			ERR("calloc() Fail(%d)", errno);
+			g_mutex_unlock(&icd_health_mutex);
+			return;
+		}
+		g_hash_table_insert(icd_health_table, ic_utils_strdup(key), health);
+	}
+
+	health->fail_count++;
+	if (health->fail_count < ICD_HEALTH_FAIL_COUNT) {
+		g_mutex_unlock(&icd_health_mutex);
+		return;
+	}
+
+	if (0 == health->open_time) {
+		WARN("%s is unreachable", key);
+		health->open_time = ICD_HEALTH_OPEN_TIME;
+	} else if (health->probing) {
+		/* the half-open request fails. Requests sent before opening are ignored */
+		health->open_time = MIN(health->open_time * 2, ICD_HEALTH_MAX_OPEN_TIME);
+	} else {
+		g_mutex_unlock(&icd_health_mutex);
+		return;
+	}
+	health->probing = false;
+	health->retry_time = g_get_monotonic_time() + health->open_time;
+	g_mutex_unlock(&icd_health_mutex);
+}
+
+
+void icd_ioty_health_deinit()
+{
+	g_mutex_lock(&icd_health_mutex);
+	if (icd_health_table) {
+		g_hash_table_destroy(icd_health_table);
+		icd_health_table = NULL;
+	}
+	g_mutex_unlock(&icd_health_mutex);
+}
@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2015 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __IOT_CONNECTIVITY_MANAGER_DAEMON_IOTIVITY_HEALTH_H__
+#define __IOT_CONNECTIVITY_MANAGER_DAEMON_IOTIVITY_HEALTH_H__
+
+#include <octypes.h>
+
+int icd_ioty_health_check(const OCDevAddr *dev_addr);
+void icd_ioty_health_report(const OCDevAddr *dev_addr, OCStackResult result);
+void icd_ioty_health_deinit();
+
+#endif /*__IOT_CONNECTIVITY_MANAGER_DAEMON_IOTIVITY_HEALTH_H__*/
@@ -25,15 +25,41 @@
 
 #include "iotcon.h"
 #include "ic-utils.h"
+#include "ic-wire.h"
 #include "icd.h"
 #include "icd-payload.h"
 #include "icd-dbus.h"
 #include "icd-ioty.h"
 #include "icd-ioty-type.h"
 #include "icd-ioty-ocprocess.h"
+#include "icd-ioty-health.h"
+
+/*
+ * OCProcess() polling interval (usec)
+ * Every stack operation queued by icd_ioty_csdk_cmd_push() wakes up the thread, and
+ * the interval drops to the minimum while the callbacks fire. An idle daemon waits up
+ * to the maximum, so the first inbound request after a quiet period is seen within
+ * 100 ms, instead of 10 ms with the former fixed interval. The following ones are
+ * polled fast, and the retransmissions of the stack (2 sec or more) are not delayed.
+ */
+#define ICD_IOTY_PROCESS_MIN_INTERVAL (2 * G_TIME_SPAN_MILLISECOND)
+#define ICD_IOTY_PROCESS_MAX_INTERVAL (100 * G_TIME_SPAN_MILLISECOND)
 
 static int icd_ioty_alive;
 
+static GMutex icd_ioty_process_mutex;
+static GCond icd_ioty_process_cond;
+static gboolean icd_ioty_process_pending;
+static int icd_ioty_process_activity;
+
+static GThreadPool *icd_worker_pool;
+static unsigned int icd_worker_queue_max = ICD_WORKER_QUEUE_MAX;
+/* to size the pool and the queue. See icd_ioty_ocprocess_worker_pool_get_stats() */
+static unsigned int icd_worker_queue_peak;
+static unsigned int icd_worker_pushed_count;
+static unsigned int icd_worker_rejected_count;
+static guint icd_worker_stats_timer;
+
 typedef int (*_ocprocess_cb)(void *user_data);
 typedef void (*_free_context)(void *context);
 
@@ -70,7 +96,8 @@ struct icd_find_context {
 	int64_t signal_number;
 	char *bus_name;
 	int conn_type;
-	GVariant **payload;
+	OCPayload *oic_payload;
+	OCDevAddr dev_addr;
 };
 
 
@@ -78,7 +105,7 @@ struct icd_crud_context {
 	GMutex icd_worker_mutex;
 	int res;
 	int crud_type;
-	GVariant *payload;
+	OCPayload *oic_payload;
 	GVariantBuilder *options;
 	GDBusMethodInvocation *invocation;
 };
@@ -89,7 +116,7 @@ struct icd_info_context {
 	int64_t signal_number;
 	int info_type;
 	char *bus_name;
-	GVariant *payload;
+	OCPayload *oic_payload;
 };
 
 
@@ -99,7 +126,7 @@ struct icd_observe_context {
 	int res;
 	int seqnum;
 	char *bus_name;
-	GVariant *payload;
+	OCPayload *oic_payload;
 	GVariantBuilder *options;
 };
 
@@ -121,22 +148,40 @@ struct icd_encap_get_context {
 	OCStackResult ret;
 	OCDevAddr dev_addr;
 	char *uri_path;
+	bool is_observe;
+	bool is_probe;
+	bool is_batch;
+};
+
+
+struct icd_encap_batch_context {
+	OCStackResult ret;
+	OCDevAddr dev_addr;
+	char *collection;
+	OCPayload *oic_payload;
+};
+
+
+struct icd_encap_discover_context {
+	OCDevAddr dev_addr;
+	GList *collections;
 };
 
 
 void icd_ioty_ocprocess_stop()
 {
 	icd_ioty_alive = 0;
+	icd_ioty_ocprocess_wakeup();
 }
 
 
-static void* _ocprocess_worker_thread(void *data)
+static void _ocprocess_worker_thread(gpointer data, gpointer user_data)
 {
 	int ret;
 	struct icd_ioty_worker *worker = data;
 	struct icd_worker_context *ctx;
 
-	RETV_IF(NULL == worker, NULL);
+	RET_IF(NULL == worker);
 
 	ctx = worker->ctx;
 
@@ -151,19 +196,125 @@ static void* _ocprocess_worker_thread(void *data)
 
 	/* worker was allocated from _ocprocess_worker_start() */
 	free(worker);
+}
 
-	/* GCC warning happen if use g_thread_exit() */
-	return NULL;
+
+void icd_ioty_ocprocess_worker_pool_get_stats(unsigned int *queue_depth,
+		unsigned int *queue_peak, unsigned int *pushed_count, unsigned int *rejected_count)
+{
+	if (queue_depth)
+		*queue_depth = icd_worker_pool ? g_thread_pool_unprocessed(icd_worker_pool) : 0;
+	if (queue_peak)
+		*queue_peak = g_atomic_int_get(&icd_worker_queue_peak);
+	if (pushed_count)
+		*pushed_count = g_atomic_int_get(&icd_worker_pushed_count);
+	if (rejected_count)
+		*rejected_count = g_atomic_int_get(&icd_worker_rejected_count);
+}
+
+
+/* reported only when the pool has been used since the last report */
+static gboolean _ocprocess_worker_stats_cb(gpointer user_data)
+{
+	static unsigned int last_pushed, last_rejected;
+	unsigned int depth, peak, pushed, rejected;
+
+	icd_ioty_ocprocess_worker_pool_get_stats(&depth, &peak, &pushed, &rejected);
+	if (pushed == last_pushed && rejected == last_rejected)
+		return G_SOURCE_CONTINUE;
+
+	INFO("worker queue : depth(%u), peak(%u/%u), pushed(%u), rejected(%u)", depth, peak,
+			icd_worker_queue_max, pushed - last_pushed, rejected - last_rejected);
+
+	last_pushed = pushed;
+	last_rejected = rejected;
+
+	return G_SOURCE_CONTINUE;
+}
+
+
+static void _ocprocess_worker_update_peak(unsigned int depth)
+{
+	unsigned int peak;
+
+	do {
+		peak = g_atomic_int_get(&icd_worker_queue_peak);
+		if (depth <= peak)
+			return;
+	} while (FALSE == g_atomic_int_compare_and_exchange(&icd_worker_queue_peak, peak,
+				depth));
+}
+
+
+int icd_ioty_ocprocess_worker_pool_init(int max_threads, unsigned int max_queue)
+{
+	GError *error = NULL;
+
+	RETV_IF(icd_worker_pool, IOTCON_ERROR_ALREADY);
+
+	if (max_threads <= 0)
+		max_threads = ICD_WORKER_POOL_SIZE;
+	if (0 == max_queue)
+		max_queue = ICD_WORKER_QUEUE_MAX;
+
+	icd_worker_pool = g_thread_pool_new(_ocprocess_worker_thread, NULL, max_threads,
+			FALSE, &error);
+	if (NULL == icd_worker_pool) {
+		ERR("g_thread_pool_new() Fail(%s)", error->message);
+		g_error_free(error);
+		return IOTCON_ERROR_SYSTEM;
+	}
+
+	icd_worker_queue_max = max_queue;
+	g_atomic_int_set(&icd_worker_queue_peak, 0);
+	g_atomic_int_set(&icd_worker_pushed_count, 0);
+	g_atomic_int_set(&icd_worker_rejected_count, 0);
+
+	icd_worker_stats_timer = g_timeout_add_seconds(ICD_WORKER_STATS_INTERVAL,
+			_ocprocess_worker_stats_cb, NULL);
+
+	DBG("worker pool created (threads:%d, queue:%u)", max_threads, max_queue);
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+void icd_ioty_ocprocess_worker_pool_deinit()
+{
+	RET_IF(NULL == icd_worker_pool);
+
+	if (icd_worker_stats_timer) {
+		g_source_remove(icd_worker_stats_timer);
+		icd_worker_stats_timer = 0;
+	}
+
+	/* process remaining works, then wait for them */
+	g_thread_pool_free(icd_worker_pool, FALSE, TRUE);
+	icd_worker_pool = NULL;
 }
 
 
 static int _ocprocess_worker_start(_ocprocess_cb cb, void *ctx, _free_context free_ctx)
 {
-	GError *error;
-	GThread *thread;
+	gboolean ret;
+	unsigned int depth;
+	GError *error = NULL;
 	struct icd_ioty_worker *worker;
 
 	RETV_IF(NULL == cb, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(NULL == icd_worker_pool, IOTCON_ERROR_SYSTEM);
+
+	/* called in OCProcess(). keep polling fast while messages are arriving */
+	g_atomic_int_set(&icd_ioty_process_activity, 1);
+
+	depth = g_thread_pool_unprocessed(icd_worker_pool);
+	if (icd_worker_queue_max <= depth) {
+		ERR("worker queue is full(%u), rejected(%u)", depth,
+				g_atomic_int_add(&icd_worker_rejected_count, 1) + 1);
+		return IOTCON_ERROR_SYSTEM;
+	}
+	_ocprocess_worker_update_peak(depth + 1);
+	g_atomic_int_inc(&icd_worker_pushed_count);
 
 	worker = calloc(1, sizeof(struct icd_ioty_worker));
 	if (NULL == worker) {
@@ -175,38 +326,33 @@ static int _ocprocess_worker_start(_ocprocess_cb cb, void *ctx, _free_context fr
 	worker->ctx = ctx;
 	worker->free_ctx = free_ctx;
 
-	/* TODO : consider thread pool mechanism */
-	thread = g_thread_try_new("worker_thread", _ocprocess_worker_thread, worker, &error);
-	if (NULL == thread) {
-		ERR("g_thread_try_new() Fail(%s)", error->message);
+	ret = g_thread_pool_push(icd_worker_pool, worker, &error);
+	if (FALSE == ret) {
+		ERR("g_thread_pool_push() Fail(%s)", error->message);
 		g_error_free(error);
 		free(worker);
 		return IOTCON_ERROR_SYSTEM;
 	}
 
-	/* DO NOT join thread. It was already detached by calling g_thread_unref() */
-	g_thread_unref(thread);
-
 	/* DO NOT FREE worker. It MUST be freed in the _ocprocess_worker_thread() */
 
 	return IOTCON_ERROR_NONE;
 }
 
 
+/* Every message of a kind is sent with the same signal name.
+ * The signal number in the body tells the client which subscriber it is for. */
 static int _ocprocess_response_signal(const char *dest, const char *signal_prefix,
 		int64_t signal_number, GVariant *value)
 {
 	int ret;
-	char signal_name[IC_DBUS_SIGNAL_LENGTH] = {0};
+	GVariant *body;
 
-	ret = snprintf(signal_name, sizeof(signal_name), "%s_%llx", signal_prefix, signal_number);
-	if (ret <= 0 || sizeof(signal_name) <= ret) {
-		ERR("snprintf() Fail(%d)", ret);
-		g_variant_unref(value);
-		return IOTCON_ERROR_IO_ERROR;
-	}
+	value = g_variant_take_ref(value);
+	body = g_variant_new("(xv)", signal_number, value);
+	g_variant_unref(value);
 
-	ret = icd_dbus_emit_signal(dest, signal_name, value);
+	ret = icd_dbus_emit_signal(dest, signal_prefix, body);
 	if (IOTCON_ERROR_NONE != ret) {
 		ERR("icd_dbus_emit_signal() Fail(%d)", ret);
 		return ret;
@@ -231,6 +377,20 @@ static inline GVariantBuilder* _ocprocess_parse_header_options(
 	return options;
 }
 
+/*
+ * ocstack destroys resp->payload after the callback returns.
+ * Take the payload over, and convert it on the worker thread outside the csdk lock.
+ */
+static inline OCPayload* _ocprocess_take_payload(OCClientResponse *resp)
+{
+	OCPayload *payload = resp->payload;
+
+	resp->payload = NULL;
+
+	return payload;
+}
+
+
 static int _ioty_oic_action_to_ioty_action(int oic_action)
 {
 	int action;
@@ -275,10 +435,8 @@ static int _worker_req_handler(void *context)
 	RETV_IF(NULL == ctx, IOTCON_ERROR_INVALID_PARAMETER);
 
 	g_variant_builder_init(&payload_builder, G_VARIANT_TYPE("av"));
-	if (ctx->payload) {
+	if (ctx->payload)
 		g_variant_builder_add(&payload_builder, "v", ctx->payload);
-		ctx->payload = NULL;
-	}
 
 	ret = icd_ioty_get_host_address(&ctx->dev_addr, &host_address, &conn_type);
 	if (IOTCON_ERROR_NONE != ret) {
@@ -310,6 +468,28 @@ static int _worker_req_handler(void *context)
 }
 
 
+/*
+ * The request is owned by ocstack, and it is passed to the other entity handlers of
+ * a collection. Convert it here, instead of cloning the tree for the worker thread.
+ */
+static GVariant* _ocprocess_request_payload_to_gvariant(OCPayload *payload,
+		const char *bus_name)
+{
+	GVariant *value;
+
+	if (NULL == payload || PAYLOAD_TYPE_REPRESENTATION != payload->type)
+		return NULL;
+
+	value = icd_payload_to_gvariant_version(payload, icd_dbus_get_wire_version(bus_name));
+	if (NULL == value) {
+		ERR("icd_payload_to_gvariant_version() Fail");
+		return NULL;
+	}
+
+	return g_variant_ref_sink(value);
+}
+
+
 OCEntityHandlerResult icd_ioty_ocprocess_req_handler(OCEntityHandlerFlag flag,
 		OCEntityHandlerRequest *request, void *user_data)
 {
@@ -356,11 +536,13 @@ OCEntityHandlerResult icd_ioty_ocprocess_req_handler(OCEntityHandlerFlag flag,
 			break;
 		case OC_REST_PUT:
 			req_ctx->request_type = IOTCON_REQUEST_PUT;
-			req_ctx->payload = icd_payload_to_gvariant(request->payload);
+			req_ctx->payload = _ocprocess_request_payload_to_gvariant(request->payload,
+					req_ctx->bus_name);
 			break;
 		case OC_REST_POST:
 			req_ctx->request_type = IOTCON_REQUEST_POST;
-			req_ctx->payload = icd_payload_to_gvariant(request->payload);
+			req_ctx->payload = _ocprocess_request_payload_to_gvariant(request->payload,
+					req_ctx->bus_name);
 			break;
 		case OC_REST_DELETE:
 			req_ctx->request_type = IOTCON_REQUEST_DELETE;
@@ -414,15 +596,44 @@ OCEntityHandlerResult icd_ioty_ocprocess_req_handler(OCEntityHandlerFlag flag,
 }
 
 
+void icd_ioty_ocprocess_wakeup()
+{
+	g_mutex_lock(&icd_ioty_process_mutex);
+	icd_ioty_process_pending = TRUE;
+	g_cond_signal(&icd_ioty_process_cond);
+	g_mutex_unlock(&icd_ioty_process_mutex);
+}
+
+
+static void _ocprocess_wait(gint64 interval)
+{
+	gint64 end_time;
+
+	g_mutex_lock(&icd_ioty_process_mutex);
+	end_time = g_get_monotonic_time() + interval;
+	while (FALSE == icd_ioty_process_pending) {
+		if (FALSE == g_cond_wait_until(&icd_ioty_process_cond, &icd_ioty_process_mutex,
+					end_time))
+			break;
+	}
+	if (icd_ioty_process_pending)
+		g_atomic_int_set(&icd_ioty_process_activity, 1);
+	icd_ioty_process_pending = FALSE;
+	g_mutex_unlock(&icd_ioty_process_mutex);
+}
+
+
 gpointer icd_ioty_ocprocess_thread(gpointer data)
 {
 	FN_CALL;
 	OCStackResult result;
-	const struct timespec delay = {0, 10 * 1000 * 1000}; /* 10 ms */
+	gint64 interval = ICD_IOTY_PROCESS_MIN_INTERVAL;
 
 	icd_ioty_alive = 1;
 	while (icd_ioty_alive) {
 		icd_ioty_csdk_lock();
+		/* run all queued stack operations in this lock acquisition */
+		icd_ioty_csdk_cmd_process();
 		result = OCProcess();
 		icd_ioty_csdk_unlock();
 		if (OC_STACK_OK != result) {
@@ -430,9 +641,15 @@ gpointer icd_ioty_ocprocess_thread(gpointer data)
 			break;
 		}
 
-		/* TODO : Current '10ms' is not proven sleep time. Revise the time after test.
-		 * Or recommend changes to event driven architecture */
-		nanosleep(&delay, NULL);
+		/* The stack does not expose its sockets, so OCProcess() is still polled.
+		 * While callbacks fire or requests are sent, poll at the minimum interval.
+		 * Otherwise, back off exponentially up to the maximum interval. */
+		if (g_atomic_int_compare_and_exchange(&icd_ioty_process_activity, 1, 0))
+			interval = ICD_IOTY_PROCESS_MIN_INTERVAL;
+		else
+			interval = MIN(interval * 2, ICD_IOTY_PROCESS_MAX_INTERVAL);
+
+		_ocprocess_wait(interval);
 	}
 
 	return NULL;
@@ -444,34 +661,47 @@ static void _icd_find_context_free(void *ctx)
 	struct icd_find_context *find_ctx = ctx;
 
 	free(find_ctx->bus_name);
+	OCPayloadDestroy(find_ctx->oic_payload);
 	free(find_ctx);
 }
 
 
 static int _worker_find_cb(void *context)
 {
-	GVariant *value;
 	int i, ret;
+	GVariant *value;
+	GVariant **payload;
+	GVariantBuilder builder;
 	struct icd_find_context *ctx = context;
 
 	RETV_IF(NULL == ctx, IOTCON_ERROR_INVALID_PARAMETER);
-	RETV_IF(NULL == ctx->payload, IOTCON_ERROR_INVALID_PARAMETER);
-
-	for (i = 0; ctx->payload[i]; i++) {
-		value = g_variant_new("(vi)", ctx->payload[i], ctx->conn_type);
-		/* TODO : If one device has multi resources, it comes as bulk data.
-		 * To reduce the number of emit_signal, let's send signal only one time for one device.
-		 * for ex, client list. */
-		ret = _ocprocess_response_signal(ctx->bus_name, IC_DBUS_SIGNAL_FOUND_RESOURCE,
-				ctx->signal_number, value);
-		if (IOTCON_ERROR_NONE != ret) {
-			ERR("_ocprocess_response_signal() Fail(%d)", ret);
-			g_variant_unref(value);
-			return ret;
-		}
+	RETV_IF(NULL == ctx->oic_payload, IOTCON_ERROR_INVALID_PARAMETER);
+
+	payload = icd_payload_res_to_gvariant(ctx->oic_payload, &ctx->dev_addr);
+	if (NULL == payload) {
+		ERR("icd_payload_res_to_gvariant() Fail");
+		return IOTCON_ERROR_OUT_OF_MEMORY;
 	}
 
-	return ret;
+	/* All resources of one device come in one discovery response.
+	 * Send them with one signal, instead of one signal per resource. */
+	g_variant_builder_init(&builder, G_VARIANT_TYPE("av"));
+	for (i = 0; payload[i]; i++)
+		g_variant_builder_add(&builder, "v", payload[i]);
+	free(payload);
+
+	value = g_variant_new("(avi)", &builder, ctx->conn_type);
+
+	ret = _ocprocess_response_signal(ctx->bus_name, IC_DBUS_SIGNAL_FOUND_RESOURCE,
+			ctx->signal_number, value);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("_ocprocess_response_signal() Fail(%d)", ret);
+		return ret;
+	}
+
+	icd_dbus_flush();
+
+	return IOTCON_ERROR_NONE;
 }
 
 
@@ -498,14 +728,14 @@ OCStackApplicationResult icd_ioty_ocprocess_find_cb(void *ctx, OCDoHandle handle
 
 	find_ctx->signal_number = sig_context->signal_number;
 	find_ctx->bus_name = ic_utils_strdup(sig_context->bus_name);
-	find_ctx->payload = icd_payload_res_to_gvariant(resp->payload, &resp->devAddr);
+	find_ctx->oic_payload = _ocprocess_take_payload(resp);
+	memcpy(&find_ctx->dev_addr, &resp->devAddr, sizeof(OCDevAddr));
 	find_ctx->conn_type = icd_ioty_transport_flag_to_conn_type(resp->devAddr.adapter,
 			resp->devAddr.flags);
 
 	ret = _ocprocess_worker_start(_worker_find_cb, find_ctx, _icd_find_context_free);
 	if (IOTCON_ERROR_NONE != ret) {
 		ERR("_ocprocess_worker_start() Fail(%d)", ret);
-		ic_utils_gvariant_array_free(find_ctx->payload);
 		_icd_find_context_free(find_ctx);
 		return OC_STACK_KEEP_TRANSACTION;
 	}
@@ -522,28 +752,34 @@ static void _icd_crud_context_free(void *ctx)
 	struct icd_crud_context *crud_ctx = ctx;
 
 	g_variant_builder_unref(crud_ctx->options);
+	OCPayloadDestroy(crud_ctx->oic_payload);
 	free(crud_ctx);
 }
 
 
 static int _worker_crud_cb(void *context)
 {
-	GVariant *value;
+	GVariant *value, *payload;
 	struct icd_crud_context *ctx = context;
 
 	RETV_IF(NULL == ctx, IOTCON_ERROR_INVALID_PARAMETER);
 
-	if (ICD_CRUD_DELETE == ctx->crud_type)
+	if (ICD_CRUD_DELETE == ctx->crud_type) {
 		value = g_variant_new("(a(qs)i)", ctx->options, ctx->res);
-	else
-		value = g_variant_new("(a(qs)vi)", ctx->options, ctx->payload, ctx->res);
+	} else {
+		payload = icd_payload_to_gvariant_version(ctx->oic_payload,
+				icd_dbus_get_wire_version(icd_dbus_get_sender(ctx->invocation)));
+		if (NULL == payload)
+			payload = icd_payload_representation_empty_gvariant();
+		value = g_variant_new("(a(qs)vi)", ctx->options, payload, ctx->res);
+	}
 	icd_ioty_complete(ctx->crud_type, ctx->invocation, value);
 
 	return IOTCON_ERROR_NONE;
 }
 
 
-static int _ocprocess_worker(_ocprocess_cb cb, int type, OCPayload *payload, int res,
+static int _ocprocess_worker(_ocprocess_cb cb, int type, OCClientResponse *resp, int res,
 		GVariantBuilder *options, void *ctx)
 {
 	int ret;
@@ -556,7 +792,8 @@ static int _ocprocess_worker(_ocprocess_cb cb, int type, OCPayload *payload, int
 	}
 
 	crud_ctx->crud_type = type;
-	crud_ctx->payload = icd_payload_to_gvariant(payload);
+	if (ICD_CRUD_DELETE != type)
+		crud_ctx->oic_payload = _ocprocess_take_payload(resp);
 	crud_ctx->res = res;
 	crud_ctx->options = options;
 	crud_ctx->invocation = ctx;
@@ -564,8 +801,7 @@ static int _ocprocess_worker(_ocprocess_cb cb, int type, OCPayload *payload, int
 	ret = _ocprocess_worker_start(cb, crud_ctx, _icd_crud_context_free);
 	if (IOTCON_ERROR_NONE != ret) {
 		ERR("_ocprocess_worker_start() Fail(%d)", ret);
-		if (crud_ctx->payload)
-			g_variant_unref(crud_ctx->payload);
+		OCPayloadDestroy(crud_ctx->oic_payload);
 		g_variant_builder_unref(crud_ctx->options);
 		free(crud_ctx);
 	}
@@ -611,6 +847,8 @@ OCStackApplicationResult icd_ioty_ocprocess_get_cb(void *ctx, OCDoHandle handle,
 
 	RETV_IF(NULL == ctx, OC_STACK_DELETE_TRANSACTION);
 
+	icd_ioty_health_report(&resp->devAddr, resp->result);
+
 	if (NULL == resp->payload) {
 		ERR("payload is empty");
 		icd_ioty_complete_error(ICD_CRUD_GET, ctx, IOTCON_ERROR_IOTIVITY);
@@ -622,8 +860,7 @@ OCStackApplicationResult icd_ioty_ocprocess_get_cb(void *ctx, OCDoHandle handle,
 	options = _ocprocess_parse_header_options(resp->rcvdVendorSpecificHeaderOptions,
 			resp->numRcvdVendorSpecificHeaderOptions);
 
-	ret = _ocprocess_worker(_worker_crud_cb, ICD_CRUD_GET, resp->payload, res,
-			options, ctx);
+	ret = _ocprocess_worker(_worker_crud_cb, ICD_CRUD_GET, resp, res, options, ctx);
 	if (IOTCON_ERROR_NONE != ret) {
 		ERR("_ocprocess_worker() Fail(%d)", ret);
 		icd_ioty_complete_error(ICD_CRUD_GET, ctx, ret);
@@ -643,6 +880,8 @@ OCStackApplicationResult icd_ioty_ocprocess_put_cb(void *ctx, OCDoHandle handle,
 
 	RETV_IF(NULL == ctx, OC_STACK_DELETE_TRANSACTION);
 
+	icd_ioty_health_report(&resp->devAddr, resp->result);
+
 	if (NULL == resp->payload) {
 		ERR("payload is empty");
 		icd_ioty_complete_error(ICD_CRUD_PUT, ctx, IOTCON_ERROR_IOTIVITY);
@@ -654,8 +893,7 @@ OCStackApplicationResult icd_ioty_ocprocess_put_cb(void *ctx, OCDoHandle handle,
 	options = _ocprocess_parse_header_options(resp->rcvdVendorSpecificHeaderOptions,
 			resp->numRcvdVendorSpecificHeaderOptions);
 
-	ret = _ocprocess_worker(_worker_crud_cb, ICD_CRUD_PUT, resp->payload, res,
-			options, ctx);
+	ret = _ocprocess_worker(_worker_crud_cb, ICD_CRUD_PUT, resp, res, options, ctx);
 	if (IOTCON_ERROR_NONE != ret) {
 		ERR("_ocprocess_worker() Fail(%d)", ret);
 		icd_ioty_complete_error(ICD_CRUD_PUT, ctx, ret);
@@ -675,6 +913,8 @@ OCStackApplicationResult icd_ioty_ocprocess_post_cb(void *ctx, OCDoHandle handle
 
 	RETV_IF(NULL == ctx, OC_STACK_DELETE_TRANSACTION);
 
+	icd_ioty_health_report(&resp->devAddr, resp->result);
+
 	if (NULL == resp->payload) {
 		ERR("payload is empty");
 		icd_ioty_complete_error(ICD_CRUD_POST, ctx, IOTCON_ERROR_IOTIVITY);
@@ -686,8 +926,7 @@ OCStackApplicationResult icd_ioty_ocprocess_post_cb(void *ctx, OCDoHandle handle
 	options = _ocprocess_parse_header_options(resp->rcvdVendorSpecificHeaderOptions,
 			resp->numRcvdVendorSpecificHeaderOptions);
 
-	ret = _ocprocess_worker(_worker_crud_cb, ICD_CRUD_POST, resp->payload, res,
-			options, ctx);
+	ret = _ocprocess_worker(_worker_crud_cb, ICD_CRUD_POST, resp, res, options, ctx);
 	if (IOTCON_ERROR_NONE != ret) {
 		ERR("_ocprocess_worker() Fail(%d)", ret);
 		icd_ioty_complete_error(ICD_CRUD_POST, ctx, ret);
@@ -707,6 +946,8 @@ OCStackApplicationResult icd_ioty_ocprocess_delete_cb(void *ctx, OCDoHandle hand
 
 	RETV_IF(NULL == ctx, OC_STACK_DELETE_TRANSACTION);
 
+	icd_ioty_health_report(&resp->devAddr, resp->result);
+
 	if (NULL == resp->payload) {
 		ERR("payload is empty");
 		icd_ioty_complete_error(ICD_CRUD_DELETE, ctx, IOTCON_ERROR_IOTIVITY);
@@ -718,7 +959,7 @@ OCStackApplicationResult icd_ioty_ocprocess_delete_cb(void *ctx, OCDoHandle hand
 	options = _ocprocess_parse_header_options(resp->rcvdVendorSpecificHeaderOptions,
 			resp->numRcvdVendorSpecificHeaderOptions);
 
-	ret = _ocprocess_worker(_worker_crud_cb, ICD_CRUD_DELETE, NULL, res, options, ctx);
+	ret = _ocprocess_worker(_worker_crud_cb, ICD_CRUD_DELETE, resp, res, options, ctx);
 	if (IOTCON_ERROR_NONE != ret) {
 		ERR("_ocprocess_worker() Fail(%d)", ret);
 		icd_ioty_complete_error(ICD_CRUD_DELETE, ctx, ret);
@@ -735,6 +976,7 @@ static void _icd_observe_context_free(void *ctx)
 
 	g_variant_builder_unref(observe_ctx->options);
 	free(observe_ctx->bus_name);
+	OCPayloadDestroy(observe_ctx->oic_payload);
 	free(observe_ctx);
 }
 
@@ -742,13 +984,17 @@ static void _icd_observe_context_free(void *ctx)
 static int _worker_observe_cb(void *context)
 {
 	int ret;
-	GVariant *value;
+	GVariant *value, *payload;
 	struct icd_observe_context *ctx = context;
 
 	RETV_IF(NULL == ctx, IOTCON_ERROR_INVALID_PARAMETER);
 
-	value = g_variant_new("(a(qs)vii)", ctx->options, ctx->payload, ctx->res,
-			ctx->seqnum);
+	payload = icd_payload_to_gvariant_version(ctx->oic_payload,
+			icd_dbus_get_wire_version(ctx->bus_name));
+	if (NULL == payload)
+		payload = icd_payload_representation_empty_gvariant();
+
+	value = g_variant_new("(a(qs)vii)", ctx->options, payload, ctx->res, ctx->seqnum);
 
 	ret = _ocprocess_response_signal(ctx->bus_name, IC_DBUS_SIGNAL_OBSERVE,
 			ctx->signal_number, value);
@@ -793,6 +1039,8 @@ OCStackApplicationResult icd_ioty_ocprocess_observe_cb(void *ctx,
 	cb_result = (OC_OBSERVE_DEREGISTER == resp->sequenceNumber) ?
 		OC_STACK_DELETE_TRANSACTION : OC_STACK_KEEP_TRANSACTION;
 
+	icd_ioty_health_report(&resp->devAddr, resp->result);
+
 	if (NULL == resp->payload) {
 		ERR("payload is empty");
 		_observe_cb_response_error(sig_context->bus_name, sig_context->signal_number,
@@ -813,7 +1061,7 @@ OCStackApplicationResult icd_ioty_ocprocess_observe_cb(void *ctx,
 	options = _ocprocess_parse_header_options(resp->rcvdVendorSpecificHeaderOptions,
 			resp->numRcvdVendorSpecificHeaderOptions);
 
-	observe_ctx->payload = icd_payload_to_gvariant(resp->payload);
+	observe_ctx->oic_payload = _ocprocess_take_payload(resp);
 	observe_ctx->signal_number = sig_context->signal_number;
 	observe_ctx->res = res;
 	observe_ctx->bus_name = ic_utils_strdup(sig_context->bus_name);
@@ -825,11 +1073,7 @@ OCStackApplicationResult icd_ioty_ocprocess_observe_cb(void *ctx,
 	if (IOTCON_ERROR_NONE != ret) {
 		ERR("_ocprocess_worker_start() Fail(%d)", ret);
 		_observe_cb_response_error(sig_context->bus_name, sig_context->signal_number, ret);
-		free(observe_ctx->bus_name);
-		if (observe_ctx->payload)
-			g_variant_unref(observe_ctx->payload);
-		g_variant_builder_unref(observe_ctx->options);
-		free(observe_ctx);
+		_icd_observe_context_free(observe_ctx);
 		return cb_result;
 	}
 
@@ -849,13 +1093,36 @@ static void _icd_presence_context_free(void *ctx)
 }
 
 
+/* unicast the presence to the subscribers of the handle, filtered by resource type */
+static int _ocprocess_presence_signal(OCDoHandle handle, const char *resource_type,
+		int result, unsigned int nonce, const char *host_address, int conn_type,
+		int trigger)
+{
+	GList *cur, *bus_names;
+	GVariant *value;
+	int ret = IOTCON_ERROR_NONE;
+
+	bus_names = icd_dbus_client_list_get_presence_subscribers(handle, resource_type);
+
+	for (cur = bus_names; cur; cur = cur->next) {
+		value = g_variant_new("(iusiis)", result, nonce, host_address, conn_type,
+				trigger, ic_utils_dbus_encode_str(resource_type));
+		ret = _ocprocess_response_signal(cur->data, IC_DBUS_SIGNAL_PRESENCE,
+				ICD_POINTER_TO_INT64(handle), value);
+		if (IOTCON_ERROR_NONE != ret)
+			ERR("_ocprocess_response_signal() Fail(%d)", ret);
+	}
+	g_list_free_full(bus_names, free);
+
+	return ret;
+}
+
+
 static int _worker_presence_cb(void *context)
 {
-	int conn_type;
+	int ret, conn_type;
 	OCDoHandle handle;
 	char *host_address;
-	GVariant *value, *value2;
-	int ret = IOTCON_ERROR_NONE;
 	struct icd_presence_context *ctx = context;
 
 	RETV_IF(NULL == ctx, IOTCON_ERROR_INVALID_PARAMETER);
@@ -866,27 +1133,21 @@ static int _worker_presence_cb(void *context)
 		return ret;
 	}
 
-	value = g_variant_new("(iusiis)", ctx->result, ctx->nonce, host_address, conn_type,
-			ctx->trigger, ic_utils_dbus_encode_str(ctx->resource_type));
-	value2 = g_variant_ref(value);
-
-	free(host_address);
-
-	ret = _ocprocess_response_signal(NULL, IC_DBUS_SIGNAL_PRESENCE,
-			ICD_POINTER_TO_INT64(ctx->handle), value);
+	ret = _ocprocess_presence_signal(ctx->handle, ctx->resource_type, ctx->result,
+			ctx->nonce, host_address, conn_type, ctx->trigger);
 	if (IOTCON_ERROR_NONE != ret)
-		ERR("_ocprocess_response_signal() Fail(%d)", ret);
+		ERR("_ocprocess_presence_signal() Fail(%d)", ret);
 
 	handle = icd_ioty_presence_table_get_handle(ICD_MULTICAST_ADDRESS);
 	if (handle && (handle != ctx->handle)) {
-		ret = _ocprocess_response_signal(NULL, IC_DBUS_SIGNAL_PRESENCE,
-				ICD_POINTER_TO_INT64(handle), value2);
+		ret = _ocprocess_presence_signal(handle, ctx->resource_type, ctx->result,
+				ctx->nonce, host_address, conn_type, ctx->trigger);
 		if (IOTCON_ERROR_NONE != ret)
-			ERR("_ocprocess_response_signal() Fail(%d)", ret);
-	} else {
-		g_variant_unref(value2);
+			ERR("_ocprocess_presence_signal() Fail(%d)", ret);
 	}
 
+	free(host_address);
+
 	return ret;
 }
 
@@ -896,25 +1157,19 @@ static void _presence_cb_response_error(OCDoHandle handle, int ret_val)
 	FN_CALL;
 	int ret;
 	OCDoHandle handle2;
-	GVariant *value, *value2;
-
-	value = g_variant_new("(iusiis)", ret_val, 0, IC_STR_NULL, IOTCON_CONNECTIVITY_ALL,
-			IOTCON_PRESENCE_RESOURCE_CREATED, IC_STR_NULL);
-	value2 = g_variant_ref(value);
 
-	ret = _ocprocess_response_signal(NULL, IC_DBUS_SIGNAL_PRESENCE,
-			ICD_POINTER_TO_INT64(handle), value);
+	/* errors are sent to every subscriber regardless of resource type */
+	ret = _ocprocess_presence_signal(handle, NULL, ret_val, 0, IC_STR_NULL,
+			IOTCON_CONNECTIVITY_ALL, IOTCON_PRESENCE_RESOURCE_CREATED);
 	if (IOTCON_ERROR_NONE != ret)
-		ERR("_ocprocess_response_signal() Fail(%d)", ret);
+		ERR("_ocprocess_presence_signal() Fail(%d)", ret);
 
 	handle2 = icd_ioty_presence_table_get_handle(ICD_MULTICAST_ADDRESS);
 	if (handle2 && (handle2 != handle)) {
-		ret = _ocprocess_response_signal(NULL, IC_DBUS_SIGNAL_PRESENCE,
-				ICD_POINTER_TO_INT64(handle), value2);
+		ret = _ocprocess_presence_signal(handle2, NULL, ret_val, 0, IC_STR_NULL,
+				IOTCON_CONNECTIVITY_ALL, IOTCON_PRESENCE_RESOURCE_CREATED);
 		if (IOTCON_ERROR_NONE != ret)
-			ERR("_ocprocess_response_signal() Fail(%d)", ret);
-	} else {
-		g_variant_unref(value2);
+			ERR("_ocprocess_presence_signal() Fail(%d)", ret);
 	}
 }
 
@@ -953,6 +1208,8 @@ OCStackApplicationResult icd_ioty_ocprocess_presence_cb(void *ctx, OCDoHandle ha
 
 	RETV_IF(NULL == resp, OC_STACK_KEEP_TRANSACTION);
 
+	icd_ioty_health_report(&resp->devAddr, resp->result);
+
 	presence_ctx = calloc(1, sizeof(struct icd_presence_context));
 	if (NULL == presence_ctx) {
 		ERR("calloc() Fail(%d)", errno);
@@ -1013,6 +1270,7 @@ static void _icd_info_context_free(void *ctx)
 	struct icd_info_context *info_ctx = ctx;
 
 	free(info_ctx->bus_name);
+	OCPayloadDestroy(info_ctx->oic_payload);
 	free(info_ctx);
 }
 
@@ -1020,18 +1278,25 @@ static void _icd_info_context_free(void *ctx)
 static int _worker_info_cb(void *context)
 {
 	int ret;
+	GVariant *payload;
 	const char *signal_prefix = NULL;
 	struct icd_info_context *ctx = context;
 
 	RETV_IF(NULL == ctx, IOTCON_ERROR_INVALID_PARAMETER);
 
+	payload = icd_payload_to_gvariant(ctx->oic_payload);
+	if (NULL == payload) {
+		ERR("icd_payload_to_gvariant() Fail");
+		return IOTCON_ERROR_OUT_OF_MEMORY;
+	}
+
 	if (ICD_DEVICE_INFO == ctx->info_type)
 		signal_prefix = IC_DBUS_SIGNAL_DEVICE;
 	else if (ICD_PLATFORM_INFO == ctx->info_type)
 		signal_prefix = IC_DBUS_SIGNAL_PLATFORM;
 
 	ret = _ocprocess_response_signal(ctx->bus_name, signal_prefix, ctx->signal_number,
-			ctx->payload);
+			payload);
 	if (IOTCON_ERROR_NONE != ret)
 		ERR("_ocprocess_response_signal() Fail(%d)", ret);
 
@@ -1065,15 +1330,13 @@ OCStackApplicationResult icd_ioty_ocprocess_info_cb(void *ctx, OCDoHandle handle
 	}
 
 	info_ctx->info_type = info_type;
-	info_ctx->payload = icd_payload_to_gvariant(resp->payload);
+	info_ctx->oic_payload = _ocprocess_take_payload(resp);
 	info_ctx->signal_number = sig_context->signal_number;
 	info_ctx->bus_name = ic_utils_strdup(sig_context->bus_name);
 
 	ret = _ocprocess_worker_start(_worker_info_cb, info_ctx, _icd_info_context_free);
 	if (IOTCON_ERROR_NONE != ret) {
 		ERR("_ocprocess_worker_start() Fail(%d)", ret);
-		if (info_ctx->payload)
-			g_variant_unref(info_ctx->payload);
 		_icd_info_context_free(info_ctx);
 		return OC_STACK_KEEP_TRANSACTION;
 	}
@@ -1094,12 +1357,181 @@ static void _icd_encap_get_context_free(void *ctx)
 }
 
 
+/* unicast the value to the clients which subscribe the type of encapsulation */
+static int _ocprocess_encap_signal(icd_encap_info_s *encap_info, int type,
+		const char *signal_prefix, GVariant *value)
+{
+	GList *cur, *bus_names;
+	int ret = IOTCON_ERROR_NONE;
+
+	value = g_variant_ref_sink(value);
+
+	bus_names = icd_ioty_encap_get_clients(encap_info, type);
+	for (cur = bus_names; cur; cur = cur->next) {
+		ret = _ocprocess_response_signal(cur->data, signal_prefix,
+				encap_info->signal_number, g_variant_ref(value));
+		if (IOTCON_ERROR_NONE != ret)
+			ERR("_ocprocess_response_signal() Fail(%d)", ret);
+	}
+	g_list_free_full(bus_names, free);
+
+	g_variant_unref(value);
+
+	return ret;
+}
+
+
+/*
+ * The whole cached representation is "(tv)" : the digest and the representation.
+ * The delta is "(tt(a{sv}as))" : the digest of the representation which it is based on,
+ * the digest after it is applied, and the changed attributes.
+ * A client drops a delta which is not based on its cached representation, and asks
+ * for the whole one with encapResyncCaching.
+ * MUST be called with the state mutex of the encap_info
+ */
+static GVariant* _ocprocess_encap_caching_value(icd_encap_info_s *encap_info,
+		int version)
+{
+	GVariant *value;
+
+	value = icd_payload_to_gvariant_version((OCPayload*)encap_info->oic_payload, version);
+	if (NULL == value) {
+		ERR("icd_payload_to_gvariant_version() Fail");
+		return NULL;
+	}
+
+	return g_variant_ref_sink(g_variant_new("(tv)", encap_info->oic_payload_digest,
+				value));
+}
+
+
+/* unicast the cached representation to the caching clients. The clients which take the
+ * changed attributes only receive the delta, once they hold the previous representation.
+ * MUST be called with the state mutex of the encap_info */
+static int _ocprocess_encap_caching_signal(icd_encap_info_s *encap_info, GVariant *delta)
+{
+	int version;
+	GList *cur, *bus_names;
+	GVariant *caching_value;
+	/* the representation is encoded once for each wire version */
+	GVariant *value[IC_WIRE_VERSION_MAX + 1] = {NULL};
+	int ret = IOTCON_ERROR_NONE;
+
+	if (delta)
+		delta = g_variant_ref_sink(delta);
+
+	bus_names = icd_ioty_encap_get_clients(encap_info, ICD_ENCAP_CACHING);
+	for (cur = bus_names; cur; cur = cur->next) {
+		if (delta && icd_ioty_encap_client_take_delta(encap_info, cur->data)) {
+			caching_value = g_variant_ref(delta);
+		} else {
+			version = icd_dbus_get_wire_version(cur->data);
+			if (NULL == value[version])
+				value[version] = _ocprocess_encap_caching_value(encap_info, version);
+			if (NULL == value[version])
+				continue;
+			caching_value = g_variant_ref(value[version]);
+		}
+
+		ret = _ocprocess_response_signal(cur->data, IC_DBUS_SIGNAL_CACHING,
+				encap_info->signal_number, caching_value);
+		if (IOTCON_ERROR_NONE != ret) {
+			ERR("_ocprocess_response_signal() Fail(%d)", ret);
+			/* the next delta would be based on the missed one */
+			icd_ioty_encap_client_unsynced(encap_info, cur->data);
+			continue;
+		}
+		if (caching_value != delta)
+			icd_ioty_encap_client_synced(encap_info, cur->data);
+	}
+	g_list_free_full(bus_names, free);
+
+	for (version = 0; version <= IC_WIRE_VERSION_MAX; version++) {
+		if (value[version])
+			g_variant_unref(value[version]);
+	}
+	if (delta)
+		g_variant_unref(delta);
+
+	return ret;
+}
+
+
+/* the client dropped a delta. Send the whole cached representation to it again */
+int icd_ioty_ocprocess_encap_resync(const char *uri_path, const char *host_address,
+		const char *bus_name)
+{
+	int ret;
+	GVariant *value;
+	icd_encap_info_s *encap_info;
+
+	RETV_IF(NULL == uri_path, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(NULL == host_address, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(NULL == bus_name, IOTCON_ERROR_INVALID_PARAMETER);
+
+	encap_info = icd_ioty_encap_table_ref_info(uri_path, host_address);
+	if (NULL == encap_info) {
+		ERR("icd_ioty_encap_table_ref_info() Fail");
+		return IOTCON_ERROR_NO_DATA;
+	}
+
+	g_mutex_lock(&encap_info->state_mutex);
+	icd_ioty_encap_client_unsynced(encap_info, bus_name);
+
+	/* nothing is cached yet. The first one is sent as a whole */
+	if (NULL == encap_info->oic_payload) {
+		g_mutex_unlock(&encap_info->state_mutex);
+		icd_ioty_encap_info_unref(encap_info);
+		return IOTCON_ERROR_NONE;
+	}
+
+	value = _ocprocess_encap_caching_value(encap_info, icd_dbus_get_wire_version(bus_name));
+	if (NULL == value) {
+		ERR("_ocprocess_encap_caching_value() Fail");
+		g_mutex_unlock(&encap_info->state_mutex);
+		icd_ioty_encap_info_unref(encap_info);
+		return IOTCON_ERROR_OUT_OF_MEMORY;
+	}
+
+	ret = _ocprocess_response_signal(bus_name, IC_DBUS_SIGNAL_CACHING,
+			encap_info->signal_number, value);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("_ocprocess_response_signal() Fail(%d)", ret);
+		g_mutex_unlock(&encap_info->state_mutex);
+		icd_ioty_encap_info_unref(encap_info);
+		return ret;
+	}
+	icd_ioty_encap_client_synced(encap_info, bus_name);
+	g_mutex_unlock(&encap_info->state_mutex);
+	icd_ioty_encap_info_unref(encap_info);
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+static bool _ocprocess_encap_payload_changed(icd_encap_info_s *encap_info,
+		OCRepPayload *payload, uint64_t digest)
+{
+	if (NULL == encap_info->oic_payload || NULL == payload)
+		return encap_info->oic_payload != payload;
+
+	if (digest != encap_info->oic_payload_digest)
+		return true;
+
+	/* same digest : rule out a collision */
+	return (IC_EQUAL != icd_payload_representation_compare(encap_info->oic_payload,
+				payload));
+}
+
+
 static int _worker_encap_get_cb(void *context)
 {
 	int ret, conn_type;
 	char *host_address;
+	bool changed = false;
+	uint64_t digest = 0, base_digest;
 	icd_encap_info_s *encap_info;
-	GVariant *monitoring_value, *caching_value;
+	GVariant *monitoring_value, *delta_value;
 	iotcon_remote_resource_state_e resource_state;
 	struct icd_encap_get_context *encap_get_ctx = context;
 
@@ -1107,17 +1539,38 @@ static int _worker_encap_get_cb(void *context)
 	ret = icd_ioty_get_host_address(&encap_get_ctx->dev_addr, &host_address, &conn_type);
 	if (IOTCON_ERROR_NONE != ret) {
 		ERR("icd_ioty_get_host_address() Fail");
+		OCRepPayloadDestroy(encap_get_ctx->oic_payload);
 		return ret;
 	}
 
-	encap_info = _icd_ioty_encap_table_get_info(encap_get_ctx->uri_path, host_address);
+	/* the entry could be removed in the main thread meanwhile */
+	encap_info = icd_ioty_encap_table_ref_info(encap_get_ctx->uri_path, host_address);
 	if (NULL == encap_info) {
-		ERR("_icd_ioty_encap_table_get_info() Fail");
+		ERR("icd_ioty_encap_table_ref_info() Fail");
 		free(host_address);
+		OCRepPayloadDestroy(encap_get_ctx->oic_payload);
 		return IOTCON_ERROR_NO_DATA;
 	}
 	free(host_address);
 
+	/* the resource answers the probe */
+	if (OC_STACK_OK == encap_get_ctx->ret)
+		g_atomic_int_set(&encap_info->probe_pending, 0);
+
+	/* The resource is alive and observed, or answered in the batch of its collection.
+	 * Poll only if the observation is silent. */
+	if (encap_get_ctx->is_observe || encap_get_ctx->is_batch)
+		icd_ioty_encap_poll_later(encap_info);
+	else if (OC_STACK_OK != encap_get_ctx->ret)
+		changed = true;
+
+	if (0 < encap_info->caching_count && OC_STACK_OK == encap_get_ctx->ret
+			&& false == encap_get_ctx->is_probe)
+		digest = icd_payload_representation_digest(encap_get_ctx->oic_payload);
+
+	/* the results of the polls, the observation and the batches come at once */
+	g_mutex_lock(&encap_info->state_mutex);
+
 	/* MONITORING */
 	if (0 < encap_info->monitoring_count) {
 		switch (encap_get_ctx->ret) {
@@ -1128,65 +1581,74 @@ static int _worker_encap_get_cb(void *context)
 		default:
 			resource_state = IOTCON_REMOTE_RESOURCE_LOST_SIGNAL;
 		}
-		if (resource_state != encap_info->resource_state) {
-			encap_info->resource_state = resource_state;
+		if (icd_ioty_encap_update_state(encap_info, resource_state)) {
+			changed = true;
 			monitoring_value = g_variant_new("(i)", resource_state);
-			ret = _ocprocess_response_signal(NULL, IC_DBUS_SIGNAL_MONITORING,
-					encap_info->signal_number, monitoring_value);
-			if (IOTCON_ERROR_NONE != ret) {
-				ERR("_ocprocess_response_signal() Fail(%d)", ret);
-				OCRepPayloadDestroy(encap_get_ctx->oic_payload);
-				return ret;
-			}
+			ret = _ocprocess_encap_signal(encap_info, ICD_ENCAP_MONITORING,
+					IC_DBUS_SIGNAL_MONITORING, monitoring_value);
+			if (IOTCON_ERROR_NONE != ret)
+				ERR("_ocprocess_encap_signal() Fail(%d)", ret);
 		}
 	}
 
 	/* CACHING */
-	if (0 < encap_info->caching_count) {
-		if (OC_STACK_OK != encap_get_ctx->ret) {
-			OCRepPayloadDestroy(encap_get_ctx->oic_payload);
-			return IOTCON_ERROR_NONE;
-		}
-
-		ret = icd_payload_representation_compare(encap_info->oic_payload,
+	if (0 < encap_info->caching_count && OC_STACK_OK == encap_get_ctx->ret
+			&& false == encap_get_ctx->is_probe
+			&& _ocprocess_encap_payload_changed(encap_info, encap_get_ctx->oic_payload,
+				digest)) {
+		changed = true;
+		delta_value = icd_payload_representation_delta_gvariant(encap_info->oic_payload,
 				encap_get_ctx->oic_payload);
-		if (IC_EQUAL == ret) {
-			OCRepPayloadDestroy(encap_get_ctx->oic_payload);
-			return IOTCON_ERROR_NONE;
-		}
-
+		base_digest = encap_info->oic_payload_digest;
+		if (delta_value)
+			delta_value = g_variant_new("(tt@(a{sv}as))", base_digest, digest, delta_value);
+		OCRepPayloadDestroy(encap_info->oic_payload);
 		encap_info->oic_payload = encap_get_ctx->oic_payload;
-		caching_value = icd_payload_to_gvariant((OCPayload*)encap_get_ctx->oic_payload);
+		encap_info->oic_payload_digest = digest;
 
-		ret = _ocprocess_response_signal(NULL, IC_DBUS_SIGNAL_CACHING,
-				encap_info->signal_number, caching_value);
-		if (IOTCON_ERROR_NONE != ret) {
-			ERR("_ocprocess_response_signal() Fail(%d)", ret);
-			return ret;
-		}
+		ret = _ocprocess_encap_caching_signal(encap_info, delta_value);
+		if (IOTCON_ERROR_NONE != ret)
+			ERR("_ocprocess_encap_caching_signal() Fail(%d)", ret);
+
+		icd_ioty_encap_history_add(encap_info, encap_info->oic_payload);
+	} else {
+		OCRepPayloadDestroy(encap_get_ctx->oic_payload);
 	}
+	g_mutex_unlock(&encap_info->state_mutex);
 
-	return IOTCON_ERROR_NONE;
+	/* the interval is adapted only by polling */
+	if (false == encap_get_ctx->is_observe && false == encap_get_ctx->is_batch)
+		icd_ioty_encap_update_interval(encap_info, changed);
+
+	icd_ioty_encap_info_unref(encap_info);
+
+	return ret;
 }
 
 
-OCStackApplicationResult icd_ioty_ocprocess_encap_get_cb(void *ctx, OCDoHandle handle,
-		OCClientResponse *resp)
+/* The probe of monitoring proves only that the resource answers. Its payload is not used. */
+static int _ocprocess_encap_update(OCClientResponse *resp, bool is_observe,
+		bool is_probe)
 {
 	int ret;
 	struct icd_encap_get_context *encap_get_ctx;
 
-	RETV_IF(NULL == resp, OC_STACK_DELETE_TRANSACTION);
+	icd_ioty_health_report(&resp->devAddr, resp->result);
 
 	encap_get_ctx = calloc(1, sizeof(struct icd_encap_get_context));
 	if (NULL == encap_get_ctx) {
 		ERR("calloc() Fail(%d)", errno);
-		return OC_STACK_DELETE_TRANSACTION;
+		return IOTCON_ERROR_OUT_OF_MEMORY;
 	}
 
 	encap_get_ctx->ret = resp->result;
-	encap_get_ctx->oic_payload = OCRepPayloadClone((OCRepPayload*)resp->payload);
+	/* the response is given to the worker thread without a copy */
+	if (false == is_probe && resp->payload
+			&& PAYLOAD_TYPE_REPRESENTATION == resp->payload->type)
+		encap_get_ctx->oic_payload = (OCRepPayload*)_ocprocess_take_payload(resp);
 	encap_get_ctx->uri_path = ic_utils_strdup(resp->resourceUri);
+	encap_get_ctx->is_observe = is_observe;
+	encap_get_ctx->is_probe = is_probe;
 	memcpy(&encap_get_ctx->dev_addr, &resp->devAddr, sizeof(OCDevAddr));
 
 	ret = _ocprocess_worker_start(_worker_encap_get_cb, encap_get_ctx,
@@ -1195,13 +1657,272 @@ OCStackApplicationResult icd_ioty_ocprocess_encap_get_cb(void *ctx, OCDoHandle h
 		ERR("_ocprocess_worker_start() Fail(%d)", ret);
 		OCRepPayloadDestroy((OCRepPayload*)encap_get_ctx->oic_payload);
 		_icd_encap_get_context_free(encap_get_ctx);
+		return ret;
+	}
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+OCStackApplicationResult icd_ioty_ocprocess_encap_get_cb(void *ctx, OCDoHandle handle,
+		OCClientResponse *resp)
+{
+	int ret;
+
+	RETV_IF(NULL == resp, OC_STACK_DELETE_TRANSACTION);
+
+	ret = _ocprocess_encap_update(resp, false, false);
+	if (IOTCON_ERROR_NONE != ret)
+		ERR("_ocprocess_encap_update() Fail(%d)", ret);
+
+	return OC_STACK_DELETE_TRANSACTION;
+}
+
+
+OCStackApplicationResult icd_ioty_ocprocess_encap_probe_cb(void *ctx, OCDoHandle handle,
+		OCClientResponse *resp)
+{
+	int ret;
+
+	RETV_IF(NULL == resp, OC_STACK_DELETE_TRANSACTION);
+
+	ret = _ocprocess_encap_update(resp, false, true);
+	if (IOTCON_ERROR_NONE != ret)
+		ERR("_ocprocess_encap_update() Fail(%d)", ret);
+
+	return OC_STACK_DELETE_TRANSACTION;
+}
+
+
+/* the probe of the resource is not answered */
+int icd_ioty_ocprocess_encap_timeout(const char *uri_path, OCDevAddr *dev_addr)
+{
+	int ret;
+	struct icd_encap_get_context *encap_get_ctx;
+
+	RETV_IF(NULL == uri_path, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(NULL == dev_addr, IOTCON_ERROR_INVALID_PARAMETER);
+
+	encap_get_ctx = calloc(1, sizeof(struct icd_encap_get_context));
+	if (NULL == encap_get_ctx) {
+		ERR("calloc() Fail(%d)", errno);
+		return IOTCON_ERROR_OUT_OF_MEMORY;
+	}
+
+	encap_get_ctx->ret = OC_STACK_TIMEOUT;
+	encap_get_ctx->uri_path = ic_utils_strdup(uri_path);
+	encap_get_ctx->is_probe = true;
+	memcpy(&encap_get_ctx->dev_addr, dev_addr, sizeof(OCDevAddr));
+
+	ret = _ocprocess_worker_start(_worker_encap_get_cb, encap_get_ctx,
+			_icd_encap_get_context_free);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("_ocprocess_worker_start() Fail(%d)", ret);
+		_icd_encap_get_context_free(encap_get_ctx);
+		return ret;
+	}
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+static void _icd_encap_discover_context_free(void *ctx)
+{
+	struct icd_encap_discover_context *discover_ctx = ctx;
+
+	g_list_free_full(discover_ctx->collections, free);
+	free(discover_ctx);
+}
+
+
+static int _worker_encap_discover_cb(void *context)
+{
+	int ret, conn_type;
+	char *host_address;
+	struct icd_encap_discover_context *ctx = context;
+
+	ret = icd_ioty_get_host_address(&ctx->dev_addr, &host_address, &conn_type);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("icd_ioty_get_host_address() Fail(%d)", ret);
+		return ret;
+	}
+
+	icd_ioty_encap_host_set_batches(host_address, ctx->collections);
+	ctx->collections = NULL;
+	free(host_address);
+
+	icd_ioty_ocprocess_wakeup();
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+/* the collections of the host, which support the batch interface */
+OCStackApplicationResult icd_ioty_ocprocess_encap_discover_cb(void *ctx,
+		OCDoHandle handle, OCClientResponse *resp)
+{
+	int ret;
+	OCStringLL *node;
+	OCResourcePayload *resource;
+	struct icd_encap_discover_context *discover_ctx;
+
+	RETV_IF(NULL == resp, OC_STACK_DELETE_TRANSACTION);
+	if (OC_STACK_OK != resp->result || NULL == resp->payload)
 		return OC_STACK_DELETE_TRANSACTION;
+	RETVM_IF(PAYLOAD_TYPE_DISCOVERY != resp->payload->type,
+			OC_STACK_DELETE_TRANSACTION, "Invalid payload type(%d)", resp->payload->type);
+
+	discover_ctx = calloc(1, sizeof(struct icd_encap_discover_context));
+	if (NULL == discover_ctx) {
+		ERR("calloc() Fail(%d)", errno);
+		return OC_STACK_DELETE_TRANSACTION;
+	}
+
+	resource = ((OCDiscoveryPayload*)resp->payload)->resources;
+	for (; resource; resource = resource->next) {
+		for (node = resource->interfaces; node; node = node->next) {
+			if (IC_STR_EQUAL != g_strcmp0(node->value, IOTCON_INTERFACE_BATCH))
+				continue;
+			discover_ctx->collections = g_list_append(discover_ctx->collections,
+					ic_utils_strdup(resource->uri));
+			break;
+		}
+	}
+	memcpy(&discover_ctx->dev_addr, &resp->devAddr, sizeof(OCDevAddr));
+
+	if (NULL == discover_ctx->collections) {
+		_icd_encap_discover_context_free(discover_ctx);
+		return OC_STACK_DELETE_TRANSACTION;
+	}
+
+	ret = _ocprocess_worker_start(_worker_encap_discover_cb, discover_ctx,
+			_icd_encap_discover_context_free);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("_ocprocess_worker_start() Fail(%d)", ret);
+		_icd_encap_discover_context_free(discover_ctx);
 	}
 
 	return OC_STACK_DELETE_TRANSACTION;
 }
 
 
+static void _icd_encap_batch_context_free(void *ctx)
+{
+	struct icd_encap_batch_context *batch_ctx = ctx;
+
+	free(batch_ctx->collection);
+	OCPayloadDestroy(batch_ctx->oic_payload);
+	free(batch_ctx);
+}
+
+
+/* fan the representation of the member out into its encap_info */
+static void _ocprocess_encap_batch_update(OCDevAddr *dev_addr, OCRepPayload *member)
+{
+	int ret;
+	struct icd_encap_get_context encap_get_ctx = {0};
+
+	encap_get_ctx.ret = OC_STACK_OK;
+	encap_get_ctx.oic_payload = member;
+	encap_get_ctx.uri_path = member->uri;
+	encap_get_ctx.is_batch = true;
+	memcpy(&encap_get_ctx.dev_addr, dev_addr, sizeof(OCDevAddr));
+
+	/* the payload is taken by _worker_encap_get_cb() */
+	ret = _worker_encap_get_cb(&encap_get_ctx);
+	if (IOTCON_ERROR_NONE != ret)
+		ERR("_worker_encap_get_cb() Fail(%d)", ret);
+}
+
+
+static int _worker_encap_batch_cb(void *context)
+{
+	int ret, conn_type;
+	char *host_address;
+	GList *members = NULL;
+	OCRepPayload *member, *next;
+	icd_encap_info_s *encap_info;
+	struct icd_encap_batch_context *ctx = context;
+
+	ret = icd_ioty_get_host_address(&ctx->dev_addr, &host_address, &conn_type);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("icd_ioty_get_host_address() Fail(%d)", ret);
+		return ret;
+	}
+
+	/* the members fall back to their own polls */
+	if (OC_STACK_OK != ctx->ret || NULL == ctx->oic_payload
+			|| PAYLOAD_TYPE_REPRESENTATION != ctx->oic_payload->type) {
+		ERR("batch of %s Fail(%d)", ctx->collection, ctx->ret);
+		icd_ioty_encap_host_remove_batch(host_address, ctx->collection);
+		free(host_address);
+		return IOTCON_ERROR_IOTIVITY;
+	}
+
+	for (member = (OCRepPayload*)ctx->oic_payload; member; member = member->next) {
+		if (member->uri)
+			members = g_list_prepend(members, ic_utils_strdup(member->uri));
+	}
+	icd_ioty_encap_host_set_members(host_address, ctx->collection, members);
+
+	member = (OCRepPayload*)ctx->oic_payload;
+	ctx->oic_payload = NULL;
+	for (; member; member = next) {
+		next = member->next;
+		member->next = NULL;
+
+		encap_info = NULL;
+		if (member->uri)
+			encap_info = icd_ioty_encap_table_ref_info(member->uri, host_address);
+		if (NULL == encap_info) {
+			OCRepPayloadDestroy(member);
+			continue;
+		}
+		icd_ioty_encap_info_unref(encap_info);
+		_ocprocess_encap_batch_update(&ctx->dev_addr, member);
+	}
+	free(host_address);
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+/* one response carries the representations of all members in the collection */
+OCStackApplicationResult icd_ioty_ocprocess_encap_batch_cb(void *ctx, OCDoHandle handle,
+		OCClientResponse *resp)
+{
+	int ret;
+	struct icd_encap_batch_context *batch_ctx;
+
+	RETV_IF(NULL == ctx, OC_STACK_DELETE_TRANSACTION);
+	RETV_IF(NULL == resp, OC_STACK_DELETE_TRANSACTION);
+
+	icd_ioty_health_report(&resp->devAddr, resp->result);
+
+	batch_ctx = calloc(1, sizeof(struct icd_encap_batch_context));
+	if (NULL == batch_ctx) {
+		ERR("calloc() Fail(%d)", errno);
+		return OC_STACK_DELETE_TRANSACTION;
+	}
+
+	batch_ctx->ret = resp->result;
+	batch_ctx->collection = ic_utils_strdup(ctx);
+	batch_ctx->oic_payload = _ocprocess_take_payload(resp);
+	memcpy(&batch_ctx->dev_addr, &resp->devAddr, sizeof(OCDevAddr));
+
+	ret = _ocprocess_worker_start(_worker_encap_batch_cb, batch_ctx,
+			_icd_encap_batch_context_free);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("_ocprocess_worker_start() Fail(%d)", ret);
+		_icd_encap_batch_context_free(batch_ctx);
+	}
+
+	/* DO NOT FREE ctx. It MUST be freed in the ocstack */
+
+	return OC_STACK_DELETE_TRANSACTION;
+}
+
+
 static int _worker_encap_get(void *context)
 {
 	int ret, conn_type;
@@ -1218,18 +1939,16 @@ static int _worker_encap_get(void *context)
 		return ret;
 	}
 
-	encap_info = _icd_ioty_encap_table_get_info(encap_ctx->uri_path, host_address);
+	encap_info = icd_ioty_encap_table_ref_info(encap_ctx->uri_path, host_address);
 	if (NULL == encap_info) {
-		ERR("_icd_ioty_encap_table_get_info() Fail");
+		ERR("icd_ioty_encap_table_ref_info() Fail");
 		free(host_address);
 		return IOTCON_ERROR_NO_DATA;
 	}
 	free(host_address);
 
-	g_source_remove(encap_info->get_timer_id);
-	icd_ioty_encap_get(encap_info);
-	encap_info->get_timer_id = g_timeout_add_seconds(icd_ioty_encap_get_time_interval(),
-			icd_ioty_encap_get, encap_info);
+	icd_ioty_encap_poll_now(encap_info);
+	icd_ioty_encap_info_unref(encap_info);
 
 	return IOTCON_ERROR_NONE;
 }
@@ -1250,6 +1969,14 @@ OCStackApplicationResult icd_ioty_ocprocess_encap_observe_cb(void *ctx, OCDoHand
 	if (OC_STACK_OK != resp->result)
 		return OC_STACK_KEEP_TRANSACTION;
 
+	/* The notification has the representation. Update the cache with it directly. */
+	if (resp->payload && PAYLOAD_TYPE_REPRESENTATION == resp->payload->type) {
+		ret = _ocprocess_encap_update(resp, true, false);
+		if (IOTCON_ERROR_NONE != ret)
+			ERR("_ocprocess_encap_update() Fail(%d)", ret);
+		return OC_STACK_KEEP_TRANSACTION;
+	}
+
 	memcpy(&encap_ctx->dev_addr, &resp->devAddr, sizeof(OCDevAddr));
 
 	ret = _ocprocess_worker_start(_worker_encap_get, encap_ctx, NULL);
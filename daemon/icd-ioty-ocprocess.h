@@ -19,7 +19,25 @@
 #include <glib.h>
 #include <octypes.h>
 
+/* can be overridden at build time (WORKER_POOL_SIZE, WORKER_QUEUE_MAX) */
+#ifndef ICD_WORKER_POOL_SIZE
+#define ICD_WORKER_POOL_SIZE 4
+#endif
+
+#ifndef ICD_WORKER_QUEUE_MAX
+#define ICD_WORKER_QUEUE_MAX 1024
+#endif
+
+/* seconds between the reports of the worker queue */
+#define ICD_WORKER_STATS_INTERVAL 60
+
 void icd_ioty_ocprocess_stop();
+void icd_ioty_ocprocess_wakeup();
+
+int icd_ioty_ocprocess_worker_pool_init(int max_threads, unsigned int max_queue);
+void icd_ioty_ocprocess_worker_pool_deinit();
+void icd_ioty_ocprocess_worker_pool_get_stats(unsigned int *queue_depth,
+		unsigned int *queue_peak, unsigned int *pushed_count, unsigned int *rejected_count);
 
 gpointer icd_ioty_ocprocess_thread(gpointer data);
 
@@ -53,6 +71,19 @@ OCStackApplicationResult icd_ioty_ocprocess_info_cb(void *ctx, OCDoHandle handle
 OCStackApplicationResult icd_ioty_ocprocess_encap_get_cb(void *ctx, OCDoHandle handle,
 		OCClientResponse* resp);
 
+OCStackApplicationResult icd_ioty_ocprocess_encap_probe_cb(void *ctx, OCDoHandle handle,
+		OCClientResponse* resp);
+
+int icd_ioty_ocprocess_encap_timeout(const char *uri_path, OCDevAddr *dev_addr);
+int icd_ioty_ocprocess_encap_resync(const char *uri_path, const char *host_address,
+		const char *bus_name);
+
+OCStackApplicationResult icd_ioty_ocprocess_encap_discover_cb(void *ctx,
+		OCDoHandle handle, OCClientResponse* resp);
+
+OCStackApplicationResult icd_ioty_ocprocess_encap_batch_cb(void *ctx, OCDoHandle handle,
+		OCClientResponse* resp);
+
 OCStackApplicationResult icd_ioty_ocprocess_encap_observe_cb(void *ctx, OCDoHandle handle,
 		OCClientResponse* resp);
 
@@ -31,14 +31,30 @@
 #include "icd.h"
 #include "icd-cynara.h"
 #include "icd-payload.h"
+#include "icd-blob.h"
 #include "icd-dbus.h"
 #include "icd-ioty.h"
 #include "icd-ioty-type.h"
 #include "icd-ioty-ocprocess.h"
+#include "icd-ioty-health.h"
 
 #define ICD_UUID_LENGTH 37
 #define ICD_REMOTE_RESOURCE_DEFAULT_TIME_INTERVAL 10 /* 10 sec */
 
+/* encap poll scheduler */
+#define ICD_ENCAP_WHEEL_TICK 100 /* 100 ms */
+#define ICD_ENCAP_WHEEL_SIZE 1024 /* slots, about 100 sec per revolution */
+#define ICD_ENCAP_POLL_MAX_PER_TICK 16
+#define ICD_ENCAP_POLL_MAX_PER_HOST 2 /* in a tick */
+#define ICD_ENCAP_RETRY_INTERVAL 1000 /* ms, while a state transition is pending */
+#define ICD_ENCAP_DEFAULT_LOST_COUNT 3 /* failures in a row, until the signal is lost */
+#define ICD_ENCAP_DEFAULT_ALIVE_COUNT 2 /* successes in a row, until alive */
+#define ICD_ENCAP_DEFAULT_DWELL_TIME 3000 /* ms, the minimum time in a state */
+#define ICD_ENCAP_MAX_DWELL_TIME (60 * 60 * 1000) /* 60 min */
+#define ICD_ENCAP_BATCH_HOLD G_TIME_SPAN_SECOND /* a batch request covers the polls within */
+#define ICD_ENCAP_BATCH_REDISCOVER (10 * G_TIME_SPAN_MINUTE)
+#define ICD_ENCAP_MAX_HISTORY 1024
+
 static int icd_remote_resource_time_interval = ICD_REMOTE_RESOURCE_DEFAULT_TIME_INTERVAL;
 
 static const char *ICD_SYSTEM_INFO_PLATFORM_NAME = "http://tizen.org/system/platform.name";
@@ -47,26 +63,241 @@ static const char *ICD_SYSTEM_INFO_MANUF_NAME = "http://tizen.org/system/manufac
 static const char *ICD_SYSTEM_INFO_MODEL_NAME = "http://tizen.org/system/model_name";
 static const char *ICD_SYSTEM_INFO_BUILD_STRING = "http://tizen.org/system/build.string";
 
-static GHashTable *icd_ioty_encap_table;
+static GMutex icd_ioty_encap_table_mutex;
+static GHashTable *icd_ioty_encap_table; /* added and removed only in the main thread */
 static GHashTable *icd_ioty_presence_table;
 
+/* All encap polls are driven by one timer wheel.
+ * The wheel is also touched by the workers, so it is guarded by the mutex.
+ * The timer is armed for the next slot which has an entry, not for every tick.
+ * base_time is the time of the current slot, and the wheel catches up when it wakes. */
+static struct {
+	GMutex mutex;
+	GQueue slots[ICD_ENCAP_WHEEL_SIZE];
+	unsigned int cur;
+	unsigned int count;
+	gint64 base_time;
+	gint64 due_time;
+	guint timer_id;
+} icd_encap_wheel;
+
+/* The encap entries are grouped by host. If the host has collections with the batch
+ * interface, their members are polled with one batch request per collection. */
+typedef struct {
+	char *uri_path;
+	gint64 request_time;
+} icd_encap_batch_s;
+
+typedef struct {
+	OCDevAddr dev_addr;
+	OCConnectivityType oic_conn_type;
+	int encap_count;
+	bool relearn;
+	gint64 discover_time;
+	GList *batches; /* icd_encap_batch_s */
+	GHashTable *members; /* key : uri path of a member, value : icd_encap_batch_s */
+} icd_encap_host_s;
+
+static GMutex icd_encap_host_mutex;
+static GHashTable *icd_encap_host_table; /* key : host address */
+
 static GMutex icd_csdk_mutex;
+static GAsyncQueue *icd_csdk_cmd_queue;
+
+/* The hold time of the csdk lock is measured with IC_DEBUGGING, and reported every
+ * ICD_CSDK_LOCK_STATS_INTERVAL seconds. It is only accessed with the lock held. */
+#ifdef IC_DEBUGGING
+#define ICD_CSDK_LOCK_HOLD_WARN (100 * G_TIME_SPAN_MILLISECOND) /* 100 ms */
+#define ICD_CSDK_LOCK_STATS_INTERVAL 60
+static gint64 icd_csdk_lock_time;
+static gint64 icd_csdk_lock_hold_max;
+static gint64 icd_csdk_lock_hold_total;
+static unsigned int icd_csdk_lock_count;
+static guint icd_csdk_lock_stats_timer;
+#endif
+
+typedef struct {
+	icd_ioty_csdk_cmd_fn fn;
+	icd_ioty_csdk_cmd_fn cancel; /* frees data without fn, on deinit */
+	void *data;
+} icd_csdk_cmd_s;
+
+typedef struct {
+	GDBusMethodInvocation *invocation;
+	OCResourceHandle handle;
+	OCRepPayload *payload;
+	OCQualityOfService qos;
+	int obs_length;
+	OCObservationId *obs_ids;
+} icd_notify_cmd_s;
+
+typedef struct {
+	GDBusMethodInvocation *invocation;
+	OCEntityHandlerResponse response;
+} icd_response_cmd_s;
+
+typedef struct {
+	int type;
+	GDBusMethodInvocation *invocation;
+	OCMethod rest_type;
+	char *uri;
+	OCDevAddr dev_addr;
+	OCPayload *payload;
+	OCConnectivityType oic_conn_type;
+	OCCallbackData cbdata;
+	OCHeaderOption oic_options[MAX_HEADER_OPTIONS];
+	int options_size;
+} icd_crud_cmd_s;
+
+typedef struct {
+	int type;
+	GDBusMethodInvocation *invocation;
+	char uri[PATH_MAX];
+	OCConnectivityType oic_conn_type;
+	OCCallbackData cbdata;
+	int timeout;
+	int64_t signal_number;
+} icd_discover_cmd_s;
+
+/* a request of the encap polls. It is sent in the stack thread, not in the main loop */
+typedef struct icd_encap_poll_cmd_s {
+	OCMethod method;
+	char *uri;
+	OCDevAddr dev_addr;
+	OCConnectivityType oic_conn_type;
+	OCQualityOfService qos;
+	OCCallbackData cbdata;
+	char *host_address; /* batch request : the collection is marked failed on failure */
+	char *collection;
+	struct icd_encap_poll_cmd_s *fallback; /* batch request : the entry polled by itself */
+} icd_encap_poll_cmd_s;
 
 void icd_ioty_csdk_lock()
 {
 	g_mutex_lock(&icd_csdk_mutex);
+#ifdef IC_DEBUGGING
+	icd_csdk_lock_time = g_get_monotonic_time();
+#endif
 }
 
 
 void icd_ioty_csdk_unlock()
 {
+#ifdef IC_DEBUGGING
+	gint64 hold_time;
+
+	hold_time = g_get_monotonic_time() - icd_csdk_lock_time;
+	icd_csdk_lock_hold_total += hold_time;
+	icd_csdk_lock_count++;
+	if (icd_csdk_lock_hold_max < hold_time)
+		icd_csdk_lock_hold_max = hold_time;
+	g_mutex_unlock(&icd_csdk_mutex);
+
+	if (ICD_CSDK_LOCK_HOLD_WARN < hold_time)
+		WARN("csdk lock was held for %lld us", hold_time);
+#else
+	g_mutex_unlock(&icd_csdk_mutex);
+#endif
+}
+
+
+#ifdef IC_DEBUGGING
+/* the hold time since the last report. The report is not counted itself */
+static gboolean _icd_ioty_csdk_lock_stats_cb(gpointer user_data)
+{
+	unsigned int count;
+	gint64 hold_max, hold_total;
+
+	g_mutex_lock(&icd_csdk_mutex);
+	count = icd_csdk_lock_count;
+	hold_max = icd_csdk_lock_hold_max;
+	hold_total = icd_csdk_lock_hold_total;
+	icd_csdk_lock_count = 0;
+	icd_csdk_lock_hold_max = 0;
+	icd_csdk_lock_hold_total = 0;
 	g_mutex_unlock(&icd_csdk_mutex);
+
+	if (0 == count)
+		return G_SOURCE_CONTINUE;
+
+	INFO("csdk lock : count(%u), avg(%lld us), max(%lld us)", count, hold_total / count,
+			hold_max);
+
+	return G_SOURCE_CONTINUE;
+}
+#endif
+
+
+/*
+ * Queue a stack operation to the stack thread. DO NOT call the iotivity API
+ * from the GLib main loop for frequent operations, it would wait for OCProcess().
+ * If the daemon stops before the stack thread runs fn, cancel is called instead.
+ * It MUST free data and complete the invocation of data with an error.
+ */
+int icd_ioty_csdk_cmd_push(icd_ioty_csdk_cmd_fn fn, icd_ioty_csdk_cmd_fn cancel,
+		void *data)
+{
+	icd_csdk_cmd_s *cmd;
+
+	RETV_IF(NULL == fn, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(NULL == cancel, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(NULL == icd_csdk_cmd_queue, IOTCON_ERROR_SYSTEM);
+
+	cmd = calloc(1, sizeof(icd_csdk_cmd_s));
+	if (NULL == cmd) {
+		ERR("calloc() Fail(%d)", errno);
+		return IOTCON_ERROR_OUT_OF_MEMORY;
+	}
+	cmd->fn = fn;
+	cmd->cancel = cancel;
+	cmd->data = data;
+
+	g_async_queue_push(icd_csdk_cmd_queue, cmd);
+	icd_ioty_ocprocess_wakeup();
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+/* MUST be called with the csdk lock held */
+void icd_ioty_csdk_cmd_process()
+{
+	icd_csdk_cmd_s *cmd;
+
+	RET_IF(NULL == icd_csdk_cmd_queue);
+
+	while ((cmd = g_async_queue_try_pop(icd_csdk_cmd_queue))) {
+		/* cmd->data MUST be freed in cmd->fn */
+		cmd->fn(cmd->data);
+		free(cmd);
+	}
+}
+
+
+/* The stack thread is stopped. The commands left are not run, but their invocations
+ * are completed not to be left unanswered */
+static void _icd_ioty_csdk_cmd_cancel_all()
+{
+	int count = 0;
+	icd_csdk_cmd_s *cmd;
+
+	RET_IF(NULL == icd_csdk_cmd_queue);
+
+	while ((cmd = g_async_queue_try_pop(icd_csdk_cmd_queue))) {
+		cmd->cancel(cmd->data);
+		free(cmd);
+		count++;
+	}
+
+	if (count)
+		WARN("%d commands are canceled", count);
 }
 
 
 GThread* icd_ioty_init(const char *addr, unsigned short port)
 {
 	FN_CALL;
+	int ret;
 	GError *error;
 	GThread *thread;
 
@@ -78,11 +309,33 @@ GThread* icd_ioty_init(const char *addr, unsigned short port)
 
 	DBG("OCInit() Success");
 
+	ret = icd_ioty_ocprocess_worker_pool_init(ICD_WORKER_POOL_SIZE, ICD_WORKER_QUEUE_MAX);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("icd_ioty_ocprocess_worker_pool_init() Fail(%d)", ret);
+		OCStop();
+		return NULL;
+	}
+
+	icd_csdk_cmd_queue = g_async_queue_new();
+
+#ifdef IC_DEBUGGING
+	icd_csdk_lock_stats_timer = g_timeout_add_seconds(ICD_CSDK_LOCK_STATS_INTERVAL,
+			_icd_ioty_csdk_lock_stats_cb, NULL);
+#endif
+
 	thread = g_thread_try_new("packet_receive_thread", icd_ioty_ocprocess_thread,
 			NULL, &error);
 	if (NULL == thread) {
 		ERR("g_thread_try_new() Fail(%s)", error->message);
 		g_error_free(error);
+#ifdef IC_DEBUGGING
+		g_source_remove(icd_csdk_lock_stats_timer);
+		icd_csdk_lock_stats_timer = 0;
+#endif
+		icd_ioty_ocprocess_worker_pool_deinit();
+		g_async_queue_unref(icd_csdk_cmd_queue);
+		icd_csdk_cmd_queue = NULL;
+		OCStop();
 		return NULL;
 	}
 
@@ -97,6 +350,20 @@ void icd_ioty_deinit(GThread *thread)
 	icd_ioty_ocprocess_stop();
 	g_thread_join(thread);
 
+#ifdef IC_DEBUGGING
+	if (icd_csdk_lock_stats_timer) {
+		g_source_remove(icd_csdk_lock_stats_timer);
+		icd_csdk_lock_stats_timer = 0;
+	}
+#endif
+
+	icd_ioty_ocprocess_worker_pool_deinit();
+	icd_ioty_health_deinit();
+
+	_icd_ioty_csdk_cmd_cancel_all();
+	g_async_queue_unref(icd_csdk_cmd_queue);
+	icd_csdk_cmd_queue = NULL;
+
 	result = OCStop();
 	if (OC_STACK_OK != result)
 		ERR("OCStop() Fail(%d)", result);
@@ -257,51 +524,104 @@ static OCQualityOfService _icd_ioty_convert_qos(gint qos)
 }
 
 
-int icd_ioty_notify(OCResourceHandle handle, GVariant *msg, GVariant *observers, gint qos)
+static void _icd_ioty_notify_cmd(void *data)
+{
+	int ret;
+	OCStackResult result;
+	icd_notify_cmd_s *cmd = data;
+
+	/* TODO : QoS is come from lib. */
+	if (cmd->payload)
+		result = OCNotifyListOfObservers(cmd->handle, cmd->obs_ids, cmd->obs_length,
+				cmd->payload, cmd->qos);
+	else
+		result = OCNotifyAllObservers(cmd->handle, cmd->qos);
+
+	if (OC_STACK_NO_OBSERVERS == result) {
+		WARN("No Observers. Stop Notifying");
+		ret = IOTCON_ERROR_NONE;
+	} else if (OC_STACK_OK != result) {
+		ERR("OCNotifyListOfObservers() Fail(%d)", result);
+		ret = icd_ioty_convert_error(result);
+	} else {
+		ret = IOTCON_ERROR_NONE;
+	}
+
+	/* the notifications from the ring have no invocation */
+	if (cmd->invocation)
+		ic_dbus_complete_notify(icd_dbus_get_object(), cmd->invocation, ret);
+
+	free(cmd->obs_ids);
+	free(cmd);
+}
+
+
+static void _icd_ioty_notify_cancel(void *data)
+{
+	icd_notify_cmd_s *cmd = data;
+
+	if (cmd->invocation) {
+		ic_dbus_complete_notify(icd_dbus_get_object(), cmd->invocation,
+				IOTCON_ERROR_SYSTEM);
+	}
+
+	OCRepPayloadDestroy(cmd->payload);
+	free(cmd->obs_ids);
+	free(cmd);
+}
+
+
+int icd_ioty_notify(GDBusMethodInvocation *invocation, OCResourceHandle handle,
+		GVariant *msg, GVariant *observers, gint qos)
 {
-	int i, obs_length, msg_length;
+	int i, ret, msg_length;
 	GVariant *repr_gvar;
 	GVariantIter obs_iter, msg_iter;
-	OCStackResult ret;
-	OCRepPayload *payload = NULL;
-	OCQualityOfService oc_qos;
+	icd_notify_cmd_s *cmd;
 
-	g_variant_iter_init(&obs_iter, observers);
-	obs_length = g_variant_iter_n_children(&obs_iter);
+	cmd = calloc(1, sizeof(icd_notify_cmd_s));
+	if (NULL == cmd) {
+		ERR("calloc() Fail(%d)", errno);
+		return IOTCON_ERROR_OUT_OF_MEMORY;
+	}
 
-	/* Variable-length Array */
-	OCObservationId obs_ids[obs_length];
+	g_variant_iter_init(&obs_iter, observers);
+	cmd->obs_length = g_variant_iter_n_children(&obs_iter);
+	if (cmd->obs_length) {
+		cmd->obs_ids = calloc(cmd->obs_length, sizeof(OCObservationId));
+		if (NULL == cmd->obs_ids) {
+			ERR("calloc() Fail(%d)", errno);
+			free(cmd);
+			return IOTCON_ERROR_OUT_OF_MEMORY;
+		}
+	}
 
-	for (i = 0; i < obs_length; i++)
-		g_variant_iter_loop(&obs_iter, "i", &obs_ids[i]);
+	for (i = 0; i < cmd->obs_length; i++)
+		g_variant_iter_loop(&obs_iter, "i", &cmd->obs_ids[i]);
 
 	g_variant_iter_init(&msg_iter, msg);
 	msg_length = g_variant_iter_n_children(&msg_iter);
 	if (msg_length) {
 		g_variant_iter_loop(&msg_iter, "v", &repr_gvar);
 		/* TODO : How to use error_code. */
-		payload = icd_payload_representation_from_gvariant(repr_gvar);
+		cmd->payload = icd_payload_representation_from_gvariant(repr_gvar);
 	}
 
-	oc_qos = _icd_ioty_convert_qos(qos);
-
-	icd_ioty_csdk_lock();
-	/* TODO : QoS is come from lib. */
-	if (msg_length)
-		ret = OCNotifyListOfObservers(handle, obs_ids, obs_length, payload, oc_qos);
-	else
-		ret = OCNotifyAllObservers(handle, oc_qos);
-
-	icd_ioty_csdk_unlock();
+	cmd->invocation = invocation;
+	cmd->handle = handle;
+	cmd->qos = _icd_ioty_convert_qos(qos);
 
-	if (OC_STACK_NO_OBSERVERS == ret) {
-		WARN("No Observers. Stop Notifying");
-		return IOTCON_ERROR_NONE;
-	} else if (OC_STACK_OK != ret) {
-		ERR("OCNotifyListOfObservers() Fail(%d)", ret);
-		return icd_ioty_convert_error(ret);
+	ret = icd_ioty_csdk_cmd_push(_icd_ioty_notify_cmd, _icd_ioty_notify_cancel, cmd);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("icd_ioty_csdk_cmd_push() Fail(%d)", ret);
+		OCRepPayloadDestroy(cmd->payload);
+		free(cmd->obs_ids);
+		free(cmd);
+		return ret;
 	}
 
+	/* DO NOT FREE cmd. It MUST be freed in the _icd_ioty_notify_cmd() */
+
 	return IOTCON_ERROR_NONE;
 }
 
@@ -332,14 +652,53 @@ static int _ioty_get_header_options(GVariantIter *src, int src_size,
 }
 
 
-int icd_ioty_send_response(GVariant *resp)
+static void _icd_ioty_send_response_cmd(void *data)
+{
+	int ret = IOTCON_ERROR_NONE;
+	OCStackResult result;
+	icd_response_cmd_s *cmd = data;
+
+	result = OCDoResponse(&cmd->response);
+	if (OC_STACK_OK != result) {
+		ERR("OCDoResponse() Fail(%d)", result);
+		ret = icd_ioty_convert_error(result);
+	}
+
+	ic_dbus_complete_send_response(icd_dbus_get_object(), cmd->invocation, ret);
+
+	free(cmd);
+}
+
+
+static void _icd_ioty_send_response_cancel(void *data)
+{
+	icd_response_cmd_s *cmd = data;
+
+	ic_dbus_complete_send_response(icd_dbus_get_object(), cmd->invocation,
+			IOTCON_ERROR_SYSTEM);
+
+	OCPayloadDestroy(cmd->response.payload);
+	free(cmd);
+}
+
+
+int icd_ioty_send_response(GDBusMethodInvocation *invocation, GVariant *resp)
 {
+	int ret;
 	GVariant *repr_gvar;
 	GVariantIter *options;
-	OCStackResult ret;
-	OCEntityHandlerResponse response = {0};
 	int result, options_size;
 	int64_t request_handle, resource_handle;
+	icd_response_cmd_s *cmd;
+	OCEntityHandlerResponse *response;
+
+	cmd = calloc(1, sizeof(icd_response_cmd_s));
+	if (NULL == cmd) {
+		ERR("calloc() Fail(%d)", errno);
+		return IOTCON_ERROR_OUT_OF_MEMORY;
+	}
+	cmd->invocation = invocation;
+	response = &cmd->response;
 
 	g_variant_get(resp, "(a(qs)ivxx)",
 			&options,
@@ -348,39 +707,42 @@ int icd_ioty_send_response(GVariant *resp)
 			&request_handle,
 			&resource_handle);
 
-	response.requestHandle = ICD_INT64_TO_POINTER(request_handle);
-	response.resourceHandle = ICD_INT64_TO_POINTER(resource_handle);
-	response.ehResult = (OCEntityHandlerResult)result;
+	response->requestHandle = ICD_INT64_TO_POINTER(request_handle);
+	response->resourceHandle = ICD_INT64_TO_POINTER(resource_handle);
+	response->ehResult = (OCEntityHandlerResult)result;
 
 	options_size = g_variant_iter_n_children(options);
-	response.numSendVendorSpecificHeaderOptions = options_size;
+	response->numSendVendorSpecificHeaderOptions = options_size;
 
 	if (0 != options_size) {
 		int ret = _ioty_get_header_options(options,
-				response.numSendVendorSpecificHeaderOptions,
-				response.sendVendorSpecificHeaderOptions,
-				sizeof(response.sendVendorSpecificHeaderOptions)
-				/ sizeof(response.sendVendorSpecificHeaderOptions[0]));
+				response->numSendVendorSpecificHeaderOptions,
+				response->sendVendorSpecificHeaderOptions,
+				sizeof(response->sendVendorSpecificHeaderOptions)
+				/ sizeof(response->sendVendorSpecificHeaderOptions[0]));
 
 		if (IOTCON_ERROR_NONE != ret)
 			ERR("_ioty_get_header_options() Fail(%d)", ret);
 	}
 	g_variant_iter_free(options);
 
-	response.payload = (OCPayload*)icd_payload_representation_from_gvariant(repr_gvar);
+	response->payload = (OCPayload*)icd_payload_representation_from_gvariant(repr_gvar);
+	g_variant_unref(repr_gvar);
 
 	/* related to block transfer */
-	response.persistentBufferFlag = 0;
-
-	icd_ioty_csdk_lock();
-	ret = OCDoResponse(&response);
-	icd_ioty_csdk_unlock();
+	response->persistentBufferFlag = 0;
 
-	if (OC_STACK_OK != ret) {
-		ERR("OCDoResponse() Fail(%d)", ret);
-		return icd_ioty_convert_error(ret);
+	ret = icd_ioty_csdk_cmd_push(_icd_ioty_send_response_cmd,
+			_icd_ioty_send_response_cancel, cmd);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("icd_ioty_csdk_cmd_push() Fail(%d)", ret);
+		OCPayloadDestroy(response->payload);
+		free(cmd);
+		return ret;
 	}
 
+	/* DO NOT FREE cmd. It MUST be freed in the _icd_ioty_send_response_cmd() */
+
 	return IOTCON_ERROR_NONE;
 }
 
@@ -410,7 +772,102 @@ static gboolean _icd_ioty_discovery_timeout(gpointer user_data)
 }
 
 
-int icd_ioty_find_resource(const char *host_address,
+static void _icd_ioty_complete_discover(int type, GDBusMethodInvocation *invocation,
+		int64_t signal_number, int ret)
+{
+	switch (type) {
+	case ICD_FIND_RESOURCE:
+		ic_dbus_complete_find_resource(icd_dbus_get_object(), invocation, signal_number,
+				ret);
+		break;
+	case ICD_DEVICE_INFO:
+		ic_dbus_complete_get_device_info(icd_dbus_get_object(), invocation,
+				signal_number, ret);
+		break;
+	case ICD_PLATFORM_INFO:
+		ic_dbus_complete_get_platform_info(icd_dbus_get_object(), invocation,
+				signal_number, ret);
+		break;
+	default:
+		INFO("Invalid Type(%d)", type);
+	}
+}
+
+
+static void _icd_ioty_discover_cmd(void *data)
+{
+	OCDoHandle handle;
+	OCStackResult result;
+	icd_discover_cmd_s *cmd = data;
+
+	/* TODO : QoS is come from lib. */
+	result = OCDoResource(&handle, OC_REST_DISCOVER, cmd->uri, NULL, NULL,
+			cmd->oic_conn_type, OC_LOW_QOS, &cmd->cbdata, NULL, 0);
+	if (OC_STACK_OK != result) {
+		ERR("OCDoResource() Fail(%d)", result);
+		_ioty_free_signal_context(cmd->cbdata.context);
+		_icd_ioty_complete_discover(cmd->type, cmd->invocation, cmd->signal_number,
+				icd_ioty_convert_error(result));
+		free(cmd);
+		return;
+	}
+
+	g_timeout_add_seconds(cmd->timeout, _icd_ioty_discovery_timeout, handle);
+
+	_icd_ioty_complete_discover(cmd->type, cmd->invocation, cmd->signal_number,
+			IOTCON_ERROR_NONE);
+	free(cmd);
+}
+
+
+static void _icd_ioty_discover_cancel(void *data)
+{
+	icd_discover_cmd_s *cmd = data;
+
+	_ioty_free_signal_context(cmd->cbdata.context);
+	_icd_ioty_complete_discover(cmd->type, cmd->invocation, cmd->signal_number,
+			IOTCON_ERROR_SYSTEM);
+	free(cmd);
+}
+
+
+static int _icd_ioty_discover(icd_discover_cmd_s *cmd, OCClientResponseHandler cb,
+		int conn_type, const char *bus_name)
+{
+	int ret;
+	icd_sig_ctx_s *context;
+
+	context = calloc(1, sizeof(icd_sig_ctx_s));
+	if (NULL == context) {
+		ERR("calloc() Fail(%d)", errno);
+		return IOTCON_ERROR_OUT_OF_MEMORY;
+	}
+
+	context->bus_name = ic_utils_strdup(bus_name);
+	context->signal_number = cmd->signal_number;
+
+	cmd->cbdata.context = context;
+	cmd->cbdata.cb = cb;
+	cmd->cbdata.cd = _ioty_free_signal_context;
+
+	cmd->oic_conn_type = icd_ioty_conn_type_to_oic_conn_type(conn_type);
+
+	ret = icd_ioty_csdk_cmd_push(_icd_ioty_discover_cmd, _icd_ioty_discover_cancel,
+			cmd);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("icd_ioty_csdk_cmd_push() Fail(%d)", ret);
+		_ioty_free_signal_context(context);
+		return ret;
+	}
+
+	/* DO NOT FREE cmd. It MUST be freed in the _icd_ioty_discover_cmd() */
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+int icd_ioty_find_resource(GDBusMethodInvocation *invocation,
+		const char *host_address,
 		int conn_type,
 		const char *resource_type,
 		bool is_secure,
@@ -418,61 +875,45 @@ int icd_ioty_find_resource(const char *host_address,
 		int64_t signal_number,
 		const char *bus_name)
 {
-	int len;
+	int ret, len;
 	char *coap_str;
-	OCDoHandle handle;
-	OCStackResult result;
-	icd_sig_ctx_s *context;
-	char uri[PATH_MAX] = {0};
-	OCCallbackData cbdata = {0};
-	OCConnectivityType oic_conn_type;
+	icd_discover_cmd_s *cmd;
+
+	cmd = calloc(1, sizeof(icd_discover_cmd_s));
+	if (NULL == cmd) {
+		ERR("calloc() Fail(%d)", errno);
+		return IOTCON_ERROR_OUT_OF_MEMORY;
+	}
 
 	coap_str = is_secure ? ICD_IOTY_COAPS : ICD_IOTY_COAP;
 
 	if (IC_STR_EQUAL == strcmp(IC_STR_NULL, host_address)) {
-		len = snprintf(uri, sizeof(uri), "%s", OC_RSRVD_WELL_KNOWN_URI);
+		len = snprintf(cmd->uri, sizeof(cmd->uri), "%s", OC_RSRVD_WELL_KNOWN_URI);
 	} else {
-		len = snprintf(uri, sizeof(uri), "%s%s%s", coap_str, host_address,
+		len = snprintf(cmd->uri, sizeof(cmd->uri), "%s%s%s", coap_str, host_address,
 				OC_RSRVD_WELL_KNOWN_URI);
 	}
-	if (len <= 0 || sizeof(uri) <= len) {
+	if (len <= 0 || sizeof(cmd->uri) <= len) {
 		ERR("snprintf() Fail(%d)", len);
+		free(cmd);
 		return IOTCON_ERROR_IO_ERROR;
 	}
 
 	if (IC_STR_EQUAL != strcmp(IC_STR_NULL, resource_type))
-		snprintf(uri + len, sizeof(uri) - len, "?rt=%s", resource_type);
-
-	context = calloc(1, sizeof(icd_sig_ctx_s));
-	if (NULL == context) {
-		ERR("calloc() Fail(%d)", errno);
-		return IOTCON_ERROR_OUT_OF_MEMORY;
-	}
-
-	context->bus_name = ic_utils_strdup(bus_name);
-	context->signal_number = signal_number;
-
-	cbdata.context = context;
-	cbdata.cb = icd_ioty_ocprocess_find_cb;
-	cbdata.cd = _ioty_free_signal_context;
-
-	oic_conn_type = icd_ioty_conn_type_to_oic_conn_type(conn_type);
+		snprintf(cmd->uri + len, sizeof(cmd->uri) - len, "?rt=%s", resource_type);
 
-	icd_ioty_csdk_lock();
-	/* TODO : QoS is come from lib. */
-	result = OCDoResource(&handle, OC_REST_DISCOVER, uri, NULL, NULL, oic_conn_type,
-			OC_LOW_QOS, &cbdata, NULL, 0);
-	icd_ioty_csdk_unlock();
+	cmd->type = ICD_FIND_RESOURCE;
+	cmd->invocation = invocation;
+	cmd->timeout = timeout;
+	cmd->signal_number = signal_number;
 
-	if (OC_STACK_OK != result) {
-		ERR("OCDoResource() Fail(%d)", result);
-		free(context->bus_name);
-		free(context);
-		return icd_ioty_convert_error(result);
+	ret = _icd_ioty_discover(cmd, icd_ioty_ocprocess_find_cb, conn_type, bus_name);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("_icd_ioty_discover() Fail(%d)", ret);
+		free(cmd);
+		return ret;
 	}
 
-	g_timeout_add_seconds(timeout, _icd_ioty_discovery_timeout, handle);
-
 	return IOTCON_ERROR_NONE;
 }
 
@@ -519,6 +960,8 @@ static char* _icd_ioty_resource_generate_uri(char *uri_path, GVariant *query)
 
 void icd_ioty_complete(int type, GDBusMethodInvocation *invocation, GVariant *value)
 {
+	icd_blob_grant(value, icd_dbus_get_sender(invocation));
+
 	switch (type) {
 	case ICD_CRUD_GET:
 		ic_dbus_complete_get(icd_dbus_get_object(), invocation, value);
@@ -575,6 +1018,37 @@ void icd_ioty_complete_error(int type, GDBusMethodInvocation *invocation, int re
 }
 
 
+static void _icd_ioty_crud_cmd(void *data)
+{
+	OCStackResult result;
+	icd_crud_cmd_s *cmd = data;
+
+	/* TODO : QoS is come from lib. And user can set QoS to client structure.  */
+	result = OCDoResource(NULL, cmd->rest_type, cmd->uri, &cmd->dev_addr, cmd->payload,
+			cmd->oic_conn_type, OC_HIGH_QOS, &cmd->cbdata,
+			cmd->options_size ? cmd->oic_options : NULL, cmd->options_size);
+	if (OC_STACK_OK != result) {
+		ERR("OCDoResource() Fail(%d)", result);
+		icd_ioty_complete_error(cmd->type, cmd->invocation, icd_ioty_convert_error(result));
+	}
+
+	free(cmd->uri);
+	free(cmd);
+}
+
+
+static void _icd_ioty_crud_cancel(void *data)
+{
+	icd_crud_cmd_s *cmd = data;
+
+	icd_ioty_complete_error(cmd->type, cmd->invocation, IOTCON_ERROR_SYSTEM);
+
+	OCPayloadDestroy(cmd->payload);
+	free(cmd->uri);
+	free(cmd);
+}
+
+
 static gboolean _icd_ioty_crud(int type,
 		icDbus *object,
 		GDBusMethodInvocation *invocation,
@@ -584,16 +1058,14 @@ static gboolean _icd_ioty_crud(int type,
 {
 	bool is_secure;
 	OCMethod rest_type;
-	OCStackResult result;
 	GVariantIter *options;
 	OCCallbackData cbdata = {0};
 	int ret, conn_type, options_size;
 	char *uri_path, *uri, *host;
-	OCHeaderOption oic_options[MAX_HEADER_OPTIONS];
-	OCHeaderOption *oic_options_ptr = NULL;
-	OCPayload *payload = NULL;
+	OCHeaderOption oic_options[MAX_HEADER_OPTIONS] = {{0}};
 	OCConnectivityType oic_conn_type;
 	OCDevAddr dev_addr = {0};
+	icd_crud_cmd_s *cmd;
 
 	ret = icd_cynara_check_network(invocation);
 	if (IOTCON_ERROR_NONE != ret) {
@@ -657,13 +1129,9 @@ static gboolean _icd_ioty_crud(int type,
 			icd_ioty_complete_error(type, invocation, ret);
 			return TRUE;
 		}
-		oic_options_ptr = oic_options;
 	}
 	g_variant_iter_free(options);
 
-	if (repr)
-		payload = (OCPayload*)icd_payload_representation_from_gvariant(repr);
-
 	oic_conn_type = icd_ioty_conn_type_to_oic_conn_type(conn_type);
 
 	ret = icd_ioty_get_dev_addr(host, conn_type, &dev_addr);
@@ -674,20 +1142,50 @@ static gboolean _icd_ioty_crud(int type,
 		return TRUE;
 	}
 
-	icd_ioty_csdk_lock();
-	/* TODO : QoS is come from lib. And user can set QoS to client structure.  */
-	result = OCDoResource(NULL, rest_type, uri, &dev_addr, payload, oic_conn_type,
-			OC_HIGH_QOS, &cbdata, oic_options_ptr, options_size);
-	icd_ioty_csdk_unlock();
-
-	free(uri);
-
-	if (OC_STACK_OK != result) {
-		ERR("OCDoResource() Fail(%d)", result);
-		icd_ioty_complete_error(type, invocation, icd_ioty_convert_error(result));
+	/* The endpoint is unreachable : fail without waiting for the retransmissions.
+	 * The error is IOTCON_ERROR_TIMEOUT, which the clients already get from the stack
+	 * for an unreachable host. */
+	ret = icd_ioty_health_check(&dev_addr);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("icd_ioty_health_check() Fail(%d)", ret);
+		icd_ioty_complete_error(type, invocation, ret);
+		free(uri);
+		return TRUE;
+	}
+
+	cmd = calloc(1, sizeof(icd_crud_cmd_s));
+	if (NULL == cmd) {
+		ERR("calloc() Fail(%d)", errno);
+		icd_ioty_complete_error(type, invocation, IOTCON_ERROR_OUT_OF_MEMORY);
+		free(uri);
+		return TRUE;
+	}
+
+	cmd->type = type;
+	cmd->invocation = invocation;
+	cmd->rest_type = rest_type;
+	cmd->uri = uri;
+	cmd->dev_addr = dev_addr;
+	cmd->oic_conn_type = oic_conn_type;
+	cmd->cbdata = cbdata;
+	memcpy(cmd->oic_options, oic_options, sizeof(oic_options));
+	cmd->options_size = options_size;
+
+	if (repr)
+		cmd->payload = (OCPayload*)icd_payload_representation_from_gvariant(repr);
+
+	ret = icd_ioty_csdk_cmd_push(_icd_ioty_crud_cmd, _icd_ioty_crud_cancel, cmd);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("icd_ioty_csdk_cmd_push() Fail(%d)", ret);
+		icd_ioty_complete_error(type, invocation, ret);
+		OCPayloadDestroy(cmd->payload);
+		free(cmd->uri);
+		free(cmd);
 		return TRUE;
 	}
 
+	/* DO NOT FREE cmd. It MUST be freed in the _icd_ioty_crud_cmd() */
+
 	return TRUE;
 }
 
@@ -752,6 +1250,7 @@ static OCDoHandle _icd_ioty_observe_register(const char *uri_path,
 	result = OCDoResource(&handle, method, uri_path, dev_addr, NULL, oic_conn_type,
 			OC_HIGH_QOS, cbdata, oic_options_ptr, options_size);
 	icd_ioty_csdk_unlock();
+	icd_ioty_ocprocess_wakeup();
 
 	if (OC_STACK_OK != result) {
 		ERR("OCDoResource() Fail(%d)", result);
@@ -807,6 +1306,14 @@ OCDoHandle icd_ioty_observer_start(GVariant *resource, int observe_policy,
 		return NULL;
 	}
 
+	ret = icd_ioty_health_check(&dev_addr);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("icd_ioty_health_check() Fail(%d)", ret);
+		free(uri);
+		g_variant_iter_free(options);
+		return NULL;
+	}
+
 	context = calloc(1, sizeof(icd_sig_ctx_s));
 	if (NULL == context) {
 		ERR("calloc() Fail(%d)", errno);
@@ -868,16 +1375,13 @@ int icd_ioty_observer_stop(OCDoHandle handle, GVariant *options)
 	return IOTCON_ERROR_NONE;
 }
 
-int icd_ioty_get_info(int type, const char *host_address, int conn_type, int timeout,
-		int64_t signal_number, const char *bus_name)
+int icd_ioty_get_info(GDBusMethodInvocation *invocation, int type,
+		const char *host_address, int conn_type, int timeout, int64_t signal_number,
+		const char *bus_name)
 {
-	OCDoHandle handle;
-	OCStackResult result;
-	icd_sig_ctx_s *context;
-	OCCallbackData cbdata = {0};
-	char uri[PATH_MAX] = {0};
+	int ret;
 	char *uri_path = NULL;
-	OCConnectivityType oic_conn_type;
+	icd_discover_cmd_s *cmd;
 
 	if (ICD_DEVICE_INFO == type)
 		uri_path = OC_RSRVD_DEVICE_URI;
@@ -886,39 +1390,29 @@ int icd_ioty_get_info(int type, const char *host_address, int conn_type, int tim
 	else
 		return IOTCON_ERROR_INVALID_PARAMETER;
 
-	if (IC_STR_EQUAL == strcmp(IC_STR_NULL, host_address))
-		snprintf(uri, sizeof(uri), "%s", uri_path);
-	else
-		snprintf(uri, sizeof(uri), "%s%s", host_address, uri_path);
-
-	context = calloc(1, sizeof(icd_sig_ctx_s));
-	if (NULL == context) {
+	cmd = calloc(1, sizeof(icd_discover_cmd_s));
+	if (NULL == cmd) {
 		ERR("calloc() Fail(%d)", errno);
 		return IOTCON_ERROR_OUT_OF_MEMORY;
 	}
-	context->bus_name = ic_utils_strdup(bus_name);
-	context->signal_number = signal_number;
-
-	cbdata.context = context;
-	cbdata.cb = icd_ioty_ocprocess_info_cb;
-	cbdata.cd = _ioty_free_signal_context;
 
-	oic_conn_type = icd_ioty_conn_type_to_oic_conn_type(conn_type);
+	if (IC_STR_EQUAL == strcmp(IC_STR_NULL, host_address))
+		snprintf(cmd->uri, sizeof(cmd->uri), "%s", uri_path);
+	else
+		snprintf(cmd->uri, sizeof(cmd->uri), "%s%s", host_address, uri_path);
 
-	icd_ioty_csdk_lock();
-	/* TODO : QoS is come from lib. And user can set QoS to client structure.  */
-	result = OCDoResource(&handle, OC_REST_DISCOVER, uri, NULL, NULL, oic_conn_type,
-			OC_LOW_QOS, &cbdata, NULL, 0);
-	icd_ioty_csdk_unlock();
+	cmd->type = type;
+	cmd->invocation = invocation;
+	cmd->timeout = timeout;
+	cmd->signal_number = signal_number;
 
-	if (OC_STACK_OK != result) {
-		ERR("OCDoResource() Fail(%d)", result);
-		free(context->bus_name);
-		free(context);
-		return icd_ioty_convert_error(result);
+	ret = _icd_ioty_discover(cmd, icd_ioty_ocprocess_info_cb, conn_type, bus_name);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("_icd_ioty_discover() Fail(%d)", ret);
+		free(cmd);
+		return ret;
 	}
 
-	g_timeout_add_seconds(timeout, _icd_ioty_discovery_timeout, handle);
 
 	return IOTCON_ERROR_NONE;
 }
@@ -1217,6 +1711,7 @@ OCDoHandle icd_ioty_subscribe_presence(int type, const char *host_address, int c
 	result = OCDoResource(&handle, OC_REST_PRESENCE, uri, NULL, NULL, oic_conn_type,
 			OC_LOW_QOS, &cbdata, NULL, 0);
 	icd_ioty_csdk_unlock();
+	icd_ioty_ocprocess_wakeup();
 
 	if (OC_STACK_OK != result) {
 		ERR("OCDoResource() Fail(%d)", result);
@@ -1295,252 +1790,1208 @@ int icd_ioty_encap_get_time_interval()
 }
 
 
-static void _encap_set_time_interval(gpointer key, gpointer value, gpointer user_data)
+static unsigned int _icd_ioty_encap_interval_ticks()
 {
-	icd_encap_info_s *encap_info = value;
+	return MAX(1, icd_remote_resource_time_interval * 1000 / ICD_ENCAP_WHEEL_TICK);
+}
 
-	g_source_remove(encap_info->get_timer_id);
 
-	encap_info->get_timer_id = g_timeout_add_seconds(icd_remote_resource_time_interval,
-			icd_ioty_encap_get, encap_info);
+/* the ticks which have passed since the current slot. MUST be called with the wheel mutex */
+static unsigned int _icd_ioty_encap_wheel_lag()
+{
+	gint64 lag;
+
+	lag = (g_get_monotonic_time() - icd_encap_wheel.base_time)
+		/ (ICD_ENCAP_WHEEL_TICK * G_TIME_SPAN_MILLISECOND);
+
+	return CLAMP(lag, 0, ICD_ENCAP_WHEEL_SIZE - 1);
 }
 
 
-void icd_ioty_encap_set_time_interval(int time_interval)
+/* MUST be called with the wheel mutex */
+static void _icd_ioty_encap_wheel_add(icd_encap_info_s *encap_info, unsigned int ticks)
 {
-	icd_remote_resource_time_interval = time_interval;
+	GQueue *slot;
+
+	if (0 == icd_encap_wheel.count)
+		icd_encap_wheel.base_time = g_get_monotonic_time();
+
+	/* from now, not from the current slot */
+	ticks = MAX(1, ticks) + _icd_ioty_encap_wheel_lag();
+
+	encap_info->wheel_slot = (icd_encap_wheel.cur + ticks) % ICD_ENCAP_WHEEL_SIZE;
+	encap_info->wheel_rounds = (ticks - 1) / ICD_ENCAP_WHEEL_SIZE;
 
-	g_hash_table_foreach(icd_ioty_encap_table, _encap_set_time_interval, NULL);
+	slot = &icd_encap_wheel.slots[encap_info->wheel_slot];
+	g_queue_push_tail(slot, encap_info);
+	encap_info->wheel_link = g_queue_peek_tail_link(slot);
+	icd_encap_wheel.count++;
 }
 
 
-static void _free_encap_info(void *user_data)
+/* MUST be called with the wheel mutex */
+static void _icd_ioty_encap_wheel_remove(icd_encap_info_s *encap_info)
 {
-	icd_encap_info_s *encap_info = user_data;
+	if (NULL == encap_info->wheel_link)
+		return;
 
-	OCRepPayloadDestroy(encap_info->oic_payload);
-	free(encap_info->uri_path);
-	free(encap_info);
+	g_queue_delete_link(&icd_encap_wheel.slots[encap_info->wheel_slot],
+			encap_info->wheel_link);
+	encap_info->wheel_link = NULL;
+	icd_encap_wheel.count--;
 }
 
 
-static icd_encap_info_s* _icd_ioty_encap_table_add(const char *uri_path,
-		const char *host_address, int conn_type)
+/* the next poll is after the interval, with 10% jitter not to be synchronized.
+ * MUST be called with the wheel mutex */
+static unsigned int _icd_ioty_encap_next_ticks(icd_encap_info_s *encap_info)
 {
-	int ret;
-	char key_str[PATH_MAX];
-	icd_encap_info_s *encap_info;
+	int ticks, jitter;
 
-	if (NULL == icd_ioty_encap_table) {
-		icd_ioty_encap_table = g_hash_table_new_full(g_str_hash, g_str_equal, free,
-				_free_encap_info);
-	}
+	if (encap_info->poll_cur)
+		ticks = MAX(1, encap_info->poll_cur / ICD_ENCAP_WHEEL_TICK);
+	else
+		ticks = _icd_ioty_encap_interval_ticks();
+	jitter = ticks / 10;
+	if (jitter)
+		ticks += g_random_int_range(-jitter, jitter + 1);
 
-	encap_info = calloc(1, sizeof(icd_encap_info_s));
-	if (NULL == encap_info) {
-		ERR("calloc() Fail(%d)", errno);
-		return NULL;
-	}
+	return MAX(1, ticks);
+}
 
-	ret = icd_ioty_get_dev_addr(host_address, conn_type, &encap_info->dev_addr);
-	if (IOTCON_ERROR_NONE != ret) {
-		ERR("icd_ioty_get_dev_addr() Fail(%d)", ret);
-		free(encap_info);
-		return NULL;
-	}
 
-	/* encap_worker_ctx */
-	encap_info->worker_ctx = calloc(1, sizeof(icd_encap_worker_ctx_s));
-	if (NULL == encap_info->worker_ctx) {
-		ERR("calloc() Fail(%d)", errno);
-		free(encap_info);
-		return NULL;
-	}
-	encap_info->worker_ctx->uri_path = ic_utils_strdup(uri_path);
-	encap_info->worker_ctx->is_valid = true;
+/* MUST be called with the wheel mutex */
+static unsigned int _icd_ioty_encap_wheel_remaining(icd_encap_info_s *encap_info)
+{
+	unsigned int ticks, lag;
 
-	encap_info->uri_path = ic_utils_strdup(uri_path);
-	encap_info->oic_conn_type = icd_ioty_conn_type_to_oic_conn_type(conn_type);
-	snprintf(key_str, sizeof(key_str), "%s%s", uri_path, host_address);
-	encap_info->signal_number = icd_dbus_generate_signal_number();
+	ticks = (encap_info->wheel_slot + ICD_ENCAP_WHEEL_SIZE - icd_encap_wheel.cur)
+		% ICD_ENCAP_WHEEL_SIZE;
+	if (0 == ticks)
+		ticks = ICD_ENCAP_WHEEL_SIZE;
+	ticks += encap_info->wheel_rounds * ICD_ENCAP_WHEEL_SIZE;
 
-	g_hash_table_insert(icd_ioty_encap_table, ic_utils_strdup(key_str),
-			encap_info);
+	lag = _icd_ioty_encap_wheel_lag();
 
-	return encap_info;
+	return (lag < ticks) ? ticks - lag : 0;
 }
 
 
-static void _icd_ioty_encap_table_remove(icd_encap_info_s *encap_info,
-		const char *host_address)
+static gboolean _icd_ioty_encap_wheel_tick(gpointer user_data);
+
+/* Arm the timer for the next slot which has an entry, unless it is armed sooner.
+ * MUST be called with the wheel mutex */
+static void _icd_ioty_encap_wheel_arm()
 {
-	char key_str[PATH_MAX];
+	gint64 due_time, interval;
+	unsigned int gap, index;
 
-	snprintf(key_str, sizeof(key_str), "%s%s", encap_info->uri_path, host_address);
+	if (0 == icd_encap_wheel.count)
+		return;
 
-	g_hash_table_remove(icd_ioty_encap_table, key_str);
+	for (gap = 1; gap < ICD_ENCAP_WHEEL_SIZE; gap++) {
+		index = (icd_encap_wheel.cur + gap) % ICD_ENCAP_WHEEL_SIZE;
+		if (FALSE == g_queue_is_empty(&icd_encap_wheel.slots[index]))
+			break;
+	}
+	due_time = icd_encap_wheel.base_time
+		+ gap * ICD_ENCAP_WHEEL_TICK * G_TIME_SPAN_MILLISECOND;
 
-	if (0 == g_hash_table_size(icd_ioty_encap_table)) {
-		g_hash_table_destroy(icd_ioty_encap_table);
-		icd_ioty_encap_table = NULL;
+	if (icd_encap_wheel.timer_id) {
+		if (icd_encap_wheel.due_time <= due_time)
+			return;
+		g_source_remove(icd_encap_wheel.timer_id);
 	}
+
+	interval = due_time - g_get_monotonic_time();
+	interval = MAX(0, (interval + G_TIME_SPAN_MILLISECOND - 1) / G_TIME_SPAN_MILLISECOND);
+
+	icd_encap_wheel.due_time = due_time;
+	icd_encap_wheel.timer_id = g_timeout_add(interval, _icd_ioty_encap_wheel_tick, NULL);
 }
 
 
-icd_encap_info_s* _icd_ioty_encap_table_get_info(const char *uri_path,
-		const char *host_address)
+/* poll again in the retry interval, unless the next poll is sooner */
+static void _icd_ioty_encap_retry(icd_encap_info_s *encap_info)
 {
-	char key_str[PATH_MAX];
-	icd_encap_info_s *encap_info;
+	unsigned int ticks = ICD_ENCAP_RETRY_INTERVAL / ICD_ENCAP_WHEEL_TICK;
 
-	if (NULL == icd_ioty_encap_table)
-		return NULL;
+	g_mutex_lock(&icd_encap_wheel.mutex);
+	if (encap_info->wheel_link && ticks < _icd_ioty_encap_wheel_remaining(encap_info)) {
+		_icd_ioty_encap_wheel_remove(encap_info);
+		_icd_ioty_encap_wheel_add(encap_info, ticks);
+		_icd_ioty_encap_wheel_arm();
+	}
+	g_mutex_unlock(&icd_encap_wheel.mutex);
+}
 
-	snprintf(key_str, sizeof(key_str), "%s%s", uri_path, host_address);
 
-	encap_info = g_hash_table_lookup(icd_ioty_encap_table, key_str);
-	if (NULL == encap_info)
+static void _icd_ioty_encap_batch_failed(const char *host_address,
+		const char *collection);
+
+static void _icd_ioty_encap_free_poll_cmd(icd_encap_poll_cmd_s *poll_cmd)
+{
+	if (NULL == poll_cmd)
+		return;
+
+	_icd_ioty_encap_free_poll_cmd(poll_cmd->fallback);
+	free(poll_cmd->collection);
+	free(poll_cmd->host_address);
+	free(poll_cmd->uri);
+	free(poll_cmd);
+}
+
+
+static icd_encap_poll_cmd_s* _icd_ioty_encap_poll_cmd_new(OCMethod method,
+		const char *uri, OCDevAddr *dev_addr, OCConnectivityType oic_conn_type,
+		OCQualityOfService qos, OCClientResponseHandler cb)
+{
+	icd_encap_poll_cmd_s *poll_cmd;
+
+	poll_cmd = calloc(1, sizeof(icd_encap_poll_cmd_s));
+	if (NULL == poll_cmd) {
+		ERR("calloc() Fail(%d)", errno);
 		return NULL;
+	}
 
-	return encap_info;
+	poll_cmd->method = method;
+	poll_cmd->uri = ic_utils_strdup(uri);
+	memcpy(&poll_cmd->dev_addr, dev_addr, sizeof(OCDevAddr));
+	poll_cmd->oic_conn_type = oic_conn_type;
+	poll_cmd->qos = qos;
+	poll_cmd->cbdata.cb = cb;
+
+	return poll_cmd;
 }
 
 
-gboolean icd_ioty_encap_get(gpointer user_data)
+/* the full representation is needed only for caching */
+static icd_encap_poll_cmd_s* _icd_ioty_encap_poll_cmd_new_get(icd_encap_info_s *encap_info)
 {
-	FN_CALL;
-	OCStackResult result;
-	OCCallbackData cbdata = {0};
-	icd_encap_info_s *encap_info = user_data;
+	if (0 == encap_info->caching_count) {
+		return _icd_ioty_encap_poll_cmd_new(OC_REST_GET, encap_info->uri_path,
+				&encap_info->dev_addr, encap_info->oic_conn_type, OC_LOW_QOS,
+				icd_ioty_ocprocess_encap_probe_cb);
+	}
 
-	cbdata.cb = icd_ioty_ocprocess_encap_get_cb;
+	return _icd_ioty_encap_poll_cmd_new(OC_REST_GET, encap_info->uri_path,
+			&encap_info->dev_addr, encap_info->oic_conn_type, OC_HIGH_QOS,
+			icd_ioty_ocprocess_encap_get_cb);
+}
 
-	icd_ioty_csdk_lock();
-	result = OCDoResource(NULL, OC_REST_GET, encap_info->uri_path, &encap_info->dev_addr,
-			NULL, encap_info->oic_conn_type, OC_HIGH_QOS, &cbdata, NULL, 0);
-	icd_ioty_csdk_unlock();
 
-	if (OC_STACK_OK != result)
+/* MUST be called with the csdk lock held. It runs in the stack thread */
+static void _icd_ioty_encap_poll_cmd(void *data)
+{
+	OCStackResult result;
+	icd_encap_poll_cmd_s *fallback;
+	icd_encap_poll_cmd_s *poll_cmd = data;
+
+	result = OCDoResource(NULL, poll_cmd->method, poll_cmd->uri, &poll_cmd->dev_addr,
+			NULL, poll_cmd->oic_conn_type, poll_cmd->qos, &poll_cmd->cbdata, NULL, 0);
+	if (OC_STACK_OK != result) {
 		ERR("OCDoResource() Fail(%d)", result);
+		if (poll_cmd->cbdata.cd)
+			poll_cmd->cbdata.cd(poll_cmd->cbdata.context);
+		if (poll_cmd->collection)
+			_icd_ioty_encap_batch_failed(poll_cmd->host_address, poll_cmd->collection);
 
-	return G_SOURCE_CONTINUE;
+		fallback = poll_cmd->fallback;
+		poll_cmd->fallback = NULL;
+		if (fallback)
+			_icd_ioty_encap_poll_cmd(fallback);
+	}
+
+	_icd_ioty_encap_free_poll_cmd(poll_cmd);
 }
 
 
-int icd_ioty_start_encap(int type, const char *uri_path, const char *host_address,
-		int conn_type, int64_t *signal_number)
+/* the polls have no invocation */
+static void _icd_ioty_encap_poll_cancel(void *data)
 {
-	OCCallbackData cbdata = {0};
-	icd_encap_info_s *encap_info;
+	icd_encap_poll_cmd_s *poll_cmd = data;
 
-	encap_info = _icd_ioty_encap_table_get_info(uri_path, host_address);
-	if (NULL == encap_info) {
-		encap_info = _icd_ioty_encap_table_add(uri_path, host_address, conn_type);
-		if (NULL == encap_info) {
-			ERR("_icd_ioty_encap_table_add() Fail");
-			return IOTCON_ERROR_OUT_OF_MEMORY;
-		}
-	}
+	if (poll_cmd->cbdata.cd)
+		poll_cmd->cbdata.cd(poll_cmd->cbdata.context);
+	_icd_ioty_encap_free_poll_cmd(poll_cmd);
+}
 
-	switch (type) {
-	case ICD_ENCAP_MONITORING:
-		if (0 != encap_info->monitoring_count) {
-			*signal_number = encap_info->signal_number;
-			encap_info->monitoring_count++;
-			return IOTCON_ERROR_NONE;
-		}
-		/* DEVICE PRESENCE */
-		encap_info->presence_handle = icd_ioty_subscribe_presence(ICD_ENCAP_MONITORING,
-				host_address, conn_type, NULL, encap_info->worker_ctx);
-		if (NULL == encap_info->presence_handle) {
-			ERR("icd_ioty_subscribe_presence() Fail");
-			if (0 == encap_info->monitoring_count + encap_info->caching_count)
-				_icd_ioty_encap_table_remove(encap_info, host_address);
-			return IOTCON_ERROR_IOTIVITY;
-		}
-		encap_info->worker_ctx->presence_flag = true;
-		encap_info->monitoring_count++;
-		break;
-	case ICD_ENCAP_CACHING:
-		if (0 != encap_info->caching_count) {
-			*signal_number = encap_info->signal_number;
-			encap_info->caching_count++;
-			return IOTCON_ERROR_NONE;
-		}
-		/* OBSERVE METHOD */
-		cbdata.context = encap_info->worker_ctx;
-		cbdata.cb = icd_ioty_ocprocess_encap_observe_cb;
-		cbdata.cd = _free_encap_worker_observe_ctx;
 
-		encap_info->observe_handle = _icd_ioty_observe_register(uri_path,
-				&encap_info->dev_addr,
-				NULL,
-				OC_REST_OBSERVE,
-				encap_info->oic_conn_type,
-				&cbdata);
-		if (NULL == encap_info->observe_handle) {
-			ERR("_icd_ioty_observe_register() Fail");
-			if (0 == encap_info->monitoring_count + encap_info->caching_count)
-				_icd_ioty_encap_table_remove(encap_info, host_address);
-			return IOTCON_ERROR_IOTIVITY;
-		}
-		encap_info->worker_ctx->observe_flag = true;
-		encap_info->caching_count++;
-		break;
-	default:
-		ERR("Invalid Type(%d)", type);
-		if (0 == encap_info->monitoring_count + encap_info->caching_count)
-			_icd_ioty_encap_table_remove(encap_info, host_address);
-		return IOTCON_ERROR_INVALID_TYPE;
-	}
+/* poll_cmd is taken */
+static int _icd_ioty_encap_poll_push(icd_encap_poll_cmd_s *poll_cmd)
+{
+	int ret;
 
-	/* GET METHOD */
-	if (1 == encap_info->monitoring_count + encap_info->caching_count) {
-		icd_ioty_encap_get(encap_info);
-		encap_info->get_timer_id = g_timeout_add_seconds(
-				icd_remote_resource_time_interval, icd_ioty_encap_get, encap_info);
-	}
+	RETV_IF(NULL == poll_cmd, IOTCON_ERROR_OUT_OF_MEMORY);
 
-	*signal_number = encap_info->signal_number;
+	ret = icd_ioty_csdk_cmd_push(_icd_ioty_encap_poll_cmd, _icd_ioty_encap_poll_cancel,
+			poll_cmd);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("icd_ioty_csdk_cmd_push() Fail(%d)", ret);
+		_icd_ioty_encap_poll_cancel(poll_cmd);
+		return ret;
+	}
 
 	return IOTCON_ERROR_NONE;
 }
 
 
-static void _icd_ioty_stop_encap_get(icd_encap_info_s *encap_info,
-		const char *host_address)
+/* Monitoring needs only whether the resource answers, not its representation.
+ * The probe is not confirmable, so the stack neither retransmits it nor reports it as
+ * lost. A probe which is not answered until the next one counts as a failure. */
+static void _icd_ioty_encap_probe(icd_encap_info_s *encap_info)
 {
-	icd_encap_worker_ctx_s *worker_ctx = encap_info->worker_ctx;
-
-	if (0 != encap_info->monitoring_count + encap_info->caching_count)
-		return;
+	int ret;
 
-	g_mutex_lock(&worker_ctx->icd_worker_mutex);
-	g_source_remove(encap_info->get_timer_id);
-	encap_info->get_timer_id = 0;
-	encap_info->worker_ctx->is_valid = false;
-	_icd_ioty_encap_table_remove(encap_info, host_address);
-	g_mutex_unlock(&worker_ctx->icd_worker_mutex);
+	if (g_atomic_int_get(&encap_info->probe_pending)) {
+		icd_ioty_health_report(&encap_info->dev_addr, OC_STACK_TIMEOUT);
+		ret = icd_ioty_ocprocess_encap_timeout(encap_info->uri_path, &encap_info->dev_addr);
+		if (IOTCON_ERROR_NONE != ret)
+			ERR("icd_ioty_ocprocess_encap_timeout() Fail(%d)", ret);
+	}
+	g_atomic_int_set(&encap_info->probe_pending, 1);
 
+	ret = _icd_ioty_encap_poll_push(_icd_ioty_encap_poll_cmd_new_get(encap_info));
+	if (IOTCON_ERROR_NONE != ret)
+		ERR("_icd_ioty_encap_poll_push() Fail(%d)", ret);
 }
 
 
-int icd_ioty_stop_encap(int type, const char *uri_path, const char *host_address)
+static void _icd_ioty_encap_get(icd_encap_info_s *encap_info)
 {
 	int ret;
-	OCDoHandle handle;
-	icd_encap_info_s *encap_info;
 
-	encap_info = _icd_ioty_encap_table_get_info(uri_path, host_address);
-	if (NULL == encap_info) {
-		ERR("_icd_ioty_encap_table_get_info() Fail");
-		return IOTCON_ERROR_NO_DATA;
+	if (0 == encap_info->caching_count) {
+		_icd_ioty_encap_probe(encap_info);
+		return;
 	}
 
-	switch (type) {
-	case ICD_ENCAP_MONITORING:
-		if (0 == encap_info->monitoring_count) {
-			ERR("Not Monitoring(%s%s)", host_address, uri_path);
+	ret = _icd_ioty_encap_poll_push(_icd_ioty_encap_poll_cmd_new_get(encap_info));
+	if (IOTCON_ERROR_NONE != ret)
+		ERR("_icd_ioty_encap_poll_push() Fail(%d)", ret);
+}
+
+
+static void _icd_ioty_encap_free_batch(void *data)
+{
+	icd_encap_batch_s *batch = data;
+
+	free(batch->uri_path);
+	free(batch);
+}
+
+
+static void _icd_ioty_encap_free_host(void *data)
+{
+	icd_encap_host_s *host = data;
+
+	g_hash_table_destroy(host->members);
+	g_list_free_full(host->batches, _icd_ioty_encap_free_batch);
+	free(host);
+}
+
+
+static void _icd_ioty_encap_host_ref(icd_encap_info_s *encap_info)
+{
+	icd_encap_host_s *host;
+
+	g_mutex_lock(&icd_encap_host_mutex);
+	if (NULL == icd_encap_host_table) {
+		icd_encap_host_table = g_hash_table_new_full(g_str_hash, g_str_equal, free,
+				_icd_ioty_encap_free_host);
+	}
+
+	host = g_hash_table_lookup(icd_encap_host_table, encap_info->host_address);
+	if (NULL == host) {
+		host = calloc(1, sizeof(icd_encap_host_s));
+		if (NULL == host) {
+			ERR("calloc() Fail(%d)", errno);
+			g_mutex_unlock(&icd_encap_host_mutex);
+			return;
+		}
+		memcpy(&host->dev_addr, &encap_info->dev_addr, sizeof(OCDevAddr));
+		host->oic_conn_type = encap_info->oic_conn_type;
+		host->members = g_hash_table_new_full(g_str_hash, g_str_equal, free, NULL);
+		g_hash_table_insert(icd_encap_host_table, ic_utils_strdup(encap_info->host_address),
+				host);
+	}
+	host->encap_count++;
+
+	/* the new entry may be a member of the collections */
+	if (host->batches)
+		host->relearn = true;
+	g_mutex_unlock(&icd_encap_host_mutex);
+}
+
+
+static void _icd_ioty_encap_host_unref(icd_encap_info_s *encap_info)
+{
+	icd_encap_host_s *host;
+
+	g_mutex_lock(&icd_encap_host_mutex);
+	if (NULL == icd_encap_host_table) {
+		g_mutex_unlock(&icd_encap_host_mutex);
+		return;
+	}
+
+	host = g_hash_table_lookup(icd_encap_host_table, encap_info->host_address);
+	if (host && 0 == --host->encap_count)
+		g_hash_table_remove(icd_encap_host_table, encap_info->host_address);
+
+	if (0 == g_hash_table_size(icd_encap_host_table)) {
+		g_hash_table_destroy(icd_encap_host_table);
+		icd_encap_host_table = NULL;
+	}
+	g_mutex_unlock(&icd_encap_host_mutex);
+}
+
+
+/* MUST be called with the host mutex */
+static icd_encap_host_s* _icd_ioty_encap_host_get(const char *host_address)
+{
+	if (NULL == icd_encap_host_table)
+		return NULL;
+
+	return g_hash_table_lookup(icd_encap_host_table, host_address);
+}
+
+
+/* MUST be called with the host mutex */
+static icd_encap_batch_s* _icd_ioty_encap_host_get_batch(icd_encap_host_s *host,
+		const char *collection)
+{
+	GList *cur;
+	icd_encap_batch_s *batch;
+
+	for (cur = host->batches; cur; cur = cur->next) {
+		batch = cur->data;
+		if (IC_STR_EQUAL == g_strcmp0(batch->uri_path, collection))
+			return batch;
+	}
+
+	return NULL;
+}
+
+
+static gboolean _icd_ioty_encap_is_member_of(gpointer key, gpointer value,
+		gpointer user_data)
+{
+	return (value == user_data);
+}
+
+
+static void _icd_ioty_encap_discover_batch(OCDevAddr *dev_addr,
+		OCConnectivityType oic_conn_type)
+{
+	int ret;
+	char uri[PATH_MAX];
+
+	snprintf(uri, sizeof(uri), "%s?if=%s", OC_RSRVD_WELL_KNOWN_URI,
+			IOTCON_INTERFACE_BATCH);
+
+	ret = _icd_ioty_encap_poll_push(_icd_ioty_encap_poll_cmd_new(OC_REST_DISCOVER, uri,
+				dev_addr, oic_conn_type, OC_HIGH_QOS, icd_ioty_ocprocess_encap_discover_cb));
+	if (IOTCON_ERROR_NONE != ret)
+		ERR("_icd_ioty_encap_poll_push() Fail(%d)", ret);
+}
+
+
+/* If the request fails in the stack thread, the collection is marked failed there and
+ * the fallback is sent instead. fallback is taken */
+static int _icd_ioty_encap_batch_request(OCDevAddr *dev_addr,
+		OCConnectivityType oic_conn_type, const char *host_address,
+		const char *collection, icd_encap_poll_cmd_s *fallback)
+{
+	char uri[PATH_MAX];
+	icd_encap_poll_cmd_s *poll_cmd;
+
+	snprintf(uri, sizeof(uri), "%s?if=%s", collection, IOTCON_INTERFACE_BATCH);
+
+	poll_cmd = _icd_ioty_encap_poll_cmd_new(OC_REST_GET, uri, dev_addr, oic_conn_type,
+			OC_HIGH_QOS, icd_ioty_ocprocess_encap_batch_cb);
+	if (NULL == poll_cmd) {
+		ERR("_icd_ioty_encap_poll_cmd_new() Fail");
+		_icd_ioty_encap_free_poll_cmd(fallback);
+		return IOTCON_ERROR_OUT_OF_MEMORY;
+	}
+	poll_cmd->cbdata.context = ic_utils_strdup(collection);
+	poll_cmd->cbdata.cd = free;
+	poll_cmd->host_address = ic_utils_strdup(host_address);
+	poll_cmd->collection = ic_utils_strdup(collection);
+	poll_cmd->fallback = fallback;
+
+	return _icd_ioty_encap_poll_push(poll_cmd);
+}
+
+
+/* The members of the collection are not held by the failed request. */
+static void _icd_ioty_encap_batch_failed(const char *host_address,
+		const char *collection)
+{
+	icd_encap_host_s *host;
+	icd_encap_batch_s *batch = NULL;
+
+	g_mutex_lock(&icd_encap_host_mutex);
+	host = _icd_ioty_encap_host_get(host_address);
+	if (host)
+		batch = _icd_ioty_encap_host_get_batch(host, collection);
+	if (batch)
+		batch->request_time = 0;
+	g_mutex_unlock(&icd_encap_host_mutex);
+}
+
+
+/* Returns true, if the poll of the encap_info is covered by a batch request.
+ * The host is discovered for the collections, once it has two entries or more. */
+static bool _icd_ioty_encap_batch_get(icd_encap_info_s *encap_info)
+{
+	int ret;
+	gint64 now;
+	GList *cur;
+	char *member_of = NULL;
+	bool discover = false;
+	bool covered = false;
+	OCDevAddr dev_addr;
+	icd_encap_host_s *host;
+	icd_encap_batch_s *batch;
+	GList *collections = NULL;
+	OCConnectivityType oic_conn_type;
+	icd_encap_poll_cmd_s *fallback;
+
+	now = g_get_monotonic_time();
+
+	g_mutex_lock(&icd_encap_host_mutex);
+	host = _icd_ioty_encap_host_get(encap_info->host_address);
+	if (NULL == host) {
+		g_mutex_unlock(&icd_encap_host_mutex);
+		return false;
+	}
+
+	if (NULL == host->batches && 2 <= host->encap_count && (0 == host->discover_time
+				|| host->discover_time + ICD_ENCAP_BATCH_REDISCOVER < now)) {
+		host->discover_time = now;
+		discover = true;
+	}
+
+	/* learn the members again */
+	if (host->relearn) {
+		host->relearn = false;
+		for (cur = host->batches; cur; cur = cur->next) {
+			batch = cur->data;
+			batch->request_time = now;
+			collections = g_list_prepend(collections, ic_utils_strdup(batch->uri_path));
+		}
+	}
+
+	batch = g_hash_table_lookup(host->members, encap_info->uri_path);
+	if (batch) {
+		covered = true;
+		member_of = ic_utils_strdup(batch->uri_path);
+		if (batch->request_time + ICD_ENCAP_BATCH_HOLD <= now) {
+			batch->request_time = now;
+			collections = g_list_prepend(collections, ic_utils_strdup(batch->uri_path));
+		}
+	}
+	memcpy(&dev_addr, &host->dev_addr, sizeof(OCDevAddr));
+	oic_conn_type = host->oic_conn_type;
+	g_mutex_unlock(&icd_encap_host_mutex);
+
+	if (discover)
+		_icd_ioty_encap_discover_batch(&dev_addr, oic_conn_type);
+
+	for (cur = collections; cur; cur = cur->next) {
+		/* the entry is polled by itself, if the request of its collection fails */
+		fallback = NULL;
+		if (IC_STR_EQUAL == g_strcmp0(member_of, cur->data))
+			fallback = _icd_ioty_encap_poll_cmd_new_get(encap_info);
+
+		ret = _icd_ioty_encap_batch_request(&dev_addr, oic_conn_type,
+				encap_info->host_address, cur->data, fallback);
+		if (IOTCON_ERROR_NONE == ret)
+			continue;
+		ERR("_icd_ioty_encap_batch_request() Fail(%d)", ret);
+		_icd_ioty_encap_batch_failed(encap_info->host_address, cur->data);
+		/* the entry is polled by itself */
+		if (IC_STR_EQUAL == g_strcmp0(member_of, cur->data))
+			covered = false;
+	}
+	g_list_free_full(collections, free);
+	free(member_of);
+
+	return covered;
+}
+
+
+/* the collections with the batch interface are discovered. collections is taken */
+void icd_ioty_encap_host_set_batches(const char *host_address, GList *collections)
+{
+	int ret;
+	GList *cur;
+	OCDevAddr dev_addr;
+	icd_encap_host_s *host;
+	icd_encap_batch_s *batch;
+	GList *requests = NULL;
+	OCConnectivityType oic_conn_type;
+
+	g_mutex_lock(&icd_encap_host_mutex);
+	host = _icd_ioty_encap_host_get(host_address);
+	if (NULL == host) {
+		g_mutex_unlock(&icd_encap_host_mutex);
+		g_list_free_full(collections, free);
+		return;
+	}
+
+	g_hash_table_remove_all(host->members);
+	g_list_free_full(host->batches, _icd_ioty_encap_free_batch);
+	host->batches = NULL;
+	host->relearn = false;
+
+	for (cur = collections; cur; cur = cur->next) {
+		batch = calloc(1, sizeof(icd_encap_batch_s));
+		if (NULL == batch) {
+			ERR("calloc() Fail(%d)", errno);
+			continue;
+		}
+		batch->uri_path = ic_utils_strdup(cur->data);
+		batch->request_time = g_get_monotonic_time();
+		host->batches = g_list_append(host->batches, batch);
+		requests = g_list_append(requests, ic_utils_strdup(cur->data));
+	}
+	memcpy(&dev_addr, &host->dev_addr, sizeof(OCDevAddr));
+	oic_conn_type = host->oic_conn_type;
+	g_mutex_unlock(&icd_encap_host_mutex);
+	g_list_free_full(collections, free);
+
+	/* learn the members */
+	for (cur = requests; cur; cur = cur->next) {
+		ret = _icd_ioty_encap_batch_request(&dev_addr, oic_conn_type, host_address,
+				cur->data, NULL);
+		if (IOTCON_ERROR_NONE != ret) {
+			ERR("_icd_ioty_encap_batch_request() Fail(%d)", ret);
+			_icd_ioty_encap_batch_failed(host_address, cur->data);
+		}
+	}
+	g_list_free_full(requests, free);
+}
+
+
+/* the batch request of the collection is answered by its members. members is taken */
+void icd_ioty_encap_host_set_members(const char *host_address, const char *collection,
+		GList *members)
+{
+	GList *cur;
+	icd_encap_host_s *host;
+	icd_encap_batch_s *batch = NULL;
+
+	g_mutex_lock(&icd_encap_host_mutex);
+	host = _icd_ioty_encap_host_get(host_address);
+	if (host)
+		batch = _icd_ioty_encap_host_get_batch(host, collection);
+	if (NULL == batch) {
+		g_mutex_unlock(&icd_encap_host_mutex);
+		g_list_free_full(members, free);
+		return;
+	}
+
+	g_hash_table_foreach_remove(host->members, _icd_ioty_encap_is_member_of, batch);
+	for (cur = members; cur; cur = cur->next) {
+		g_hash_table_replace(host->members, cur->data, batch);
+		cur->data = NULL;
+	}
+	g_mutex_unlock(&icd_encap_host_mutex);
+
+	g_list_free(members);
+}
+
+
+/* the batch request of the collection fails. Its members are polled one by one */
+void icd_ioty_encap_host_remove_batch(const char *host_address, const char *collection)
+{
+	icd_encap_host_s *host;
+	icd_encap_batch_s *batch = NULL;
+
+	g_mutex_lock(&icd_encap_host_mutex);
+	host = _icd_ioty_encap_host_get(host_address);
+	if (host)
+		batch = _icd_ioty_encap_host_get_batch(host, collection);
+	if (batch) {
+		g_hash_table_foreach_remove(host->members, _icd_ioty_encap_is_member_of, batch);
+		host->batches = g_list_remove(host->batches, batch);
+		_icd_ioty_encap_free_batch(batch);
+	}
+	g_mutex_unlock(&icd_encap_host_mutex);
+}
+
+
+static gboolean _icd_ioty_encap_wheel_tick(gpointer user_data)
+{
+	int ret, host_count;
+	GQueue *slot;
+	GList *cur, *next, *last;
+	GList *due_list = NULL;
+	GHashTable *host_table = NULL;
+	icd_encap_info_s *encap_info;
+	unsigned int steps, polls = 0;
+
+	g_mutex_lock(&icd_encap_wheel.mutex);
+	/* a replaced timer could still be dispatched */
+	if (g_source_get_id(g_main_current_source()) == icd_encap_wheel.timer_id)
+		icd_encap_wheel.timer_id = 0;
+
+	/* catch up with the slots which are due by now */
+	for (steps = _icd_ioty_encap_wheel_lag(); 0 < steps; steps--) {
+		icd_encap_wheel.cur = (icd_encap_wheel.cur + 1) % ICD_ENCAP_WHEEL_SIZE;
+		icd_encap_wheel.base_time += ICD_ENCAP_WHEEL_TICK * G_TIME_SPAN_MILLISECOND;
+		slot = &icd_encap_wheel.slots[icd_encap_wheel.cur];
+
+		/* entries re-added to this slot while looping are for the next revolution */
+		last = slot->tail;
+		for (cur = slot->head; cur; cur = next) {
+			next = (cur == last) ? NULL : cur->next;
+			encap_info = cur->data;
+
+			if (0 < encap_info->wheel_rounds) {
+				encap_info->wheel_rounds--;
+				continue;
+			}
+			_icd_ioty_encap_wheel_remove(encap_info);
+
+			if (NULL == host_table)
+				host_table = g_hash_table_new(g_str_hash, g_str_equal);
+			host_count = GPOINTER_TO_INT(g_hash_table_lookup(host_table,
+						encap_info->host_address));
+
+			/* over the limits, try again in the next tick */
+			if (ICD_ENCAP_POLL_MAX_PER_TICK <= polls
+					|| ICD_ENCAP_POLL_MAX_PER_HOST <= host_count) {
+				_icd_ioty_encap_wheel_add(encap_info, 1);
+				continue;
+			}
+			g_hash_table_replace(host_table, encap_info->host_address,
+					GINT_TO_POINTER(host_count + 1));
+			polls++;
+
+			_icd_ioty_encap_wheel_add(encap_info,
+					_icd_ioty_encap_next_ticks(encap_info));
+			due_list = g_list_prepend(due_list, encap_info);
+		}
+	}
+	_icd_ioty_encap_wheel_arm();
+	g_mutex_unlock(&icd_encap_wheel.mutex);
+
+	if (host_table)
+		g_hash_table_destroy(host_table);
+
+	/* encap_info is removed only in the main thread, which runs this function.
+	 * The requests are queued to the stack thread, which sends them in one lock hold.
+	 * The main loop does not wait for the csdk lock. */
+	for (cur = due_list; cur; cur = cur->next) {
+		encap_info = cur->data;
+
+		/* the host is unreachable : the poll fails without a request */
+		if (IOTCON_ERROR_NONE != icd_ioty_health_check(&encap_info->dev_addr)) {
+			ret = icd_ioty_ocprocess_encap_timeout(encap_info->uri_path,
+					&encap_info->dev_addr);
+			if (IOTCON_ERROR_NONE != ret)
+				ERR("icd_ioty_ocprocess_encap_timeout() Fail(%d)", ret);
+			continue;
+		}
+
+		if (_icd_ioty_encap_batch_get(encap_info))
+			continue;
+		_icd_ioty_encap_get(encap_info);
+	}
+	g_list_free(due_list);
+
+	return G_SOURCE_REMOVE;
+}
+
+
+/* ticks 0 : after the poll interval of the encap_info */
+static void _icd_ioty_encap_schedule(icd_encap_info_s *encap_info, unsigned int ticks)
+{
+	g_mutex_lock(&icd_encap_wheel.mutex);
+	/* a worker could still hold the removed entry */
+	if (encap_info->is_removed) {
+		g_mutex_unlock(&icd_encap_wheel.mutex);
+		return;
+	}
+	if (0 == ticks)
+		ticks = _icd_ioty_encap_next_ticks(encap_info);
+	_icd_ioty_encap_wheel_remove(encap_info);
+	_icd_ioty_encap_wheel_add(encap_info, ticks);
+	_icd_ioty_encap_wheel_arm();
+	g_mutex_unlock(&icd_encap_wheel.mutex);
+}
+
+
+/* poll the resource in the next tick */
+void icd_ioty_encap_poll_now(icd_encap_info_s *encap_info)
+{
+	RET_IF(NULL == encap_info);
+
+	_icd_ioty_encap_schedule(encap_info, 1);
+}
+
+
+/* postpone the poll to the next interval */
+void icd_ioty_encap_poll_later(icd_encap_info_s *encap_info)
+{
+	RET_IF(NULL == encap_info);
+
+	_icd_ioty_encap_schedule(encap_info, 0);
+}
+
+
+/* Back off while the resource is stable, and snap back on a change or a lost signal */
+void icd_ioty_encap_update_interval(icd_encap_info_s *encap_info, bool changed)
+{
+	RET_IF(NULL == encap_info);
+
+	g_mutex_lock(&icd_encap_wheel.mutex);
+	if (0 == encap_info->poll_min) {
+		g_mutex_unlock(&icd_encap_wheel.mutex);
+		return;
+	}
+
+	if (false == changed) {
+		encap_info->poll_cur = MIN(encap_info->poll_cur * 2, encap_info->poll_max);
+	} else if (encap_info->poll_min != encap_info->poll_cur) {
+		encap_info->poll_cur = encap_info->poll_min;
+		if (encap_info->wheel_link) {
+			_icd_ioty_encap_wheel_remove(encap_info);
+			_icd_ioty_encap_wheel_add(encap_info, _icd_ioty_encap_next_ticks(encap_info));
+			_icd_ioty_encap_wheel_arm();
+		}
+	}
+	g_mutex_unlock(&icd_encap_wheel.mutex);
+}
+
+
+/* lost_count 0 : use the default hysteresis */
+int icd_ioty_encap_set_hysteresis(const char *uri_path, const char *host_address,
+		unsigned int lost_count, unsigned int alive_count, unsigned int dwell_time)
+{
+	icd_encap_info_s *encap_info;
+
+	if (lost_count) {
+		RETV_IF(0 == alive_count, IOTCON_ERROR_INVALID_PARAMETER);
+		RETV_IF(ICD_ENCAP_MAX_DWELL_TIME < dwell_time, IOTCON_ERROR_INVALID_PARAMETER);
+	}
+
+	encap_info = _icd_ioty_encap_table_get_info(uri_path, host_address);
+	if (NULL == encap_info) {
+		ERR("_icd_ioty_encap_table_get_info() Fail");
+		return IOTCON_ERROR_NO_DATA;
+	}
+
+	g_mutex_lock(&encap_info->state_mutex);
+	encap_info->lost_count = lost_count;
+	encap_info->alive_count = lost_count ? alive_count : 0;
+	encap_info->dwell_time = lost_count ? dwell_time : 0;
+	g_mutex_unlock(&encap_info->state_mutex);
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+/* Returns true, if the state of the resource is changed by the result.
+ * The state changes after the results against it come enough times in a row, and not
+ * before it is kept for the dwell time. Until then, the resource is polled sooner.
+ * MUST be called with the state mutex of the encap_info */
+bool icd_ioty_encap_update_state(icd_encap_info_s *encap_info,
+		iotcon_remote_resource_state_e state)
+{
+	gint64 now;
+	unsigned int threshold, dwell_time;
+
+	RETV_IF(NULL == encap_info, false);
+
+	if (state == encap_info->resource_state) {
+		encap_info->transit_count = 0;
+		return false;
+	}
+
+	encap_info->transit_count++;
+	if (encap_info->lost_count) {
+		if (IOTCON_REMOTE_RESOURCE_LOST_SIGNAL == state)
+			threshold = encap_info->lost_count;
+		else
+			threshold = encap_info->alive_count;
+		dwell_time = encap_info->dwell_time;
+	} else {
+		if (IOTCON_REMOTE_RESOURCE_LOST_SIGNAL == state)
+			threshold = ICD_ENCAP_DEFAULT_LOST_COUNT;
+		else
+			threshold = ICD_ENCAP_DEFAULT_ALIVE_COUNT;
+		dwell_time = ICD_ENCAP_DEFAULT_DWELL_TIME;
+	}
+
+	now = g_get_monotonic_time();
+	if (encap_info->transit_count < threshold
+			|| now < encap_info->state_time + dwell_time * G_TIME_SPAN_MILLISECOND) {
+		_icd_ioty_encap_retry(encap_info);
+		return false;
+	}
+
+	encap_info->resource_state = state;
+	encap_info->transit_count = 0;
+	encap_info->state_time = now;
+
+	return true;
+}
+
+
+/* min_interval 0 : use the global time interval */
+int icd_ioty_encap_set_poll_interval(const char *uri_path, const char *host_address,
+		unsigned int min_interval, unsigned int max_interval)
+{
+	icd_encap_info_s *encap_info;
+
+	RETV_IF(min_interval && max_interval < min_interval, IOTCON_ERROR_INVALID_PARAMETER);
+
+	encap_info = _icd_ioty_encap_table_get_info(uri_path, host_address);
+	if (NULL == encap_info) {
+		ERR("_icd_ioty_encap_table_get_info() Fail");
+		return IOTCON_ERROR_NO_DATA;
+	}
+
+	g_mutex_lock(&icd_encap_wheel.mutex);
+	encap_info->poll_min = min_interval;
+	encap_info->poll_max = min_interval ? max_interval : 0;
+	encap_info->poll_cur = min_interval;
+	g_mutex_unlock(&icd_encap_wheel.mutex);
+
+	_icd_ioty_encap_schedule(encap_info, 0);
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+static void _encap_set_time_interval(gpointer key, gpointer value, gpointer user_data)
+{
+	icd_encap_info_s *encap_info = value;
+	unsigned int ticks = GPOINTER_TO_UINT(user_data);
+
+	/* the resource has its own poll interval */
+	if (encap_info->poll_min)
+		return;
+
+	/* spread the polls over the new interval */
+	_icd_ioty_encap_schedule(encap_info, g_random_int_range(1, ticks + 1));
+}
+
+
+void icd_ioty_encap_set_time_interval(int time_interval)
+{
+	icd_remote_resource_time_interval = time_interval;
+
+	g_mutex_lock(&icd_ioty_encap_table_mutex);
+	if (icd_ioty_encap_table) {
+		g_hash_table_foreach(icd_ioty_encap_table, _encap_set_time_interval,
+				GUINT_TO_POINTER(_icd_ioty_encap_interval_ticks()));
+	}
+	g_mutex_unlock(&icd_ioty_encap_table_mutex);
+}
+
+
+static void _icd_ioty_encap_free_history(void *data)
+{
+	icd_encap_history_s *history = data;
+
+	g_variant_unref(history->value);
+	free(history);
+}
+
+
+static void _icd_ioty_encap_history_clear(icd_encap_info_s *encap_info)
+{
+	icd_encap_history_s *history;
+
+	g_mutex_lock(&encap_info->history_mutex);
+	while ((history = g_queue_pop_head(&encap_info->history)))
+		_icd_ioty_encap_free_history(history);
+	encap_info->history_size = 0;
+	g_mutex_unlock(&encap_info->history_mutex);
+}
+
+
+static void _free_encap_info(void *user_data)
+{
+	icd_encap_info_s *encap_info = user_data;
+
+	_icd_ioty_encap_history_clear(encap_info);
+	g_mutex_clear(&encap_info->history_mutex);
+	OCRepPayloadDestroy(encap_info->oic_payload);
+	g_mutex_clear(&encap_info->state_mutex);
+	g_hash_table_destroy(encap_info->monitoring_clients);
+	g_hash_table_destroy(encap_info->caching_clients);
+	g_hash_table_destroy(encap_info->caching_delta_clients);
+	g_hash_table_destroy(encap_info->caching_synced_clients);
+	g_mutex_clear(&encap_info->clients_mutex);
+	free(encap_info->host_address);
+	free(encap_info->uri_path);
+	free(encap_info);
+}
+
+
+/* The last one frees the entry. It could be a worker thread after the entry is removed. */
+void icd_ioty_encap_info_unref(icd_encap_info_s *encap_info)
+{
+	RET_IF(NULL == encap_info);
+
+	if (g_atomic_int_dec_and_test(&encap_info->ref_count))
+		_free_encap_info(encap_info);
+}
+
+
+static icd_encap_info_s* _icd_ioty_encap_table_add(const char *uri_path,
+		const char *host_address, int conn_type)
+{
+	int ret;
+	char key_str[PATH_MAX];
+	icd_encap_info_s *encap_info;
+
+	encap_info = calloc(1, sizeof(icd_encap_info_s));
+	if (NULL == encap_info) {
+		ERR("calloc() Fail(%d)", errno);
+		return NULL;
+	}
+
+	ret = icd_ioty_get_dev_addr(host_address, conn_type, &encap_info->dev_addr);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("icd_ioty_get_dev_addr() Fail(%d)", ret);
+		free(encap_info);
+		return NULL;
+	}
+
+	/* encap_worker_ctx */
+	encap_info->worker_ctx = calloc(1, sizeof(icd_encap_worker_ctx_s));
+	if (NULL == encap_info->worker_ctx) {
+		ERR("calloc() Fail(%d)", errno);
+		free(encap_info);
+		return NULL;
+	}
+	encap_info->worker_ctx->uri_path = ic_utils_strdup(uri_path);
+	encap_info->worker_ctx->is_valid = true;
+
+	g_mutex_init(&encap_info->state_mutex);
+	g_mutex_init(&encap_info->clients_mutex);
+	g_mutex_init(&encap_info->history_mutex);
+	g_queue_init(&encap_info->history);
+	encap_info->monitoring_clients = g_hash_table_new_full(g_str_hash, g_str_equal, free,
+			NULL);
+	encap_info->caching_clients = g_hash_table_new_full(g_str_hash, g_str_equal, free,
+			NULL);
+	encap_info->caching_delta_clients = g_hash_table_new_full(g_str_hash, g_str_equal,
+			free, NULL);
+	encap_info->caching_synced_clients = g_hash_table_new_full(g_str_hash, g_str_equal,
+			free, NULL);
+
+	encap_info->uri_path = ic_utils_strdup(uri_path);
+	encap_info->host_address = ic_utils_strdup(host_address);
+	encap_info->oic_conn_type = icd_ioty_conn_type_to_oic_conn_type(conn_type);
+	snprintf(key_str, sizeof(key_str), "%s%s", uri_path, host_address);
+	encap_info->signal_number = icd_dbus_generate_signal_number();
+	/* the reference of the table */
+	encap_info->ref_count = 1;
+
+	g_mutex_lock(&icd_ioty_encap_table_mutex);
+	if (NULL == icd_ioty_encap_table) {
+		icd_ioty_encap_table = g_hash_table_new_full(g_str_hash, g_str_equal, free,
+				(GDestroyNotify)icd_ioty_encap_info_unref);
+	}
+	g_hash_table_insert(icd_ioty_encap_table, ic_utils_strdup(key_str),
+			encap_info);
+	g_mutex_unlock(&icd_ioty_encap_table_mutex);
+
+	_icd_ioty_encap_host_ref(encap_info);
+
+	return encap_info;
+}
+
+
+static void _icd_ioty_encap_table_remove(icd_encap_info_s *encap_info,
+		const char *host_address)
+{
+	char key_str[PATH_MAX];
+
+	snprintf(key_str, sizeof(key_str), "%s%s", encap_info->uri_path, host_address);
+
+	_icd_ioty_encap_host_unref(encap_info);
+
+	g_mutex_lock(&icd_encap_wheel.mutex);
+	_icd_ioty_encap_wheel_remove(encap_info);
+	encap_info->is_removed = true;
+	g_mutex_unlock(&icd_encap_wheel.mutex);
+
+	/* the workers using the entry keep it until they unref it */
+	g_mutex_lock(&icd_ioty_encap_table_mutex);
+	g_hash_table_remove(icd_ioty_encap_table, key_str);
+
+	if (0 == g_hash_table_size(icd_ioty_encap_table)) {
+		g_hash_table_destroy(icd_ioty_encap_table);
+		icd_ioty_encap_table = NULL;
+	}
+	g_mutex_unlock(&icd_ioty_encap_table_mutex);
+}
+
+
+/* MUST be called with the table mutex */
+static icd_encap_info_s* _icd_ioty_encap_table_lookup(const char *uri_path,
+		const char *host_address)
+{
+	char key_str[PATH_MAX];
+
+	if (NULL == icd_ioty_encap_table)
+		return NULL;
+
+	snprintf(key_str, sizeof(key_str), "%s%s", uri_path, host_address);
+
+	return g_hash_table_lookup(icd_ioty_encap_table, key_str);
+}
+
+
+/* The entries are removed only in the main thread. So the entry is valid in the main
+ * thread without a reference. The other threads MUST use icd_ioty_encap_table_ref_info() */
+icd_encap_info_s* _icd_ioty_encap_table_get_info(const char *uri_path,
+		const char *host_address)
+{
+	icd_encap_info_s *encap_info;
+
+	g_mutex_lock(&icd_ioty_encap_table_mutex);
+	encap_info = _icd_ioty_encap_table_lookup(uri_path, host_address);
+	g_mutex_unlock(&icd_ioty_encap_table_mutex);
+
+	return encap_info;
+}
+
+
+/* The entry is valid until icd_ioty_encap_info_unref(), even if it is removed */
+icd_encap_info_s* icd_ioty_encap_table_ref_info(const char *uri_path,
+		const char *host_address)
+{
+	icd_encap_info_s *encap_info;
+
+	g_mutex_lock(&icd_ioty_encap_table_mutex);
+	encap_info = _icd_ioty_encap_table_lookup(uri_path, host_address);
+	if (encap_info)
+		g_atomic_int_inc(&encap_info->ref_count);
+	g_mutex_unlock(&icd_ioty_encap_table_mutex);
+
+	return encap_info;
+}
+
+
+int icd_ioty_start_encap(int type, const char *uri_path, const char *host_address,
+		int conn_type, int64_t *signal_number)
+{
+	OCCallbackData cbdata = {0};
+	icd_encap_info_s *encap_info;
+
+	encap_info = _icd_ioty_encap_table_get_info(uri_path, host_address);
+	if (NULL == encap_info) {
+		encap_info = _icd_ioty_encap_table_add(uri_path, host_address, conn_type);
+		if (NULL == encap_info) {
+			ERR("_icd_ioty_encap_table_add() Fail");
+			return IOTCON_ERROR_OUT_OF_MEMORY;
+		}
+	}
+
+	switch (type) {
+	case ICD_ENCAP_MONITORING:
+		if (0 != encap_info->monitoring_count) {
+			*signal_number = encap_info->signal_number;
+			encap_info->monitoring_count++;
+			return IOTCON_ERROR_NONE;
+		}
+		/* DEVICE PRESENCE */
+		encap_info->presence_handle = icd_ioty_subscribe_presence(ICD_ENCAP_MONITORING,
+				host_address, conn_type, NULL, encap_info->worker_ctx);
+		if (NULL == encap_info->presence_handle) {
+			ERR("icd_ioty_subscribe_presence() Fail");
+			if (0 == encap_info->monitoring_count + encap_info->caching_count)
+				_icd_ioty_encap_table_remove(encap_info, host_address);
+			return IOTCON_ERROR_IOTIVITY;
+		}
+		encap_info->worker_ctx->presence_flag = true;
+		encap_info->monitoring_count++;
+		break;
+	case ICD_ENCAP_CACHING:
+		if (0 != encap_info->caching_count) {
+			*signal_number = encap_info->signal_number;
+			encap_info->caching_count++;
+			return IOTCON_ERROR_NONE;
+		}
+		/* OBSERVE METHOD */
+		cbdata.context = encap_info->worker_ctx;
+		cbdata.cb = icd_ioty_ocprocess_encap_observe_cb;
+		cbdata.cd = _free_encap_worker_observe_ctx;
+
+		encap_info->observe_handle = _icd_ioty_observe_register(uri_path,
+				&encap_info->dev_addr,
+				NULL,
+				OC_REST_OBSERVE,
+				encap_info->oic_conn_type,
+				&cbdata);
+		if (NULL == encap_info->observe_handle) {
+			ERR("_icd_ioty_observe_register() Fail");
+			if (0 == encap_info->monitoring_count + encap_info->caching_count)
+				_icd_ioty_encap_table_remove(encap_info, host_address);
+			return IOTCON_ERROR_IOTIVITY;
+		}
+		encap_info->worker_ctx->observe_flag = true;
+		encap_info->caching_count++;
+		break;
+	default:
+		ERR("Invalid Type(%d)", type);
+		if (0 == encap_info->monitoring_count + encap_info->caching_count)
+			_icd_ioty_encap_table_remove(encap_info, host_address);
+		return IOTCON_ERROR_INVALID_TYPE;
+	}
+
+	/* GET METHOD */
+	if (1 == encap_info->monitoring_count + encap_info->caching_count)
+		icd_ioty_encap_poll_now(encap_info);
+
+	*signal_number = encap_info->signal_number;
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+static void _icd_ioty_stop_encap_get(icd_encap_info_s *encap_info,
+		const char *host_address)
+{
+	icd_encap_worker_ctx_s *worker_ctx = encap_info->worker_ctx;
+
+	if (0 != encap_info->monitoring_count + encap_info->caching_count)
+		return;
+
+	g_mutex_lock(&worker_ctx->icd_worker_mutex);
+	encap_info->worker_ctx->is_valid = false;
+	_icd_ioty_encap_table_remove(encap_info, host_address);
+	g_mutex_unlock(&worker_ctx->icd_worker_mutex);
+
+}
+
+
+int icd_ioty_stop_encap(int type, const char *uri_path, const char *host_address)
+{
+	int ret;
+	OCDoHandle handle;
+	icd_encap_info_s *encap_info;
+
+	encap_info = _icd_ioty_encap_table_get_info(uri_path, host_address);
+	if (NULL == encap_info) {
+		ERR("_icd_ioty_encap_table_get_info() Fail");
+		return IOTCON_ERROR_NO_DATA;
+	}
+
+	switch (type) {
+	case ICD_ENCAP_MONITORING:
+		if (0 == encap_info->monitoring_count) {
+			ERR("Not Monitoring(%s%s)", host_address, uri_path);
 			return IOTCON_ERROR_INVALID_PARAMETER;
 		}
 
@@ -1569,6 +3020,8 @@ int icd_ioty_stop_encap(int type, const char *uri_path, const char *host_address
 		if (0 != encap_info->caching_count)
 			return IOTCON_ERROR_NONE;
 
+		_icd_ioty_encap_history_clear(encap_info);
+
 		/* GET METHOD */
 		handle = encap_info->observe_handle;
 		_icd_ioty_stop_encap_get(encap_info, host_address);
@@ -1588,3 +3041,284 @@ int icd_ioty_stop_encap(int type, const char *uri_path, const char *host_address
 	return IOTCON_ERROR_NONE;
 }
 
+
+static GHashTable* _icd_ioty_encap_get_client_table(icd_encap_info_s *encap_info,
+		int type)
+{
+	switch (type) {
+	case ICD_ENCAP_MONITORING:
+		return encap_info->monitoring_clients;
+	case ICD_ENCAP_CACHING:
+		return encap_info->caching_clients;
+	default:
+		ERR("Invalid Type(%d)", type);
+		return NULL;
+	}
+}
+
+
+static void _icd_ioty_encap_client_table_add(GHashTable *clients, const char *bus_name)
+{
+	int count;
+
+	count = GPOINTER_TO_INT(g_hash_table_lookup(clients, bus_name));
+	if (0 == count)
+		g_hash_table_insert(clients, ic_utils_strdup(bus_name), GINT_TO_POINTER(1));
+	else
+		g_hash_table_replace(clients, ic_utils_strdup(bus_name), GINT_TO_POINTER(count + 1));
+}
+
+
+static void _icd_ioty_encap_client_table_remove(GHashTable *clients,
+		const char *bus_name, int count)
+{
+	int cur_count;
+
+	cur_count = GPOINTER_TO_INT(g_hash_table_lookup(clients, bus_name));
+	if (cur_count <= count)
+		g_hash_table_remove(clients, bus_name);
+	else
+		g_hash_table_replace(clients, ic_utils_strdup(bus_name),
+				GINT_TO_POINTER(cur_count - count));
+}
+
+
+void icd_ioty_encap_add_client(int type, const char *uri_path, const char *host_address,
+		const char *bus_name, bool delta)
+{
+	GHashTable *clients;
+	icd_encap_info_s *encap_info;
+
+	RET_IF(NULL == bus_name);
+
+	encap_info = _icd_ioty_encap_table_get_info(uri_path, host_address);
+	if (NULL == encap_info) {
+		ERR("_icd_ioty_encap_table_get_info() Fail");
+		return;
+	}
+
+	clients = _icd_ioty_encap_get_client_table(encap_info, type);
+	RET_IF(NULL == clients);
+
+	g_mutex_lock(&encap_info->clients_mutex);
+	_icd_ioty_encap_client_table_add(clients, bus_name);
+	if (ICD_ENCAP_CACHING == type) {
+		if (delta)
+			_icd_ioty_encap_client_table_add(encap_info->caching_delta_clients, bus_name);
+		/* the new subscription has no cached representation yet */
+		g_hash_table_remove(encap_info->caching_synced_clients, bus_name);
+	}
+	g_mutex_unlock(&encap_info->clients_mutex);
+}
+
+
+void icd_ioty_encap_remove_client(int type, const char *uri_path,
+		const char *host_address, const char *bus_name, int count, int delta_count)
+{
+	GHashTable *clients;
+	icd_encap_info_s *encap_info;
+
+	RET_IF(NULL == bus_name);
+
+	/* encap_info is already removed, if it was the last client */
+	encap_info = _icd_ioty_encap_table_get_info(uri_path, host_address);
+	if (NULL == encap_info)
+		return;
+
+	clients = _icd_ioty_encap_get_client_table(encap_info, type);
+	RET_IF(NULL == clients);
+
+	g_mutex_lock(&encap_info->clients_mutex);
+	_icd_ioty_encap_client_table_remove(clients, bus_name, count);
+	if (ICD_ENCAP_CACHING == type) {
+		if (0 < delta_count) {
+			_icd_ioty_encap_client_table_remove(encap_info->caching_delta_clients,
+					bus_name, delta_count);
+		}
+		if (NULL == g_hash_table_lookup(encap_info->caching_delta_clients, bus_name))
+			g_hash_table_remove(encap_info->caching_synced_clients, bus_name);
+	}
+	g_mutex_unlock(&encap_info->clients_mutex);
+}
+
+
+/* returns the copied bus names, which subscribe the type of encapsulation */
+GList* icd_ioty_encap_get_clients(icd_encap_info_s *encap_info, int type)
+{
+	GList *cur, *bus_names;
+	GHashTable *clients;
+
+	RETV_IF(NULL == encap_info, NULL);
+
+	clients = _icd_ioty_encap_get_client_table(encap_info, type);
+	RETV_IF(NULL == clients, NULL);
+
+	g_mutex_lock(&encap_info->clients_mutex);
+	bus_names = g_hash_table_get_keys(clients);
+	for (cur = bus_names; cur; cur = cur->next)
+		cur->data = ic_utils_strdup(cur->data);
+	g_mutex_unlock(&encap_info->clients_mutex);
+
+	return bus_names;
+}
+
+
+/* returns true, if the client takes only the changed attributes and it already holds
+ * the previous cached representation */
+bool icd_ioty_encap_client_take_delta(icd_encap_info_s *encap_info,
+		const char *bus_name)
+{
+	bool take_delta;
+
+	RETV_IF(NULL == encap_info, false);
+	RETV_IF(NULL == bus_name, false);
+
+	g_mutex_lock(&encap_info->clients_mutex);
+	take_delta = g_hash_table_contains(encap_info->caching_synced_clients, bus_name);
+	g_mutex_unlock(&encap_info->clients_mutex);
+
+	return take_delta;
+}
+
+
+/* the client received the whole cached representation */
+void icd_ioty_encap_client_synced(icd_encap_info_s *encap_info, const char *bus_name)
+{
+	RET_IF(NULL == encap_info);
+	RET_IF(NULL == bus_name);
+
+	g_mutex_lock(&encap_info->clients_mutex);
+	if (g_hash_table_lookup(encap_info->caching_delta_clients, bus_name)) {
+		g_hash_table_replace(encap_info->caching_synced_clients,
+				ic_utils_strdup(bus_name), GINT_TO_POINTER(1));
+	}
+	g_mutex_unlock(&encap_info->clients_mutex);
+}
+
+
+/* the client missed a caching signal, or asks again. It receives the whole cached
+ * representation next time */
+void icd_ioty_encap_client_unsynced(icd_encap_info_s *encap_info, const char *bus_name)
+{
+	RET_IF(NULL == encap_info);
+	RET_IF(NULL == bus_name);
+
+	g_mutex_lock(&encap_info->clients_mutex);
+	g_hash_table_remove(encap_info->caching_synced_clients, bus_name);
+	g_mutex_unlock(&encap_info->clients_mutex);
+}
+
+
+/* The history keeps the largest size requested by the caching clients.
+ * It is cleared when the last caching client stops. */
+int icd_ioty_encap_set_history_size(const char *uri_path, const char *host_address,
+		unsigned int size)
+{
+	icd_encap_info_s *encap_info;
+
+	RETV_IF(NULL == uri_path, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(NULL == host_address, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(ICD_ENCAP_MAX_HISTORY < size, IOTCON_ERROR_INVALID_PARAMETER);
+
+	encap_info = _icd_ioty_encap_table_get_info(uri_path, host_address);
+	if (NULL == encap_info || 0 == encap_info->caching_count) {
+		ERR("Not Caching(%s%s)", host_address, uri_path);
+		return IOTCON_ERROR_NO_DATA;
+	}
+
+	g_mutex_lock(&encap_info->history_mutex);
+	encap_info->history_size = MAX(encap_info->history_size, size);
+	g_mutex_unlock(&encap_info->history_mutex);
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+/* a new representation is cached */
+void icd_ioty_encap_history_add(icd_encap_info_s *encap_info, OCRepPayload *payload)
+{
+	GVariant *value;
+	icd_encap_history_s *history;
+
+	RET_IF(NULL == encap_info);
+	RET_IF(NULL == payload);
+
+	/* history_size only grows while caching. It is checked again under the mutex */
+	if (0 == encap_info->history_size)
+		return;
+
+	value = icd_payload_to_gvariant((OCPayload*)payload);
+	if (NULL == value) {
+		ERR("icd_payload_to_gvariant() Fail");
+		return;
+	}
+
+	history = calloc(1, sizeof(icd_encap_history_s));
+	if (NULL == history) {
+		ERR("calloc() Fail(%d)", errno);
+		g_variant_unref(g_variant_ref_sink(value));
+		return;
+	}
+	history->timestamp = g_get_real_time() / 1000;
+	history->value = g_variant_ref_sink(value);
+
+	g_mutex_lock(&encap_info->history_mutex);
+	if (0 == encap_info->history_size) {
+		g_mutex_unlock(&encap_info->history_mutex);
+		_icd_ioty_encap_free_history(history);
+		return;
+	}
+	g_queue_push_tail(&encap_info->history, history);
+	while (encap_info->history_size < g_queue_get_length(&encap_info->history))
+		_icd_ioty_encap_free_history(g_queue_pop_head(&encap_info->history));
+	g_mutex_unlock(&encap_info->history_mutex);
+}
+
+
+/* The last count entries in the range from since to until, the oldest first.
+ * count 0 means no limit. since and until 0 mean no bound. */
+int icd_ioty_encap_get_history(const char *uri_path, const char *host_address,
+		unsigned int count, int64_t since, int64_t until, GVariant **history)
+{
+	GList *cur;
+	unsigned int n = 0;
+	GList *entries = NULL;
+	GVariantBuilder builder;
+	icd_encap_info_s *encap_info;
+	icd_encap_history_s *entry;
+
+	RETV_IF(NULL == uri_path, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(NULL == host_address, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(NULL == history, IOTCON_ERROR_INVALID_PARAMETER);
+
+	encap_info = _icd_ioty_encap_table_get_info(uri_path, host_address);
+	if (NULL == encap_info || 0 == encap_info->caching_count) {
+		ERR("Not Caching(%s%s)", host_address, uri_path);
+		return IOTCON_ERROR_NO_DATA;
+	}
+
+	g_variant_builder_init(&builder, G_VARIANT_TYPE("a(xv)"));
+
+	g_mutex_lock(&encap_info->history_mutex);
+	for (cur = encap_info->history.tail; cur; cur = cur->prev) {
+		entry = cur->data;
+		if (until && until < entry->timestamp)
+			continue;
+		if (since && entry->timestamp < since)
+			break;
+		if (count && count <= n)
+			break;
+		entries = g_list_prepend(entries, entry);
+		n++;
+	}
+	for (cur = entries; cur; cur = cur->next) {
+		entry = cur->data;
+		g_variant_builder_add(&builder, "(xv)", entry->timestamp, entry->value);
+	}
+	g_mutex_unlock(&encap_info->history_mutex);
+	g_list_free(entries);
+
+	*history = g_variant_builder_end(&builder);
+
+	return IOTCON_ERROR_NONE;
+}
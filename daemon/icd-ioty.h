@@ -51,20 +51,50 @@ typedef struct {
 } icd_encap_worker_ctx_s;
 
 typedef struct {
+	int ref_count; /* the table and the workers using the entry */
+	bool is_removed; /* out of the table. MUST be accessed with the wheel mutex */
 	char *uri_path;
 	OCDevAddr dev_addr;
 	OCConnectivityType oic_conn_type;
 	int64_t signal_number;
-	int get_timer_id;
+	char *host_address;
+	GList *wheel_link;
+	unsigned int wheel_slot;
+	unsigned int wheel_rounds;
+	unsigned int poll_min; /* ms, 0 : global time interval */
+	unsigned int poll_max; /* ms */
+	unsigned int poll_cur; /* ms */
+	unsigned int lost_count; /* 0 : the default hysteresis */
+	unsigned int alive_count;
+	unsigned int dwell_time; /* ms */
+	int probe_pending; /* the last probe is not answered */
+	/* the workers update the state and the cached representation of an entry at once */
+	GMutex state_mutex;
+	unsigned int transit_count; /* results in a row against resource_state */
+	gint64 state_time; /* monotonic time of the last state transition */
 	int monitoring_count;
 	int caching_count;
 	OCDoHandle presence_handle;
 	OCDoHandle observe_handle;
 	iotcon_remote_resource_state_e resource_state;
 	OCRepPayload *oic_payload;
+	uint64_t oic_payload_digest;
 	icd_encap_worker_ctx_s *worker_ctx;
+	GMutex clients_mutex;
+	GHashTable *monitoring_clients; /* key : bus name, value : count */
+	GHashTable *caching_clients; /* key : bus name, value : count */
+	GHashTable *caching_delta_clients; /* key : bus name, value : count */
+	GHashTable *caching_synced_clients; /* bus names holding the cached representation */
+	GMutex history_mutex;
+	GQueue history; /* icd_encap_history_s, the oldest first */
+	unsigned int history_size; /* 0 : no history */
 } icd_encap_info_s;
 
+typedef struct {
+	int64_t timestamp; /* ms since the epoch */
+	GVariant *value;
+} icd_encap_history_s;
+
 enum {
 	ICD_CRUD_GET,
 	ICD_CRUD_PUT,
@@ -75,12 +105,20 @@ enum {
 	ICD_ENCAP_MONITORING,
 	ICD_ENCAP_CACHING,
 	ICD_PRESENCE,
+	ICD_FIND_RESOURCE,
 };
 
+typedef void (*icd_ioty_csdk_cmd_fn)(void *data);
+
 void icd_ioty_csdk_lock();
 
 void icd_ioty_csdk_unlock();
 
+int icd_ioty_csdk_cmd_push(icd_ioty_csdk_cmd_fn fn, icd_ioty_csdk_cmd_fn cancel,
+		void *data);
+
+void icd_ioty_csdk_cmd_process();
+
 GThread* icd_ioty_init(const char *addr, unsigned short port);
 
 void icd_ioty_deinit(GThread *thread);
@@ -98,11 +136,13 @@ int icd_ioty_bind_resource(OCResourceHandle parent, OCResourceHandle child);
 
 int icd_ioty_unbind_resource(OCResourceHandle parent, OCResourceHandle child);
 
-int icd_ioty_notify(OCResourceHandle handle, GVariant *msg, GVariant *observers, gint qos);
+int icd_ioty_notify(GDBusMethodInvocation *invocation, OCResourceHandle handle,
+		GVariant *msg, GVariant *observers, gint qos);
 
-int icd_ioty_send_response(GVariant *resp);
+int icd_ioty_send_response(GDBusMethodInvocation *invocation, GVariant *resp);
 
-int icd_ioty_find_resource(const char *host_address,
+int icd_ioty_find_resource(GDBusMethodInvocation *invocation,
+		const char *host_address,
 		int conn_type,
 		const char *resource_type,
 		bool is_secure,
@@ -130,8 +170,9 @@ OCDoHandle icd_ioty_observer_start(GVariant *resource, int observe_type,
 
 int icd_ioty_observer_stop(OCDoHandle handle, GVariant *options);
 
-int icd_ioty_get_info(int type, const char *host_address, int conn_type, int timeout,
-		int64_t signal_number, const char *bus_name);
+int icd_ioty_get_info(GDBusMethodInvocation *invocation, int type,
+		const char *host_address, int conn_type, int timeout, int64_t signal_number,
+		const char *bus_name);
 
 int icd_ioty_set_device_info();
 int icd_ioty_set_platform_info();
@@ -154,13 +195,61 @@ void icd_ioty_encap_set_time_interval(int time_interval);
 icd_encap_info_s* _icd_ioty_encap_table_get_info(const char *uri_path,
 		const char *host_address);
 
-gboolean icd_ioty_encap_get(gpointer user_data);
+icd_encap_info_s* icd_ioty_encap_table_ref_info(const char *uri_path,
+		const char *host_address);
+
+void icd_ioty_encap_info_unref(icd_encap_info_s *encap_info);
+
+void icd_ioty_encap_poll_now(icd_encap_info_s *encap_info);
+
+void icd_ioty_encap_poll_later(icd_encap_info_s *encap_info);
+
+void icd_ioty_encap_update_interval(icd_encap_info_s *encap_info, bool changed);
+
+int icd_ioty_encap_set_poll_interval(const char *uri_path, const char *host_address,
+		unsigned int min_interval, unsigned int max_interval);
+
+int icd_ioty_encap_set_hysteresis(const char *uri_path, const char *host_address,
+		unsigned int lost_count, unsigned int alive_count,
+		unsigned int dwell_time);
+
+bool icd_ioty_encap_update_state(icd_encap_info_s *encap_info,
+		iotcon_remote_resource_state_e state);
 
 int icd_ioty_start_encap(int type, const char *uri_path, const char *host_address,
 		int conn_type, int64_t *signal_number);
 
 int icd_ioty_stop_encap(int type, const char  *uri_path, const char *host_address);
 
+void icd_ioty_encap_add_client(int type, const char *uri_path, const char *host_address,
+		const char *bus_name, bool delta);
+
+void icd_ioty_encap_remove_client(int type, const char *uri_path,
+		const char *host_address, const char *bus_name, int count, int delta_count);
+
+GList* icd_ioty_encap_get_clients(icd_encap_info_s *encap_info, int type);
+
+void icd_ioty_encap_host_set_batches(const char *host_address, GList *collections);
+
+void icd_ioty_encap_host_set_members(const char *host_address, const char *collection,
+		GList *members);
+
+void icd_ioty_encap_host_remove_batch(const char *host_address, const char *collection);
+
+bool icd_ioty_encap_client_take_delta(icd_encap_info_s *encap_info,
+		const char *bus_name);
+
+void icd_ioty_encap_client_synced(icd_encap_info_s *encap_info, const char *bus_name);
+void icd_ioty_encap_client_unsynced(icd_encap_info_s *encap_info, const char *bus_name);
+
+int icd_ioty_encap_set_history_size(const char *uri_path, const char *host_address,
+		unsigned int size);
+
+void icd_ioty_encap_history_add(icd_encap_info_s *encap_info, OCRepPayload *payload);
+
+int icd_ioty_encap_get_history(const char *uri_path, const char *host_address,
+		unsigned int count, int64_t since, int64_t until, GVariant **history);
+
 static inline int icd_ioty_convert_error(int ret)
 {
 	switch (ret) {
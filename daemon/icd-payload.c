@@ -15,6 +15,7 @@
  */
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <glib.h>
 
 #include <ocstack.h>
@@ -24,23 +25,14 @@
 
 #include "iotcon.h"
 #include "ic-utils.h"
+#include "ic-blob.h"
+#include "ic-wire.h"
 #include "icd.h"
+#include "icd-blob.h"
 #include "icd-ioty.h"
 #include "icd-ioty-type.h"
 #include "icd-payload.h"
 
-union icd_state_value_u {
-	int i;
-	double d;
-	bool b;
-};
-
-struct icd_state_list_s {
-	OCRepPayloadPropType type;
-	size_t dimensions[MAX_REP_ARRAY_DEPTH];
-	GList *list;
-};
-
 static GVariant* _icd_payload_representation_to_gvariant(OCRepPayload *repr, gboolean is_parent);
 static int _icd_state_value_from_gvariant(OCRepPayload *repr, GVariantIter *iter);
 static GVariantBuilder* _icd_state_value_to_gvariant_builder(OCRepPayload *repr);
@@ -117,7 +109,7 @@ GVariant** icd_payload_res_to_gvariant(OCPayload *payload, OCDevAddr *dev_addr)
 		 * Check "resource->secure" and "resource->bitmap" */
 		value[i] = g_variant_new("(ssasasibsi)", resource->uri, device_id, &ifaces, &types,
 				properties, resource->secure, dev_addr->addr, port);
-		DBG("found resource[%d] : %s", i, g_variant_print(value[i], FALSE));
+		DBG_GVARIANT("found resource", value[i]);
 	}
 
 	return value;
@@ -217,50 +209,62 @@ static GVariant* _icd_state_value_to_gvariant(OCRepPayload *state)
 	return var;
 }
 
-static GVariantBuilder* _icd_state_value_to_gvariant_builder(OCRepPayload *repr)
+static GVariant* _icd_state_attr_to_gvariant(OCRepPayloadValue *val)
 {
 	int total_len;
 	GVariant *var = NULL;
+
+	switch (val->type) {
+	case OCREP_PROP_INT:
+		var = g_variant_new_int32(val->i);
+		break;
+	case OCREP_PROP_BOOL:
+		var = g_variant_new_boolean(val->b);
+		break;
+	case OCREP_PROP_DOUBLE:
+		var = g_variant_new_double(val->d);
+		break;
+	case OCREP_PROP_STRING:
+		var = g_variant_new_string(val->str);
+		break;
+	case OCREP_PROP_BYTE_STRING:
+		/* a large byte string goes by fd instead of D-Bus marshalling */
+		if (IC_BLOB_THRESHOLD <= val->ocByteStr.len)
+			var = icd_blob_new(val->ocByteStr.bytes, val->ocByteStr.len);
+		if (NULL == var)
+			var = g_variant_new_fixed_array(G_VARIANT_TYPE("y"), val->ocByteStr.bytes,
+					val->ocByteStr.len, sizeof(uint8_t));
+		break;
+	case OCREP_PROP_NULL:
+		var = g_variant_new_string(IC_STR_NULL);
+		break;
+	case OCREP_PROP_ARRAY:
+		total_len = calcDimTotal(val->arr.dimensions);
+		var = _icd_state_array_to_gvariant(&(val->arr), 0, total_len, 0);
+		break;
+	case OCREP_PROP_OBJECT:
+		var = _icd_state_value_to_gvariant(val->obj);
+		break;
+	default:
+		ERR("Invalid Type(%d)", val->type);
+	}
+
+	return var;
+}
+
+
+static GVariantBuilder* _icd_state_value_to_gvariant_builder(OCRepPayload *repr)
+{
+	GVariant *var;
 	GVariantBuilder *builder;
 	OCRepPayloadValue *val = repr->values;
 
 	builder = g_variant_builder_new(G_VARIANT_TYPE("a{sv}"));
 
 	while (val) {
-		switch (val->type) {
-		case OCREP_PROP_INT:
-			var = g_variant_new_int32(val->i);
-			break;
-		case OCREP_PROP_BOOL:
-			var = g_variant_new_boolean(val->b);
-			break;
-		case OCREP_PROP_DOUBLE:
-			var = g_variant_new_double(val->d);
-			break;
-		case OCREP_PROP_STRING:
-			var = g_variant_new_string(val->str);
-			break;
-		case OCREP_PROP_BYTE_STRING:
-			var = g_variant_new_fixed_array(G_VARIANT_TYPE("y"), val->ocByteStr.bytes,
-					val->ocByteStr.len, sizeof(uint8_t));
-			break;
-		case OCREP_PROP_NULL:
-			var = g_variant_new_string(IC_STR_NULL);
-			break;
-		case OCREP_PROP_ARRAY:
-			total_len = calcDimTotal(val->arr.dimensions);
-			var = _icd_state_array_to_gvariant(&(val->arr), 0, total_len, 0);
-			break;
-		case OCREP_PROP_OBJECT:
-			var = _icd_state_value_to_gvariant(val->obj);
-			break;
-		default:
-			ERR("Invalid Type(%d)", val->type);
-		}
-		if (var) {
+		var = _icd_state_attr_to_gvariant(val);
+		if (var)
 			g_variant_builder_add(builder, "{sv}", val->name, var);
-			var = NULL;
-		}
 		val = val->next;
 	}
 
@@ -334,6 +338,225 @@ GVariant* icd_payload_representation_empty_gvariant(void)
 }
 
 
+static void _icd_wire_write_state(ic_wire_writer_s *writer, guint32 state,
+		OCRepPayload *repr);
+
+static int _icd_wire_write_array(ic_wire_writer_s *writer, guint32 list,
+		OCRepPayloadValueArray *arr, int depth, int len, int index)
+{
+	int i, ret, count;
+	guint8 tag;
+	guint32 first = 0, value;
+
+	if ((MAX_REP_ARRAY_DEPTH - 1) == depth || 0 == arr->dimensions[depth]
+			|| 0 == arr->dimensions[depth + 1]) {
+		switch (arr->type) {
+		case OCREP_PROP_INT:
+			tag = IC_WIRE_INT;
+			for (i = 0; i < len; i++) {
+				value = ic_wire_writer_add_int(writer, arr->iArray[index + i]);
+				if (0 == i)
+					first = value;
+			}
+			break;
+		case OCREP_PROP_BOOL:
+			tag = IC_WIRE_BOOL;
+			for (i = 0; i < len; i++) {
+				value = ic_wire_writer_add_bool(writer, arr->bArray[index + i]);
+				if (0 == i)
+					first = value;
+			}
+			break;
+		case OCREP_PROP_DOUBLE:
+			tag = IC_WIRE_DOUBLE;
+			for (i = 0; i < len; i++) {
+				value = ic_wire_writer_add_double(writer, arr->dArray[index + i]);
+				if (0 == i)
+					first = value;
+			}
+			break;
+		case OCREP_PROP_STRING:
+			tag = IC_WIRE_STR;
+			for (i = 0; i < len; i++) {
+				value = ic_wire_writer_add_str(writer, arr->strArray[index + i]);
+				if (0 == i)
+					first = value;
+			}
+			break;
+		case OCREP_PROP_BYTE_STRING:
+			tag = IC_WIRE_BYTE_STR;
+			for (i = 0; i < len; i++) {
+				value = ic_wire_writer_add_byte_str(writer,
+						arr->ocByteStrArray[index + i].bytes,
+						arr->ocByteStrArray[index + i].len);
+				if (0 == i)
+					first = value;
+			}
+			break;
+		case OCREP_PROP_NULL:
+			tag = IC_WIRE_STR;
+			for (i = 0; i < len; i++) {
+				value = ic_wire_writer_add_str(writer, IC_STR_NULL);
+				if (0 == i)
+					first = value;
+			}
+			break;
+		case OCREP_PROP_OBJECT:
+			tag = IC_WIRE_STATE;
+			first = ic_wire_writer_reserve_states(writer, len);
+			for (i = 0; i < len; i++)
+				_icd_wire_write_state(writer, first + i, arr->objArray[index + i]);
+			break;
+		case OCREP_PROP_ARRAY:
+		default:
+			ERR("Invalid Type(%d)", arr->type);
+			return IOTCON_ERROR_INVALID_TYPE;
+		}
+		ic_wire_writer_set_list(writer, list, tag, first, len);
+		return IOTCON_ERROR_NONE;
+	}
+
+	/* the sub-lists are contiguous */
+	count = arr->dimensions[depth];
+	first = ic_wire_writer_reserve_lists(writer, count);
+	for (i = 0; i < count; i++) {
+		ret = _icd_wire_write_array(writer, first + i, arr, depth + 1, len / count,
+				index + i * (len / count));
+		if (IOTCON_ERROR_NONE != ret)
+			return ret;
+	}
+	ic_wire_writer_set_list(writer, list, IC_WIRE_LIST, first, count);
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+static int _icd_wire_write_value(ic_wire_writer_s *writer, OCRepPayloadValue *val,
+		guint8 *tag, guint32 *index)
+{
+	GVariant *blob = NULL;
+	guint64 blob_id, blob_length;
+
+	*index = 0;
+
+	switch (val->type) {
+	case OCREP_PROP_INT:
+		*tag = IC_WIRE_INT;
+		*index = ic_wire_writer_add_int(writer, val->i);
+		break;
+	case OCREP_PROP_BOOL:
+		*tag = IC_WIRE_BOOL;
+		*index = ic_wire_writer_add_bool(writer, val->b);
+		break;
+	case OCREP_PROP_DOUBLE:
+		*tag = IC_WIRE_DOUBLE;
+		*index = ic_wire_writer_add_double(writer, val->d);
+		break;
+	case OCREP_PROP_STRING:
+		*tag = IC_WIRE_STR;
+		*index = ic_wire_writer_add_str(writer, val->str);
+		break;
+	case OCREP_PROP_BYTE_STRING:
+		/* a large byte string goes by fd instead of D-Bus marshalling */
+		if (IC_BLOB_THRESHOLD <= val->ocByteStr.len)
+			blob = icd_blob_new(val->ocByteStr.bytes, val->ocByteStr.len);
+		if (blob) {
+			g_variant_get(blob, IC_BLOB_TYPE, &blob_id, &blob_length);
+			g_variant_unref(g_variant_ref_sink(blob));
+			*tag = IC_WIRE_BLOB;
+			*index = ic_wire_writer_add_blob(writer, blob_id, blob_length);
+			break;
+		}
+		*tag = IC_WIRE_BYTE_STR;
+		*index = ic_wire_writer_add_byte_str(writer, val->ocByteStr.bytes,
+				val->ocByteStr.len);
+		break;
+	case OCREP_PROP_NULL:
+		*tag = IC_WIRE_NULL;
+		break;
+	case OCREP_PROP_ARRAY:
+		*tag = IC_WIRE_LIST;
+		*index = ic_wire_writer_reserve_lists(writer, 1);
+		return _icd_wire_write_array(writer, *index, &(val->arr), 0,
+				calcDimTotal(val->arr.dimensions), 0);
+	case OCREP_PROP_OBJECT:
+		*tag = IC_WIRE_STATE;
+		*index = ic_wire_writer_reserve_states(writer, 1);
+		_icd_wire_write_state(writer, *index, val->obj);
+		break;
+	default:
+		ERR("Invalid Type(%d)", val->type);
+		return IOTCON_ERROR_INVALID_TYPE;
+	}
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+static void _icd_wire_write_state(ic_wire_writer_s *writer, guint32 state,
+		OCRepPayload *repr)
+{
+	int ret;
+	guint8 tag;
+	OCRepPayloadValue *val;
+	guint32 first, count = 0, index;
+
+	for (val = repr->values; val; val = val->next)
+		count++;
+
+	first = ic_wire_writer_reserve_attrs(writer, count);
+
+	/* an invalid attribute is skipped, and leaves an unused slot */
+	count = 0;
+	for (val = repr->values; val; val = val->next) {
+		ret = _icd_wire_write_value(writer, val, &tag, &index);
+		if (IOTCON_ERROR_NONE != ret) {
+			ERR("_icd_wire_write_value() Fail(%d)", ret);
+			continue;
+		}
+		ic_wire_writer_set_attr(writer, first + count, val->name, tag, index);
+		count++;
+	}
+
+	ic_wire_writer_set_state(writer, state, first, count);
+}
+
+
+static GVariant* _icd_payload_string_list_to_gvariant(OCStringLL *node)
+{
+	GVariantBuilder builder;
+
+	g_variant_builder_init(&builder, G_VARIANT_TYPE("as"));
+	for (; node; node = node->next)
+		g_variant_builder_add(&builder, "s", node->value);
+
+	return g_variant_builder_end(&builder);
+}
+
+
+/* IC_WIRE_VERSION_2 : the children are chained by next of the parent */
+static GVariant* _icd_payload_representation_to_wire(OCRepPayload *repr)
+{
+	guint32 state;
+	OCRepPayload *node;
+	ic_wire_writer_s writer;
+	guint32 parent = IC_WIRE_NO_PARENT;
+
+	ic_wire_writer_init(&writer);
+
+	for (node = repr; node; node = node->next) {
+		state = ic_wire_writer_reserve_states(&writer, 1);
+		_icd_wire_write_state(&writer, state, node);
+		ic_wire_writer_add_node(&writer, ic_utils_dbus_encode_str(node->uri),
+				_icd_payload_string_list_to_gvariant(node->interfaces),
+				_icd_payload_string_list_to_gvariant(node->types), parent, state);
+		parent = 0;
+	}
+
+	return ic_wire_writer_end(&writer);
+}
+
+
 static GVariant* _icd_payload_platform_to_gvariant(OCPlatformPayload *repr)
 {
 	GVariant *value;
@@ -401,112 +624,450 @@ GVariant* icd_payload_to_gvariant(OCPayload *repr)
 }
 
 
-static int _icd_state_list_from_gvariant(GVariant *var,
-		struct icd_state_list_s *value_list, int depth)
+/* the elements of the lists in the representation, including the nested ones */
+static size_t _icd_payload_count_elements(OCRepPayload *repr)
+{
+	size_t i, total, count = 0;
+	OCRepPayloadValue *val;
+
+	for (val = repr->values; val; val = val->next) {
+		if (OCREP_PROP_OBJECT == val->type && val->obj) {
+			count += _icd_payload_count_elements(val->obj);
+		} else if (OCREP_PROP_ARRAY == val->type) {
+			total = calcDimTotal(val->arr.dimensions);
+			count += total;
+			if (OCREP_PROP_OBJECT != val->arr.type)
+				continue;
+			for (i = 0; i < total; i++) {
+				if (val->arr.objArray[i])
+					count += _icd_payload_count_elements(val->arr.objArray[i]);
+			}
+		}
+	}
+
+	return count;
+}
+
+
+/* A representation goes in the wire version of the client, if it is worth.
+ * Otherwise, it is the same as icd_payload_to_gvariant(). */
+GVariant* icd_payload_to_gvariant_version(OCPayload *payload, int wire_version)
+{
+	size_t count = 0;
+	OCRepPayload *node;
+
+	if (NULL == payload || PAYLOAD_TYPE_REPRESENTATION != payload->type
+			|| wire_version < IC_WIRE_VERSION_2)
+		return icd_payload_to_gvariant(payload);
+
+	for (node = (OCRepPayload*)payload; node; node = node->next)
+		count += _icd_payload_count_elements(node);
+	if (count < IC_WIRE_FLAT_MIN_ELEMENTS)
+		return icd_payload_to_gvariant(payload);
+
+	return _icd_payload_representation_to_wire((OCRepPayload*)payload);
+}
+
+
+/* an array of OCRepPayload, which is filled from the nested lists in one pass */
+struct icd_state_array_s {
+	guint8 tag;
+	size_t dimensions[MAX_REP_ARRAY_DEPTH];
+	size_t len;
+	size_t pos;
+	union {
+		void *p;
+		int64_t *i;
+		bool *b;
+		double *d;
+		const char **s;
+		OCByteString *y;
+		OCRepPayload **o;
+	} arr;
+};
+
+/* one allocation for all the elements */
+static int _icd_state_array_alloc(struct icd_state_array_s *arr)
+{
+	size_t size;
+
+	switch (arr->tag) {
+	case IC_WIRE_INT:
+		size = sizeof(int64_t);
+		break;
+	case IC_WIRE_BOOL:
+		size = sizeof(bool);
+		break;
+	case IC_WIRE_DOUBLE:
+		size = sizeof(double);
+		break;
+	case IC_WIRE_STR:
+		size = sizeof(char*);
+		break;
+	case IC_WIRE_BYTE_STR:
+		size = sizeof(OCByteString);
+		break;
+	case IC_WIRE_STATE:
+		size = sizeof(OCRepPayload*);
+		break;
+	default:
+		ERR("Invalid tag(%d)", arr->tag);
+		return IOTCON_ERROR_INVALID_TYPE;
+	}
+
+	arr->len = calcDimTotal(arr->dimensions);
+	arr->arr.p = calloc(arr->len ? arr->len : 1, size);
+	if (NULL == arr->arr.p) {
+		ERR("calloc() Fail(%d)", errno);
+		return IOTCON_ERROR_OUT_OF_MEMORY;
+	}
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+static void _icd_state_array_free(struct icd_state_array_s *arr)
+{
+	size_t i;
+
+	if (IC_WIRE_STATE == arr->tag) {
+		for (i = 0; i < arr->len; i++)
+			OCRepPayloadDestroy(arr->arr.o[i]);
+	}
+	free(arr->arr.p);
+}
+
+
+/* The elements are given to repr. */
+static void _icd_state_array_set(OCRepPayload *repr, const char *key,
+		struct icd_state_array_s *arr)
+{
+	switch (arr->tag) {
+	case IC_WIRE_INT:
+		OCRepPayloadSetIntArrayAsOwner(repr, key, arr->arr.i, arr->dimensions);
+		break;
+	case IC_WIRE_BOOL:
+		OCRepPayloadSetBoolArrayAsOwner(repr, key, arr->arr.b, arr->dimensions);
+		break;
+	case IC_WIRE_DOUBLE:
+		OCRepPayloadSetDoubleArrayAsOwner(repr, key, arr->arr.d, arr->dimensions);
+		break;
+	case IC_WIRE_STR:
+		/* the strings are copied */
+		OCRepPayloadSetStringArray(repr, key, arr->arr.s, arr->dimensions);
+		free(arr->arr.s);
+		break;
+	case IC_WIRE_BYTE_STR:
+		OCRepPayloadSetByteStringArray(repr, key, arr->arr.y, arr->dimensions);
+		free(arr->arr.y);
+		break;
+	case IC_WIRE_STATE:
+		OCRepPayloadSetPropObjectArrayAsOwner(repr, key, arr->arr.o, arr->dimensions);
+		break;
+	}
+}
+
+
+static guint8 _icd_state_list_tag(GVariant *var)
+{
+	if (g_variant_is_of_type(var, G_VARIANT_TYPE("ab")))
+		return IC_WIRE_BOOL;
+	else if (g_variant_is_of_type(var, G_VARIANT_TYPE("ai")))
+		return IC_WIRE_INT;
+	else if (g_variant_is_of_type(var, G_VARIANT_TYPE("ad")))
+		return IC_WIRE_DOUBLE;
+	else if (g_variant_is_of_type(var, G_VARIANT_TYPE("as")))
+		return IC_WIRE_STR;
+	else if (g_variant_is_of_type(var, G_VARIANT_TYPE("av")))
+		return IC_WIRE_LIST;
+
+	return IC_WIRE_NULL;
+}
+
+
+/* The dimensions are taken from the first element of each level. */
+static int _icd_state_list_shape(GVariant *var, int depth, struct icd_state_array_s *arr)
+{
+	int ret;
+	GVariant *value;
+
+	if (MAX_REP_ARRAY_DEPTH <= depth) {
+		ERR("Invalid depth(%d)", depth);
+		return IOTCON_ERROR_INVALID_PARAMETER;
+	}
+
+	arr->tag = _icd_state_list_tag(var);
+	if (IC_WIRE_NULL == arr->tag) {
+		ERR("Invalid type(%s)", g_variant_get_type_string(var));
+		return IOTCON_ERROR_INVALID_TYPE;
+	}
+
+	arr->dimensions[depth] = g_variant_n_children(var);
+	if (IC_WIRE_LIST != arr->tag)
+		return IOTCON_ERROR_NONE;
+
+	/* the type of an empty list of variants is unknown */
+	if (0 == arr->dimensions[depth]) {
+		ERR("Empty list of variants");
+		return IOTCON_ERROR_INVALID_TYPE;
+	}
+
+	g_variant_get_child(var, 0, "v", &value);
+	if (g_variant_is_of_type(value, G_VARIANT_TYPE("a{sv}"))) {
+		arr->tag = IC_WIRE_STATE;
+		ret = IOTCON_ERROR_NONE;
+	} else if (g_variant_is_of_type(value, G_VARIANT_TYPE("ay"))) {
+		arr->tag = IC_WIRE_BYTE_STR;
+		ret = IOTCON_ERROR_NONE;
+	} else {
+		ret = _icd_state_list_shape(value, depth + 1, arr);
+	}
+	g_variant_unref(value);
+
+	return ret;
+}
+
+
+/* The byte strings and the strings point into var, until the stack copies them. */
+static int _icd_state_list_fill_value(GVariant *value, struct icd_state_array_s *arr,
+		size_t pos)
 {
 	int ret;
+	GVariantIter state_iter;
+
+	if (IC_WIRE_BYTE_STR == arr->tag) {
+		if (false == g_variant_is_of_type(value, G_VARIANT_TYPE("ay"))) {
+			ERR("Invalid type(%s)", g_variant_get_type_string(value));
+			return IOTCON_ERROR_INVALID_TYPE;
+		}
+		arr->arr.y[pos].bytes = (uint8_t*)g_variant_get_data(value);
+		arr->arr.y[pos].len = g_variant_get_size(value);
+		return IOTCON_ERROR_NONE;
+	}
+
+	if (false == g_variant_is_of_type(value, G_VARIANT_TYPE("a{sv}"))) {
+		ERR("Invalid type(%s)", g_variant_get_type_string(value));
+		return IOTCON_ERROR_INVALID_TYPE;
+	}
+
+	arr->arr.o[pos] = OCRepPayloadCreate();
+	g_variant_iter_init(&state_iter, value);
+	ret = _icd_state_value_from_gvariant(arr->arr.o[pos], &state_iter);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("_icd_state_value_from_gvariant() Fail(%d)", ret);
+		return ret;
+	}
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+static int _icd_state_list_fill_elements(GVariant *var, struct icd_state_array_s *arr)
+{
+	int ret;
+	gsize i, count;
+	GVariant *value;
 	GVariantIter iter;
-	const GVariantType *type;
-	union icd_state_value_u *value;
+	const guchar *bools;
+	const gint32 *ints;
+	const gdouble *doubles;
+	size_t pos = arr->pos;
+
+	switch (arr->tag) {
+	case IC_WIRE_BOOL:
+		/* a boolean is a byte in the serialized GVariant */
+		bools = g_variant_get_fixed_array(var, &count, sizeof(guchar));
+		for (i = 0; i < count; i++)
+			arr->arr.b[pos + i] = !!bools[i];
+		break;
+	case IC_WIRE_INT:
+		ints = g_variant_get_fixed_array(var, &count, sizeof(gint32));
+		for (i = 0; i < count; i++)
+			arr->arr.i[pos + i] = ints[i];
+		break;
+	case IC_WIRE_DOUBLE:
+		doubles = g_variant_get_fixed_array(var, &count, sizeof(gdouble));
+		if (count)
+			memcpy(arr->arr.d + pos, doubles, count * sizeof(double));
+		break;
+	case IC_WIRE_STR:
+		g_variant_iter_init(&iter, var);
+		count = 0;
+		while (g_variant_iter_next(&iter, "&s", &arr->arr.s[pos + count]))
+			count++;
+		break;
+	default:
+		g_variant_iter_init(&iter, var);
+		for (count = 0; g_variant_iter_next(&iter, "v", &value); count++) {
+			ret = _icd_state_list_fill_value(value, arr, pos + count);
+			g_variant_unref(value);
+			if (IOTCON_ERROR_NONE != ret) {
+				ERR("_icd_state_list_fill_value() Fail(%d)", ret);
+				return ret;
+			}
+		}
+		break;
+	}
+	arr->pos = pos + count;
+
+	return IOTCON_ERROR_NONE;
+}
 
-	type = g_variant_get_type(var);
+
+/* OCRepPayload arrays are rectangular, and every leaf has the same type. */
+static int _icd_state_list_fill(GVariant *var, int level, struct icd_state_array_s *arr)
+{
+	int ret;
+	gsize count;
+	GVariant *value;
+	GVariantIter iter;
+	guint8 tag, leaf_tag;
+
+	tag = _icd_state_list_tag(var);
+	if (IC_WIRE_NULL == tag || g_variant_n_children(var) != arr->dimensions[level]) {
+		ERR("Invalid list(%s)", g_variant_get_type_string(var));
+		return IOTCON_ERROR_INVALID_PARAMETER;
+	}
+	count = arr->dimensions[level];
+
+	if ((MAX_REP_ARRAY_DEPTH - 1) == level || 0 == arr->dimensions[level + 1]) {
+		/* the byte strings and the states are boxed in variants */
+		if (IC_WIRE_BYTE_STR == arr->tag || IC_WIRE_STATE == arr->tag)
+			leaf_tag = IC_WIRE_LIST;
+		else
+			leaf_tag = arr->tag;
+
+		if (leaf_tag != tag || arr->len - arr->pos < count) {
+			ERR("Invalid list(%s)", g_variant_get_type_string(var));
+			return IOTCON_ERROR_INVALID_PARAMETER;
+		}
+		return _icd_state_list_fill_elements(var, arr);
+	}
+
+	if (IC_WIRE_LIST != tag) {
+		ERR("Invalid list(%s)", g_variant_get_type_string(var));
+		return IOTCON_ERROR_INVALID_PARAMETER;
+	}
 
 	g_variant_iter_init(&iter, var);
+	while (g_variant_iter_next(&iter, "v", &value)) {
+		ret = _icd_state_list_fill(value, level + 1, arr);
+		g_variant_unref(value);
+		if (IOTCON_ERROR_NONE != ret)
+			return ret;
+	}
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+static int _icd_state_array_from_gvariant(OCRepPayload *repr, const char *key,
+		GVariant *var)
+{
+	int ret;
+	struct icd_state_array_s arr = {0};
+
+	ret = _icd_state_list_shape(var, 0, &arr);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("_icd_state_list_shape() Fail(%d)", ret);
+		return ret;
+	}
+
+	ret = _icd_state_array_alloc(&arr);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("_icd_state_array_alloc() Fail(%d)", ret);
+		return ret;
+	}
+
+	ret = _icd_state_list_fill(var, 0, &arr);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("_icd_state_list_fill() Fail(%d)", ret);
+		_icd_state_array_free(&arr);
+		return ret;
+	}
+
+	_icd_state_array_set(repr, key, &arr);
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+static int _icd_state_value_from_gvariant(OCRepPayload *repr, GVariantIter *iter)
+{
+	int ret;
+	char *key;
+	GVariant *var;
+	const char *str_value;
+	OCRepPayload *repr_value;
+
+	while (g_variant_iter_loop(iter, "{sv}", &key, &var)) {
 
-	value_list->dimensions[depth] = g_variant_iter_n_children(&iter);
-	DBG("[%d]list dim : %d", depth, value_list->dimensions[depth]);
+		if (g_variant_is_of_type(var, G_VARIANT_TYPE_BOOLEAN)) {
+			OCRepPayloadSetPropBool(repr, key, g_variant_get_boolean(var));
 
-	if (g_variant_type_equal(G_VARIANT_TYPE("ab"), type)) {
-		bool b;
-		value_list->type = OCREP_PROP_BOOL;
-		while (g_variant_iter_loop(&iter, "b", &b)) {
-			value = calloc(1, sizeof(union icd_state_value_u));
-			if (NULL == value) {
-				ERR("calloc() Fail(%d)", errno);
+		} else if (g_variant_is_of_type(var, G_VARIANT_TYPE_INT32)) {
+			OCRepPayloadSetPropInt(repr, key, g_variant_get_int32(var));
+
+		} else if (g_variant_is_of_type(var, G_VARIANT_TYPE_DOUBLE)) {
+			OCRepPayloadSetPropDouble(repr, key, g_variant_get_double(var));
+
+		} else if (g_variant_is_of_type(var, G_VARIANT_TYPE_STRING)) {
+			str_value = g_variant_get_string(var, NULL);
+			if (NULL == str_value) {
+				ERR("g_variant_get_string() Fail");
 				return IOTCON_ERROR_OUT_OF_MEMORY;
 			}
-			value->b = b;
-			value_list->list = g_list_append(value_list->list, value);
-		}
-	} else if (g_variant_type_equal(G_VARIANT_TYPE("ai"), type)) {
-		int i;
-		value_list->type = OCREP_PROP_INT;
-		while (g_variant_iter_loop(&iter, "i", &i)) {
-			value = calloc(1, sizeof(union icd_state_value_u));
-			if (NULL == value) {
-				ERR("calloc() Fail(%d)", errno);
-				return IOTCON_ERROR_OUT_OF_MEMORY;
+			if (IC_STR_EQUAL == strcmp(IC_STR_NULL, str_value))
+				OCRepPayloadSetNull(repr, key);
+			else
+				OCRepPayloadSetPropString(repr, key, str_value);
+
+		} else if (g_variant_is_of_type(var, G_VARIANT_TYPE("ay"))) {
+			OCByteString byte_value;
+			byte_value.bytes = (uint8_t*)g_variant_get_data(var);
+			byte_value.len = g_variant_get_size(var);
+			OCRepPayloadSetPropByteString(repr, key, byte_value);
+
+		} else if (g_variant_is_of_type(var, G_VARIANT_TYPE(IC_BLOB_TYPE))) {
+			guint64 id, length;
+			OCByteString byte_value;
+			const unsigned char *data;
+
+			g_variant_get(var, IC_BLOB_TYPE, &id, &length);
+			ret = icd_blob_map(id, length, &data);
+			if (IOTCON_ERROR_NONE != ret) {
+				ERR("icd_blob_map() Fail(%d)", ret);
+				return ret;
 			}
-			value->i = i;
-			value_list->list = g_list_append(value_list->list, value);
-		}
-	} else if (g_variant_type_equal(G_VARIANT_TYPE("ad"), type)) {
-		double d;
-		value_list->type = OCREP_PROP_DOUBLE;
-		while (g_variant_iter_loop(&iter, "d", &d)) {
-			value = calloc(1, sizeof(union icd_state_value_u));
-			if (NULL == value) {
-				ERR("calloc() Fail(%d)", errno);
-				return IOTCON_ERROR_OUT_OF_MEMORY;
+			/* the stack copies the bytes */
+			byte_value.bytes = (uint8_t*)data;
+			byte_value.len = length;
+			OCRepPayloadSetPropByteString(repr, key, byte_value);
+			ic_blob_unmap(data, length);
+
+		} else if (g_variant_is_of_type(var, G_VARIANT_TYPE("a{sv}"))) {
+			GVariantIter state_iter;
+			repr_value = OCRepPayloadCreate();
+			g_variant_iter_init(&state_iter, var);
+
+			ret = _icd_state_value_from_gvariant(repr_value, &state_iter);
+			if (IOTCON_ERROR_NONE != ret) {
+				ERR("_icd_state_value_from_gvariant() Fail(%d)", ret);
+				OCRepPayloadDestroy(repr_value);
+				return ret;
 			}
-			value->d = d;
-			value_list->list = g_list_append(value_list->list, value);
-		}
-	} else if (g_variant_type_equal(G_VARIANT_TYPE("as"), type)) {
-		char *s;
-		value_list->type = OCREP_PROP_STRING;
-		while (g_variant_iter_next(&iter, "s", &s))
-			value_list->list = g_list_append(value_list->list, s);
-	} else if (g_variant_type_equal(G_VARIANT_TYPE("av"), type)) {
-		GVariant *value;
-		if (g_variant_iter_loop(&iter, "v", &value)) {
-			if (g_variant_is_of_type(value, G_VARIANT_TYPE("a{sv}"))) {
-				OCRepPayload *repr;
-				GVariantIter state_iter;
-				value_list->type = OCREP_PROP_OBJECT;
-				do {
-					repr = OCRepPayloadCreate();
-					g_variant_iter_init(&state_iter, value);
-					ret = _icd_state_value_from_gvariant(repr, &state_iter);
-					if (IOTCON_ERROR_NONE != ret) {
-						ERR("_icd_state_value_from_gvariant() Fail(%d)", ret);
-						OCRepPayloadDestroy(repr);
-						return ret;
-					}
-					value_list->list = g_list_append(value_list->list, repr);
-				} while (g_variant_iter_loop(&iter, "v", &value));
-
-			} else if (g_variant_is_of_type(value, G_VARIANT_TYPE("ay"))) {
-				OCByteString *byte_str;
-				value_list->type = OCREP_PROP_BYTE_STRING;
-				do {
-					byte_str = calloc(1, sizeof(OCByteString));
-					if (NULL == byte_str) {
-						ERR("calloc() Fail(%d)", errno);
-						return IOTCON_ERROR_OUT_OF_MEMORY;
-					}
-
-					byte_str->len = g_variant_get_size(value);
-					byte_str->bytes = calloc(byte_str->len, sizeof(uint8_t));
-					if (NULL == byte_str->bytes) {
-						ERR("calloc() Fail(%d)", errno);
-						free(byte_str);
-						return IOTCON_ERROR_OUT_OF_MEMORY;
-					}
-					memcpy(byte_str->bytes, g_variant_get_data(value), byte_str->len);
-
-					value_list->list = g_list_append(value_list->list, byte_str);
-				} while (g_variant_iter_loop(&iter, "v", &value));
-
-			} else if (g_variant_is_of_type(value, G_VARIANT_TYPE_ARRAY)) {
-				do {
-					ret = _icd_state_list_from_gvariant(value, value_list, depth + 1);
-					if (IOTCON_ERROR_NONE != ret) {
-						ERR("_icd_state_list_from_gvariant() Fail(%d)", ret);
-						return ret;
-					}
-				} while (g_variant_iter_loop(&iter, "v", &value));
+			OCRepPayloadSetPropObjectAsOwner(repr, key, repr_value);
+
+		} else if (g_variant_is_of_type(var, G_VARIANT_TYPE_ARRAY)) {
+			ret = _icd_state_array_from_gvariant(repr, key, var);
+			if (IOTCON_ERROR_NONE != ret) {
+				ERR("_icd_state_array_from_gvariant() Fail(%d)", ret);
+				return ret;
 			}
+
+		} else {
+			ERR("Invalid type(%s)", g_variant_get_type_string(var));
+			return IOTCON_ERROR_INVALID_TYPE;
 		}
 	}
 
@@ -514,208 +1075,275 @@ static int _icd_state_list_from_gvariant(GVariant *var,
 }
 
 
-static void _icd_payload_object_destroy(gpointer node)
+static int _icd_wire_read_state(ic_wire_reader_s *reader, OCRepPayload *repr,
+		guint32 state, int depth);
+
+/* The dimensions are taken from the first element of each level. */
+static int _icd_wire_array_shape(ic_wire_reader_s *reader, guint32 list, int depth,
+		struct icd_state_array_s *arr)
 {
-	OCRepPayloadDestroy(node);
+	const ic_wire_list_s *wire_list;
+
+	if (MAX_REP_ARRAY_DEPTH <= depth) {
+		ERR("Invalid depth(%d)", depth);
+		return IOTCON_ERROR_INVALID_PARAMETER;
+	}
+
+	wire_list = ic_wire_reader_get_list(reader, list);
+	if (NULL == wire_list) {
+		ERR("ic_wire_reader_get_list() Fail");
+		return IOTCON_ERROR_INVALID_PARAMETER;
+	}
+
+	arr->dimensions[depth] = wire_list->count;
+	if (IC_WIRE_LIST != wire_list->tag) {
+		arr->tag = wire_list->tag;
+		return IOTCON_ERROR_NONE;
+	}
+
+	/* the type of an empty list of lists is unknown */
+	if (0 == wire_list->count) {
+		ERR("Empty list of lists");
+		return IOTCON_ERROR_INVALID_TYPE;
+	}
+
+	return _icd_wire_array_shape(reader, wire_list->first, depth + 1, arr);
 }
 
 
-static int _icd_state_array_from_list(OCRepPayload *repr,
-		struct icd_state_list_s *value_list, const char *key)
+static int _icd_wire_array_fill_elements(ic_wire_reader_s *reader,
+		const ic_wire_list_s *wire_list, struct icd_state_array_s *arr, int depth)
 {
-	int i, len;
-	GList *node;
-	bool *b_arr;
-	double *d_arr;
-	char **str_arr;
-	int64_t *i_arr;
-	OCByteString *byte_arr;
-	union icd_state_value_u *value;
-	struct OCRepPayload **state_arr;
-
-	len = calcDimTotal(value_list->dimensions);
-
-	switch (value_list->type) {
-	case OCREP_PROP_INT:
-		i_arr = calloc(len, sizeof(int64_t));
-		if (NULL == i_arr) {
-			ERR("calloc() Fail(%d)", errno);
-			return IOTCON_ERROR_OUT_OF_MEMORY;
-		}
-		for (node = value_list->list, i = 0; node; node = node->next, i++) {
-			value = node->data;
-			i_arr[i] = value->i;
-		}
-		g_list_free_full(value_list->list, free);
-		OCRepPayloadSetIntArrayAsOwner(repr, key, i_arr, value_list->dimensions);
-		break;
-	case OCREP_PROP_BOOL:
-		b_arr = calloc(len, sizeof(bool));
-		if (NULL == b_arr) {
-			ERR("calloc() Fail(%d)", errno);
-			return IOTCON_ERROR_OUT_OF_MEMORY;
-		}
-		for (node = value_list->list, i = 0; node; node = node->next, i++) {
-			value = node->data;
-			b_arr[i] = value->b;
-		}
-		g_list_free_full(value_list->list, free);
-		OCRepPayloadSetBoolArrayAsOwner(repr, key, b_arr, value_list->dimensions);
-		break;
-	case OCREP_PROP_DOUBLE:
-		d_arr = calloc(len, sizeof(double));
-		if (NULL == d_arr) {
-			ERR("calloc() Fail(%d)", errno);
-			return IOTCON_ERROR_OUT_OF_MEMORY;
-		}
-		for (node = value_list->list, i = 0; node; node = node->next, i++) {
-			value = node->data;
-			d_arr[i] = value->d;
-		}
-		g_list_free_full(value_list->list, free);
-		OCRepPayloadSetDoubleArrayAsOwner(repr, key, d_arr, value_list->dimensions);
-		break;
-	case OCREP_PROP_STRING:
-		str_arr = calloc(len, sizeof(char *));
-		if (NULL == str_arr) {
-			ERR("calloc() Fail(%d)", errno);
-			return IOTCON_ERROR_OUT_OF_MEMORY;
-		}
-		for (node = value_list->list, i = 0; node; node = node->next, i++)
-			str_arr[i] = strdup(node->data);
-		g_list_free_full(value_list->list, free);
-		OCRepPayloadSetStringArrayAsOwner(repr, key, str_arr, value_list->dimensions);
-		break;
-	case OCREP_PROP_BYTE_STRING:
-		byte_arr = calloc(len, sizeof(OCByteString));
-		if (NULL == byte_arr) {
-			ERR("calloc() Fail(%d)", errno);
-			return IOTCON_ERROR_OUT_OF_MEMORY;
-		}
-		for (node = value_list->list, i = 0; node; node = node->next, i++) {
-			OCByteString *byte_str = node->data;
-			byte_arr[i].bytes = byte_str->bytes;
-			byte_arr[i].len = byte_str->len;
+	int ret;
+	guint32 i, length;
+	size_t pos = arr->pos;
+	const unsigned char *data;
+
+	for (i = 0; i < wire_list->count; i++, pos++) {
+		switch (arr->tag) {
+		case IC_WIRE_INT:
+			arr->arr.i[pos] = reader->ints[wire_list->first + i];
+			break;
+		case IC_WIRE_BOOL:
+			arr->arr.b[pos] = !!reader->bools[wire_list->first + i];
+			break;
+		case IC_WIRE_DOUBLE:
+			arr->arr.d[pos] = reader->doubles[wire_list->first + i];
+			break;
+		case IC_WIRE_STR:
+			arr->arr.s[pos] = reader->strs[wire_list->first + i];
+			break;
+		case IC_WIRE_BYTE_STR:
+			if (false == ic_wire_reader_get_byte_str(reader, wire_list->first + i, &data,
+						&length)) {
+				ERR("ic_wire_reader_get_byte_str() Fail");
+				return IOTCON_ERROR_INVALID_PARAMETER;
+			}
+			/* the stack copies the bytes */
+			arr->arr.y[pos].bytes = (uint8_t*)data;
+			arr->arr.y[pos].len = length;
+			break;
+		case IC_WIRE_STATE:
+			arr->arr.o[pos] = OCRepPayloadCreate();
+			ret = _icd_wire_read_state(reader, arr->arr.o[pos], wire_list->first + i,
+					depth + 1);
+			if (IOTCON_ERROR_NONE != ret) {
+				ERR("_icd_wire_read_state() Fail(%d)", ret);
+				return ret;
+			}
+			break;
+		default:
+			ERR("Invalid tag(%d)", arr->tag);
+			return IOTCON_ERROR_INVALID_TYPE;
 		}
-		g_list_free(value_list->list);
-		OCRepPayloadSetByteStringArray(repr, key, byte_arr, value_list->dimensions);
+	}
+	arr->pos = pos;
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+/* OCRepPayload arrays are rectangular, and every leaf has the same type. */
+static int _icd_wire_array_fill(ic_wire_reader_s *reader, guint32 list, int level,
+		struct icd_state_array_s *arr, int depth)
+{
+	int ret;
+	guint32 i;
+	const ic_wire_list_s *wire_list;
 
-		break;
-	case OCREP_PROP_OBJECT:
-		state_arr = calloc(len, sizeof(struct OCRepPayload *));
-		if (NULL == state_arr) {
-			ERR("calloc() Fail(%d)", errno);
-			return IOTCON_ERROR_OUT_OF_MEMORY;
+	wire_list = ic_wire_reader_get_list(reader, list);
+	if (NULL == wire_list || wire_list->count != arr->dimensions[level]) {
+		ERR("Invalid list(%u)", list);
+		return IOTCON_ERROR_INVALID_PARAMETER;
+	}
+
+	if ((MAX_REP_ARRAY_DEPTH - 1) == level || 0 == arr->dimensions[level + 1]) {
+		if (wire_list->tag != arr->tag || arr->len - arr->pos < wire_list->count) {
+			ERR("Invalid list(%u)", list);
+			return IOTCON_ERROR_INVALID_PARAMETER;
 		}
-		for (node = value_list->list, i = 0; node; node = node->next, i++)
-			state_arr[i] = OCRepPayloadClone(node->data);
-		g_list_free_full(value_list->list, _icd_payload_object_destroy);
-		OCRepPayloadSetPropObjectArrayAsOwner(repr, key, state_arr,
-				value_list->dimensions);
-		break;
-	case OCREP_PROP_ARRAY:
-	case OCREP_PROP_NULL:
-	default:
-		ERR("Invalid Type(%d)", value_list->type);
-		return IOTCON_ERROR_INVALID_TYPE;
+		return _icd_wire_array_fill_elements(reader, wire_list, arr, depth);
+	}
+
+	if (IC_WIRE_LIST != wire_list->tag) {
+		ERR("Invalid tag(%d)", wire_list->tag);
+		return IOTCON_ERROR_INVALID_PARAMETER;
+	}
+
+	for (i = 0; i < wire_list->count; i++) {
+		ret = _icd_wire_array_fill(reader, wire_list->first + i, level + 1, arr, depth);
+		if (IOTCON_ERROR_NONE != ret)
+			return ret;
 	}
 
 	return IOTCON_ERROR_NONE;
 }
 
 
-static void _icd_payload_state_list_destroy(struct icd_state_list_s *state_list)
+static int _icd_wire_read_array(ic_wire_reader_s *reader, OCRepPayload *repr,
+		const char *key, guint32 list, int depth)
 {
-	switch (state_list->type) {
-	case OCREP_PROP_BOOL:
-	case OCREP_PROP_INT:
-	case OCREP_PROP_DOUBLE:
-	case OCREP_PROP_STRING:
-		g_list_free_full(state_list->list, free);
-		break;
-	case OCREP_PROP_OBJECT:
-		g_list_free_full(state_list->list, _icd_payload_object_destroy);
-		break;
-	case OCREP_PROP_ARRAY:
-	case OCREP_PROP_NULL:
-	default:
-		ERR("Invalid Type(%d)", state_list->type);
-		break;
+	int ret;
+	struct icd_state_array_s arr = {0};
+
+	ret = _icd_wire_array_shape(reader, list, 0, &arr);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("_icd_wire_array_shape() Fail(%d)", ret);
+		return ret;
+	}
+
+	ret = _icd_state_array_alloc(&arr);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("_icd_state_array_alloc() Fail(%d)", ret);
+		return ret;
+	}
+
+	ret = _icd_wire_array_fill(reader, list, 0, &arr, depth);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("_icd_wire_array_fill() Fail(%d)", ret);
+		_icd_state_array_free(&arr);
+		return ret;
 	}
 
-	return;
+	_icd_state_array_set(repr, key, &arr);
+
+	return IOTCON_ERROR_NONE;
 }
 
 
-static int _icd_state_value_from_gvariant(OCRepPayload *repr, GVariantIter *iter)
+static int _icd_wire_read_blob(ic_wire_reader_s *reader, OCRepPayload *repr,
+		const char *key, guint32 index)
 {
 	int ret;
-	char *key;
-	GVariant *var;
-	const char *str_value;
-	OCRepPayload *repr_value;
-	struct icd_state_list_s value_list = {0};
+	OCByteString byte_value;
+	const unsigned char *data;
+	const ic_wire_blob_s *blob;
 
-	while (g_variant_iter_loop(iter, "{sv}", &key, &var)) {
+	if (false == ic_wire_reader_check(reader, IC_WIRE_BLOB, index, 1))
+		return IOTCON_ERROR_INVALID_PARAMETER;
 
-		if (g_variant_is_of_type(var, G_VARIANT_TYPE_BOOLEAN)) {
-			OCRepPayloadSetPropBool(repr, key, g_variant_get_boolean(var));
+	blob = &reader->blobs[index];
+	ret = icd_blob_map(blob->id, blob->length, &data);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("icd_blob_map() Fail(%d)", ret);
+		return ret;
+	}
+	/* the stack copies the bytes */
+	byte_value.bytes = (uint8_t*)data;
+	byte_value.len = blob->length;
+	OCRepPayloadSetPropByteString(repr, key, byte_value);
+	ic_blob_unmap(data, blob->length);
 
-		} else if (g_variant_is_of_type(var, G_VARIANT_TYPE_INT32)) {
-			OCRepPayloadSetPropInt(repr, key, g_variant_get_int32(var));
+	return IOTCON_ERROR_NONE;
+}
 
-		} else if (g_variant_is_of_type(var, G_VARIANT_TYPE_DOUBLE)) {
-			OCRepPayloadSetPropDouble(repr, key, g_variant_get_double(var));
 
-		} else if (g_variant_is_of_type(var, G_VARIANT_TYPE_STRING)) {
-			str_value = g_variant_get_string(var, NULL);
-			if (NULL == str_value) {
-				ERR("g_variant_get_string() Fail");
-				_icd_payload_state_list_destroy(&value_list);
-				return IOTCON_ERROR_OUT_OF_MEMORY;
-			}
-			if (IC_STR_EQUAL == strcmp(IC_STR_NULL, str_value))
-				OCRepPayloadSetNull(repr, key);
-			else
-				OCRepPayloadSetPropString(repr, key, str_value);
+static int _icd_wire_read_state(ic_wire_reader_s *reader, OCRepPayload *repr,
+		guint32 state, int depth)
+{
+	int ret;
+	guint32 i, v, length;
+	const char *key;
+	OCRepPayload *repr_value;
+	OCByteString byte_value;
+	const unsigned char *data;
+	const ic_wire_attr_s *attr;
+	const ic_wire_range_s *range;
+
+	if (IC_WIRE_MAX_DEPTH < depth) {
+		ERR("Invalid depth(%d)", depth);
+		return IOTCON_ERROR_INVALID_PARAMETER;
+	}
 
-		} else if (g_variant_is_of_type(var, G_VARIANT_TYPE("ay"))) {
-			OCByteString byte_value;
-			byte_value.bytes = (uint8_t*)g_variant_get_data(var);
-			byte_value.len = g_variant_get_size(var);
-			OCRepPayloadSetPropByteString(repr, key, byte_value);
+	range = ic_wire_reader_get_state(reader, state);
+	if (NULL == range) {
+		ERR("ic_wire_reader_get_state() Fail");
+		return IOTCON_ERROR_INVALID_PARAMETER;
+	}
 
-		} else if (g_variant_is_of_type(var, G_VARIANT_TYPE("a{sv}"))) {
-			GVariantIter state_iter;
-			repr_value = OCRepPayloadCreate();
-			g_variant_iter_init(&state_iter, var);
+	for (i = 0; i < range->count; i++) {
+		attr = &reader->attrs[range->first + i];
+		v = attr->value;
 
-			ret = _icd_state_value_from_gvariant(repr_value, &state_iter);
+		key = ic_wire_reader_get_key(reader, attr->key);
+		if (NULL == key) {
+			ERR("ic_wire_reader_get_key() Fail");
+			return IOTCON_ERROR_INVALID_PARAMETER;
+		}
+
+		if (IC_WIRE_NULL != attr->tag && IC_WIRE_LIST != attr->tag
+				&& false == ic_wire_reader_check(reader, attr->tag, v, 1))
+			return IOTCON_ERROR_INVALID_PARAMETER;
+
+		switch (attr->tag) {
+		case IC_WIRE_NULL:
+			OCRepPayloadSetNull(repr, key);
+			break;
+		case IC_WIRE_BOOL:
+			OCRepPayloadSetPropBool(repr, key, reader->bools[v]);
+			break;
+		case IC_WIRE_INT:
+			OCRepPayloadSetPropInt(repr, key, reader->ints[v]);
+			break;
+		case IC_WIRE_DOUBLE:
+			OCRepPayloadSetPropDouble(repr, key, reader->doubles[v]);
+			break;
+		case IC_WIRE_STR:
+			OCRepPayloadSetPropString(repr, key, reader->strs[v]);
+			break;
+		case IC_WIRE_BYTE_STR:
+			if (false == ic_wire_reader_get_byte_str(reader, v, &data, &length))
+				return IOTCON_ERROR_INVALID_PARAMETER;
+			byte_value.bytes = (uint8_t*)data;
+			byte_value.len = length;
+			OCRepPayloadSetPropByteString(repr, key, byte_value);
+			break;
+		case IC_WIRE_BLOB:
+			ret = _icd_wire_read_blob(reader, repr, key, v);
 			if (IOTCON_ERROR_NONE != ret) {
-				ERR("_icd_state_value_from_gvariant() Fail(%d)", ret);
-				_icd_payload_state_list_destroy(&value_list);
-				OCRepPayloadDestroy(repr_value);
+				ERR("_icd_wire_read_blob() Fail(%d)", ret);
 				return ret;
 			}
-			OCRepPayloadSetPropObjectAsOwner(repr, key, repr_value);
-
-		} else if (g_variant_is_of_type(var, G_VARIANT_TYPE_ARRAY)) {
-			memset(&value_list, 0, sizeof(struct icd_state_list_s));
-			ret = _icd_state_list_from_gvariant(var, &value_list, 0);
+			break;
+		case IC_WIRE_STATE:
+			repr_value = OCRepPayloadCreate();
+			ret = _icd_wire_read_state(reader, repr_value, v, depth + 1);
 			if (IOTCON_ERROR_NONE != ret) {
-				ERR("_icd_state_list_from_gvariant() Fail(%d)", ret);
-				_icd_payload_state_list_destroy(&value_list);
+				ERR("_icd_wire_read_state() Fail(%d)", ret);
+				OCRepPayloadDestroy(repr_value);
 				return ret;
 			}
-			ret = _icd_state_array_from_list(repr, &value_list, key);
+			OCRepPayloadSetPropObjectAsOwner(repr, key, repr_value);
+			break;
+		case IC_WIRE_LIST:
+			ret = _icd_wire_read_array(reader, repr, key, v, depth);
 			if (IOTCON_ERROR_NONE != ret) {
-				ERR("_icd_state_array_from_list() Fail(%d)", ret);
-				_icd_payload_state_list_destroy(&value_list);
+				ERR("_icd_wire_read_array() Fail(%d)", ret);
 				return ret;
 			}
-
-		} else {
-			ERR("Invalid type(%s)", g_variant_get_type_string(var));
+			break;
+		default:
+			ERR("Invalid tag(%d)", attr->tag);
 			return IOTCON_ERROR_INVALID_TYPE;
 		}
 	}
@@ -723,6 +1351,64 @@ static int _icd_state_value_from_gvariant(OCRepPayload *repr, GVariantIter *iter
 	return IOTCON_ERROR_NONE;
 }
 
+
+/* Every node is chained by next of the parent, as the stack sends the children. */
+static OCRepPayload* _icd_payload_representation_from_wire(GVariant *var)
+{
+	int i, ret;
+	guint32 node, parent, state;
+	const char *uri_path;
+	const gchar **ifaces, **types;
+	ic_wire_reader_s reader;
+	OCRepPayload *repr = NULL, *cur, *last = NULL;
+
+	ret = ic_wire_reader_init(&reader, var);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("ic_wire_reader_init() Fail(%d)", ret);
+		return NULL;
+	}
+
+	for (node = 0; node < reader.n_nodes; node++) {
+		ret = ic_wire_reader_get_node(&reader, node, &uri_path, &ifaces, &types, &parent,
+				&state);
+		if (IOTCON_ERROR_NONE != ret) {
+			ERR("ic_wire_reader_get_node() Fail(%d)", ret);
+			break;
+		}
+
+		cur = OCRepPayloadCreate();
+		if (last)
+			last->next = cur;
+		else
+			repr = cur;
+		last = cur;
+
+		if (IC_STR_EQUAL != strcmp(IC_STR_NULL, uri_path))
+			OCRepPayloadSetUri(cur, uri_path);
+		for (i = 0; ifaces[i]; i++)
+			OCRepPayloadAddInterface(cur, ifaces[i]);
+		for (i = 0; types[i]; i++)
+			OCRepPayloadAddResourceType(cur, types[i]);
+		g_free(types);
+		g_free(ifaces);
+
+		ret = _icd_wire_read_state(&reader, cur, state, 0);
+		if (IOTCON_ERROR_NONE != ret) {
+			ERR("_icd_wire_read_state() Fail(%d)", ret);
+			break;
+		}
+	}
+	ic_wire_reader_clear(&reader);
+
+	if (IOTCON_ERROR_NONE != ret) {
+		OCRepPayloadDestroy(repr);
+		return NULL;
+	}
+
+	return repr;
+}
+
+
 OCRepPayload* icd_payload_representation_from_gvariant(GVariant *var)
 {
 	int ret;
@@ -731,6 +1417,9 @@ OCRepPayload* icd_payload_representation_from_gvariant(GVariant *var)
 	char *uri_path, *resource_iface, *resource_type;
 	GVariantIter *resource_types, *resource_ifaces, *repr_gvar, *children;
 
+	if (ic_wire_is_flat(var))
+		return _icd_payload_representation_from_wire(var);
+
 	repr = OCRepPayloadCreate();
 
 	g_variant_get(var, "(&sasasa{sv}av)", &uri_path, &resource_ifaces, &resource_types,
@@ -903,8 +1592,10 @@ static int _representation_compare_value(OCRepPayloadValue *value1,
 		ret = (IC_STR_EQUAL == g_strcmp0(value1->str, value2->str)) ? IC_EQUAL : 1;
 		break;
 	case OCREP_PROP_BYTE_STRING:
+		if (value1->ocByteStr.len != value2->ocByteStr.len)
+			break;
 		ret = (IC_EQUAL == memcmp(value1->ocByteStr.bytes, value2->ocByteStr.bytes,
-					value2->ocByteStr.len));
+					value2->ocByteStr.len)) ? IC_EQUAL : 1;
 		break;
 	case OCREP_PROP_OBJECT:
 		ret = icd_payload_representation_compare(value1->obj, value2->obj);
@@ -1059,3 +1750,261 @@ int icd_payload_representation_compare(OCRepPayload *repr1, OCRepPayload *repr2)
 
 	return IC_EQUAL;
 }
+
+
+/* Returns "(a{sv}as)" : the attributes of new_repr which are added or changed since
+ * old_repr, and the keys which are removed.
+ * If anything except the attributes of the parent differs, NULL is returned and the whole
+ * representation should be sent instead. */
+GVariant* icd_payload_representation_delta_gvariant(OCRepPayload *old_repr,
+		OCRepPayload *new_repr)
+{
+	GVariant *var;
+	GHashTable *old_values;
+	OCRepPayloadValue *val, *old_val;
+	GHashTableIter iter;
+	GVariantBuilder changed, removed;
+
+	RETV_IF(NULL == old_repr, NULL);
+	RETV_IF(NULL == new_repr, NULL);
+
+	if (IC_STR_EQUAL != g_strcmp0(old_repr->uri, new_repr->uri))
+		return NULL;
+	if (IC_EQUAL != _representation_compare_string_list(old_repr->types,
+				new_repr->types))
+		return NULL;
+	if (IC_EQUAL != _representation_compare_string_list(old_repr->interfaces,
+				new_repr->interfaces))
+		return NULL;
+	if (IC_EQUAL != _representation_compare_children(old_repr->next, new_repr->next))
+		return NULL;
+
+	old_values = g_hash_table_new(g_str_hash, g_str_equal);
+	for (val = old_repr->values; val; val = val->next)
+		g_hash_table_insert(old_values, val->name, val);
+
+	g_variant_builder_init(&changed, G_VARIANT_TYPE("a{sv}"));
+	for (val = new_repr->values; val; val = val->next) {
+		old_val = g_hash_table_lookup(old_values, val->name);
+		g_hash_table_remove(old_values, val->name);
+
+		if (old_val && IC_EQUAL == _representation_compare_value(old_val, val))
+			continue;
+
+		var = _icd_state_attr_to_gvariant(val);
+		if (var)
+			g_variant_builder_add(&changed, "{sv}", val->name, var);
+	}
+
+	/* the rest of the old attributes are removed */
+	g_variant_builder_init(&removed, G_VARIANT_TYPE("as"));
+	g_hash_table_iter_init(&iter, old_values);
+	while (g_hash_table_iter_next(&iter, NULL, (gpointer*)&old_val))
+		g_variant_builder_add(&removed, "s", old_val->name);
+	g_hash_table_destroy(old_values);
+
+	return g_variant_new("(a{sv}as)", &changed, &removed);
+}
+
+
+/* FNV-1a */
+#define ICD_DIGEST_OFFSET 0xcbf29ce484222325ULL
+#define ICD_DIGEST_PRIME 0x100000001b3ULL
+
+static uint64_t _digest_bytes(uint64_t h, const void *data, size_t len)
+{
+	size_t i;
+	const unsigned char *p = data;
+
+	for (i = 0; i < len; i++) {
+		h ^= p[i];
+		h *= ICD_DIGEST_PRIME;
+	}
+
+	return h;
+}
+
+
+static uint64_t _digest_u64(uint64_t h, uint64_t v)
+{
+	return _digest_bytes(h, &v, sizeof(v));
+}
+
+
+static uint64_t _digest_double(uint64_t h, double d)
+{
+	uint64_t bits;
+
+	/* 0.0 and -0.0 compare equal */
+	if (0 == d)
+		d = 0;
+
+	memcpy(&bits, &d, sizeof(bits));
+
+	return _digest_u64(h, bits);
+}
+
+
+static uint64_t _digest_string(uint64_t h, const char *str)
+{
+	if (NULL == str)
+		return _digest_u64(h, 0);
+
+	/* including the terminator keeps adjacent strings apart */
+	return _digest_bytes(h, str, strlen(str) + 1);
+}
+
+
+/* finalizer of MurmurHash3. Element digests are mixed before they are summed so
+ * that the sum does not cancel out for similar elements. */
+static uint64_t _digest_mix(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+
+	return h;
+}
+
+
+static uint64_t _digest_string_list(uint64_t h, OCStringLL *list)
+{
+	uint64_t sum = 0, count = 0;
+	OCStringLL *c;
+
+	for (c = list; c; c = c->next, count++)
+		sum += _digest_mix(_digest_string(ICD_DIGEST_OFFSET, c->value));
+
+	h = _digest_u64(h, count);
+
+	return _digest_u64(h, sum);
+}
+
+
+static uint64_t _digest_array(uint64_t h, OCRepPayloadValueArray *arr)
+{
+	int i, len;
+
+	len = calcDimTotal(arr->dimensions);
+
+	h = _digest_u64(h, arr->type);
+	for (i = 0; i < MAX_REP_ARRAY_DEPTH; i++)
+		h = _digest_u64(h, arr->dimensions[i]);
+
+	/* array elements are ordered */
+	for (i = 0; i < len; i++) {
+		switch (arr->type) {
+		case OCREP_PROP_INT:
+			h = _digest_u64(h, arr->iArray[i]);
+			break;
+		case OCREP_PROP_BOOL:
+			h = _digest_u64(h, arr->bArray[i]);
+			break;
+		case OCREP_PROP_DOUBLE:
+			h = _digest_double(h, arr->dArray[i]);
+			break;
+		case OCREP_PROP_STRING:
+			h = _digest_string(h, arr->strArray[i]);
+			break;
+		case OCREP_PROP_BYTE_STRING:
+			h = _digest_u64(h, arr->ocByteStrArray[i].len);
+			h = _digest_bytes(h, arr->ocByteStrArray[i].bytes,
+					arr->ocByteStrArray[i].len);
+			break;
+		case OCREP_PROP_OBJECT:
+			h = _digest_u64(h, icd_payload_representation_digest(arr->objArray[i]));
+			break;
+		default:
+			ERR("Invalid Type (%d)", arr->type);
+			return h;
+		}
+	}
+
+	return h;
+}
+
+
+static uint64_t _digest_value(OCRepPayloadValue *value)
+{
+	uint64_t h = ICD_DIGEST_OFFSET;
+
+	h = _digest_string(h, value->name);
+	h = _digest_u64(h, value->type);
+
+	switch (value->type) {
+	case OCREP_PROP_NULL:
+		break;
+	case OCREP_PROP_INT:
+		h = _digest_u64(h, value->i);
+		break;
+	case OCREP_PROP_DOUBLE:
+		h = _digest_double(h, value->d);
+		break;
+	case OCREP_PROP_BOOL:
+		h = _digest_u64(h, value->b);
+		break;
+	case OCREP_PROP_STRING:
+		h = _digest_string(h, value->str);
+		break;
+	case OCREP_PROP_BYTE_STRING:
+		h = _digest_u64(h, value->ocByteStr.len);
+		h = _digest_bytes(h, value->ocByteStr.bytes, value->ocByteStr.len);
+		break;
+	case OCREP_PROP_OBJECT:
+		h = _digest_u64(h, icd_payload_representation_digest(value->obj));
+		break;
+	case OCREP_PROP_ARRAY:
+		h = _digest_array(h, &value->arr);
+		break;
+	default:
+		ERR("Invalid Type (%d)", value->type);
+	}
+
+	return h;
+}
+
+
+static uint64_t _representation_digest_without_children(OCRepPayload *repr)
+{
+	uint64_t h, sum = 0, count = 0;
+	OCRepPayloadValue *c;
+
+	h = _digest_string(ICD_DIGEST_OFFSET, repr->uri);
+	h = _digest_string_list(h, repr->types);
+	h = _digest_string_list(h, repr->interfaces);
+
+	/* attributes are unordered */
+	for (c = repr->values; c; c = c->next, count++)
+		sum += _digest_mix(_digest_value(c));
+
+	h = _digest_u64(h, count);
+	h = _digest_u64(h, sum);
+
+	return _digest_mix(h);
+}
+
+
+/* Two representations which are equal by icd_payload_representation_compare()
+ * always have the same digest, regardless of the order of their attributes,
+ * resource types, interfaces and children. */
+uint64_t icd_payload_representation_digest(OCRepPayload *repr)
+{
+	uint64_t h, sum = 0, count = 0;
+	OCRepPayload *c;
+
+	if (NULL == repr)
+		return 0;
+
+	h = _representation_digest_without_children(repr);
+
+	/* children are unordered */
+	for (c = repr->next; c; c = c->next, count++)
+		sum += _representation_digest_without_children(c);
+
+	h = _digest_u64(h, count);
+	h = _digest_u64(h, sum);
+
+	return _digest_mix(h);
+}
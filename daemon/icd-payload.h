@@ -16,14 +16,19 @@
 #ifndef __IOT_CONNECTIVITY_MANAGER_DAEMON_PAYLOAD_H__
 #define __IOT_CONNECTIVITY_MANAGER_DAEMON_PAYLOAD_H__
 
+#include <stdint.h>
 #include <glib.h>
 
 #include <ocpayload.h>
 
 GVariant* icd_payload_representation_empty_gvariant(void);
 GVariant* icd_payload_to_gvariant(OCPayload *payload);
+GVariant* icd_payload_to_gvariant_version(OCPayload *payload, int wire_version);
 GVariant** icd_payload_res_to_gvariant(OCPayload *payload, OCDevAddr *dev_addr);
 OCRepPayload* icd_payload_representation_from_gvariant(GVariant *var);
 int icd_payload_representation_compare(OCRepPayload *repr1, OCRepPayload *repr2);
+uint64_t icd_payload_representation_digest(OCRepPayload *repr);
+GVariant* icd_payload_representation_delta_gvariant(OCRepPayload *old_repr,
+		OCRepPayload *new_repr);
 
 #endif /*__IOT_CONNECTIVITY_MANAGER_DAEMON_PAYLOAD_H__*/
@@ -21,6 +21,7 @@
 #include "iotcon.h"
 #include "ic-utils.h"
 #include "icl.h"
+#include "icl-dbus.h"
 #include "icl-resource.h"
 #include "icl-resource-types.h"
 #include "icl-resource-interfaces.h"
@@ -93,9 +94,10 @@ GVariant* icl_dbus_representation_to_gvariant(struct icl_representation_s *repr)
 	g_variant_builder_init(&builder, G_VARIANT_TYPE("av"));
 
 	if (repr) {
-		repr_gvar = icl_representation_to_gvariant(repr);
+		repr_gvar = icl_representation_to_gvariant_version(repr,
+				icl_dbus_get_wire_version());
 		if (NULL == repr_gvar) {
-			ERR("icl_representation_to_gvariant() Fail");
+			ERR("icl_representation_to_gvariant_version() Fail");
 			g_variant_builder_clear(&builder);
 			return NULL;
 		}
@@ -124,9 +126,10 @@ GVariant* icl_dbus_response_to_gvariant(struct icl_resource_response *response)
 		}
 	}
 
-	repr_gvar = icl_representation_to_gvariant(response->repr);
+	repr_gvar = icl_representation_to_gvariant_version(response->repr,
+			icl_dbus_get_wire_version());
 	if (NULL == repr_gvar) {
-		ERR("icl_representation_to_gvariant() Fail");
+		ERR("icl_representation_to_gvariant_version() Fail");
 		g_variant_builder_clear(&options);
 		return NULL;
 	}
@@ -16,68 +16,246 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <glib-unix.h>
 #include <gio/gio.h>
+#include <gio/gunixfdlist.h>
 #include <tizen_type.h>
 
 #include "iotcon.h"
 #include "ic-common.h"
 #include "ic-utils.h"
+#include "ic-ring.h"
+#include "ic-wire.h"
 #include "ic-dbus.h"
 #include "icl.h"
 #include "icl-dbus.h"
 
 static unsigned int icl_dbus_count;
 static icDbus *icl_dbus_object;
-static GList *icl_dbus_sub_ids;
 static GList *icl_dbus_conn_changed_cbs;
 
+/* The private connection to the daemon carries the method calls and the signals.
+ * The system bus is used only for the handshake and the name owner tracking. */
+static icDbus *icl_dbus_p2p_object;
+static unsigned int icl_dbus_p2p_signal_sub_id;
+static unsigned long icl_dbus_p2p_closed_id;
+
+/* The rings shared with the daemon carry the signals and the notifications
+ * without D-Bus marshalling. */
+static ic_ring_s *icl_dbus_signal_ring;
+static ic_ring_s *icl_dbus_notify_ring;
+static unsigned int icl_dbus_signal_ring_source;
+/* The daemon sent the signals through D-Bus, since the ring was full. The ring is not
+ * read until the reply of ringResume, which follows those signals. */
+static unsigned int icl_dbus_ring_sub_id;
+static bool icl_dbus_signal_ring_paused;
+
+/* the wire version of the representations to the daemon */
+static int icl_dbus_wire_version = IC_WIRE_VERSION_1;
+
+/* The daemon sends one signal per message kind to our unique name.
+ * The signal number in the body selects the subscriber. */
+static unsigned int icl_dbus_signal_sub_id;
+/* key : id */
+static GHashTable *icl_dbus_sub_table;
+/* key : "<signal kind>_<signal number>", value : GList of icl_dbus_sub_s */
+static GHashTable *icl_dbus_sub_name_table;
+
 typedef struct {
 	void *cb;
 	void *user_data;
 	unsigned int id;
 } icl_cb_container_s;
 
+typedef struct {
+	unsigned int id;
+	char *signal_name;
+	void *cb_container;
+	GDestroyNotify cb_free;
+	GDBusSignalCallback sig_handler;
+	bool removed;
+} icl_dbus_sub_s;
+
 
 icDbus* icl_dbus_get_object()
 {
+	if (icl_dbus_p2p_object)
+		return icl_dbus_p2p_object;
+
 	return icl_dbus_object;
 }
 
 
+static gboolean _icl_dbus_sub_free_idle(gpointer p)
+{
+	icl_dbus_sub_s *sub = p;
+
+	if (sub->cb_free)
+		sub->cb_free(sub->cb_container);
+	free(sub->signal_name);
+	free(sub);
+
+	return G_SOURCE_REMOVE;
+}
+
+
+static void _icl_dbus_sub_remove(icl_dbus_sub_s *sub)
+{
+	GList *subs;
+
+	subs = g_hash_table_lookup(icl_dbus_sub_name_table, sub->signal_name);
+	subs = g_list_remove(subs, sub);
+	if (subs) /* the key is owned by the first subscription */
+		g_hash_table_replace(icl_dbus_sub_name_table,
+				((icl_dbus_sub_s*)subs->data)->signal_name, subs);
+	else
+		g_hash_table_remove(icl_dbus_sub_name_table, sub->signal_name);
+
+	/* Like GDBus, cb_free is called later, not in the middle of a signal handler */
+	sub->removed = true;
+	g_idle_add(_icl_dbus_sub_free_idle, sub);
+}
+
+
+static void _icl_dbus_signal_cb(GDBusConnection *connection,
+		const gchar *sender_name,
+		const gchar *object_path,
+		const gchar *interface_name,
+		const gchar *signal_name,
+		GVariant *parameters,
+		gpointer user_data)
+{
+	GList *cur, *subs;
+	icl_dbus_sub_s *sub;
+	GVariant *value;
+	int64_t signal_number;
+	char sub_name[IC_DBUS_SIGNAL_LENGTH] = {0};
+
+	RET_IF(NULL == icl_dbus_sub_name_table);
+
+	if (FALSE == g_variant_is_of_type(parameters, G_VARIANT_TYPE("(xv)"))) {
+		ERR("Invalid signal(%s)", signal_name);
+		return;
+	}
+
+	g_variant_get(parameters, "(xv)", &signal_number, &value);
+
+	snprintf(sub_name, sizeof(sub_name), "%s_%llx", signal_name, signal_number);
+
+	/* handlers could unsubscribe themselves or the others */
+	subs = g_list_copy(g_hash_table_lookup(icl_dbus_sub_name_table, sub_name));
+	for (cur = subs; cur; cur = cur->next) {
+		sub = cur->data;
+		if (sub->removed)
+			continue;
+		sub->sig_handler(connection, sender_name, object_path, interface_name, sub_name,
+				value, sub->cb_container);
+	}
+	g_list_free(subs);
+
+	g_variant_unref(value);
+}
+
+
+static int _icl_dbus_ring_dispatch()
+{
+	int ret;
+	const char *signal_name;
+	GVariant *record, *parameters;
+
+	/* the handlers could stop the ring */
+	while (icl_dbus_signal_ring) {
+		ret = ic_ring_read(icl_dbus_signal_ring, G_VARIANT_TYPE(IC_RING_SIGNAL_TYPE),
+				&record);
+		if (IOTCON_ERROR_NONE != ret) {
+			ERR("ic_ring_read() Fail(%d)", ret);
+			return ret;
+		}
+		if (NULL == record)
+			break;
+
+		g_variant_get(record, "(&sv)", &signal_name, &parameters);
+		_icl_dbus_signal_cb(NULL, NULL, IOTCON_DBUS_OBJPATH, IOTCON_DBUS_INTERFACE,
+				signal_name, parameters, NULL);
+		g_variant_unref(parameters);
+		g_variant_unref(record);
+	}
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+static gboolean _icl_dbus_ring_signal_cb(gint fd, GIOCondition condition,
+		gpointer user_data)
+{
+	int ret;
+
+	ic_ring_clear_event(icl_dbus_signal_ring);
+
+	/* the reply of ringResume reads the ring again */
+	if (icl_dbus_signal_ring_paused)
+		return G_SOURCE_CONTINUE;
+
+	do {
+		ret = _icl_dbus_ring_dispatch();
+		if (IOTCON_ERROR_NONE != ret) {
+			ERR("_icl_dbus_ring_dispatch() Fail(%d)", ret);
+			icl_dbus_signal_ring_source = 0;
+			return G_SOURCE_REMOVE;
+		}
+		if (NULL == icl_dbus_signal_ring)
+			return G_SOURCE_REMOVE;
+	} while (false == ic_ring_wait(icl_dbus_signal_ring));
+
+	return G_SOURCE_CONTINUE;
+}
+
+
 unsigned int icl_dbus_subscribe_signal(char *signal_name, void *cb_container,
 		void *cb_free, GDBusSignalCallback sig_handler)
 {
-	unsigned int id;
-	GDBusConnection *conn = g_dbus_proxy_get_connection(G_DBUS_PROXY(icl_dbus_object));
+	GList *subs;
+	icl_dbus_sub_s *sub;
+	static unsigned int icl_dbus_sub_id = 0;
 
-	id = g_dbus_connection_signal_subscribe(conn,
-			NULL,
-			IOTCON_DBUS_INTERFACE,
-			signal_name,
-			IOTCON_DBUS_OBJPATH,
-			NULL,
-			G_DBUS_SIGNAL_FLAGS_NONE,
-			sig_handler,
-			cb_container,
-			cb_free);
-	if (0 == id) {
-		ERR("g_dbus_connection_signal_subscribe() Fail");
-		return id;
+	RETV_IF(NULL == icl_dbus_sub_table, 0);
+
+	sub = calloc(1, sizeof(icl_dbus_sub_s));
+	if (NULL == sub) {
+		ERR("calloc() Fail(%d)", errno);
+		return 0;
 	}
 
-	icl_dbus_sub_ids = g_list_append(icl_dbus_sub_ids, GUINT_TO_POINTER(id));
+	if (0 == ++icl_dbus_sub_id)
+		icl_dbus_sub_id++;
+
+	sub->id = icl_dbus_sub_id;
+	sub->signal_name = ic_utils_strdup(signal_name);
+	sub->cb_container = cb_container;
+	sub->cb_free = cb_free;
+	sub->sig_handler = sig_handler;
 
-	return id;
+	subs = g_hash_table_lookup(icl_dbus_sub_name_table, sub->signal_name);
+	subs = g_list_prepend(subs, sub);
+	g_hash_table_replace(icl_dbus_sub_name_table, sub->signal_name, subs);
+	g_hash_table_insert(icl_dbus_sub_table, GUINT_TO_POINTER(sub->id), sub);
+
+	return sub->id;
 }
 
 
 void icl_dbus_unsubscribe_signal(unsigned int id)
 {
-	GDBusConnection *conn = g_dbus_proxy_get_connection(G_DBUS_PROXY(icl_dbus_object));
+	icl_dbus_sub_s *sub;
+
+	RET_IF(NULL == icl_dbus_sub_table);
 
-	g_dbus_connection_signal_unsubscribe(conn, id);
+	sub = g_hash_table_lookup(icl_dbus_sub_table, GUINT_TO_POINTER(id));
+	if (NULL == sub)
+		return;
 
-	icl_dbus_sub_ids = g_list_remove(icl_dbus_sub_ids, GUINT_TO_POINTER(id));
+	g_hash_table_remove(icl_dbus_sub_table, GUINT_TO_POINTER(id));
+	_icl_dbus_sub_remove(sub);
 }
 
 
@@ -173,32 +351,347 @@ API int iotcon_remove_connection_changed_cb(iotcon_connection_changed_cb cb,
 }
 
 
-static void _icl_dbus_sub_id_list_free(gpointer data)
+/* Unsubscribe all signals */
+static void _icl_dbus_cleanup()
 {
-	GDBusConnection *conn = g_dbus_proxy_get_connection(G_DBUS_PROXY(icl_dbus_object));
+	GList *cur, *subs;
+
+	if (NULL == icl_dbus_sub_table)
+		return;
 
-	g_dbus_connection_signal_unsubscribe(conn, GPOINTER_TO_UINT(data));
+	subs = g_hash_table_get_values(icl_dbus_sub_table);
+	g_hash_table_steal_all(icl_dbus_sub_table);
+	for (cur = subs; cur; cur = cur->next)
+		_icl_dbus_sub_remove(cur->data);
+	g_list_free(subs);
 }
 
 
-/* Unsubscribe all signals */
-static void _icl_dbus_cleanup()
+static void _icl_dbus_p2p_stop()
+{
+	GDBusConnection *conn;
+
+	if (NULL == icl_dbus_p2p_object)
+		return;
+
+	conn = g_dbus_proxy_get_connection(G_DBUS_PROXY(icl_dbus_p2p_object));
+
+	g_signal_handler_disconnect(conn, icl_dbus_p2p_closed_id);
+	icl_dbus_p2p_closed_id = 0;
+	g_dbus_connection_signal_unsubscribe(conn, icl_dbus_p2p_signal_sub_id);
+	icl_dbus_p2p_signal_sub_id = 0;
+
+	g_dbus_connection_close(conn, NULL, NULL, NULL);
+
+	g_object_unref(icl_dbus_p2p_object);
+	icl_dbus_p2p_object = NULL;
+}
+
+
+static void _icl_dbus_p2p_closed_cb(GDBusConnection *conn, gboolean remote_peer_vanished,
+		GError *error, gpointer user_data)
+{
+	WARN("p2p connection closed");
+
+	/* the method calls fall back to the system bus */
+	_icl_dbus_p2p_stop();
+}
+
+
+/* the daemon stops writing the signals into the ring */
+static void _icl_dbus_ring_close()
 {
-	g_list_free_full(icl_dbus_sub_ids, _icl_dbus_sub_id_list_free);
-	icl_dbus_sub_ids = NULL;
+	int ret;
+	GError *error = NULL;
+
+	ic_dbus_call_ring_close_sync(icl_dbus_get_object(), &ret, NULL, &error);
+	if (error) {
+		ERR("ic_dbus_call_ring_close_sync() Fail(%s)", error->message);
+		g_error_free(error);
+	}
+}
+
+
+static void _icl_dbus_ring_resume_cb(GObject *object, GAsyncResult *g_async_res,
+		gpointer user_data)
+{
+	int ret;
+	guint source;
+	GError *error = NULL;
+
+	ic_dbus_call_ring_resume_finish(IC_DBUS(object), &ret, g_async_res, &error);
+	if (error) {
+		ERR("ic_dbus_call_ring_resume_finish() Fail(%s)", error->message);
+		g_error_free(error);
+	} else if (IOTCON_ERROR_NONE != ret) {
+		ERR("iotcon-daemon Fail(%d)", ret);
+	}
+
+	icl_dbus_signal_ring_paused = false;
+
+	/* the ring could be stopped, while the call is in progress */
+	if (NULL == icl_dbus_signal_ring || 0 == icl_dbus_signal_ring_source)
+		return;
+
+	/* the records written after the reply */
+	source = icl_dbus_signal_ring_source;
+	_icl_dbus_ring_signal_cb(0, G_IO_IN, NULL);
+
+	/* the ring is broken. The source is not removed by itself */
+	if (icl_dbus_signal_ring && 0 == icl_dbus_signal_ring_source)
+		g_source_remove(source);
+}
+
+
+/* every record of the ring is read, and every signal through D-Bus before this one */
+static void _icl_dbus_ring_drained_cb(GDBusConnection *connection,
+		const gchar *sender_name,
+		const gchar *object_path,
+		const gchar *interface_name,
+		const gchar *signal_name,
+		GVariant *parameters,
+		gpointer user_data)
+{
+	if (NULL == icl_dbus_signal_ring || icl_dbus_signal_ring_paused)
+		return;
+
+	icl_dbus_signal_ring_paused = true;
+
+	ic_dbus_call_ring_resume(icl_dbus_get_object(), NULL, _icl_dbus_ring_resume_cb, NULL);
+}
+
+
+static void _icl_dbus_ring_stop(bool close)
+{
+	if (NULL == icl_dbus_signal_ring)
+		return;
+
+	if (icl_dbus_signal_ring_source)
+		g_source_remove(icl_dbus_signal_ring_source);
+	icl_dbus_signal_ring_source = 0;
+
+	if (icl_dbus_ring_sub_id)
+		icl_dbus_unsubscribe_signal(icl_dbus_ring_sub_id);
+	icl_dbus_ring_sub_id = 0;
+	icl_dbus_signal_ring_paused = false;
+
+	ic_ring_destroy(icl_dbus_notify_ring);
+	icl_dbus_notify_ring = NULL;
+	ic_ring_destroy(icl_dbus_signal_ring);
+	icl_dbus_signal_ring = NULL;
+
+	if (close)
+		_icl_dbus_ring_close();
+}
+
+
+/* Without the rings, the signals and the notifications go through D-Bus */
+static int _icl_dbus_ring_start()
+{
+	int ret;
+	GError *error = NULL;
+	GUnixFDList *fd_list = NULL;
+	gint signal_ring, signal_event, notify_ring, notify_event;
+	char signal_name[IC_DBUS_SIGNAL_LENGTH] = {0};
+
+	if (icl_dbus_signal_ring)
+		return IOTCON_ERROR_NONE;
+
+	ic_dbus_call_ring_open_sync(icl_dbus_get_object(), NULL, &signal_ring, &signal_event,
+			&notify_ring, &notify_event, &ret, &fd_list, NULL, &error);
+	if (error) {
+		ERR("ic_dbus_call_ring_open_sync() Fail(%s)", error->message);
+		ret = icl_dbus_convert_dbus_error(error->code);
+		g_error_free(error);
+		return ret;
+	}
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("iotcon-daemon Fail(%d)", ret);
+		if (fd_list)
+			g_object_unref(fd_list);
+		return icl_dbus_convert_daemon_error(ret);
+	}
+
+	icl_dbus_signal_ring = ic_ring_attach(g_unix_fd_list_get(fd_list, signal_ring, NULL),
+			g_unix_fd_list_get(fd_list, signal_event, NULL));
+	icl_dbus_notify_ring = ic_ring_attach(g_unix_fd_list_get(fd_list, notify_ring, NULL),
+			g_unix_fd_list_get(fd_list, notify_event, NULL));
+	g_object_unref(fd_list);
+
+	if (NULL == icl_dbus_signal_ring || NULL == icl_dbus_notify_ring) {
+		ERR("ic_ring_attach() Fail");
+		ic_ring_destroy(icl_dbus_notify_ring);
+		icl_dbus_notify_ring = NULL;
+		ic_ring_destroy(icl_dbus_signal_ring);
+		icl_dbus_signal_ring = NULL;
+		_icl_dbus_ring_close();
+		return IOTCON_ERROR_SYSTEM;
+	}
+
+	snprintf(signal_name, sizeof(signal_name), "%s_%llx", IC_DBUS_SIGNAL_RING, 0LL);
+	icl_dbus_ring_sub_id = icl_dbus_subscribe_signal(signal_name, NULL, NULL,
+			_icl_dbus_ring_drained_cb);
+	if (0 == icl_dbus_ring_sub_id)
+		WARN("icl_dbus_subscribe_signal() Fail");
+
+	/* the eventfd is already readable, if the daemon wrote before */
+	icl_dbus_signal_ring_source = g_unix_fd_add(ic_ring_get_event_fd(icl_dbus_signal_ring),
+			G_IO_IN, _icl_dbus_ring_signal_cb, NULL);
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+/* Without the private connection, everything goes through the system bus */
+static int _icl_dbus_p2p_start()
+{
+	int ret;
+	gchar *address;
+	GError *error = NULL;
+	GDBusConnection *conn;
+
+	if (icl_dbus_p2p_object)
+		return IOTCON_ERROR_NONE;
+
+	ic_dbus_call_p2p_connect_sync(icl_dbus_object, &address, &ret, NULL, &error);
+	if (error) {
+		ERR("ic_dbus_call_p2p_connect_sync() Fail(%s)", error->message);
+		ret = icl_dbus_convert_dbus_error(error->code);
+		g_error_free(error);
+		return ret;
+	}
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("iotcon-daemon Fail(%d)", ret);
+		g_free(address);
+		return icl_dbus_convert_daemon_error(ret);
+	}
+
+	/* no signal is dispatched until the subscription */
+	conn = g_dbus_connection_new_for_address_sync(address,
+			G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT
+			| G_DBUS_CONNECTION_FLAGS_DELAY_MESSAGE_PROCESSING,
+			NULL,
+			NULL,
+			&error);
+	g_free(address);
+	if (NULL == conn) {
+		ERR("g_dbus_connection_new_for_address_sync() Fail(%s)", error->message);
+		g_error_free(error);
+		return IOTCON_ERROR_DBUS;
+	}
+
+	icl_dbus_p2p_object = ic_dbus_proxy_new_sync(conn,
+			G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES
+			| G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS,
+			NULL,
+			IOTCON_DBUS_OBJPATH,
+			NULL,
+			&error);
+	if (NULL == icl_dbus_p2p_object) {
+		ERR("ic_dbus_proxy_new_sync() Fail(%s)", error->message);
+		g_error_free(error);
+		g_dbus_connection_close(conn, NULL, NULL, NULL);
+		g_object_unref(conn);
+		return IOTCON_ERROR_DBUS;
+	}
+	g_dbus_proxy_set_default_timeout(G_DBUS_PROXY(icl_dbus_p2p_object),
+			g_dbus_proxy_get_default_timeout(G_DBUS_PROXY(icl_dbus_object)));
+
+	icl_dbus_p2p_signal_sub_id = g_dbus_connection_signal_subscribe(conn,
+			NULL,
+			IOTCON_DBUS_INTERFACE,
+			NULL,
+			IOTCON_DBUS_OBJPATH,
+			NULL,
+			G_DBUS_SIGNAL_FLAGS_NONE,
+			_icl_dbus_signal_cb,
+			NULL,
+			NULL);
+	icl_dbus_p2p_closed_id = g_signal_connect(conn, "closed",
+			G_CALLBACK(_icl_dbus_p2p_closed_cb), NULL);
+
+	g_dbus_connection_start_message_processing(conn);
+	/* the proxy holds the connection */
+	g_object_unref(conn);
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+/* An old daemon does not know the method, and gets IC_WIRE_VERSION_1. */
+static void _icl_dbus_wire_negotiate()
+{
+	guint16 version;
+	GError *error = NULL;
+
+	icl_dbus_wire_version = IC_WIRE_VERSION_1;
+
+	ic_dbus_call_negotiate_wire_sync(icl_dbus_get_object(), IC_WIRE_VERSION_MAX,
+			&version, NULL, &error);
+	if (error) {
+		WARN("ic_dbus_call_negotiate_wire_sync() Fail(%s)", error->message);
+		g_error_free(error);
+		return;
+	}
+
+	if (version < IC_WIRE_VERSION_1 || IC_WIRE_VERSION_MAX < version) {
+		ERR("Invalid version(%d)", version);
+		return;
+	}
+
+	icl_dbus_wire_version = version;
+}
+
+
+int icl_dbus_get_wire_version()
+{
+	return icl_dbus_wire_version;
 }
 
 
 static void _icl_dbus_name_owner_notify(GObject *object, GParamSpec *pspec,
 		gpointer user_data)
 {
+	int ret;
 	GDBusProxy *proxy = G_DBUS_PROXY(object);
 	gchar *name_owner = g_dbus_proxy_get_name_owner(proxy);
 
-	if (name_owner)
+	if (name_owner) {
+		g_free(name_owner);
+
+		/* the daemon is restarted */
+		ret = _icl_dbus_p2p_start();
+		if (IOTCON_ERROR_NONE != ret)
+			WARN("_icl_dbus_p2p_start() Fail(%d)", ret);
+		_icl_dbus_wire_negotiate();
+		ret = _icl_dbus_ring_start();
+		if (IOTCON_ERROR_NONE != ret)
+			WARN("_icl_dbus_ring_start() Fail(%d)", ret);
 		return;
+	}
 
+	_icl_dbus_ring_stop(false);
+	_icl_dbus_p2p_stop();
 	_icl_dbus_cleanup();
+	icl_dbus_wire_version = IC_WIRE_VERSION_1;
+}
+
+
+/* The daemon does not answer. The values should not be floating. */
+int icl_dbus_ring_notify(int64_t handle, GVariant *notify_msg, GVariant *observers,
+		int qos)
+{
+	int ret;
+	GVariant *record;
+
+	RETV_IF(NULL == icl_dbus_notify_ring, IOTCON_ERROR_NOT_SUPPORTED);
+
+	record = g_variant_ref_sink(g_variant_new("(x@av@aii)", handle, notify_msg,
+				observers, qos));
+	ret = ic_ring_write(icl_dbus_notify_ring, record);
+	g_variant_unref(record);
+
+	return ret;
 }
 
 
@@ -234,6 +727,10 @@ int icl_dbus_set_timeout(int timeout_seconds)
 	RETV_IF(NULL == icl_dbus_object, IOTCON_ERROR_DBUS);
 
 	g_dbus_proxy_set_default_timeout(G_DBUS_PROXY(icl_dbus_object), timeout_seconds * 1000);
+	if (icl_dbus_p2p_object) {
+		g_dbus_proxy_set_default_timeout(G_DBUS_PROXY(icl_dbus_p2p_object),
+				timeout_seconds * 1000);
+	}
 
 	return IOTCON_ERROR_NONE;
 }
@@ -254,6 +751,7 @@ int icl_dbus_get_timeout()
 
 int icl_dbus_start()
 {
+	int ret;
 	unsigned int id;
 	GError *error = NULL;
 
@@ -284,6 +782,42 @@ int icl_dbus_start()
 	g_dbus_proxy_set_default_timeout(G_DBUS_PROXY(icl_dbus_object),
 			ICL_DBUS_TIMEOUT_DEFAULT * 1000);
 
+	icl_dbus_sub_table = g_hash_table_new(g_direct_hash, g_direct_equal);
+	icl_dbus_sub_name_table = g_hash_table_new(g_str_hash, g_str_equal);
+
+	/* only one match rule for all signals of iotcon */
+	icl_dbus_signal_sub_id = g_dbus_connection_signal_subscribe(
+			g_dbus_proxy_get_connection(G_DBUS_PROXY(icl_dbus_object)),
+			NULL,
+			IOTCON_DBUS_INTERFACE,
+			NULL,
+			IOTCON_DBUS_OBJPATH,
+			NULL,
+			G_DBUS_SIGNAL_FLAGS_NONE,
+			_icl_dbus_signal_cb,
+			NULL,
+			NULL);
+	if (0 == icl_dbus_signal_sub_id) {
+		ERR("g_dbus_connection_signal_subscribe() Fail");
+		g_hash_table_destroy(icl_dbus_sub_name_table);
+		icl_dbus_sub_name_table = NULL;
+		g_hash_table_destroy(icl_dbus_sub_table);
+		icl_dbus_sub_table = NULL;
+		g_object_unref(icl_dbus_object);
+		icl_dbus_object = NULL;
+		return IOTCON_ERROR_DBUS;
+	}
+
+	ret = _icl_dbus_p2p_start();
+	if (IOTCON_ERROR_NONE != ret)
+		WARN("_icl_dbus_p2p_start() Fail(%d)", ret);
+
+	_icl_dbus_wire_negotiate();
+
+	ret = _icl_dbus_ring_start();
+	if (IOTCON_ERROR_NONE != ret)
+		WARN("_icl_dbus_ring_start() Fail(%d)", ret);
+
 	icl_dbus_count++;
 	return IOTCON_ERROR_NONE;
 }
@@ -304,6 +838,20 @@ void icl_dbus_stop()
 	DBG("All connection is closed");
 
 	_icl_dbus_cleanup();
+	_icl_dbus_ring_stop(true);
+	_icl_dbus_p2p_stop();
+	icl_dbus_wire_version = IC_WIRE_VERSION_1;
+
+	g_dbus_connection_signal_unsubscribe(
+			g_dbus_proxy_get_connection(G_DBUS_PROXY(icl_dbus_object)),
+			icl_dbus_signal_sub_id);
+	icl_dbus_signal_sub_id = 0;
+
+	/* subscriptions left in the name table are freed in the idle callbacks */
+	g_hash_table_destroy(icl_dbus_sub_name_table);
+	icl_dbus_sub_name_table = NULL;
+	g_hash_table_destroy(icl_dbus_sub_table);
+	icl_dbus_sub_table = NULL;
 
 	g_list_free_full(icl_dbus_conn_changed_cbs, free);
 	icl_dbus_conn_changed_cbs = NULL;
@@ -30,6 +30,10 @@ unsigned int icl_dbus_subscribe_signal(char *signal_name, void *cb_container,
 		void *cb_free, GDBusSignalCallback sig_handler);
 void icl_dbus_unsubscribe_signal(unsigned int id);
 
+int icl_dbus_ring_notify(int64_t handle, GVariant *notify_msg, GVariant *observers,
+		int qos);
+int icl_dbus_get_wire_version();
+
 int icl_dbus_add_connection_changed_cb(iotcon_connection_changed_cb cb,
 		void *user_data);
 int icl_dbus_remove_connection_changed_cb(iotcon_connection_changed_cb cb,
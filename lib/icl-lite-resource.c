@@ -148,9 +148,9 @@ static void _icl_lite_resource_request_handler(GDBusConnection *connection,
 	int ret, request_type;
 	int64_t oic_request_h = 0;
 	int64_t oic_resource_h = 0;
-	iotcon_representation_h repr;
 	iotcon_state_h recv_state = NULL;
-	GVariantIter *repr_iter, *state_iter;
+	GVariantIter *repr_iter;
+	iotcon_representation_h repr, recv_repr;
 	iotcon_lite_resource_h resource = user_data;
 
 	ret = iotcon_representation_create(&repr);
@@ -194,19 +194,18 @@ static void _icl_lite_resource_request_handler(GDBusConnection *connection,
 			return;
 		}
 
-		g_variant_get(repr_gvar, "(sasasa{sv}av)", NULL, NULL, NULL, &state_iter,
-				NULL);
-
-		ret = iotcon_state_create(&recv_state);
-		if (IOTCON_ERROR_NONE != ret) {
-			ERR("iotcon_state_create() Fail(%d)", ret);
+		/* the representation could be in any wire version */
+		recv_repr = icl_representation_from_gvariant(repr_gvar);
+		if (NULL == recv_repr) {
+			ERR("icl_representation_from_gvariant() Fail");
 			_icl_lite_resource_response_send(repr, oic_request_h, oic_resource_h,
 					IOTCON_RESPONSE_ERROR);
 			iotcon_representation_destroy(repr);
 			return;
 		}
 
-		icl_state_from_gvariant(recv_state, state_iter);
+		recv_state = icl_state_ref(recv_repr->state);
+		iotcon_representation_destroy(recv_repr);
 
 		if (resource->cb) {
 			if (false == resource->cb(resource, recv_state, resource->cb_data)) {
@@ -14,11 +14,17 @@
  * limitations under the License.
  */
 #include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
 #include <glib.h>
+#include <gio/gunixfdlist.h>
 
 #include "iotcon.h"
 #include "ic-utils.h"
+#include "ic-blob.h"
+#include "ic-wire.h"
 #include "icl.h"
+#include "icl-dbus.h"
 #include "icl-representation.h"
 #include "icl-state.h"
 #include "icl-list.h"
@@ -31,6 +37,109 @@
 static GVariant* _icl_state_value_to_gvariant(GHashTable *hash);
 static iotcon_list_h _icl_state_list_from_gvariant(GVariant *var);
 
+static int _icl_payload_blob_put(icl_val_byte_str_s *value, uint64_t *id)
+{
+	int fd, ret;
+	GError *error = NULL;
+	GUnixFDList *fd_list;
+
+	/* the blob from the daemon is sent back without copying */
+	if (0 <= value->fd)
+		fd = dup(value->fd);
+	else
+		fd = ic_blob_create(value->s, value->len);
+	if (fd < 0)
+		return IOTCON_ERROR_NOT_SUPPORTED;
+
+	fd_list = g_unix_fd_list_new_from_array(&fd, 1);
+
+	ic_dbus_call_blob_put_sync(icl_dbus_get_object(), 0, value->len, fd_list, id, &ret,
+			NULL, NULL, &error);
+	g_object_unref(fd_list);
+	if (error) {
+		ERR("ic_dbus_call_blob_put_sync() Fail(%s)", error->message);
+		ret = icl_dbus_convert_dbus_error(error->code);
+		g_error_free(error);
+		return ret;
+	}
+
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("iotcon-daemon Fail(%d)", ret);
+		return icl_dbus_convert_daemon_error(ret);
+	}
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+static GVariant* _icl_byte_str_to_gvariant(icl_val_byte_str_s *value)
+{
+	int ret, len;
+	uint64_t id;
+	unsigned char *s;
+
+	/* a large byte string goes by fd instead of D-Bus marshalling */
+	if (IC_BLOB_THRESHOLD <= value->len) {
+		ret = _icl_payload_blob_put(value, &id);
+		if (IOTCON_ERROR_NONE == ret)
+			return g_variant_new(IC_BLOB_TYPE, id, (guint64)value->len);
+		WARN("_icl_payload_blob_put() Fail(%d)", ret);
+	}
+
+	ret = icl_value_get_byte_str((iotcon_value_h)value, &s, &len);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("icl_value_get_byte_str() Fail(%d)", ret);
+		return NULL;
+	}
+
+	return g_variant_new_fixed_array(G_VARIANT_TYPE("y"), s, len, sizeof(unsigned char));
+}
+
+
+static iotcon_value_h _icl_byte_str_from_blob(guint64 id, guint64 length)
+{
+	int fd, ret;
+	GError *error = NULL;
+	GUnixFDList *fd_list = NULL;
+	gint blob;
+
+	ic_dbus_call_blob_get_sync(icl_dbus_get_object(), id, length, NULL, &blob, &ret,
+			&fd_list, NULL, &error);
+	if (error) {
+		ERR("ic_dbus_call_blob_get_sync() Fail(%s)", error->message);
+		g_error_free(error);
+		return NULL;
+	}
+
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("iotcon-daemon Fail(%d)", ret);
+		if (fd_list)
+			g_object_unref(fd_list);
+		return NULL;
+	}
+
+	fd = g_unix_fd_list_get(fd_list, blob, &error);
+	g_object_unref(fd_list);
+	if (fd < 0) {
+		ERR("g_unix_fd_list_get() Fail(%s)", error->message);
+		g_error_free(error);
+		return NULL;
+	}
+
+	return icl_value_create_byte_str_blob(fd, length);
+}
+
+
+static iotcon_value_h _icl_byte_str_from_gvariant(GVariant *var)
+{
+	guint64 id, length;
+
+	g_variant_get(var, IC_BLOB_TYPE, &id, &length);
+
+	return _icl_byte_str_from_blob(id, length);
+}
+
+
 static GVariant* _icl_state_list_to_gvariant(iotcon_list_h list)
 {
 	GList *node;
@@ -137,10 +246,7 @@ static GVariantBuilder* _icl_state_value_to_gvariant_builder(GHashTable *hash)
 			var = g_variant_new_string(IC_STR_NULL);
 			break;
 		case IOTCON_TYPE_BYTE_STR:
-			var = g_variant_new_fixed_array(G_VARIANT_TYPE("y"),
-					((icl_val_byte_str_s*)state_value)->s,
-					((icl_val_byte_str_s*)state_value)->len,
-					sizeof(unsigned char));
+			var = _icl_byte_str_to_gvariant((icl_val_byte_str_s*)state_value);
 			break;
 		case IOTCON_TYPE_LIST:
 			var = _icl_state_list_to_gvariant(((icl_val_list_s*)state_value)->list);
@@ -242,6 +348,313 @@ GVariant* icl_representation_to_gvariant(iotcon_representation_h repr)
 }
 
 
+static void _icl_wire_write_state(ic_wire_writer_s *writer, guint32 state,
+		GHashTable *hash);
+
+static int _icl_wire_write_list(ic_wire_writer_s *writer, guint32 list,
+		iotcon_list_h value)
+{
+	int ret, len;
+	guint8 tag;
+	GList *node;
+	iotcon_state_h state;
+	const unsigned char *s;
+	guint32 i, index, first = 0, count;
+	struct icl_value_s *list_value;
+
+	count = g_list_length(value->list);
+
+	switch (value->type) {
+	case IOTCON_TYPE_INT:
+		tag = IC_WIRE_INT;
+		for (node = value->list, i = 0; node; node = node->next, i++) {
+			index = ic_wire_writer_add_int(writer, ((icl_basic_s*)node->data)->val.i);
+			if (0 == i)
+				first = index;
+		}
+		break;
+	case IOTCON_TYPE_BOOL:
+		tag = IC_WIRE_BOOL;
+		for (node = value->list, i = 0; node; node = node->next, i++) {
+			index = ic_wire_writer_add_bool(writer, ((icl_basic_s*)node->data)->val.b);
+			if (0 == i)
+				first = index;
+		}
+		break;
+	case IOTCON_TYPE_DOUBLE:
+		tag = IC_WIRE_DOUBLE;
+		for (node = value->list, i = 0; node; node = node->next, i++) {
+			index = ic_wire_writer_add_double(writer, ((icl_basic_s*)node->data)->val.d);
+			if (0 == i)
+				first = index;
+		}
+		break;
+	case IOTCON_TYPE_STR:
+		tag = IC_WIRE_STR;
+		for (node = value->list, i = 0; node; node = node->next, i++) {
+			index = ic_wire_writer_add_str(writer, ((icl_basic_s*)node->data)->val.s);
+			if (0 == i)
+				first = index;
+		}
+		break;
+	case IOTCON_TYPE_BYTE_STR:
+		tag = IC_WIRE_BYTE_STR;
+		for (node = value->list, i = 0; node; node = node->next, i++) {
+			ret = icl_value_get_byte_str_readonly(node->data, &s, &len);
+			if (IOTCON_ERROR_NONE != ret) {
+				ERR("icl_value_get_byte_str_readonly() Fail(%d)", ret);
+				return ret;
+			}
+			index = ic_wire_writer_add_byte_str(writer, s, len);
+			if (0 == i)
+				first = index;
+		}
+		break;
+	case IOTCON_TYPE_LIST:
+		tag = IC_WIRE_LIST;
+		first = ic_wire_writer_reserve_lists(writer, count);
+		for (node = value->list, i = 0; node; node = node->next, i++) {
+			list_value = node->data;
+			ret = _icl_wire_write_list(writer, first + i,
+					((icl_val_list_s*)list_value)->list);
+			if (IOTCON_ERROR_NONE != ret) {
+				ERR("_icl_wire_write_list() Fail(%d)", ret);
+				return ret;
+			}
+		}
+		break;
+	case IOTCON_TYPE_STATE:
+		tag = IC_WIRE_STATE;
+		first = ic_wire_writer_reserve_states(writer, count);
+		for (node = value->list, i = 0; node; node = node->next, i++) {
+			state = ((icl_val_state_s*)node->data)->state;
+			_icl_wire_write_state(writer, first + i, state->hash_table);
+		}
+		break;
+	default:
+		ERR("Invalid type(%d)", value->type);
+		return IOTCON_ERROR_INVALID_TYPE;
+	}
+
+	ic_wire_writer_set_list(writer, list, tag, first, count);
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+static int _icl_wire_write_value(ic_wire_writer_s *writer, struct icl_value_s *value,
+		guint8 *tag, guint32 *index)
+{
+	int ret, len;
+	uint64_t id;
+	iotcon_state_h state;
+	const unsigned char *s;
+
+	*index = 0;
+
+	switch (value->type) {
+	case IOTCON_TYPE_INT:
+		*tag = IC_WIRE_INT;
+		*index = ic_wire_writer_add_int(writer, ((icl_basic_s*)value)->val.i);
+		break;
+	case IOTCON_TYPE_BOOL:
+		*tag = IC_WIRE_BOOL;
+		*index = ic_wire_writer_add_bool(writer, ((icl_basic_s*)value)->val.b);
+		break;
+	case IOTCON_TYPE_DOUBLE:
+		*tag = IC_WIRE_DOUBLE;
+		*index = ic_wire_writer_add_double(writer, ((icl_basic_s*)value)->val.d);
+		break;
+	case IOTCON_TYPE_STR:
+		*tag = IC_WIRE_STR;
+		*index = ic_wire_writer_add_str(writer, ((icl_basic_s*)value)->val.s);
+		break;
+	case IOTCON_TYPE_NULL:
+		*tag = IC_WIRE_NULL;
+		break;
+	case IOTCON_TYPE_BYTE_STR:
+		/* a large byte string goes by fd instead of D-Bus marshalling */
+		if (IC_BLOB_THRESHOLD <= ((icl_val_byte_str_s*)value)->len) {
+			ret = _icl_payload_blob_put((icl_val_byte_str_s*)value, &id);
+			if (IOTCON_ERROR_NONE == ret) {
+				*tag = IC_WIRE_BLOB;
+				*index = ic_wire_writer_add_blob(writer, id,
+						((icl_val_byte_str_s*)value)->len);
+				break;
+			}
+			WARN("_icl_payload_blob_put() Fail(%d)", ret);
+		}
+		ret = icl_value_get_byte_str_readonly((iotcon_value_h)value, &s, &len);
+		if (IOTCON_ERROR_NONE != ret) {
+			ERR("icl_value_get_byte_str_readonly() Fail(%d)", ret);
+			return ret;
+		}
+		*tag = IC_WIRE_BYTE_STR;
+		*index = ic_wire_writer_add_byte_str(writer, s, len);
+		break;
+	case IOTCON_TYPE_LIST:
+		*tag = IC_WIRE_LIST;
+		*index = ic_wire_writer_reserve_lists(writer, 1);
+		return _icl_wire_write_list(writer, *index, ((icl_val_list_s*)value)->list);
+	case IOTCON_TYPE_STATE:
+		*tag = IC_WIRE_STATE;
+		*index = ic_wire_writer_reserve_states(writer, 1);
+		state = ((icl_val_state_s*)value)->state;
+		_icl_wire_write_state(writer, *index, state->hash_table);
+		break;
+	case IOTCON_TYPE_NONE:
+	default:
+		ERR("Invalid Type(%d)", value->type);
+		return IOTCON_ERROR_INVALID_TYPE;
+	}
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+static void _icl_wire_write_state(ic_wire_writer_s *writer, guint32 state,
+		GHashTable *hash)
+{
+	int ret;
+	guint8 tag;
+	gpointer key, value;
+	GHashTableIter iter;
+	guint32 first, count, index;
+
+	if (NULL == hash)
+		return;
+
+	first = ic_wire_writer_reserve_attrs(writer, g_hash_table_size(hash));
+
+	/* an invalid attribute is skipped, and leaves an unused slot */
+	count = 0;
+	g_hash_table_iter_init(&iter, hash);
+	while (g_hash_table_iter_next(&iter, &key, &value)) {
+		ret = _icl_wire_write_value(writer, value, &tag, &index);
+		if (IOTCON_ERROR_NONE != ret) {
+			ERR("_icl_wire_write_value() Fail(%d)", ret);
+			continue;
+		}
+		ic_wire_writer_set_attr(writer, first + count, key, tag, index);
+		count++;
+	}
+
+	ic_wire_writer_set_state(writer, state, first, count);
+}
+
+
+static void _icl_wire_write_node(ic_wire_writer_s *writer,
+		iotcon_representation_h repr, guint32 parent)
+{
+	GList *node;
+	guint32 state, index;
+	GVariantBuilder resource_types, resource_ifaces;
+
+	state = ic_wire_writer_reserve_states(writer, 1);
+	if (repr->state && (ICL_VISIBILITY_REPR & repr->visibility))
+		_icl_wire_write_state(writer, state, repr->state->hash_table);
+
+	g_variant_builder_init(&resource_types, G_VARIANT_TYPE("as"));
+	g_variant_builder_init(&resource_ifaces, G_VARIANT_TYPE("as"));
+
+	if (ICL_VISIBILITY_PROP & repr->visibility) {
+		if (repr->res_types) {
+			for (node = repr->res_types->type_list; node; node = node->next)
+				g_variant_builder_add(&resource_types, "s", node->data);
+		}
+
+		if (repr->interfaces) {
+			for (node = repr->interfaces->iface_list; node; node = node->next)
+				g_variant_builder_add(&resource_ifaces, "s", node->data);
+		}
+	}
+
+	index = ic_wire_writer_add_node(writer, ic_utils_dbus_encode_str(repr->uri_path),
+			g_variant_builder_end(&resource_ifaces),
+			g_variant_builder_end(&resource_types), parent, state);
+
+	/* a child follows its parent */
+	for (node = repr->children; node; node = node->next)
+		_icl_wire_write_node(writer, node->data, index);
+}
+
+
+static unsigned int _icl_wire_count_state(GHashTable *hash);
+
+/* the elements of the list, including the nested ones */
+static unsigned int _icl_wire_count_list(iotcon_list_h list)
+{
+	GList *node;
+	struct icl_value_s *value;
+	unsigned int count = 0;
+
+	for (node = list->list; node; node = node->next) {
+		count++;
+		value = node->data;
+		if (IOTCON_TYPE_LIST == value->type)
+			count += _icl_wire_count_list(((icl_val_list_s*)value)->list);
+		else if (IOTCON_TYPE_STATE == value->type)
+			count += _icl_wire_count_state(((icl_val_state_s*)value)->state->hash_table);
+	}
+
+	return count;
+}
+
+
+static unsigned int _icl_wire_count_state(GHashTable *hash)
+{
+	gpointer value;
+	GHashTableIter iter;
+	unsigned int count = 0;
+
+	g_hash_table_iter_init(&iter, hash);
+	while (g_hash_table_iter_next(&iter, NULL, &value)) {
+		if (IOTCON_TYPE_LIST == ((struct icl_value_s*)value)->type)
+			count += _icl_wire_count_list(((icl_val_list_s*)value)->list);
+		else if (IOTCON_TYPE_STATE == ((struct icl_value_s*)value)->type)
+			count += _icl_wire_count_state(((icl_val_state_s*)value)->state->hash_table);
+	}
+
+	return count;
+}
+
+
+static unsigned int _icl_wire_count_elements(iotcon_representation_h repr)
+{
+	GList *node;
+	unsigned int count = 0;
+
+	if (repr->state && (ICL_VISIBILITY_REPR & repr->visibility))
+		count += _icl_wire_count_state(repr->state->hash_table);
+
+	for (node = repr->children; node; node = node->next)
+		count += _icl_wire_count_elements(node->data);
+
+	return count;
+}
+
+
+/* For the representations in a "v", which is read by the daemon.
+ * The typed arguments of put and post are always IC_WIRE_VERSION_1.
+ * IC_WIRE_VERSION_2 is used, only if it is worth. */
+GVariant* icl_representation_to_gvariant_version(iotcon_representation_h repr,
+		int wire_version)
+{
+	ic_wire_writer_s writer;
+
+	if (NULL == repr || wire_version < IC_WIRE_VERSION_2)
+		return icl_representation_to_gvariant(repr);
+
+	if (_icl_wire_count_elements(repr) < IC_WIRE_FLAT_MIN_ELEMENTS)
+		return icl_representation_to_gvariant(repr);
+
+	ic_wire_writer_init(&writer);
+	_icl_wire_write_node(&writer, repr, IC_WIRE_NO_PARENT);
+
+	return ic_wire_writer_end(&writer);
+}
+
+
 void icl_state_from_gvariant(iotcon_state_h state, GVariantIter *iter)
 {
 	char *key;
@@ -276,6 +689,12 @@ void icl_state_from_gvariant(iotcon_state_h state, GVariantIter *iter)
 		} else if (g_variant_is_of_type(var, G_VARIANT_TYPE("ay"))) {
 			value = icl_value_create_byte_str(g_variant_get_data(var),
 					g_variant_get_size(var));
+		} else if (g_variant_is_of_type(var, G_VARIANT_TYPE(IC_BLOB_TYPE))) {
+			value = _icl_byte_str_from_gvariant(var);
+			if (NULL == value) {
+				ERR("_icl_byte_str_from_gvariant() Fail");
+				continue;
+			}
 		} else if (g_variant_is_of_type(var, G_VARIANT_TYPE_ARRAY)) {
 			list_value = _icl_state_list_from_gvariant(var);
 			value = icl_value_create_list(list_value);
@@ -392,6 +811,301 @@ static iotcon_list_h _icl_state_list_from_gvariant(GVariant *var)
 }
 
 
+static int _icl_wire_read_state(ic_wire_reader_s *reader, iotcon_state_h state,
+		guint32 index, int depth);
+static iotcon_list_h _icl_wire_read_list(ic_wire_reader_s *reader, guint32 index,
+		int depth);
+
+static iotcon_value_h _icl_wire_read_value(ic_wire_reader_s *reader, guint8 tag,
+		guint32 index, int depth)
+{
+	int ret;
+	guint32 length;
+	iotcon_list_h list;
+	iotcon_state_h state;
+	const unsigned char *data;
+
+	if (IC_WIRE_NULL != tag && IC_WIRE_LIST != tag
+			&& false == ic_wire_reader_check(reader, tag, index, 1))
+		return NULL;
+
+	switch (tag) {
+	case IC_WIRE_NULL:
+		return icl_value_create_null();
+	case IC_WIRE_BOOL:
+		return icl_value_create_bool(!!reader->bools[index]);
+	case IC_WIRE_INT:
+		return icl_value_create_int(reader->ints[index]);
+	case IC_WIRE_DOUBLE:
+		return icl_value_create_double(reader->doubles[index]);
+	case IC_WIRE_STR:
+		return icl_value_create_str(reader->strs[index]);
+	case IC_WIRE_BYTE_STR:
+		if (false == ic_wire_reader_get_byte_str(reader, index, &data, &length))
+			return NULL;
+		return icl_value_create_byte_str(data, length);
+	case IC_WIRE_BLOB:
+		return _icl_byte_str_from_blob(reader->blobs[index].id,
+				reader->blobs[index].length);
+	case IC_WIRE_LIST:
+		list = _icl_wire_read_list(reader, index, depth);
+		if (NULL == list)
+			return NULL;
+		return icl_value_create_list(list);
+	case IC_WIRE_STATE:
+		ret = iotcon_state_create(&state);
+		if (IOTCON_ERROR_NONE != ret) {
+			ERR("iotcon_state_create() Fail(%d)", ret);
+			return NULL;
+		}
+		ret = _icl_wire_read_state(reader, state, index, depth + 1);
+		if (IOTCON_ERROR_NONE != ret) {
+			ERR("_icl_wire_read_state() Fail(%d)", ret);
+			iotcon_state_destroy(state);
+			return NULL;
+		}
+		return icl_value_create_state(state);
+	default:
+		ERR("Invalid tag(%d)", tag);
+		return NULL;
+	}
+}
+
+
+static iotcon_list_h _icl_wire_read_list(ic_wire_reader_s *reader, guint32 index,
+		int depth)
+{
+	int ret, type;
+	guint32 i;
+	GList *values = NULL;
+	iotcon_value_h value;
+	iotcon_list_h list;
+	const ic_wire_list_s *wire_list;
+
+	if (IC_WIRE_MAX_DEPTH < depth) {
+		ERR("Invalid depth(%d)", depth);
+		return NULL;
+	}
+
+	wire_list = ic_wire_reader_get_list(reader, index);
+	if (NULL == wire_list) {
+		ERR("ic_wire_reader_get_list() Fail");
+		return NULL;
+	}
+
+	switch (wire_list->tag) {
+	case IC_WIRE_BOOL:
+		type = IOTCON_TYPE_BOOL;
+		break;
+	case IC_WIRE_INT:
+		type = IOTCON_TYPE_INT;
+		break;
+	case IC_WIRE_DOUBLE:
+		type = IOTCON_TYPE_DOUBLE;
+		break;
+	case IC_WIRE_STR:
+		type = IOTCON_TYPE_STR;
+		break;
+	case IC_WIRE_BYTE_STR:
+		type = IOTCON_TYPE_BYTE_STR;
+		break;
+	case IC_WIRE_LIST:
+		type = IOTCON_TYPE_LIST;
+		break;
+	case IC_WIRE_STATE:
+	default:
+		type = IOTCON_TYPE_STATE;
+		break;
+	}
+
+	ret = iotcon_list_create(type, &list);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("iotcon_list_create() Fail(%d)", ret);
+		return NULL;
+	}
+
+	/* prepended, not to walk the list for each element */
+	for (i = 0; i < wire_list->count; i++) {
+		value = _icl_wire_read_value(reader, wire_list->tag, wire_list->first + i,
+				depth + 1);
+		if (NULL == value) {
+			ERR("_icl_wire_read_value() Fail");
+			g_list_free_full(values, icl_value_destroy);
+			iotcon_list_destroy(list);
+			return NULL;
+		}
+		values = g_list_prepend(values, value);
+	}
+	list->list = g_list_reverse(values);
+
+	return list;
+}
+
+
+static int _icl_wire_read_state(ic_wire_reader_s *reader, iotcon_state_h state,
+		guint32 index, int depth)
+{
+	guint32 i;
+	const char *key;
+	iotcon_value_h value;
+	const ic_wire_attr_s *attr;
+	const ic_wire_range_s *range;
+
+	if (IC_WIRE_MAX_DEPTH < depth) {
+		ERR("Invalid depth(%d)", depth);
+		return IOTCON_ERROR_INVALID_PARAMETER;
+	}
+
+	range = ic_wire_reader_get_state(reader, index);
+	if (NULL == range) {
+		ERR("ic_wire_reader_get_state() Fail");
+		return IOTCON_ERROR_INVALID_PARAMETER;
+	}
+
+	for (i = 0; i < range->count; i++) {
+		attr = &reader->attrs[range->first + i];
+
+		key = ic_wire_reader_get_key(reader, attr->key);
+		if (NULL == key) {
+			ERR("ic_wire_reader_get_key() Fail");
+			return IOTCON_ERROR_INVALID_PARAMETER;
+		}
+
+		value = _icl_wire_read_value(reader, attr->tag, attr->value, depth);
+		if (NULL == value) {
+			/* the blob could be expired in the daemon */
+			if (IC_WIRE_BLOB == attr->tag) {
+				ERR("_icl_byte_str_from_blob() Fail");
+				continue;
+			}
+			ERR("_icl_wire_read_value() Fail");
+			return IOTCON_ERROR_INVALID_PARAMETER;
+		}
+		g_hash_table_replace(state->hash_table, ic_utils_strdup(key), value);
+	}
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+static int _icl_wire_read_node(ic_wire_reader_s *reader, guint32 node,
+		iotcon_representation_h *nodes)
+{
+	int i, ret;
+	guint32 parent, state_index;
+	const char *uri_path;
+	iotcon_state_h state;
+	iotcon_representation_h repr;
+	const gchar **ifaces, **types;
+
+	ret = ic_wire_reader_get_node(reader, node, &uri_path, &ifaces, &types, &parent,
+			&state_index);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("ic_wire_reader_get_node() Fail(%d)", ret);
+		return ret;
+	}
+
+	ret = iotcon_representation_create(&repr);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("iotcon_representation_create() Fail(%d)", ret);
+		g_free(types);
+		g_free(ifaces);
+		return ret;
+	}
+
+	/* the parent destroys its children */
+	nodes[node] = repr;
+	if (0 < node)
+		nodes[parent]->children = g_list_prepend(nodes[parent]->children, repr);
+
+	if (IC_STR_EQUAL != strcmp(IC_STR_NULL, uri_path))
+		repr->uri_path = strdup(uri_path);
+
+	if (types[0]) {
+		ret = iotcon_resource_types_create(&repr->res_types);
+		if (IOTCON_ERROR_NONE != ret) {
+			ERR("iotcon_resource_types_create() Fail(%d)", ret);
+			g_free(types);
+			g_free(ifaces);
+			return ret;
+		}
+		for (i = 0; types[i]; i++)
+			iotcon_resource_types_add(repr->res_types, types[i]);
+	}
+	g_free(types);
+
+	if (ifaces[0]) {
+		ret = iotcon_resource_interfaces_create(&repr->interfaces);
+		if (IOTCON_ERROR_NONE != ret) {
+			ERR("iotcon_resource_interfaces_create() Fail(%d)", ret);
+			g_free(ifaces);
+			return ret;
+		}
+		for (i = 0; ifaces[i]; i++)
+			iotcon_resource_interfaces_add(repr->interfaces, ifaces[i]);
+	}
+	g_free(ifaces);
+
+	ret = iotcon_state_create(&state);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("iotcon_state_create() Fail(%d)", ret);
+		return ret;
+	}
+
+	ret = _icl_wire_read_state(reader, state, state_index, 0);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("_icl_wire_read_state() Fail(%d)", ret);
+		iotcon_state_destroy(state);
+		return ret;
+	}
+	repr->state = state;
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+static iotcon_representation_h _icl_representation_from_wire(GVariant *var)
+{
+	int ret;
+	guint32 node;
+	ic_wire_reader_s reader;
+	iotcon_representation_h repr, *nodes;
+
+	ret = ic_wire_reader_init(&reader, var);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("ic_wire_reader_init() Fail(%d)", ret);
+		return NULL;
+	}
+
+	nodes = calloc(reader.n_nodes, sizeof(iotcon_representation_h));
+	if (NULL == nodes) {
+		ERR("calloc() Fail(%d)", errno);
+		ic_wire_reader_clear(&reader);
+		return NULL;
+	}
+
+	for (node = 0; node < reader.n_nodes; node++) {
+		ret = _icl_wire_read_node(&reader, node, nodes);
+		if (IOTCON_ERROR_NONE != ret) {
+			ERR("_icl_wire_read_node() Fail(%d)", ret);
+			iotcon_representation_destroy(nodes[0]);
+			free(nodes);
+			ic_wire_reader_clear(&reader);
+			return NULL;
+		}
+	}
+
+	for (node = 0; node < reader.n_nodes; node++)
+		nodes[node]->children = g_list_reverse(nodes[node]->children);
+
+	repr = nodes[0];
+	free(nodes);
+	ic_wire_reader_clear(&reader);
+
+	return repr;
+}
+
+
 iotcon_representation_h icl_representation_from_gvariant(GVariant *var)
 {
 	int ret;
@@ -401,6 +1115,9 @@ iotcon_representation_h icl_representation_from_gvariant(GVariant *var)
 	char *uri_path, *resource_type, *resource_iface;
 	GVariantIter *children, *repr_gvar, *resource_types, *resource_ifaces;
 
+	if (ic_wire_is_flat(var))
+		return _icl_representation_from_wire(var);
+
 	ret = iotcon_representation_create(&repr);
 	if (IOTCON_ERROR_NONE != ret) {
 		ERR("iotcon_representation_create() Fail(%d)", ret);
@@ -477,3 +1194,59 @@ iotcon_representation_h icl_representation_from_gvariant(GVariant *var)
 
 	return repr;
 }
+
+
+/* patches the attributes of repr with "(a{sv}as)", the changed attributes and the removed
+ * keys. The keys are returned in changed_keys. */
+int icl_representation_apply_delta(iotcon_representation_h repr, GVariant *var,
+		iotcon_list_h *changed_keys)
+{
+	int ret;
+	char *key;
+	GVariant *value;
+	GVariantIter iter;
+	iotcon_list_h keys;
+	GVariant *changed, *removed;
+
+	RETV_IF(NULL == repr, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(NULL == var, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(NULL == changed_keys, IOTCON_ERROR_INVALID_PARAMETER);
+
+	ret = iotcon_list_create(IOTCON_TYPE_STR, &keys);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("iotcon_list_create() Fail(%d)", ret);
+		return ret;
+	}
+
+	if (NULL == repr->state) {
+		ret = iotcon_state_create(&repr->state);
+		if (IOTCON_ERROR_NONE != ret) {
+			ERR("iotcon_state_create() Fail(%d)", ret);
+			iotcon_list_destroy(keys);
+			return ret;
+		}
+	}
+
+	changed = g_variant_get_child_value(var, 0);
+	removed = g_variant_get_child_value(var, 1);
+
+	g_variant_iter_init(&iter, changed);
+	icl_state_from_gvariant(repr->state, &iter);
+
+	g_variant_iter_init(&iter, changed);
+	while (g_variant_iter_loop(&iter, "{sv}", &key, &value))
+		iotcon_list_add_str(keys, key, -1);
+
+	g_variant_iter_init(&iter, removed);
+	while (g_variant_iter_loop(&iter, "s", &key)) {
+		g_hash_table_remove(repr->state->hash_table, key);
+		iotcon_list_add_str(keys, key, -1);
+	}
+
+	g_variant_unref(removed);
+	g_variant_unref(changed);
+
+	*changed_keys = keys;
+
+	return IOTCON_ERROR_NONE;
+}
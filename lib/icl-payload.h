@@ -20,6 +20,10 @@
 
 void icl_state_from_gvariant(iotcon_state_h state, GVariantIter *iter);
 GVariant* icl_representation_to_gvariant(iotcon_representation_h repr);
+GVariant* icl_representation_to_gvariant_version(iotcon_representation_h repr,
+		int wire_version);
 iotcon_representation_h icl_representation_from_gvariant(GVariant *var);
+int icl_representation_apply_delta(iotcon_representation_h repr, GVariant *var,
+		iotcon_list_h *changed_keys);
 
 #endif /*__IOT_CONNECTIVITY_MANAGER_LIBRARY_PAYLOAD_H__*/
@@ -32,13 +32,58 @@
 #include "icl-payload.h"
 #include "icl-remote-resource.h"
 
+#define ICL_REMOTE_RESOURCE_MAX_HISTORY 1024
+
 typedef struct {
 	iotcon_remote_resource_cached_representation_changed_cb cb;
+	iotcon_remote_resource_cached_representation_delta_cb delta_cb;
 	void *user_data;
 	iotcon_remote_resource_h resource;
 } icl_caching_s;
 
 
+static void _icl_caching_resync_cb(GObject *object, GAsyncResult *g_async_res,
+		gpointer user_data)
+{
+	int ret;
+	GError *error = NULL;
+	iotcon_remote_resource_h resource = user_data;
+
+	ic_dbus_call_encap_resync_caching_finish(IC_DBUS(object), &ret, g_async_res, &error);
+	if (error) {
+		ERR("ic_dbus_call_encap_resync_caching_finish() Fail(%s)", error->message);
+		g_error_free(error);
+		resource->caching_resync = false;
+	} else if (IOTCON_ERROR_NONE != ret) {
+		ERR("iotcon-daemon Fail(%d)", ret);
+		resource->caching_resync = false;
+	}
+
+	icl_remote_resource_unref(resource);
+}
+
+
+/* ask the daemon for the whole cached representation. The deltas are dropped until
+ * it arrives */
+static void _icl_caching_resync(iotcon_remote_resource_h resource)
+{
+	RET_IF(NULL == icl_dbus_get_object());
+
+	if (resource->caching_resync)
+		return;
+
+	resource->caching_resync = true;
+	icl_remote_resource_ref(resource);
+
+	ic_dbus_call_encap_resync_caching(icl_dbus_get_object(),
+			resource->uri_path,
+			resource->host_address,
+			NULL,
+			_icl_caching_resync_cb,
+			resource);
+}
+
+
 static void _icl_caching_cb(GDBusConnection *connection,
 		const gchar *sender_name,
 		const gchar *object_path,
@@ -49,26 +94,58 @@ static void _icl_caching_cb(GDBusConnection *connection,
 {
 	FN_CALL;
 	int ret;
-	iotcon_representation_h repr, cached_repr;
+	uint64_t base_digest, digest;
+	GVariant *delta, *repr_value;
+	iotcon_representation_h repr;
+	iotcon_list_h changed_keys = NULL;
 	icl_caching_s *cb_container = user_data;
-	iotcon_remote_resource_cached_representation_changed_cb cb = cb_container->cb;
-
-	repr = icl_representation_from_gvariant(parameters);
-
-	ret = iotcon_representation_clone(repr, &cached_repr);
-	if (IOTCON_ERROR_NONE != ret) {
-		ERR("iotcon_representation_clone() Fail(%d)", ret);
+	iotcon_remote_resource_h resource = cb_container->resource;
+
+	if (g_variant_is_of_type(parameters, G_VARIANT_TYPE("(tt(a{sv}as))"))) {
+		/* only the changed attributes, based on the representation of base_digest */
+		g_variant_get(parameters, "(tt@(a{sv}as))", &base_digest, &digest, &delta);
+		if (NULL == resource->cached_repr || base_digest != resource->cached_digest) {
+			WARN("Drop the delta(%llx, %llx)", base_digest, resource->cached_digest);
+			g_variant_unref(delta);
+			_icl_caching_resync(resource);
+			return;
+		}
+		ret = icl_representation_apply_delta(resource->cached_repr, delta, &changed_keys);
+		g_variant_unref(delta);
+		if (IOTCON_ERROR_NONE != ret) {
+			ERR("icl_representation_apply_delta() Fail(%d)", ret);
+			_icl_caching_resync(resource);
+			return;
+		}
+		resource->cached_digest = digest;
+	} else if (g_variant_is_of_type(parameters, G_VARIANT_TYPE("(tv)"))) {
+		g_variant_get(parameters, "(tv)", &digest, &repr_value);
+		repr = icl_representation_from_gvariant(repr_value);
+		g_variant_unref(repr_value);
+		if (NULL == repr) {
+			ERR("icl_representation_from_gvariant() Fail");
+			return;
+		}
+
+		if (resource->cached_repr)
+			iotcon_representation_destroy(resource->cached_repr);
+		resource->cached_repr = repr;
+		resource->cached_digest = digest;
+		resource->caching_resync = false;
+	} else {
+		ERR("Invalid Caching Signal(%s)", g_variant_get_type_string(parameters));
 		return;
 	}
 
-	if (cb_container->resource->cached_repr)
-		iotcon_representation_destroy(cb_container->resource->cached_repr);
-	cb_container->resource->cached_repr = cached_repr;
-
-	if (cb) {
-		cb(cb_container->resource, cb_container->resource->cached_repr,
+	if (cb_container->delta_cb) {
+		cb_container->delta_cb(resource, resource->cached_repr, changed_keys,
 				cb_container->user_data);
+	} else if (cb_container->cb) {
+		cb_container->cb(resource, resource->cached_repr, cb_container->user_data);
 	}
+
+	if (changed_keys)
+		iotcon_list_destroy(changed_keys);
 }
 
 
@@ -79,13 +156,49 @@ static void _icl_caching_conn_cleanup(icl_caching_s *cb_container)
 		cb_container->resource->cached_repr = NULL;
 	}
 	cb_container->resource->caching_sub_id = 0;
+	cb_container->resource->caching_delta = false;
+	cb_container->resource->cached_digest = 0;
+	cb_container->resource->caching_resync = false;
 	icl_remote_resource_unref(cb_container->resource);
 	free(cb_container);
 }
 
 
-API int iotcon_remote_resource_start_caching(iotcon_remote_resource_h resource,
-		iotcon_remote_resource_cached_representation_changed_cb cb, void *user_data)
+static int _icl_remote_resource_apply_history_size(iotcon_remote_resource_h resource)
+{
+	int ret;
+	GError *error = NULL;
+
+	RETV_IF(NULL == icl_dbus_get_object(), IOTCON_ERROR_DBUS);
+
+	ic_dbus_call_encap_set_history_size_sync(icl_dbus_get_object(),
+			resource->uri_path,
+			resource->host_address,
+			resource->history_size,
+			&ret,
+			NULL,
+			&error);
+	if (error) {
+		ERR("ic_dbus_call_encap_set_history_size_sync() Fail(%s)", error->message);
+		ret = icl_dbus_convert_dbus_error(error->code);
+		g_error_free(error);
+		return ret;
+	}
+
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("iotcon-daemon Fail(%d)", ret);
+		return icl_dbus_convert_daemon_error(ret);
+	}
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+static int _icl_remote_resource_start_caching(iotcon_remote_resource_h resource,
+		bool delta,
+		iotcon_remote_resource_cached_representation_changed_cb cb,
+		iotcon_remote_resource_cached_representation_delta_cb delta_cb,
+		void *user_data)
 {
 	int ret, sub_id;
 	GError *error = NULL;
@@ -93,9 +206,7 @@ API int iotcon_remote_resource_start_caching(iotcon_remote_resource_h resource,
 	icl_caching_s *cb_container;
 	char signal_name[IC_DBUS_SIGNAL_LENGTH] = {0};
 
-	RETV_IF(false == ic_utils_check_oic_feature_supported(), IOTCON_ERROR_NOT_SUPPORTED);
 	RETV_IF(NULL == icl_dbus_get_object(), IOTCON_ERROR_DBUS);
-	RETV_IF(NULL == resource, IOTCON_ERROR_INVALID_PARAMETER);
 
 	if (0 != resource->caching_sub_id) {
 		ERR("Already Start Caching");
@@ -108,6 +219,7 @@ API int iotcon_remote_resource_start_caching(iotcon_remote_resource_h resource,
 			resource->uri_path,
 			resource->host_address,
 			resource->connectivity_type,
+			delta,
 			&signal_number,
 			&ret,
 			NULL,
@@ -133,6 +245,7 @@ API int iotcon_remote_resource_start_caching(iotcon_remote_resource_h resource,
 	}
 
 	cb_container->cb = cb;
+	cb_container->delta_cb = delta_cb;
 	cb_container->user_data = user_data;
 
 	sub_id = icl_dbus_subscribe_signal(signal_name, cb_container,
@@ -143,13 +256,47 @@ API int iotcon_remote_resource_start_caching(iotcon_remote_resource_h resource,
 		return IOTCON_ERROR_DBUS;
 	}
 	resource->caching_sub_id = sub_id;
+	resource->caching_delta = delta;
 	cb_container->resource = resource;
 	icl_remote_resource_ref(resource);
 
+	if (resource->poll_min_interval) {
+		ret = icl_remote_resource_apply_poll_interval(resource);
+		if (IOTCON_ERROR_NONE != ret)
+			ERR("icl_remote_resource_apply_poll_interval() Fail(%d)", ret);
+	}
+
+	if (resource->history_size) {
+		ret = _icl_remote_resource_apply_history_size(resource);
+		if (IOTCON_ERROR_NONE != ret)
+			ERR("_icl_remote_resource_apply_history_size() Fail(%d)", ret);
+	}
+
 	return IOTCON_ERROR_NONE;
 }
 
 
+API int iotcon_remote_resource_start_caching(iotcon_remote_resource_h resource,
+		iotcon_remote_resource_cached_representation_changed_cb cb, void *user_data)
+{
+	RETV_IF(false == ic_utils_check_oic_feature_supported(), IOTCON_ERROR_NOT_SUPPORTED);
+	RETV_IF(NULL == resource, IOTCON_ERROR_INVALID_PARAMETER);
+
+	return _icl_remote_resource_start_caching(resource, false, cb, NULL, user_data);
+}
+
+
+API int iotcon_remote_resource_start_caching_delta(iotcon_remote_resource_h resource,
+		iotcon_remote_resource_cached_representation_delta_cb cb, void *user_data)
+{
+	RETV_IF(false == ic_utils_check_oic_feature_supported(), IOTCON_ERROR_NOT_SUPPORTED);
+	RETV_IF(NULL == resource, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(NULL == cb, IOTCON_ERROR_INVALID_PARAMETER);
+
+	return _icl_remote_resource_start_caching(resource, true, NULL, cb, user_data);
+}
+
+
 API int iotcon_remote_resource_stop_caching(iotcon_remote_resource_h resource)
 {
 	int ret;
@@ -169,6 +316,7 @@ API int iotcon_remote_resource_stop_caching(iotcon_remote_resource_h resource)
 	ic_dbus_call_stop_caching_sync(icl_dbus_get_object(),
 			resource->uri_path,
 			resource->host_address,
+			resource->caching_delta,
 			&ret,
 			NULL,
 			&error);
@@ -185,6 +333,7 @@ API int iotcon_remote_resource_stop_caching(iotcon_remote_resource_h resource)
 
 	icl_dbus_unsubscribe_signal(resource->caching_sub_id);
 	resource->caching_sub_id = 0;
+	resource->caching_delta = false;
 
 	return IOTCON_ERROR_NONE;
 }
@@ -208,3 +357,89 @@ API int iotcon_remote_resource_get_cached_representation(
 	return IOTCON_ERROR_NONE;
 }
 
+
+API int iotcon_remote_resource_set_cached_representation_history_size(
+		iotcon_remote_resource_h resource, unsigned int size)
+{
+	RETV_IF(false == ic_utils_check_oic_feature_supported(), IOTCON_ERROR_NOT_SUPPORTED);
+	RETV_IF(NULL == resource, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(ICL_REMOTE_RESOURCE_MAX_HISTORY < size, IOTCON_ERROR_INVALID_PARAMETER);
+
+	resource->history_size = size;
+
+	if (0 == resource->caching_sub_id || 0 == size)
+		return IOTCON_ERROR_NONE;
+
+	return _icl_remote_resource_apply_history_size(resource);
+}
+
+
+API int iotcon_remote_resource_foreach_cached_representation_history(
+		iotcon_remote_resource_h resource,
+		unsigned int count,
+		int64_t since,
+		int64_t until,
+		iotcon_remote_resource_cached_representation_history_cb cb,
+		void *user_data)
+{
+	int ret;
+	int64_t timestamp;
+	GVariant *history, *value;
+	GVariantIter iter;
+	GError *error = NULL;
+	iotcon_representation_h repr;
+
+	RETV_IF(false == ic_utils_check_oic_feature_supported(), IOTCON_ERROR_NOT_SUPPORTED);
+	RETV_IF(NULL == icl_dbus_get_object(), IOTCON_ERROR_DBUS);
+	RETV_IF(NULL == resource, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(NULL == cb, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(since < 0 || until < 0, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(until && until < since, IOTCON_ERROR_INVALID_PARAMETER);
+
+	if (0 == resource->caching_sub_id) {
+		ERR("Not Cached");
+		return IOTCON_ERROR_INVALID_PARAMETER;
+	}
+
+	ic_dbus_call_encap_get_history_sync(icl_dbus_get_object(),
+			resource->uri_path,
+			resource->host_address,
+			count,
+			since,
+			until,
+			&history,
+			&ret,
+			NULL,
+			&error);
+	if (error) {
+		ERR("ic_dbus_call_encap_get_history_sync() Fail(%s)", error->message);
+		ret = icl_dbus_convert_dbus_error(error->code);
+		g_error_free(error);
+		return ret;
+	}
+
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("iotcon-daemon Fail(%d)", ret);
+		g_variant_unref(history);
+		return icl_dbus_convert_daemon_error(ret);
+	}
+
+	g_variant_iter_init(&iter, history);
+	while (g_variant_iter_loop(&iter, "(xv)", &timestamp, &value)) {
+		repr = icl_representation_from_gvariant(value);
+		if (NULL == repr) {
+			ERR("icl_representation_from_gvariant() Fail");
+			continue;
+		}
+
+		ret = cb(resource, timestamp, repr, user_data);
+		iotcon_representation_destroy(repr);
+		if (IOTCON_FUNC_STOP == ret) {
+			g_variant_unref(value);
+			break;
+		}
+	}
+	g_variant_unref(history);
+
+	return IOTCON_ERROR_NONE;
+}
@@ -123,6 +123,18 @@ API int iotcon_remote_resource_start_monitoring(iotcon_remote_resource_h resourc
 	cb_container->resource = resource;
 	icl_remote_resource_ref(resource);
 
+	if (resource->poll_min_interval) {
+		ret = icl_remote_resource_apply_poll_interval(resource);
+		if (IOTCON_ERROR_NONE != ret)
+			ERR("icl_remote_resource_apply_poll_interval() Fail(%d)", ret);
+	}
+
+	if (resource->lost_count) {
+		ret = icl_remote_resource_apply_hysteresis(resource);
+		if (IOTCON_ERROR_NONE != ret)
+			ERR("icl_remote_resource_apply_hysteresis() Fail(%d)", ret);
+	}
+
 	return IOTCON_ERROR_NONE;
 }
 
@@ -21,6 +21,7 @@
 #include <glib.h>
 
 #include "iotcon-types.h"
+#include "iotcon-internal.h"
 #include "ic-utils.h"
 #include "icl.h"
 #include "icl-options.h"
@@ -32,10 +33,14 @@
 #include "icl-payload.h"
 
 #define ICL_REMOTE_RESOURCE_MAX_TIME_INTERVAL 3600 /* 60 min */
+#define ICL_REMOTE_RESOURCE_MIN_POLL_INTERVAL 100 /* 100 ms */
+#define ICL_REMOTE_RESOURCE_MAX_POLL_INTERVAL (ICL_REMOTE_RESOURCE_MAX_TIME_INTERVAL * 1000)
+#define ICL_REMOTE_RESOURCE_MAX_DWELL_TIME (ICL_REMOTE_RESOURCE_MAX_TIME_INTERVAL * 1000)
 
 typedef struct {
 	bool found;
 	iotcon_found_resource_cb cb;
+	iotcon_found_resource_batch_cb batch_cb;
 	void *user_data;
 	unsigned int id;
 	int timeout_id;
@@ -53,29 +58,57 @@ static void _icl_found_resource_cb(GDBusConnection *connection,
 		gpointer user_data)
 {
 	FN_CALL;
-	int connectivity_type;
-	iotcon_remote_resource_h resource;
-
+	int i, count, connectivity_type;
 	GVariant *payload;
+	GVariantIter *iter;
+	iotcon_remote_resource_h *resources;
 	icl_found_resource_s *cb_container = user_data;
-	iotcon_found_resource_cb cb = cb_container->cb;
 
 	cb_container->found = true;
 
-	g_variant_get(parameters, "(vi)", &payload, &connectivity_type);
+	g_variant_get(parameters, "(avi)", &iter, &connectivity_type);
 
-	resource = _icl_remote_resource_from_gvariant(payload, connectivity_type);
-	if (NULL == resource) {
-		ERR("icl_remote_resource_from_gvariant() Fail");
+	count = g_variant_iter_n_children(iter);
+	if (0 == count) {
+		g_variant_iter_free(iter);
 		return;
 	}
 
-	if (cb)
-		cb(resource, IOTCON_ERROR_NONE, cb_container->user_data);
+	resources = calloc(count, sizeof(iotcon_remote_resource_h));
+	if (NULL == resources) {
+		ERR("calloc() Fail(%d)", errno);
+		g_variant_iter_free(iter);
+		return;
+	}
 
-	iotcon_remote_resource_destroy(resource);
+	i = 0;
+	while (g_variant_iter_loop(iter, "v", &payload)) {
+		resources[i] = _icl_remote_resource_from_gvariant(payload, connectivity_type);
+		if (NULL == resources[i]) {
+			ERR("icl_remote_resource_from_gvariant() Fail");
+			continue;
+		}
+		i++;
+	}
+	g_variant_iter_free(iter);
+	count = i;
+
+	if (cb_container->batch_cb) {
+		if (count)
+			cb_container->batch_cb(resources, count, IOTCON_ERROR_NONE,
+					cb_container->user_data);
+	} else if (cb_container->cb) {
+		/* iotcon_find_resource() gets the resources one by one */
+		for (i = 0; i < count; i++)
+			cb_container->cb(resources[i], IOTCON_ERROR_NONE, cb_container->user_data);
+	}
+
+	for (i = 0; i < count; i++)
+		iotcon_remote_resource_destroy(resources[i]);
+	free(resources);
 }
 
+
 static gboolean _icl_timeout_find_resource(gpointer p)
 {
 	icl_found_resource_s *cb_container = p;
@@ -85,8 +118,12 @@ static gboolean _icl_timeout_find_resource(gpointer p)
 		return G_SOURCE_REMOVE;
 	}
 
-	if (false == cb_container->found && cb_container->cb)
-		cb_container->cb(NULL, IOTCON_ERROR_TIMEOUT, cb_container->user_data);
+	if (false == cb_container->found) {
+		if (cb_container->batch_cb)
+			cb_container->batch_cb(NULL, 0, IOTCON_ERROR_TIMEOUT, cb_container->user_data);
+		else if (cb_container->cb)
+			cb_container->cb(NULL, IOTCON_ERROR_TIMEOUT, cb_container->user_data);
+	}
 	cb_container->timeout_id = 0;
 
 	icl_dbus_unsubscribe_signal(cb_container->id);
@@ -106,11 +143,12 @@ static void _icl_find_resource_conn_cleanup(icl_found_resource_s *cb_container)
 
 /* The length of resource_type should be less than or equal to 61.
  * If resource_type is NULL, then All resources in host are discovered. */
-API int iotcon_find_resource(const char *host_address,
+static int _icl_find_resource(const char *host_address,
 		iotcon_connectivity_type_e connectivity_type,
 		const char *resource_type,
 		bool is_secure,
 		iotcon_found_resource_cb cb,
+		iotcon_found_resource_batch_cb batch_cb,
 		void *user_data)
 {
 	int ret, timeout;
@@ -122,7 +160,7 @@ API int iotcon_find_resource(const char *host_address,
 
 	RETV_IF(false == ic_utils_check_oic_feature_supported(), IOTCON_ERROR_NOT_SUPPORTED);
 	RETV_IF(NULL == icl_dbus_get_object(), IOTCON_ERROR_DBUS);
-	RETV_IF(NULL == cb, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(NULL == cb && NULL == batch_cb, IOTCON_ERROR_INVALID_PARAMETER);
 	if (resource_type && (ICL_RESOURCE_TYPE_LENGTH_MAX < strlen(resource_type))) {
 		ERR("The length of resource_type(%s) is invalid", resource_type);
 		return IOTCON_ERROR_INVALID_PARAMETER;
@@ -162,6 +200,7 @@ API int iotcon_find_resource(const char *host_address,
 	}
 
 	cb_container->cb = cb;
+	cb_container->batch_cb = batch_cb;
 	cb_container->user_data = user_data;
 
 	sub_id = icl_dbus_subscribe_signal(signal_name, cb_container,
@@ -179,6 +218,35 @@ API int iotcon_find_resource(const char *host_address,
 	return ret;
 }
 
+
+API int iotcon_find_resource(const char *host_address,
+		iotcon_connectivity_type_e connectivity_type,
+		const char *resource_type,
+		bool is_secure,
+		iotcon_found_resource_cb cb,
+		void *user_data)
+{
+	RETV_IF(NULL == cb, IOTCON_ERROR_INVALID_PARAMETER);
+
+	return _icl_find_resource(host_address, connectivity_type, resource_type, is_secure,
+			cb, NULL, user_data);
+}
+
+
+/* Resources of one device are delivered to the cb at once. */
+API int iotcon_find_resource_batch(const char *host_address,
+		iotcon_connectivity_type_e connectivity_type,
+		const char *resource_type,
+		bool is_secure,
+		iotcon_found_resource_batch_cb cb,
+		void *user_data)
+{
+	RETV_IF(NULL == cb, IOTCON_ERROR_INVALID_PARAMETER);
+
+	return _icl_find_resource(host_address, connectivity_type, resource_type, is_secure,
+			NULL, cb, user_data);
+}
+
 /* If you know the information of resource, then you can make a proxy of the resource. */
 API int iotcon_remote_resource_create(const char *host_address,
 		iotcon_connectivity_type_e connectivity_type,
@@ -585,3 +653,115 @@ API int iotcon_remote_resource_set_time_interval(int time_interval)
 	return IOTCON_ERROR_NONE;
 }
 
+
+int icl_remote_resource_apply_poll_interval(iotcon_remote_resource_h resource)
+{
+	int ret;
+	GError *error = NULL;
+
+	RETV_IF(NULL == icl_dbus_get_object(), IOTCON_ERROR_DBUS);
+
+	ic_dbus_call_encap_set_poll_interval_sync(icl_dbus_get_object(),
+			resource->uri_path,
+			resource->host_address,
+			resource->poll_min_interval,
+			resource->poll_max_interval,
+			&ret,
+			NULL,
+			&error);
+	if (error) {
+		ERR("ic_dbus_call_encap_set_poll_interval_sync() Fail(%s)", error->message);
+		ret = icl_dbus_convert_dbus_error(error->code);
+		g_error_free(error);
+		return ret;
+	}
+
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("iotcon-daemon Fail(%d)", ret);
+		return icl_dbus_convert_daemon_error(ret);
+	}
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+/* min_interval 0 means the global time interval */
+API int iotcon_remote_resource_set_poll_interval(iotcon_remote_resource_h resource,
+		unsigned int min_interval, unsigned int max_interval)
+{
+	RETV_IF(false == ic_utils_check_oic_feature_supported(), IOTCON_ERROR_NOT_SUPPORTED);
+	RETV_IF(NULL == resource, IOTCON_ERROR_INVALID_PARAMETER);
+	if (min_interval) {
+		RETV_IF(min_interval < ICL_REMOTE_RESOURCE_MIN_POLL_INTERVAL,
+				IOTCON_ERROR_INVALID_PARAMETER);
+		RETV_IF(ICL_REMOTE_RESOURCE_MAX_POLL_INTERVAL < max_interval,
+				IOTCON_ERROR_INVALID_PARAMETER);
+		RETV_IF(max_interval < min_interval, IOTCON_ERROR_INVALID_PARAMETER);
+	}
+
+	resource->poll_min_interval = min_interval;
+	resource->poll_max_interval = min_interval ? max_interval : 0;
+
+	if (0 == resource->caching_sub_id && 0 == resource->monitoring_sub_id)
+		return IOTCON_ERROR_NONE;
+
+	return icl_remote_resource_apply_poll_interval(resource);
+}
+
+
+int icl_remote_resource_apply_hysteresis(iotcon_remote_resource_h resource)
+{
+	int ret;
+	GError *error = NULL;
+
+	RETV_IF(NULL == icl_dbus_get_object(), IOTCON_ERROR_DBUS);
+
+	ic_dbus_call_encap_set_hysteresis_sync(icl_dbus_get_object(),
+			resource->uri_path,
+			resource->host_address,
+			resource->lost_count,
+			resource->alive_count,
+			resource->dwell_time,
+			&ret,
+			NULL,
+			&error);
+	if (error) {
+		ERR("ic_dbus_call_encap_set_hysteresis_sync() Fail(%s)", error->message);
+		ret = icl_dbus_convert_dbus_error(error->code);
+		g_error_free(error);
+		return ret;
+	}
+
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("iotcon-daemon Fail(%d)", ret);
+		return icl_dbus_convert_daemon_error(ret);
+	}
+
+	return IOTCON_ERROR_NONE;
+}
+
+
+/* lost_count 0 means the default hysteresis */
+API int iotcon_remote_resource_set_monitoring_hysteresis(
+		iotcon_remote_resource_h resource,
+		unsigned int lost_count,
+		unsigned int alive_count,
+		unsigned int dwell_time)
+{
+	RETV_IF(false == ic_utils_check_oic_feature_supported(), IOTCON_ERROR_NOT_SUPPORTED);
+	RETV_IF(NULL == resource, IOTCON_ERROR_INVALID_PARAMETER);
+	if (lost_count) {
+		RETV_IF(0 == alive_count, IOTCON_ERROR_INVALID_PARAMETER);
+		RETV_IF(ICL_REMOTE_RESOURCE_MAX_DWELL_TIME < dwell_time,
+				IOTCON_ERROR_INVALID_PARAMETER);
+	}
+
+	resource->lost_count = lost_count;
+	resource->alive_count = lost_count ? alive_count : 0;
+	resource->dwell_time = lost_count ? dwell_time : 0;
+
+	if (0 == resource->monitoring_sub_id)
+		return IOTCON_ERROR_NONE;
+
+	return icl_remote_resource_apply_hysteresis(resource);
+}
@@ -43,11 +43,22 @@ struct icl_remote_resource {
 	unsigned int observe_sub_id;
 	unsigned int monitoring_sub_id;
 	unsigned int caching_sub_id;
+	bool caching_delta;
 	iotcon_representation_h cached_repr;
+	uint64_t cached_digest; /* the digest of cached_repr in the daemon */
+	bool caching_resync; /* encapResyncCaching is in progress */
+	unsigned int poll_min_interval; /* ms, 0 : global time interval */
+	unsigned int poll_max_interval; /* ms */
+	unsigned int lost_count; /* 0 : the default hysteresis */
+	unsigned int alive_count;
+	unsigned int dwell_time; /* ms */
+	unsigned int history_size; /* 0 : no history */
 };
 
 void icl_remote_resource_ref(iotcon_remote_resource_h resource);
 void icl_remote_resource_unref(iotcon_remote_resource_h resource);
 void icl_remote_resource_crud_stop(iotcon_remote_resource_h resource);
+int icl_remote_resource_apply_poll_interval(iotcon_remote_resource_h resource);
+int icl_remote_resource_apply_hysteresis(iotcon_remote_resource_h resource);
 
 #endif /* __IOT_CONNECTIVITY_MANAGER_LIBRARY_CLIENT_H__ */
@@ -621,14 +621,25 @@ API int iotcon_resource_notify(iotcon_resource_h resource,
 	else
 		obs = icl_dbus_observers_to_gvariant(resource->observers);
 
+	g_variant_ref_sink(repr_gvar);
+	g_variant_ref_sink(obs);
+
+	/* the high-rate notifications skip D-Bus, if the ring is not full */
+	ret = icl_dbus_ring_notify(resource->handle, repr_gvar, obs, qos);
+	if (IOTCON_ERROR_NONE == ret) {
+		g_variant_unref(obs);
+		g_variant_unref(repr_gvar);
+		return IOTCON_ERROR_NONE;
+	}
+
 	ic_dbus_call_notify_sync(icl_dbus_get_object(), resource->handle, repr_gvar, obs, qos,
 			&ret, NULL, &error);
+	g_variant_unref(obs);
+	g_variant_unref(repr_gvar);
 	if (error) {
 		ERR("ic_dbus_call_notify_sync() Fail(%s)", error->message);
 		ret = icl_dbus_convert_dbus_error(error->code);
 		g_error_free(error);
-		g_variant_unref(obs);
-		g_variant_unref(repr_gvar);
 		return ret;
 	}
 
@@ -17,6 +17,7 @@
 #include <glib.h>
 
 #include "iotcon-types.h"
+#include "iotcon-internal.h"
 #include "ic-utils.h"
 #include "icl.h"
 #include "icl-list.h"
@@ -306,10 +307,34 @@ API int iotcon_state_get_byte_str(iotcon_state_h state, const char *key,
 		return IOTCON_ERROR_INVALID_TYPE;
 	}
 
-	*val = real->s;
-	*len = real->len;
+	return icl_value_get_byte_str(value, val, len);
+}
 
-	return IOTCON_ERROR_NONE;
+API int iotcon_state_get_byte_str_readonly(iotcon_state_h state, const char *key,
+		const unsigned char **val, int *len)
+{
+	iotcon_value_h value = NULL;
+	icl_val_byte_str_s *real = NULL;
+
+	RETV_IF(false == ic_utils_check_oic_feature_supported(), IOTCON_ERROR_NOT_SUPPORTED);
+	RETV_IF(NULL == state, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(NULL == key, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(NULL == val, IOTCON_ERROR_INVALID_PARAMETER);
+	RETV_IF(NULL == len, IOTCON_ERROR_INVALID_PARAMETER);
+
+	value = g_hash_table_lookup(state->hash_table, key);
+	if (NULL == value) {
+		ERR("g_hash_table_lookup() Fail");
+		return IOTCON_ERROR_NO_DATA;
+	}
+
+	real = (icl_val_byte_str_s*)value;
+	if (IOTCON_TYPE_BYTE_STR != real->type) {
+		ERR("Invalid Type(%d)", real->type);
+		return IOTCON_ERROR_INVALID_TYPE;
+	}
+
+	return icl_value_get_byte_str_readonly(value, val, len);
 }
 
 API int iotcon_state_add_byte_str(iotcon_state_h state, const char *key,
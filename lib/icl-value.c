@@ -16,10 +16,12 @@
 
 #include <stdlib.h>
 #include <errno.h>
+#include <unistd.h>
 
 #include "iotcon-types.h"
 #include "iotcon-representation.h"
 #include "ic-utils.h"
+#include "ic-blob.h"
 #include "icl.h"
 #include "icl-representation.h"
 #include "icl-list.h"
@@ -159,6 +161,34 @@ iotcon_value_h icl_value_create_byte_str(const unsigned char *val, int len)
 	}
 	memcpy(value->s, val, len);
 	value->len = len;
+	value->fd = -1;
+
+	return (iotcon_value_h)value;
+}
+
+
+/* The bytes are not copied, but mapped. The fd is owned by the value, even if it fails. */
+iotcon_value_h icl_value_create_byte_str_blob(int fd, int len)
+{
+	int ret;
+	icl_val_byte_str_s *value;
+
+	value = (icl_val_byte_str_s*)_icl_value_create(IOTCON_TYPE_BYTE_STR);
+	if (NULL == value) {
+		ERR("_icl_value_create(BYTE STRING) Fail");
+		close(fd);
+		return NULL;
+	}
+
+	ret = ic_blob_map(fd, len, &value->map);
+	if (IOTCON_ERROR_NONE != ret) {
+		ERR("ic_blob_map() Fail(%d)", ret);
+		close(fd);
+		free(value);
+		return NULL;
+	}
+	value->len = len;
+	value->fd = fd;
 
 	return (iotcon_value_h)value;
 }
@@ -255,6 +285,16 @@ int icl_value_get_byte_str(iotcon_value_h value, unsigned char **val, int *len)
 	RETVM_IF(IOTCON_TYPE_BYTE_STR != real->type, IOTCON_ERROR_INVALID_PARAMETER,
 			"Invalid Type(%d)", real->type);
 
+	/* the caller could write to the bytes */
+	if (NULL == real->s && real->map) {
+		real->s = calloc(real->len, sizeof(unsigned char));
+		if (NULL == real->s) {
+			ERR("calloc() Fail(%d)", errno);
+			return IOTCON_ERROR_OUT_OF_MEMORY;
+		}
+		memcpy(real->s, real->map, real->len);
+	}
+
 	*val = real->s;
 	*len = real->len;
 
@@ -262,6 +302,22 @@ int icl_value_get_byte_str(iotcon_value_h value, unsigned char **val, int *len)
 }
 
 
+int icl_value_get_byte_str_readonly(iotcon_value_h value, const unsigned char **val,
+		int *len)
+{
+	icl_val_byte_str_s *real = (icl_val_byte_str_s*)value;
+
+	RETV_IF(NULL == value, IOTCON_ERROR_INVALID_PARAMETER);
+	RETVM_IF(IOTCON_TYPE_BYTE_STR != real->type, IOTCON_ERROR_INVALID_PARAMETER,
+			"Invalid Type(%d)", real->type);
+
+	*val = real->map ? real->map : real->s;
+	*len = real->len;
+
+	return IOTCON_ERROR_NONE;
+}
+
+
 int icl_value_get_list(iotcon_value_h value, iotcon_list_h *list)
 {
 	icl_val_list_s *real = (icl_val_list_s*)value;
@@ -311,6 +367,9 @@ void icl_value_destroy(gpointer data)
 		break;
 	case IOTCON_TYPE_BYTE_STR:
 		free(((icl_val_byte_str_s*)value)->s);
+		ic_blob_unmap(((icl_val_byte_str_s*)value)->map, ((icl_val_byte_str_s*)value)->len);
+		if (0 <= ((icl_val_byte_str_s*)value)->fd)
+			close(((icl_val_byte_str_s*)value)->fd);
 		break;
 	case IOTCON_TYPE_LIST:
 		ret = icl_value_get_list(value, &list);
@@ -360,8 +419,13 @@ iotcon_value_h icl_value_clone(iotcon_value_h src)
 		dest = icl_value_create_null();
 		break;
 	case IOTCON_TYPE_BYTE_STR:
-		dest = icl_value_create_byte_str(((icl_val_byte_str_s*)real)->s,
-				((icl_val_byte_str_s*)real)->len);
+		/* the blob is shared, not copied */
+		if (0 <= ((icl_val_byte_str_s*)real)->fd)
+			dest = icl_value_create_byte_str_blob(dup(((icl_val_byte_str_s*)real)->fd),
+					((icl_val_byte_str_s*)real)->len);
+		else
+			dest = icl_value_create_byte_str(((icl_val_byte_str_s*)real)->s,
+					((icl_val_byte_str_s*)real)->len);
 		break;
 	case IOTCON_TYPE_LIST:
 		dest = icl_value_create_list(((icl_val_list_s*)real)->list);
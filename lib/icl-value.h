@@ -36,8 +36,10 @@ typedef struct {
 
 typedef struct {
 	int type;
-	unsigned char *s;
+	unsigned char *s; /* NULL until a writable copy of the blob is needed */
 	int len;
+	int fd; /* the sealed memfd of a large byte string, or -1 */
+	const unsigned char *map; /* the read-only mapping of fd */
 } icl_val_byte_str_s;
 
 typedef struct {
@@ -76,6 +78,7 @@ iotcon_value_h icl_value_create_bool(bool val);
 iotcon_value_h icl_value_create_double(double val);
 iotcon_value_h icl_value_create_str(const char *val);
 iotcon_value_h icl_value_create_byte_str(const unsigned char *val, int len);
+iotcon_value_h icl_value_create_byte_str_blob(int fd, int len);
 iotcon_value_h icl_value_create_list(iotcon_list_h val);
 iotcon_value_h icl_value_create_state(iotcon_state_h val);
 
@@ -85,6 +88,8 @@ int icl_value_get_bool(iotcon_value_h value, bool *val);
 int icl_value_get_double(iotcon_value_h value, double *val);
 int icl_value_get_str(iotcon_value_h value, char **val);
 int icl_value_get_byte_str(iotcon_value_h value, unsigned char **val, int *len);
+int icl_value_get_byte_str_readonly(iotcon_value_h value, const unsigned char **val,
+		int *len);
 int icl_value_get_list(iotcon_value_h value, iotcon_list_h *list);
 int icl_value_get_state(iotcon_value_h value, iotcon_state_h *state);
 
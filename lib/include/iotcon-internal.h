@@ -16,6 +16,9 @@
 #ifndef __IOT_CONNECTIVITY_MANAGER_INTERNAL_H__
 #define __IOT_CONNECTIVITY_MANAGER_INTERNAL_H__
 
+#include <iotcon-types.h>
+#include <iotcon-errors.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -118,6 +121,319 @@ int iotcon_remote_resource_get_time_interval(int *time_interval);
  */
 int iotcon_remote_resource_set_time_interval(int time_interval);
 
+/**
+ * @brief Sets the adaptive poll interval of monitoring & caching API of the remote resource.
+ * @details The GET method of iotcon_remote_resource_start_monitoring() and
+ * iotcon_remote_resource_start_caching() for @a resource starts at @a min_interval.\n
+ * The interval is doubled up to @a max_interval while the resource is not changed,
+ * and returns to @a min_interval when it is changed or its signal is lost.\n
+ * If @a min_interval is 0, the time interval of iotcon_remote_resource_set_time_interval()
+ * is used.
+ *
+ * @since_tizen 3.0
+ *
+ * @remarks The interval is shared by all clients which monitor or cache the same resource.
+ *
+ * @param[in] resource The handle of the remote resource
+ * @param[in] min_interval Milliseconds for minimum interval (must be 0, or from 100)
+ * @param[in] max_interval Milliseconds for maximum interval (must be in range from
+ * @a min_interval to 3600000)
+ *
+ * @return 0 on success, otherwise a negative error value.
+ * @retval #IOTCON_ERROR_NONE Successful
+ * @retval #IOTCON_ERROR_NOT_SUPPORTED  Not supported
+ * @retval #IOTCON_ERROR_INVALID_PARAMETER Invalid parameter
+ * @retval #IOTCON_ERROR_DBUS  Dbus error
+ *
+ * @see iotcon_remote_resource_set_time_interval()
+ * @see iotcon_remote_resource_start_monitoring()
+ * @see iotcon_remote_resource_start_caching()
+ */
+int iotcon_remote_resource_set_poll_interval(iotcon_remote_resource_h resource,
+		unsigned int min_interval, unsigned int max_interval);
+
+/**
+ * @brief Sets the hysteresis of monitoring API of the remote resource.
+ * @details The state of @a resource changes to
+ * #IOTCON_REMOTE_RESOURCE_LOST_SIGNAL after @a lost_count failures in a row, and back to
+ * #IOTCON_REMOTE_RESOURCE_ALIVE after @a alive_count successes in a row.
+ * In any case, the state is kept for @a dwell_time at least.\n
+ * While a change is pending, the resource is polled every second.\n
+ * If @a lost_count is 0, the default values 3, 2 and 3000 are used.
+ *
+ * @since_tizen 3.0
+ *
+ * @remarks The hysteresis is shared by all clients which monitor the same resource.
+ *
+ * @param[in] resource The handle of the remote resource
+ * @param[in] lost_count The number of failures until the signal is lost (0 for the
+ * default values)
+ * @param[in] alive_count The number of successes until alive (must be from 1)
+ * @param[in] dwell_time Milliseconds for the minimum time in a state (must be in range
+ * from 0 to 3600000)
+ *
+ * @return 0 on success, otherwise a negative error value.
+ * @retval #IOTCON_ERROR_NONE Successful
+ * @retval #IOTCON_ERROR_NOT_SUPPORTED  Not supported
+ * @retval #IOTCON_ERROR_INVALID_PARAMETER Invalid parameter
+ * @retval #IOTCON_ERROR_DBUS  Dbus error
+ *
+ * @see iotcon_remote_resource_start_monitoring()
+ */
+int iotcon_remote_resource_set_monitoring_hysteresis(
+		iotcon_remote_resource_h resource,
+		unsigned int lost_count,
+		unsigned int alive_count,
+		unsigned int dwell_time);
+
+/**
+ * @brief Specifies the type of function passed to
+ * iotcon_remote_resource_start_caching_delta().
+ *
+ * @since_tizen 3.0
+ *
+ * @remarks @a changed_keys is NULL, if the whole representation is replaced.\n
+ * Otherwise it holds the keys of the added, changed and removed attributes. A key is
+ * removed, if it is not in the state of @a representation any more.\n
+ * @a changed_keys is released after the callback returns.
+ *
+ * @param[in] resource The handle of the remote resource
+ * @param[in] representation The handle of the cached representation
+ * @param[in] changed_keys The list of the changed keys (#IOTCON_TYPE_STR)
+ * @param[in] user_data The user data to pass to the function
+ *
+ * @pre The callback must be registered using iotcon_remote_resource_start_caching_delta()
+ *
+ * @see iotcon_remote_resource_start_caching_delta()
+ * @see iotcon_remote_resource_stop_caching()
+ */
+typedef void (*iotcon_remote_resource_cached_representation_delta_cb)(
+		iotcon_remote_resource_h resource,
+		iotcon_representation_h representation,
+		iotcon_list_h changed_keys,
+		void *user_data);
+
+/**
+ * @brief Starts caching of a remote resource, receiving only the changed attributes.
+ * @details Works as iotcon_remote_resource_start_caching(), but once the whole
+ * representation is cached, iotcon-daemon sends only the added, changed and removed
+ * attributes. The cached representation is patched in place.\n
+ * Use iotcon_remote_resource_stop_caching() to stop caching.
+ *
+ * @since_tizen 3.0
+ * @privlevel public
+ * @privilege %http://tizen.org/privilege/network.get
+ * @privilege %http://tizen.org/privilege/d2d.datasharing
+ *
+ * @param[in] resource The handle of the remote resource
+ * @param[in] cb The callback function to add into callback list
+ * @param[in] user_data The user data to pass to the callback function
+ *
+ * @return 0 on success, otherwise a negative error value.
+ * @retval #IOTCON_ERROR_NONE  Successful
+ * @retval #IOTCON_ERROR_NOT_SUPPORTED  Not supported
+ * @retval #IOTCON_ERROR_INVALID_PARAMETER  Invalid parameter
+ * @retval #IOTCON_ERROR_ALREADY  Already done
+ * @retval #IOTCON_ERROR_DBUS  Dbus error
+ * @retval #IOTCON_ERROR_PERMISSION_DENIED Permission denied
+ *
+ * @post iotcon_remote_resource_cached_representation_delta_cb() will be invoked.
+ * @see iotcon_remote_resource_stop_caching()
+ * @see iotcon_remote_resource_get_cached_representation()
+ */
+int iotcon_remote_resource_start_caching_delta(iotcon_remote_resource_h resource,
+		iotcon_remote_resource_cached_representation_delta_cb cb, void *user_data);
+
+/**
+ * @brief Sets the size of the history of the cached representation.
+ * @details iotcon-daemon keeps the last @a size cached representations of @a resource
+ * with their timestamps, while it is cached.\n
+ * The history is read with iotcon_remote_resource_foreach_cached_representation_history().
+ *
+ * @since_tizen 3.0
+ *
+ * @remarks The history is shared by all clients which cache the same resource.
+ * It keeps the largest size of the clients, and is cleared when the last client stops
+ * caching.
+ *
+ * @param[in] resource The handle of the remote resource
+ * @param[in] size The number of the representations to keep (must be in range from 0 to
+ * 1024). 0 means no history.
+ *
+ * @return 0 on success, otherwise a negative error value.
+ * @retval #IOTCON_ERROR_NONE Successful
+ * @retval #IOTCON_ERROR_NOT_SUPPORTED  Not supported
+ * @retval #IOTCON_ERROR_INVALID_PARAMETER Invalid parameter
+ * @retval #IOTCON_ERROR_DBUS  Dbus error
+ *
+ * @see iotcon_remote_resource_start_caching()
+ * @see iotcon_remote_resource_foreach_cached_representation_history()
+ */
+int iotcon_remote_resource_set_cached_representation_history_size(
+		iotcon_remote_resource_h resource, unsigned int size);
+
+/**
+ * @brief Specifies the type of function passed to
+ * iotcon_remote_resource_foreach_cached_representation_history().
+ *
+ * @since_tizen 3.0
+ *
+ * @remarks @a representation is released after the callback returns.
+ *
+ * @param[in] resource The handle of the remote resource
+ * @param[in] timestamp Milliseconds since the Epoch, when @a representation was cached
+ * @param[in] representation The handle of the cached representation
+ * @param[in] user_data The user data to pass to the function
+ *
+ * @return true to continue with the next iteration of the loop,
+ * otherwise false to break out of the loop. #IOTCON_FUNC_CONTINUE and #IOTCON_FUNC_STOP
+ * are more friendly values for the return.
+ *
+ * @pre iotcon_remote_resource_foreach_cached_representation_history() will invoke this
+ * callback function.
+ *
+ * @see iotcon_remote_resource_foreach_cached_representation_history()
+ */
+typedef bool (*iotcon_remote_resource_cached_representation_history_cb)(
+		iotcon_remote_resource_h resource,
+		int64_t timestamp,
+		iotcon_representation_h representation,
+		void *user_data);
+
+/**
+ * @brief Gets the history of the cached representation.
+ * @details Invokes @a cb for the last @a count representations cached from @a since to
+ * @a until, the oldest first.
+ *
+ * @since_tizen 3.0
+ * @privlevel public
+ * @privilege %http://tizen.org/privilege/network.get
+ * @privilege %http://tizen.org/privilege/d2d.datasharing
+ *
+ * @param[in] resource The handle of the remote resource
+ * @param[in] count The maximum number of the representations. 0 means no limit.
+ * @param[in] since Milliseconds since the Epoch. 0 means no lower bound.
+ * @param[in] until Milliseconds since the Epoch. 0 means no upper bound.
+ * @param[in] cb The callback function to invoke
+ * @param[in] user_data The user data to pass to the function
+ *
+ * @return 0 on success, otherwise a negative error value.
+ * @retval #IOTCON_ERROR_NONE  Successful
+ * @retval #IOTCON_ERROR_NOT_SUPPORTED  Not supported
+ * @retval #IOTCON_ERROR_INVALID_PARAMETER  Invalid parameter
+ * @retval #IOTCON_ERROR_NO_DATA  No data available
+ * @retval #IOTCON_ERROR_DBUS  Dbus error
+ * @retval #IOTCON_ERROR_PERMISSION_DENIED Permission denied
+ *
+ * @pre iotcon_remote_resource_start_caching() or
+ * iotcon_remote_resource_start_caching_delta() should be called.
+ * @post iotcon_remote_resource_cached_representation_history_cb() will be called.
+ *
+ * @see iotcon_remote_resource_set_cached_representation_history_size()
+ */
+int iotcon_remote_resource_foreach_cached_representation_history(
+		iotcon_remote_resource_h resource,
+		unsigned int count,
+		int64_t since,
+		int64_t until,
+		iotcon_remote_resource_cached_representation_history_cb cb,
+		void *user_data);
+
+/**
+ * @brief Gets the byte string value from the given key, without copying it.
+ * @details A large byte string from iotcon-daemon is mapped read-only from the memory
+ * shared with the daemon. iotcon_state_get_byte_str() makes a writable copy of it.
+ *
+ * @since_tizen 3.0
+ *
+ * @remarks @a val must not be released using free(), and must not be written.
+ * It is valid until the value of @a key is changed or @a state is destroyed.
+ *
+ * @param[in] state The state handle
+ * @param[in] key The key
+ * @param[out] val The byte string value
+ * @param[out] len The length of @a val
+ *
+ * @return 0 on success, otherwise a negative error value.
+ * @retval #IOTCON_ERROR_NONE  Successful
+ * @retval #IOTCON_ERROR_NOT_SUPPORTED  Not supported
+ * @retval #IOTCON_ERROR_INVALID_PARAMETER  Invalid parameter
+ * @retval #IOTCON_ERROR_NO_DATA  No data available
+ * @retval #IOTCON_ERROR_INVALID_TYPE  Invalid type
+ *
+ * @see iotcon_state_get_byte_str()
+ */
+int iotcon_state_get_byte_str_readonly(iotcon_state_h state, const char *key,
+		const unsigned char **val, int *len);
+
+/**
+ * @brief Specifies the type of function passed to iotcon_find_resource_batch().
+ * @details Called when resources are found from the remote server.
+ * All resources which one server returns in a response are passed at once.
+ * The @a result could be one of #iotcon_error_e.
+ *
+ * @since_tizen 3.0
+ *
+ * @remarks The handles in @a resources are valid only in this function.
+ * To use one of them outside this function, copy it by calling iotcon_remote_resource_clone().
+ *
+ * @param[in] resources The array of resource handles which are found
+ * @param[in] count The number of handles in @a resources
+ * @param[in] result The result code (Lesser than 0 on fail, otherwise a response result value)
+ * @param[in] user_data The user data to pass to the function
+ *
+ * @pre The callback must be registered using iotcon_find_resource_batch()
+ *
+ * @see iotcon_find_resource_batch()
+ */
+typedef void (*iotcon_found_resource_batch_cb)(iotcon_remote_resource_h *resources,
+		int count, iotcon_error_e result, void *user_data);
+
+/**
+ * @brief Finds resources, asynchronously.
+ * @details Same as iotcon_find_resource(), except that all resources of a server are
+ * delivered to iotcon_found_resource_batch_cb() at once, instead of calling the callback
+ * for each resource.\n
+ * @a host_address could be #IOTCON_MULTICAST_ADDRESS for multicast.
+ *
+ * @since_tizen 3.0
+ * @privlevel public
+ * @privilege %http://tizen.org/privilege/network.get
+ * @privilege %http://tizen.org/privilege/d2d.datasharing
+ *
+ * @remarks The length of @a resource_type should be less than or equal to 61.\n
+ * The @a resource_type must start with a lowercase alphabetic character, followed by a sequence
+ * of lowercase alphabetic, numeric, ".", or "-" characters, and contains no white space.\n
+ *
+ * @param[in] host_address The address or addressable name of server
+ * @param[in] connectivity_type The connectivity type
+ * @param[in] resource_type The resource type specified as a filter for the resource
+ * @param[in] is_secure The flag for secure communication with the server
+ * @param[in] cb The callback function to invoke
+ * @param[in] user_data The user data to pass to the function
+ *
+ * @return 0 on success, otherwise a negative error value.
+ * @retval #IOTCON_ERROR_NONE  Successful
+ * @retval #IOTCON_ERROR_NOT_SUPPORTED  Not supported
+ * @retval #IOTCON_ERROR_INVALID_PARAMETER  Invalid parameter
+ * @retval #IOTCON_ERROR_DBUS  Dbus error
+ * @retval #IOTCON_ERROR_SYSTEM System error
+ * @retval #IOTCON_ERROR_PERMISSION_DENIED Permission denied
+ *
+ * @pre iotcon_connect() should be called to connect a connection to the iotcon.
+ * @post iotcon_found_resource_batch_cb() will be invoked.
+ *
+ * @see iotcon_found_resource_batch_cb()
+ * @see iotcon_find_resource()
+ * @see iotcon_set_timeout()
+ */
+int iotcon_find_resource_batch(const char *host_address,
+		iotcon_connectivity_type_e connectivity_type,
+		const char *resource_type,
+		bool is_secure,
+		iotcon_found_resource_batch_cb cb,
+		void *user_data);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,459 @@
+/*
+ * Copyright (c) 2015 Samsung Electronics Co., Ltd All Rights Reserved
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Compares the wire formats of representations (see common/ic-wire.h) :
+ * the serialized size, the encoding time and the decoding time of typical sensor
+ * representations. It does not need the daemon.
+ *
+ * The encoding builds the GVariant and serializes it, as D-Bus does.
+ * The decoding starts from the untrusted bytes, and reads every value.
+ *
+ *  $ /usr/bin/iotcon-test-wire-bench [iterations]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <glib.h>
+
+#include <iotcon-errors.h>
+
+#include "ic-wire.h"
+
+#define BENCH_ITERATIONS 20000
+#define BENCH_MAX_LIST 64
+#define BENCH_MAX_ATTRS 8
+#define BENCH_MAX_CHILDREN 8
+
+enum {
+	BENCH_BOOL,
+	BENCH_INT,
+	BENCH_DOUBLE,
+	BENCH_STR,
+	BENCH_DOUBLE_LIST,
+};
+
+typedef struct {
+	const char *key;
+	int type;
+	bool b;
+	int i;
+	double d;
+	const char *s;
+	int n_list;
+	double list[BENCH_MAX_LIST];
+} bench_attr_s;
+
+typedef struct bench_node {
+	const char *uri_path;
+	const char *iface;
+	const char *type;
+	int n_attrs;
+	bench_attr_s attrs[BENCH_MAX_ATTRS];
+	int n_children;
+	struct bench_node *children[BENCH_MAX_CHILDREN];
+} bench_node_s;
+
+static bench_node_s bench_temperature = {
+	"/a/temperature", "oic.if.s", "oic.r.temperature", 4, {
+		{ .key = "temperature", .type = BENCH_DOUBLE, .d = 23.5 },
+		{ .key = "units", .type = BENCH_STR, .s = "C" },
+		{ .key = "range", .type = BENCH_DOUBLE_LIST, .n_list = 2, .list = { -40.0, 125.0 } },
+		{ .key = "step", .type = BENCH_DOUBLE, .d = 0.1 },
+	},
+};
+
+static bench_node_s bench_humidity = {
+	"/a/humidity", "oic.if.s", "oic.r.humidity", 2, {
+		{ .key = "humidity", .type = BENCH_INT, .i = 41 },
+		{ .key = "desiredHumidity", .type = BENCH_INT, .i = 45 },
+	},
+};
+
+static bench_node_s bench_light = {
+	"/a/light", "oic.if.a", "oic.r.switch.binary", 3, {
+		{ .key = "value", .type = BENCH_BOOL, .b = true },
+		{ .key = "brightness", .type = BENCH_INT, .i = 80 },
+		{ .key = "color", .type = BENCH_STR, .s = "ffffff" },
+	},
+};
+
+static bench_node_s bench_motion = {
+	"/a/motion", "oic.if.s", "oic.r.sensor.motion", 1, {
+		{ .key = "value", .type = BENCH_BOOL, .b = false },
+	},
+};
+
+static bench_node_s bench_co2 = {
+	"/a/co2", "oic.if.s", "oic.r.sensor.carbondioxide", 3, {
+		{ .key = "value", .type = BENCH_BOOL, .b = false },
+		{ .key = "co2level", .type = BENCH_DOUBLE, .d = 412.0 },
+		{ .key = "units", .type = BENCH_STR, .s = "ppm" },
+	},
+};
+
+static bench_node_s bench_room = {
+	"/a/room", "oic.if.b", "oic.wk.col", 1, {
+		{ .key = "name", .type = BENCH_STR, .s = "living room" },
+	}, 5, { &bench_temperature, &bench_humidity, &bench_light, &bench_motion, &bench_co2 },
+};
+
+static bench_node_s bench_accel = {
+	"/a/acceleration", "oic.if.s", "oic.r.sensor.acceleration", 2, {
+		{ .key = "units", .type = BENCH_STR, .s = "g" },
+		{ .key = "samples", .type = BENCH_DOUBLE_LIST, .n_list = BENCH_MAX_LIST },
+	},
+};
+
+
+/* the layout of IC_WIRE_VERSION_1 : "(sasasa{sv}av)" */
+static GVariant* _bench_v1_encode(bench_node_s *node)
+{
+	int i, j;
+	GVariant *value;
+	bench_attr_s *attr;
+	GVariantBuilder ifaces, types, state, children, list;
+
+	g_variant_builder_init(&ifaces, G_VARIANT_TYPE("as"));
+	g_variant_builder_add(&ifaces, "s", node->iface);
+	g_variant_builder_init(&types, G_VARIANT_TYPE("as"));
+	g_variant_builder_add(&types, "s", node->type);
+
+	g_variant_builder_init(&state, G_VARIANT_TYPE("a{sv}"));
+	for (i = 0; i < node->n_attrs; i++) {
+		attr = &node->attrs[i];
+		switch (attr->type) {
+		case BENCH_BOOL:
+			value = g_variant_new_boolean(attr->b);
+			break;
+		case BENCH_INT:
+			value = g_variant_new_int32(attr->i);
+			break;
+		case BENCH_DOUBLE:
+			value = g_variant_new_double(attr->d);
+			break;
+		case BENCH_STR:
+			value = g_variant_new_string(attr->s);
+			break;
+		case BENCH_DOUBLE_LIST:
+		default:
+			g_variant_builder_init(&list, G_VARIANT_TYPE("ad"));
+			for (j = 0; j < attr->n_list; j++)
+				g_variant_builder_add(&list, "d", attr->list[j]);
+			value = g_variant_builder_end(&list);
+			break;
+		}
+		g_variant_builder_add(&state, "{sv}", attr->key, value);
+	}
+
+	g_variant_builder_init(&children, G_VARIANT_TYPE("av"));
+	for (i = 0; i < node->n_children; i++)
+		g_variant_builder_add(&children, "v", _bench_v1_encode(node->children[i]));
+
+	return g_variant_new("(sasasa{sv}av)", node->uri_path, &ifaces, &types, &state,
+			&children);
+}
+
+
+static void _bench_v2_write_node(ic_wire_writer_s *writer, bench_node_s *node,
+		guint32 parent)
+{
+	int i, j;
+	bench_attr_s *attr;
+	guint32 state, first, index, list, element;
+	GVariantBuilder ifaces, types;
+
+	state = ic_wire_writer_reserve_states(writer, 1);
+	first = ic_wire_writer_reserve_attrs(writer, node->n_attrs);
+	for (i = 0; i < node->n_attrs; i++) {
+		attr = &node->attrs[i];
+		switch (attr->type) {
+		case BENCH_BOOL:
+			index = ic_wire_writer_add_bool(writer, attr->b);
+			ic_wire_writer_set_attr(writer, first + i, attr->key, IC_WIRE_BOOL, index);
+			break;
+		case BENCH_INT:
+			index = ic_wire_writer_add_int(writer, attr->i);
+			ic_wire_writer_set_attr(writer, first + i, attr->key, IC_WIRE_INT, index);
+			break;
+		case BENCH_DOUBLE:
+			index = ic_wire_writer_add_double(writer, attr->d);
+			ic_wire_writer_set_attr(writer, first + i, attr->key, IC_WIRE_DOUBLE, index);
+			break;
+		case BENCH_STR:
+			index = ic_wire_writer_add_str(writer, attr->s);
+			ic_wire_writer_set_attr(writer, first + i, attr->key, IC_WIRE_STR, index);
+			break;
+		case BENCH_DOUBLE_LIST:
+		default:
+			list = ic_wire_writer_reserve_lists(writer, 1);
+			element = 0;
+			for (j = 0; j < attr->n_list; j++) {
+				index = ic_wire_writer_add_double(writer, attr->list[j]);
+				if (0 == j)
+					element = index;
+			}
+			ic_wire_writer_set_list(writer, list, IC_WIRE_DOUBLE, element, attr->n_list);
+			ic_wire_writer_set_attr(writer, first + i, attr->key, IC_WIRE_LIST, list);
+			break;
+		}
+	}
+	ic_wire_writer_set_state(writer, state, first, node->n_attrs);
+
+	g_variant_builder_init(&ifaces, G_VARIANT_TYPE("as"));
+	g_variant_builder_add(&ifaces, "s", node->iface);
+	g_variant_builder_init(&types, G_VARIANT_TYPE("as"));
+	g_variant_builder_add(&types, "s", node->type);
+
+	index = ic_wire_writer_add_node(writer, node->uri_path,
+			g_variant_builder_end(&ifaces), g_variant_builder_end(&types), parent, state);
+
+	/* a child follows its parent */
+	for (i = 0; i < node->n_children; i++)
+		_bench_v2_write_node(writer, node->children[i], index);
+}
+
+
+static GVariant* _bench_v2_encode(bench_node_s *node)
+{
+	ic_wire_writer_s writer;
+
+	ic_wire_writer_init(&writer);
+	_bench_v2_write_node(&writer, node, IC_WIRE_NO_PARENT);
+
+	return ic_wire_writer_end(&writer);
+}
+
+
+/* Every value is read, and summed up not to be optimized out */
+static double _bench_v1_decode(GVariant *value)
+{
+	double sum = 0;
+	const char *key;
+	GVariant *attr_value, *child, *ifaces, *types;
+	GVariantIter *state_iter, *children_iter, list_iter;
+	const char *uri_path, *str;
+	double d;
+
+	g_variant_get(value, "(&s@as@asa{sv}av)", &uri_path, &ifaces, &types, &state_iter,
+			&children_iter);
+	sum += strlen(uri_path);
+	sum += g_variant_n_children(ifaces) + g_variant_n_children(types);
+	g_variant_unref(ifaces);
+	g_variant_unref(types);
+
+	while (g_variant_iter_loop(state_iter, "{&sv}", &key, &attr_value)) {
+		sum += strlen(key);
+		if (g_variant_is_of_type(attr_value, G_VARIANT_TYPE_BOOLEAN)) {
+			sum += g_variant_get_boolean(attr_value);
+		} else if (g_variant_is_of_type(attr_value, G_VARIANT_TYPE_INT32)) {
+			sum += g_variant_get_int32(attr_value);
+		} else if (g_variant_is_of_type(attr_value, G_VARIANT_TYPE_DOUBLE)) {
+			sum += g_variant_get_double(attr_value);
+		} else if (g_variant_is_of_type(attr_value, G_VARIANT_TYPE_STRING)) {
+			str = g_variant_get_string(attr_value, NULL);
+			sum += strlen(str);
+		} else if (g_variant_is_of_type(attr_value, G_VARIANT_TYPE("ad"))) {
+			g_variant_iter_init(&list_iter, attr_value);
+			while (g_variant_iter_next(&list_iter, "d", &d))
+				sum += d;
+		}
+	}
+	g_variant_iter_free(state_iter);
+
+	while (g_variant_iter_loop(children_iter, "v", &child))
+		sum += _bench_v1_decode(child);
+	g_variant_iter_free(children_iter);
+
+	return sum;
+}
+
+
+static double _bench_v2_decode(GVariant *value)
+{
+	int ret;
+	double sum = 0;
+	guint32 i, j, node, parent, state;
+	const char *uri_path;
+	const gchar **ifaces, **types;
+	const ic_wire_attr_s *attr;
+	const ic_wire_list_s *list;
+	const ic_wire_range_s *range;
+	ic_wire_reader_s reader;
+
+	ret = ic_wire_reader_init(&reader, value);
+	if (IOTCON_ERROR_NONE != ret) {
+		printf("ic_wire_reader_init() Fail(%d)\n", ret);
+		return 0;
+	}
+
+	for (node = 0; node < reader.n_nodes; node++) {
+		ret = ic_wire_reader_get_node(&reader, node, &uri_path, &ifaces, &types, &parent,
+				&state);
+		if (IOTCON_ERROR_NONE != ret)
+			break;
+		sum += strlen(uri_path);
+		sum += g_strv_length((gchar**)ifaces) + g_strv_length((gchar**)types);
+		g_free(ifaces);
+		g_free(types);
+
+		range = ic_wire_reader_get_state(&reader, state);
+		if (NULL == range)
+			break;
+		for (i = 0; i < range->count; i++) {
+			attr = &reader.attrs[range->first + i];
+			sum += strlen(ic_wire_reader_get_key(&reader, attr->key));
+			if (IC_WIRE_LIST == attr->tag) {
+				list = ic_wire_reader_get_list(&reader, attr->value);
+				if (NULL == list || IC_WIRE_DOUBLE != list->tag)
+					continue;
+				if (false == ic_wire_reader_check(&reader, list->tag, list->first,
+							list->count))
+					continue;
+				for (j = 0; j < list->count; j++)
+					sum += reader.doubles[list->first + j];
+				continue;
+			}
+			if (false == ic_wire_reader_check(&reader, attr->tag, attr->value, 1))
+				continue;
+			switch (attr->tag) {
+			case IC_WIRE_BOOL:
+				sum += reader.bools[attr->value];
+				break;
+			case IC_WIRE_INT:
+				sum += reader.ints[attr->value];
+				break;
+			case IC_WIRE_DOUBLE:
+				sum += reader.doubles[attr->value];
+				break;
+			case IC_WIRE_STR:
+				sum += strlen(reader.strs[attr->value]);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+	ic_wire_reader_clear(&reader);
+
+	return sum;
+}
+
+
+static void _bench_run(const char *name, bench_node_s *node, int version, int iterations)
+{
+	int i;
+	gsize size = 0;
+	gint64 start, encode_time, decode_time;
+	double sum = 0;
+	GVariant *value, *received;
+	const GVariantType *type;
+	gconstpointer data;
+
+	/* encode, and serialize as D-Bus does */
+	start = g_get_monotonic_time();
+	for (i = 0; i < iterations; i++) {
+		if (IC_WIRE_VERSION_1 == version)
+			value = _bench_v1_encode(node);
+		else
+			value = _bench_v2_encode(node);
+		value = g_variant_ref_sink(value);
+		size = g_variant_get_size(value);
+		data = g_variant_get_data(value);
+		sum += ((const guint8*)data)[0];
+		g_variant_unref(value);
+	}
+	encode_time = g_get_monotonic_time() - start;
+
+	if (IC_WIRE_VERSION_1 == version) {
+		value = _bench_v1_encode(node);
+		type = G_VARIANT_TYPE("(sasasa{sv}av)");
+	} else {
+		value = _bench_v2_encode(node);
+		type = G_VARIANT_TYPE(IC_WIRE_TYPE);
+	}
+	value = g_variant_ref_sink(value);
+
+	/* decode the bytes from the peer, which is not trusted */
+	start = g_get_monotonic_time();
+	for (i = 0; i < iterations; i++) {
+		received = g_variant_new_from_data(type, g_variant_get_data(value),
+				g_variant_get_size(value), FALSE, NULL, NULL);
+		received = g_variant_ref_sink(received);
+		if (IC_WIRE_VERSION_1 == version)
+			sum += _bench_v1_decode(received);
+		else
+			sum += _bench_v2_decode(received);
+		g_variant_unref(received);
+	}
+	decode_time = g_get_monotonic_time() - start;
+	g_variant_unref(value);
+
+	printf("%-12s v%d %6zu bytes  encode %8.0f ns  decode %8.0f ns  (%g)\n", name, version,
+			size, encode_time * 1000.0 / iterations, decode_time * 1000.0 / iterations,
+			sum);
+}
+
+
+/* the same choice as the daemon and the library make */
+static unsigned int _bench_count_elements(bench_node_s *node)
+{
+	int i;
+	unsigned int count = 0;
+
+	for (i = 0; i < node->n_attrs; i++) {
+		if (BENCH_DOUBLE_LIST == node->attrs[i].type)
+			count += node->attrs[i].n_list;
+	}
+	for (i = 0; i < node->n_children; i++)
+		count += _bench_count_elements(node->children[i]);
+
+	return count;
+}
+
+
+static void _bench_payload(const char *name, bench_node_s *node, int iterations)
+{
+	unsigned int count;
+
+	_bench_run(name, node, IC_WIRE_VERSION_1, iterations);
+	_bench_run(name, node, IC_WIRE_VERSION_2, iterations);
+
+	count = _bench_count_elements(node);
+	printf("%-12s sent as v%d (%u list elements)\n", name,
+			(count < IC_WIRE_FLAT_MIN_ELEMENTS) ? IC_WIRE_VERSION_1 : IC_WIRE_VERSION_2,
+			count);
+}
+
+
+int main(int argc, char **argv)
+{
+	int i, iterations = BENCH_ITERATIONS;
+
+	if (2 <= argc)
+		iterations = atoi(argv[1]);
+	if (iterations <= 0)
+		iterations = BENCH_ITERATIONS;
+
+	for (i = 0; i < BENCH_MAX_LIST; i++)
+		bench_accel.attrs[1].list[i] = 0.98 + (i % 7) * 0.01;
+
+	_bench_payload("temperature", &bench_temperature, iterations);
+	_bench_payload("light", &bench_light, iterations);
+	_bench_payload("room", &bench_room, iterations);
+	_bench_payload("acceleration", &bench_accel, iterations);
+
+	return 0;
+}